@@ -0,0 +1,531 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include "aot.h"
+#include "bignum.h"
+#include "compiler.h"
+#include "symtab.h"
+#include "vector.h"
+#include "talloc.h"
+
+// Functions are written out children first, each named by its position in
+// this list, so that the program's constants can be set up afterwards.
+Function **emitted = NULL;
+int emittedCount = 0;
+int emittedCapacity = 0;
+
+// print a string as a C string literal. takes in the string
+void emitString(const char *s) {
+    putchar('"');
+    for (; *s; s++) {
+        unsigned char c = *s;
+        if (c == '"' || c == '\\' || c == '?') {
+            printf("\\%c", c);
+        } else if (isprint(c)) {
+            putchar(c);
+        } else {
+            printf("\\%03o", c);
+        }
+    }
+    putchar('"');
+}
+
+// print a C expression that builds a copy of an item: a constant, or a
+// parse tree to evaluate with the tree walker. takes in the item
+void emitItem(Item *item) {
+    switch (item->type) {
+        case INT_TYPE:
+            // the most negative long has no literal in C
+            if (item->i == LONG_MIN) {
+                printf("aotInteger(\"%ld\")", item->i);
+            } else {
+                printf("aotInt(%ldL)", item->i);
+            }
+            break;
+        case BIGNUM_TYPE:
+            printf("aotInteger(\"%s\")", integerToString(item));
+            break;
+        case DOUBLE_TYPE:
+            printf("aotDouble(%.17g)", item->d);
+            break;
+        case BOOL_TYPE:
+            printf("aotBool(%d)", (int)item->i);
+            break;
+        case STR_TYPE:
+            printf("aotString(");
+            emitString(item->s);
+            printf(")");
+            break;
+        case SYMBOL_TYPE:
+            printf("aotSymbol(");
+            emitString(item->s);
+            printf(")");
+            break;
+        case CALL_SITE_TYPE:
+            emitItem(item->cs.symbol);
+            break;
+        case CONS_TYPE: {
+            int count = 0;
+            Item *rest = item;
+            while (rest->type == CONS_TYPE) {
+                count++;
+                rest = cdr(rest);
+            }
+            if (rest->type != NULL_TYPE) {
+                printf("cons(");
+                emitItem(car(item));
+                printf(", ");
+                emitItem(cdr(item));
+                printf(")");
+                break;
+            }
+            printf("aotList(%d", count);
+            for (rest = item; rest->type == CONS_TYPE; rest = cdr(rest)) {
+                printf(", ");
+                emitItem(car(rest));
+            }
+            printf(")");
+            break;
+        }
+        case VECTOR_TYPE:
+            printf("aotVector(aotList(%ld", item->v.length);
+            for (long i = 0; i < item->v.length; i++) {
+                printf(", ");
+                emitItem(item->v.elements[i]);
+            }
+            printf("))");
+            break;
+        default:
+            printf("makeNull()");
+            break;
+    }
+}
+
+// print the expression for an environment some number of levels up
+void emitEnv(intptr_t depth) {
+    printf("env");
+    while (depth-- > 0) {
+        printf("->parent");
+    }
+}
+
+// print the C statements for one instruction. takes in the function, its
+// number, the position of the instruction and the numbers of the functions
+// nested in it
+void emitInstruction(Function *function, int id, int pc, int *children) {
+    Opcode op = function->code[pc];
+    intptr_t operand = function->code[pc + 1];
+    switch (op) {
+        case CONST_OP:
+            printf("    *sp++ = constant%d[%ld];\n", id, (long)operand);
+            break;
+        case LOCAL_REF_OP:
+            printf("    { Item *v = ");
+            emitEnv(operand);
+            printf("->slots[%ld]; if (v == NULL) evaluationError(\"Unbound symbol\"); *sp++ = v; }\n",
+                   (long)function->code[pc + 2]);
+            break;
+        case LOCAL_SET_OP:
+            printf("    ");
+            emitEnv(operand);
+            printf("->slots[%ld] = *--sp;\n", (long)function->code[pc + 2]);
+            break;
+        case BOX_OP:
+            printf("    env->slots[%ld] = makeBox(env->slots[%ld]);\n", (long)operand, (long)operand);
+            break;
+        case BOX_REF_OP:
+            printf("    { Item *v = ");
+            emitEnv(operand);
+            printf("->slots[%ld]->c.cdr; if (v == NULL) evaluationError(\"Unbound symbol\"); *sp++ = v; }\n",
+                   (long)function->code[pc + 2]);
+            break;
+        case BOX_SET_OP:
+            printf("    ");
+            emitEnv(operand);
+            printf("->slots[%ld]->c.cdr = *--sp;\n", (long)function->code[pc + 2]);
+            break;
+        case GLOBAL_REF_OP:
+            printf("    *sp++ = resolveGlobal(constant%d[%ld])->c.cdr;\n", id, (long)operand);
+            break;
+        case GLOBAL_SET_OP:
+            printf("    resolveGlobal(constant%d[%ld])->c.cdr = *--sp;\n", id, (long)operand);
+            break;
+        case GLOBAL_DEFINE_OP:
+            printf("    defineGlobal(constant%d[%ld]->s, *--sp);\n", id, (long)operand);
+            break;
+        case VOID_OP:
+            printf("    *sp++ = voidItem;\n");
+            break;
+        case POP_OP:
+            printf("    sp--;\n");
+            break;
+        case JUMP_OP:
+            printf("    goto L%ld;\n", (long)operand);
+            break;
+        case JUMP_IF_FALSE_OP:
+            printf("    { Item *v = *--sp; if (v->type != BOOL_TYPE) "
+                   "evaluationError(\"if expects a boolean as the first argument\"); "
+                   "if (!v->i) goto L%ld; }\n", (long)operand);
+            break;
+        case JUMP_UNLESS_TRUE_OP:
+            printf("    { Item *v = *--sp; if (v->type != BOOL_TYPE || !v->i) goto L%ld; }\n",
+                   (long)operand);
+            break;
+        case AND_JUMP_OP:
+        case OR_JUMP_OP:
+            printf("    { Item *v = sp[-1]; if (v->type != BOOL_TYPE) "
+                   "evaluationError(\"boolean arguments expected\"); "
+                   "if (%sv->i) goto L%ld; sp--; }\n", op == AND_JUMP_OP ? "!" : "", (long)operand);
+            break;
+        case MAKE_CLOSURE_OP:
+            printf("    *sp++ = makeClosure(&function%d, env);\n", children[operand]);
+            break;
+        case CALL_OP:
+            printf("    sp -= %ld; *sp = aotCall(sp, %ld); sp++;\n", (long)operand + 1, (long)operand);
+            break;
+        case TAIL_CALL_OP:
+            // a tail call to the function itself is a jump back to its start
+            printf("    sp -= %ld;\n", (long)operand + 1);
+            printf("    if (sp[0]->type == COMPILED_TYPE && sp[0]->cc.function == &function%d) {\n", id);
+            printf("        env = bindSlots(&function%d, sp[0]->cc.env, sp + 1, %ld);\n", id, (long)operand);
+            printf("        sp = stack;\n");
+            printf("        goto start;\n");
+            printf("    }\n");
+            printf("    return aotTailCall(sp, %ld);\n", (long)operand);
+            break;
+        case RETURN_OP:
+            printf("    return *--sp;\n");
+            break;
+        case SET_CAR_OP:
+        case SET_CDR_OP:
+            printf("    { Item *v = *--sp; Item *pair = *--sp; if (pair->type != CONS_TYPE) "
+                   "evaluationError(\"%s\"); pair->c.%s = v; *sp++ = voidItem; }\n",
+                   op == SET_CAR_OP ? "not a pair" : "set-cdr! expects a pair as the first argument",
+                   op == SET_CAR_OP ? "car" : "cdr");
+            break;
+        case PROMISE_OP:
+            printf("    sp[-1] = makePromise(sp[-1], NULL, %ld);\n", (long)operand);
+            break;
+        case FIXNUM_OP:
+        case FLONUM_OP:
+            printf("    sp--; sp[-1] = %s(%ld, sp - 1);\n",
+                   op == FIXNUM_OP ? "computeFixnum" : "computeFlonum", (long)operand);
+            break;
+        default:
+            break;
+    }
+}
+
+// write the C code for a compiled function and every function nested in
+// it. takes in the function and returns the number that names it
+int emitFunction(Function *function) {
+    int *children = talloc(sizeof(int) * (function->functionCount + 1));
+    for (int i = 0; i < function->functionCount; i++) {
+        children[i] = emitFunction(function->functions[i]);
+    }
+    if (emittedCount == emittedCapacity) {
+        emittedCapacity = emittedCapacity ? 2 * emittedCapacity : 64;
+        Function **newEmitted = talloc(sizeof(Function *) * emittedCapacity);
+        if (emittedCount > 0) {
+            memcpy(newEmitted, emitted, sizeof(Function *) * emittedCount);
+        }
+        emitted = newEmitted;
+    }
+    int id = emittedCount;
+    emitted[emittedCount++] = function;
+
+    int length = function->codeLength;
+    int *isTarget = talloc(sizeof(int) * (length + 1));
+    int hasTailCall = 0;
+    for (int pc = 0; pc <= length; pc++) {
+        isTarget[pc] = 0;
+    }
+    for (int pc = 0; pc < length; pc += 1 + opcodeOperands[function->code[pc]]) {
+        Opcode op = function->code[pc];
+        if (op == JUMP_OP || op == JUMP_IF_FALSE_OP || op == JUMP_UNLESS_TRUE_OP ||
+            op == AND_JUMP_OP || op == OR_JUMP_OP) {
+            isTarget[function->code[pc + 1]] = 1;
+        }
+        hasTailCall |= op == TAIL_CALL_OP;
+    }
+
+    if (function->constantCount > 0) {
+        printf("static Item *constant%d[%d];\n", id, function->constantCount);
+    }
+    if (function->captureCount > 0) {
+        printf("static intptr_t captures%d[] = {", id);
+        for (int i = 0; i < 2 * function->captureCount; i++) {
+            printf(i > 0 ? ", %ld" : "%ld", (long)function->captures[i]);
+        }
+        printf("};\n");
+    }
+    printf("static Item *code%d(Env *env);\n", id);
+    printf("static Function function%d = {", id);
+    if (function->captureCount > 0) {
+        printf(".captures = captures%d, .captureCount = %d, ", id, function->captureCount);
+    }
+    printf(".paramCount = %d, .variadic = %d, .slotCount = %d, .aotEntry = code%d};\n\n",
+           function->paramCount, function->variadic, function->slotCount, id);
+    printf("static Item *code%d(Env *env) {\n", id);
+    printf("    Item *stack[%d];\n", function->maxStack + 1);
+    printf("    Item **sp = stack;\n");
+    if (hasTailCall) {
+        printf("start:\n");
+    }
+    for (int pc = 0; pc < length; pc += 1 + opcodeOperands[function->code[pc]]) {
+        if (isTarget[pc]) {
+            printf("L%d:\n", pc);
+        }
+        emitInstruction(function, id, pc, children);
+    }
+    printf("}\n\n");
+    return id;
+}
+
+// print a C expression for a constant of an emitted function. a pair,
+// string or vector the program can mutate or compare with eq? is built only
+// once, and every other function that has the same one, as functions an
+// inlined body was copied into do, refers to the first copy. takes in the
+// function's position in the emitted list and the constant's index
+void emitConstant(int id, int index) {
+    Item *constant = emitted[id]->constants[index];
+    if (constant->type == CONS_TYPE || constant->type == STR_TYPE || constant->type == VECTOR_TYPE) {
+        for (int other = 0; other <= id; other++) {
+            int count = other < id ? emitted[other]->constantCount : index;
+            for (int k = 0; k < count; k++) {
+                if (emitted[other]->constants[k] == constant) {
+                    printf("constant%d[%d]", other, k);
+                    return;
+                }
+            }
+        }
+    }
+    emitItem(constant);
+}
+
+// translate a program to C and print it. takes in the parse tree
+void compileToC(Item *tree) {
+    // compiling consults the global table to see which defines shadow a
+    // global, so each top-level define is entered in it as it is compiled,
+    // as it would have been evaluated by then
+    initializeGlobals();
+    int formCount = length(tree);
+    int *forms = talloc(sizeof(int) * (formCount + 1));
+
+    printf("// Compiled from Scheme with --compile-to-c. Link with the\n");
+    printf("// interpreter's sources other than main.c.\n");
+    printf("#include \"aot.h\"\n\n");
+    Item *form = tree;
+    for (int i = 0; i < formCount; i++, form = cdr(form)) {
+        Function *function = compileTopLevel(car(form));
+        forms[i] = function ? emitFunction(function) : -1;
+        Item *first = car(form)->type == CONS_TYPE ? car(car(form)) : NULL;
+        if (first != NULL && first->type == SYMBOL_TYPE && strcmp(first->s, "define") == 0 &&
+            length(car(form)) == 3 && car(cdr(car(form)))->type == SYMBOL_TYPE) {
+            defineGlobal(car(cdr(car(form)))->s, makeVoid());
+        }
+    }
+
+    printf("static void program() {\n");
+    for (int id = 0; id < emittedCount; id++) {
+        for (int k = 0; k < emitted[id]->constantCount; k++) {
+            printf("    constant%d[%d] = ", id, k);
+            emitConstant(id, k);
+            printf(";\n");
+        }
+    }
+    form = tree;
+    for (int i = 0; i < formCount; i++, form = cdr(form)) {
+        if (forms[i] >= 0) {
+            printf("    aotPrint(aotRun(&function%d));\n", forms[i]);
+        } else {
+            printf("    aotPrint(aotEval(");
+            emitItem(car(form));
+            printf("));\n");
+        }
+    }
+    printf("}\n\n");
+    printf("int main(int argc, char **argv) {\n");
+    printf("    return aotMain(argc, argv, program);\n");
+    printf("}\n");
+}
+
+// The runtime support below is used by compiled programs.
+
+Frame *aotGlobalFrame = NULL;
+
+// the closure and environment of a tail call handed back to aotInvoke,
+// which is signalled by returning the marker item
+Function *pendingFunction = NULL;
+Env *pendingEnv = NULL;
+Item tailCallMarker;
+
+// run a compiled function, and any tail calls it makes to other closures.
+// takes in the function and its environment, and returns its value
+Item *aotInvoke(Function *function, Env *env) {
+    checkStackDepth();
+    Item *result = function->aotEntry(env);
+    while (result == &tailCallMarker) {
+        result = pendingFunction->aotEntry(pendingEnv);
+    }
+    return result;
+}
+
+// apply an arithmetic or comparison primitive to two fixnums without
+// allocating anything but the result. takes in the primitive and the arguments, and
+// returns the result, or NULL if the primitive has to be called instead
+Item *callFixnumPrimitive(Item *function, Item *a, Item *b) {
+    if (a->type != INT_TYPE || b->type != INT_TYPE) {
+        return NULL;
+    }
+    Primitive *primitive = function->pr;
+    long result;
+    if (primitive->call == primitivePlus) {
+        return __builtin_add_overflow(a->i, b->i, &result) ? NULL : aotInt(result);
+    } else if (primitive->call2 == primitiveMinus) {
+        return __builtin_sub_overflow(a->i, b->i, &result) ? NULL : aotInt(result);
+    } else if (primitive->call == primitiveMultiply) {
+        return __builtin_mul_overflow(a->i, b->i, &result) ? NULL : aotInt(result);
+    } else if (primitive->call2 == primitiveLess) {
+        return aotBool(a->i < b->i);
+    } else if (primitive->call2 == primitiveGreater) {
+        return aotBool(a->i > b->i);
+    } else if (primitive->call2 == primitiveEqual) {
+        return aotBool(a->i == b->i);
+    }
+    return NULL;
+}
+
+// call a function. takes in an array holding the function and then its
+// arguments, and the number of arguments, and returns the result
+Item *aotCall(Item **values, int argc) {
+    Item *function = values[0];
+    if (function->type == COMPILED_TYPE && function->cc.function->aotEntry != NULL) {
+        Function *target = function->cc.function;
+        return aotInvoke(target, bindSlots(target, function->cc.env, values + 1, argc));
+    }
+    if (function->type == PRIMITIVE_TYPE && argc == 2) {
+        Item *result = callFixnumPrimitive(function, values[1], values[2]);
+        if (result != NULL) {
+            return result;
+        }
+    }
+    return callOut(function, values + 1, argc);
+}
+
+// make a tail call. a compiled closure is handed back to aotInvoke to run;
+// anything else is called right away. takes in the same as aotCall, and
+// returns the result or the tail call marker
+Item *aotTailCall(Item **values, int argc) {
+    Item *function = values[0];
+    if (function->type == COMPILED_TYPE && function->cc.function->aotEntry != NULL) {
+        pendingFunction = function->cc.function;
+        pendingEnv = bindSlots(pendingFunction, function->cc.env, values + 1, argc);
+        return &tailCallMarker;
+    }
+    return callOut(function, values + 1, argc);
+}
+
+// run a compiled top-level form. takes in its function and returns its value
+Item *aotRun(Function *function) {
+    return aotInvoke(function, bindSlots(function, NULL, NULL, 0));
+}
+
+// evaluate a form the compiler left to the tree walker
+Item *aotEval(Item *form) {
+    return eval(form, aotGlobalFrame);
+}
+
+// print the value of a top-level form, as interpret does
+void aotPrint(Item *result) {
+    if (result->type != VOID_TYPE) {
+        printItem(result);
+        printf("\n");
+    }
+}
+
+Item *aotInt(long value) {
+    Item *item = talloc(sizeof(Item));
+    item->type = INT_TYPE;
+    item->i = value;
+    return item;
+}
+
+Item *aotInteger(const char *digits) {
+    return parseInteger(digits);
+}
+
+Item *aotDouble(double value) {
+    Item *item = talloc(sizeof(Item));
+    item->type = DOUBLE_TYPE;
+    item->d = value;
+    return item;
+}
+
+Item *aotBool(int value) {
+    Item *item = talloc(sizeof(Item));
+    item->type = BOOL_TYPE;
+    item->i = value;
+    return item;
+}
+
+Item *aotString(const char *s) {
+    Item *item = talloc(sizeof(Item));
+    item->type = STR_TYPE;
+    item->str.chars = intern(s);
+    item->str.length = strlen(s);
+    item->str.rope = NULL;
+    return item;
+}
+
+// make a symbol. every use gets its own item, since a symbol in a parse
+// tree caches the binding of that one reference
+Item *aotSymbol(const char *name) {
+    Item *item = talloc(sizeof(Item));
+    item->type = SYMBOL_TYPE;
+    item->s = intern(name);
+    item->sc.cell = NULL;
+    item->sc.epoch = 0;
+    return item;
+}
+
+// make a list. takes in the number of elements and the elements
+Item *aotList(int count, ...) {
+    Item **elements = talloc(sizeof(Item *) * (count + 1));
+    va_list args;
+    va_start(args, count);
+    for (int i = 0; i < count; i++) {
+        elements[i] = va_arg(args, Item *);
+    }
+    va_end(args);
+    Item *list = makeNull();
+    for (int i = count - 1; i >= 0; i--) {
+        list = cons(elements[i], list);
+    }
+    return list;
+}
+
+// make a vector. takes in the list of its elements
+Item *aotVector(Item *elements) {
+    return listToVector(elements);
+}
+
+// the main function of a compiled program. takes in the command line and
+// the program, and returns the exit status
+int aotMain(int argc, char **argv, void (*program)()) {
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--stack-limit=", 14) == 0 && atol(argv[i] + 14) > 0) {
+            setStackLimit((size_t)atol(argv[i] + 14) * 1024 * 1024);
+        } else {
+            printf("Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    aotGlobalFrame = initializeGlobals();
+    voidItem = makeVoid();
+    runOnProgramStack(program);
+    tfree();
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include "item.h"
+#include "vm.h"
+#include "interpreter.h"
+#include "linkedlist.h"
+
+#ifndef AOT_H
+#define AOT_H
+
+// Ahead-of-time compilation to C. compileToC writes a C program that does
+// what interpreting the parse tree would: every top-level form and lambda the
+// bytecode compiler handles becomes a C function operating on an Env of
+// slots, and any other form is rebuilt as a parse tree and evaluated with
+// the tree walker. The program links against the interpreter's sources,
+// minus main.c, and calls into the runtime support declared below.
+void compileToC(Item *tree);
+
+// Runtime support for compiled programs. Closures are COMPILED_TYPE items
+// whose function has an aotEntry, made with makeClosure like the VM's. Calls that are not self tail calls go
+// through aotCall, and tail calls to other closures are returned to the
+// nearest aotInvoke, which runs them in a loop so tail calls use no stack.
+Item *aotInvoke(Function *function, Env *env);
+Item *aotCall(Item **values, int argc);
+Item *aotTailCall(Item **values, int argc);
+Item *aotRun(Function *function);
+Item *aotEval(Item *form);
+void aotPrint(Item *result);
+
+// Build the constants and parse trees of a compiled program.
+Item *aotInt(long value);
+Item *aotInteger(const char *digits);
+Item *aotDouble(double value);
+Item *aotBool(int value);
+Item *aotString(const char *s);
+Item *aotSymbol(const char *name);
+Item *aotList(int count, ...);
+Item *aotVector(Item *elements);
+
+// The main function of a compiled program: sets up the global frame and
+// runs the program on a stack the size of the stack limit (see
+// runOnProgramStack).
+int aotMain(int argc, char **argv, void (*program)());
+
+#endif
@@ -0,0 +1,492 @@
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bignum.h"
+#include "talloc.h"
+
+// operands with at least this many limbs are multiplied by Karatsuba's
+// method, smaller ones limb by limb
+#define KARATSUBA_THRESHOLD 32
+
+// ten to the ninth, the largest power of ten a limb holds, so decimal
+// digits are converted nine at a time
+#define DECIMAL_CHUNK 1000000000u
+#define DECIMAL_CHUNK_DIGITS 9
+
+// makes a fixnum. takes in its value
+Item *makeFixnum(long value) {
+    Item *result = talloc(sizeof(Item));
+    result->type = INT_TYPE;
+    result->i = value;
+    return result;
+}
+
+// views an integer as a sign and magnitude. a fixnum's limbs are written
+// to storage, which must have room for two; zero has no limbs. takes in
+// the integer, the view and the storage and does not return anything
+static void viewInteger(Item *value, Bignum *view, uint32_t *storage) {
+    if (value->type == BIGNUM_TYPE) {
+        *view = *value->bn;
+        return;
+    }
+    uint64_t magnitude = value->i < 0 ? -(uint64_t)value->i : (uint64_t)value->i;
+    storage[0] = (uint32_t)magnitude;
+    storage[1] = (uint32_t)(magnitude >> 32);
+    view->sign = value->i < 0 ? -1 : 1;
+    view->length = storage[1] != 0 ? 2 : storage[0] != 0 ? 1 : 0;
+    view->limbs = storage;
+}
+
+// finds how many limbs of a magnitude are in use. takes in the limbs and
+// how many there are room for, and returns the count without leading zeros
+static int usedLength(const uint32_t *limbs, int length) {
+    while (length > 0 && limbs[length - 1] == 0) {
+        length--;
+    }
+    return length;
+}
+
+// makes an integer from a sign and a magnitude: a fixnum if it fits in
+// one, or else a bignum that keeps the limbs, which must have been
+// allocated with talloc. takes in the sign, the limbs and their count
+static Item *makeInteger(int sign, uint32_t *limbs, int length) {
+    length = usedLength(limbs, length);
+    if (length <= 2) {
+        uint64_t magnitude = length == 0 ? 0 : limbs[0];
+        if (length == 2) {
+            magnitude |= (uint64_t)limbs[1] << 32;
+        }
+        if (magnitude <= (uint64_t)LONG_MAX) {
+            return makeFixnum(sign < 0 ? -(long)magnitude : (long)magnitude);
+        }
+        if (sign < 0 && magnitude == (uint64_t)LONG_MAX + 1) {
+            return makeFixnum(LONG_MIN);
+        }
+    }
+    Bignum *bignum = talloc(sizeof(Bignum));
+    bignum->sign = sign;
+    bignum->length = length;
+    bignum->limbs = limbs;
+    Item *result = talloc(sizeof(Item));
+    result->type = BIGNUM_TYPE;
+    result->bn = bignum;
+    return result;
+}
+
+// compares two magnitudes with no leading zeros. takes in each as its
+// limbs and their count, and returns -1, 0 or 1
+static int compareMagnitudes(const uint32_t *a, int aLength, const uint32_t *b, int bLength) {
+    if (aLength != bLength) {
+        return aLength < bLength ? -1 : 1;
+    }
+    for (int i = aLength - 1; i >= 0; i--) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+// adds a magnitude into another in place. the sum must fit in the limbs
+// of the first. takes in each as its limbs and their count, the second
+// no longer than the first, and does not return anything
+static void addInto(uint32_t *x, int xLength, const uint32_t *y, int yLength) {
+    uint64_t carry = 0;
+    int i = 0;
+    for (; i < yLength; i++) {
+        uint64_t sum = (uint64_t)x[i] + y[i] + carry;
+        x[i] = (uint32_t)sum;
+        carry = sum >> 32;
+    }
+    for (; carry != 0 && i < xLength; i++) {
+        uint64_t sum = (uint64_t)x[i] + carry;
+        x[i] = (uint32_t)sum;
+        carry = sum >> 32;
+    }
+}
+
+// subtracts a magnitude from another in place. the first must be the
+// larger. takes in each as its limbs and their count, the second no longer
+// than the first, and does not return anything
+static void subtractFrom(uint32_t *x, int xLength, const uint32_t *y, int yLength) {
+    int64_t borrow = 0;
+    int i = 0;
+    for (; i < yLength; i++) {
+        int64_t difference = (int64_t)x[i] - y[i] - borrow;
+        x[i] = (uint32_t)difference;
+        borrow = difference < 0;
+    }
+    for (; borrow != 0 && i < xLength; i++) {
+        int64_t difference = (int64_t)x[i] - borrow;
+        x[i] = (uint32_t)difference;
+        borrow = difference < 0;
+    }
+}
+
+// adds two integers, or subtracts the second from the first, by their
+// signs and magnitudes. takes in the integers and 1 to add or -1 to
+// subtract, and returns the result
+static Item *addSigned(Item *a, Item *b, int direction) {
+    uint32_t aStorage[2], bStorage[2];
+    Bignum x, y;
+    viewInteger(a, &x, aStorage);
+    viewInteger(b, &y, bStorage);
+    y.sign *= direction;
+    if (x.length < y.length || (x.sign != y.sign &&
+                                compareMagnitudes(x.limbs, x.length, y.limbs, y.length) < 0)) {
+        Bignum swap = x;
+        x = y;
+        y = swap;
+    }
+    uint32_t *limbs = talloc(sizeof(uint32_t) * (x.length + 1));
+    memcpy(limbs, x.limbs, sizeof(uint32_t) * x.length);
+    limbs[x.length] = 0;
+    if (x.sign == y.sign) {
+        addInto(limbs, x.length + 1, y.limbs, y.length);
+    } else {
+        subtractFrom(limbs, x.length, y.limbs, y.length);
+    }
+    return makeInteger(x.sign, limbs, x.length + 1);
+}
+
+// multiplies two magnitudes limb by limb. takes in each as its limbs and
+// their count, and where to put the product, which has room for as many
+// limbs as the two have together
+static void multiplySchoolbook(const uint32_t *a, int aLength, const uint32_t *b, int bLength,
+                               uint32_t *out) {
+    memset(out, 0, sizeof(uint32_t) * (aLength + bLength));
+    for (int i = 0; i < aLength; i++) {
+        uint64_t carry = 0;
+        for (int j = 0; j < bLength; j++) {
+            uint64_t product = (uint64_t)a[i] * b[j] + out[i + j] + carry;
+            out[i + j] = (uint32_t)product;
+            carry = product >> 32;
+        }
+        out[i + bLength] = (uint32_t)carry;
+    }
+}
+
+// multiplies two magnitudes of the same length by Karatsuba's method: the
+// product of the low halves, the product of the high halves, and the
+// product of the sums of the halves, less the other two, for the middle,
+// so three half-size products instead of four. takes in the magnitudes,
+// their length, where to put the product, which has room for twice that,
+// and scratch space for 4 * length + 1024 limbs, and does not return
+// anything
+static void multiplyKaratsuba(const uint32_t *a, const uint32_t *b, int length, uint32_t *out,
+                              uint32_t *scratch) {
+    if (length < KARATSUBA_THRESHOLD) {
+        multiplySchoolbook(a, length, b, length, out);
+        return;
+    }
+    int low = length / 2;
+    int high = length - low;
+    multiplyKaratsuba(a, b, low, out, scratch);
+    multiplyKaratsuba(a + low, b + low, high, out + 2 * low, scratch);
+
+    uint32_t *aSum = scratch;
+    uint32_t *bSum = aSum + high + 1;
+    uint32_t *middle = bSum + high + 1;
+    memcpy(aSum, a + low, sizeof(uint32_t) * high);
+    aSum[high] = 0;
+    addInto(aSum, high + 1, a, low);
+    memcpy(bSum, b + low, sizeof(uint32_t) * high);
+    bSum[high] = 0;
+    addInto(bSum, high + 1, b, low);
+    multiplyKaratsuba(aSum, bSum, high + 1, middle, middle + 2 * (high + 1));
+    subtractFrom(middle, 2 * (high + 1), out, 2 * low);
+    subtractFrom(middle, 2 * (high + 1), out + 2 * low, 2 * high);
+    addInto(out + low, 2 * length - low, middle, usedLength(middle, 2 * (high + 1)));
+}
+
+// multiplies two magnitudes. operands too short for Karatsuba's method are
+// multiplied limb by limb; otherwise the longer is cut into pieces as long
+// as the shorter, each multiplied by Karatsuba's method. takes in each as
+// its limbs and their count, and where to put the product, which has room
+// for as many limbs as the two have together
+static void multiplyMagnitudes(const uint32_t *a, int aLength, const uint32_t *b, int bLength,
+                               uint32_t *out) {
+    if (aLength < bLength) {
+        const uint32_t *swap = a;
+        a = b;
+        b = swap;
+        int swapLength = aLength;
+        aLength = bLength;
+        bLength = swapLength;
+    }
+    if (bLength < KARATSUBA_THRESHOLD) {
+        multiplySchoolbook(a, aLength, b, bLength, out);
+        return;
+    }
+    // the scratch space only lives for this call, so it is freed rather
+    // than left to talloc
+    uint32_t *scratch = malloc(sizeof(uint32_t) * (7 * bLength + 1024));
+    uint32_t *piece = scratch + 4 * bLength + 1024;
+    uint32_t *product = piece + bLength;
+    memset(out, 0, sizeof(uint32_t) * (aLength + bLength));
+    for (int offset = 0; offset < aLength; offset += bLength) {
+        int length = aLength - offset < bLength ? aLength - offset : bLength;
+        memcpy(piece, a + offset, sizeof(uint32_t) * length);
+        memset(piece + length, 0, sizeof(uint32_t) * (bLength - length));
+        multiplyKaratsuba(piece, b, bLength, product, scratch);
+        addInto(out + offset, aLength + bLength - offset, product, usedLength(product, 2 * bLength));
+    }
+    free(scratch);
+}
+
+// divides a magnitude by a single limb. takes in the magnitude as its
+// limbs and their count, the divisor, and where to put the quotient, which
+// may be the magnitude itself or NULL, and returns the remainder
+static uint32_t divideByLimb(const uint32_t *a, int length, uint32_t divisor, uint32_t *quotient) {
+    uint64_t remainder = 0;
+    for (int i = length - 1; i >= 0; i--) {
+        uint64_t current = remainder << 32 | a[i];
+        if (quotient != NULL) {
+            quotient[i] = (uint32_t)(current / divisor);
+        }
+        remainder = current % divisor;
+    }
+    return (uint32_t)remainder;
+}
+
+// shifts a magnitude left by less than a limb. takes in the magnitude as
+// its limbs and their count, the shift, and where to put the result, which
+// has room for one more limb
+static void shiftLeft(const uint32_t *a, int length, int shift, uint32_t *out) {
+    uint32_t carry = 0;
+    for (int i = 0; i < length; i++) {
+        out[i] = a[i] << shift | carry;
+        carry = shift == 0 ? 0 : a[i] >> (32 - shift);
+    }
+    out[length] = carry;
+}
+
+// finds the remainder of dividing a magnitude by one of at least two limbs
+// and no longer than it, by Knuth's algorithm D: both are shifted so the
+// divisor's top limb has its top bit set, which keeps each estimate of a
+// quotient limb from the top limbs at most two too large. takes in each
+// as its limbs and their count, and where to put the remainder, which has
+// room for as many limbs as the divisor
+static void remainderMagnitudes(const uint32_t *a, int aLength, const uint32_t *b, int bLength,
+                                uint32_t *out) {
+    int shift = __builtin_clz(b[bLength - 1]);
+    uint32_t *v = malloc(sizeof(uint32_t) * (bLength + 1));
+    uint32_t *u = malloc(sizeof(uint32_t) * (aLength + 1));
+    shiftLeft(b, bLength, shift, v);
+    shiftLeft(a, aLength, shift, u);
+    uint64_t top = v[bLength - 1];
+    for (int j = aLength - bLength; j >= 0; j--) {
+        uint64_t numerator = (uint64_t)u[j + bLength] << 32 | u[j + bLength - 1];
+        uint64_t estimate = numerator / top;
+        uint64_t rest = numerator % top;
+        while (estimate > UINT32_MAX ||
+               estimate * v[bLength - 2] > (rest << 32 | u[j + bLength - 2])) {
+            estimate--;
+            rest += top;
+            if (rest > UINT32_MAX) {
+                break;
+            }
+        }
+        uint64_t carry = 0;
+        int64_t borrow = 0;
+        for (int i = 0; i < bLength; i++) {
+            uint64_t product = estimate * v[i] + carry;
+            carry = product >> 32;
+            int64_t difference = (int64_t)u[i + j] - (uint32_t)product - borrow;
+            u[i + j] = (uint32_t)difference;
+            borrow = difference < 0;
+        }
+        int64_t difference = (int64_t)u[j + bLength] - (int64_t)carry - borrow;
+        u[j + bLength] = (uint32_t)difference;
+        if (difference < 0) {
+            // the estimate was one too large, so the divisor is added back
+            carry = 0;
+            for (int i = 0; i < bLength; i++) {
+                uint64_t sum = (uint64_t)u[i + j] + v[i] + carry;
+                u[i + j] = (uint32_t)sum;
+                carry = sum >> 32;
+            }
+            u[j + bLength] += (uint32_t)carry;
+        }
+    }
+    for (int i = 0; i < bLength; i++) {
+        out[i] = u[i] >> shift;
+        if (shift != 0) {
+            out[i] |= u[i + 1] << (32 - shift);
+        }
+    }
+    free(u);
+    free(v);
+}
+
+// adds two integers. takes in the integers and returns their sum
+Item *integerAdd(Item *a, Item *b) {
+    long sum;
+    if (a->type == INT_TYPE && b->type == INT_TYPE && !__builtin_add_overflow(a->i, b->i, &sum)) {
+        return makeFixnum(sum);
+    }
+    return addSigned(a, b, 1);
+}
+
+// subtracts an integer from another. takes in the integers and returns
+// their difference
+Item *integerSubtract(Item *a, Item *b) {
+    long difference;
+    if (a->type == INT_TYPE && b->type == INT_TYPE &&
+        !__builtin_sub_overflow(a->i, b->i, &difference)) {
+        return makeFixnum(difference);
+    }
+    return addSigned(a, b, -1);
+}
+
+// multiplies two integers. takes in the integers and returns their product
+Item *integerMultiply(Item *a, Item *b) {
+    long product;
+    if (a->type == INT_TYPE && b->type == INT_TYPE &&
+        !__builtin_mul_overflow(a->i, b->i, &product)) {
+        return makeFixnum(product);
+    }
+    uint32_t aStorage[2], bStorage[2];
+    Bignum x, y;
+    viewInteger(a, &x, aStorage);
+    viewInteger(b, &y, bStorage);
+    if (x.length == 0 || y.length == 0) {
+        return makeFixnum(0);
+    }
+    uint32_t *limbs = talloc(sizeof(uint32_t) * (x.length + y.length));
+    multiplyMagnitudes(x.limbs, x.length, y.limbs, y.length, limbs);
+    return makeInteger(x.sign * y.sign, limbs, x.length + y.length);
+}
+
+// finds the remainder of dividing an integer by another, other than 0.
+// takes in the integers and returns the remainder, which has the sign of
+// the first
+Item *integerRemainder(Item *a, Item *b) {
+    if (a->type == INT_TYPE && b->type == INT_TYPE) {
+        // LONG_MIN % -1 overflows in C, though the remainder is 0
+        return makeFixnum(b->i == -1 ? 0 : a->i % b->i);
+    }
+    uint32_t aStorage[2], bStorage[2];
+    Bignum x, y;
+    viewInteger(a, &x, aStorage);
+    viewInteger(b, &y, bStorage);
+    if (compareMagnitudes(x.limbs, x.length, y.limbs, y.length) < 0) {
+        return a;
+    }
+    uint32_t *limbs = talloc(sizeof(uint32_t) * y.length);
+    if (y.length == 1) {
+        limbs[0] = divideByLimb(x.limbs, x.length, y.limbs[0], NULL);
+    } else {
+        remainderMagnitudes(x.limbs, x.length, y.limbs, y.length, limbs);
+    }
+    return makeInteger(x.sign, limbs, y.length);
+}
+
+// compares two integers. takes in the integers and returns a negative
+// number, 0 or a positive number as the first is less than, equal to or
+// greater than the second
+int integerCompare(Item *a, Item *b) {
+    if (a->type == INT_TYPE && b->type == INT_TYPE) {
+        return (a->i > b->i) - (a->i < b->i);
+    }
+    uint32_t aStorage[2], bStorage[2];
+    Bignum x, y;
+    viewInteger(a, &x, aStorage);
+    viewInteger(b, &y, bStorage);
+    if (x.sign != y.sign) {
+        return x.sign;
+    }
+    return x.sign * compareMagnitudes(x.limbs, x.length, y.limbs, y.length);
+}
+
+// checks whether an integer is zero. takes in the integer
+int isZeroInteger(Item *value) {
+    return value->type == INT_TYPE && value->i == 0;
+}
+
+// converts an integer to a double. takes in the integer and returns the
+// nearest double, or an infinity if it is too large for one
+double integerToDouble(Item *value) {
+    if (value->type == INT_TYPE) {
+        return value->i;
+    }
+    double result = 0.0;
+    for (int i = value->bn->length - 1; i >= 0; i--) {
+        result = result * 4294967296.0 + value->bn->limbs[i];
+    }
+    return value->bn->sign * result;
+}
+
+// reads an integer written in decimal, nine digits at a time. takes in the
+// digits, after an optional sign, and returns the integer
+Item *parseInteger(const char *text) {
+    int sign = 1;
+    if (*text == '-' || *text == '+') {
+        sign = *text == '-' ? -1 : 1;
+        text++;
+    }
+    int digits = strlen(text);
+    uint32_t *limbs = talloc(sizeof(uint32_t) * (digits / DECIMAL_CHUNK_DIGITS + 2));
+    int length = 0;
+    int position = 0;
+    while (position < digits) {
+        // the first chunk takes the digits left over by the rest
+        int count = (digits - position) % DECIMAL_CHUNK_DIGITS;
+        if (count == 0) {
+            count = DECIMAL_CHUNK_DIGITS;
+        }
+        uint32_t chunk = 0;
+        uint32_t scale = 1;
+        for (int i = 0; i < count; i++) {
+            chunk = chunk * 10 + (text[position++] - '0');
+            scale *= 10;
+        }
+        uint64_t carry = chunk;
+        for (int i = 0; i < length; i++) {
+            uint64_t product = (uint64_t)limbs[i] * scale + carry;
+            limbs[i] = (uint32_t)product;
+            carry = product >> 32;
+        }
+        if (carry != 0) {
+            limbs[length++] = (uint32_t)carry;
+        }
+    }
+    return makeInteger(sign, limbs, length);
+}
+
+// writes an integer in decimal. a bignum is divided by ten to the ninth
+// over and over, each remainder giving nine digits, from the lowest.
+// takes in the integer and returns the digits, with a minus sign if it is
+// negative
+char *integerToString(Item *value) {
+    if (value->type == INT_TYPE) {
+        char *text = talloc(24);
+        snprintf(text, 24, "%ld", value->i);
+        return text;
+    }
+    Bignum *bignum = value->bn;
+    int length = bignum->length;
+    uint32_t *quotient = malloc(sizeof(uint32_t) * length);
+    memcpy(quotient, bignum->limbs, sizeof(uint32_t) * length);
+    // each limb holds fewer than ten digits, so fewer than 10/9 chunks
+    int chunkRoom = length * 10 / DECIMAL_CHUNK_DIGITS + 2;
+    uint32_t *chunks = malloc(sizeof(uint32_t) * chunkRoom);
+    int chunkCount = 0;
+    do {
+        chunks[chunkCount++] = divideByLimb(quotient, length, DECIMAL_CHUNK, quotient);
+        length = usedLength(quotient, length);
+    } while (length > 0);
+    char *text = talloc(chunkCount * DECIMAL_CHUNK_DIGITS + 2);
+    int position = 0;
+    if (bignum->sign < 0) {
+        text[position++] = '-';
+    }
+    position += sprintf(text + position, "%u", chunks[chunkCount - 1]);
+    for (int i = chunkCount - 2; i >= 0; i--) {
+        position += sprintf(text + position, "%09u", chunks[i]);
+    }
+    free(chunks);
+    free(quotient);
+    return text;
+}
@@ -0,0 +1,45 @@
+#include <stdint.h>
+#include "item.h"
+
+#ifndef BIGNUM_H
+#define BIGNUM_H
+
+// Exact integers. An integer is a fixnum, an INT item holding a long, for
+// as long as it fits in one, and a bignum, a BIGNUM item, only once it
+// does not: each operation here returns a fixnum whenever its result fits,
+// so the two never overlap and equal integers always have the same type.
+// The fixnum case of each operation is checked first and overflows into
+// the bignum code, so arithmetic on small integers costs no more than an
+// overflow check. Operands must be integers of either kind.
+
+// A bignum: its sign, 1 or -1, and its magnitude as length 32-bit limbs,
+// least significant first, the last of which is never 0.
+struct Bignum {
+    int sign;
+    int length;
+    uint32_t *limbs;
+};
+
+typedef struct Bignum Bignum;
+
+// Makes a fixnum. Takes in its value.
+Item *makeFixnum(long value);
+
+// Arithmetic and comparison. integerRemainder takes the sign of the
+// dividend, as C's % does, and expects a divisor other than 0;
+// integerCompare returns a negative number, 0 or a positive number as a
+// is less than, equal to or greater than b.
+Item *integerAdd(Item *a, Item *b);
+Item *integerSubtract(Item *a, Item *b);
+Item *integerMultiply(Item *a, Item *b);
+Item *integerRemainder(Item *a, Item *b);
+int integerCompare(Item *a, Item *b);
+int isZeroInteger(Item *value);
+
+// Conversions: to the nearest double, from a string of decimal digits with
+// an optional sign, and to a string of decimal digits.
+double integerToDouble(Item *value);
+Item *parseInteger(const char *text);
+char *integerToString(Item *value);
+
+#endif
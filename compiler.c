@@ -0,0 +1,950 @@
+#include <string.h>
+#include "compiler.h"
+#include "interpreter.h"
+#include "linkedlist.h"
+#include "talloc.h"
+
+// A variable: its name, its slot, and whether the slot holds a box with the
+// value in it rather than the value itself.
+typedef struct {
+    char *name;
+    int slot;
+    int boxed;
+} Variable;
+
+// A named let compiled as a loop: its name, the position of the loop
+// instruction that starts each iteration, the height of the operand stack
+// there, with the new values of the variables on it, and how many
+// variables there are.
+typedef struct {
+    char *name;
+    int start;
+    int depth;
+    int count;
+} Loop;
+
+// The state of compiling one function: the function being built, the
+// variables in scope in it, the variables of enclosing functions it uses,
+// and the compiler of the function it is nested in.
+typedef struct Compiler {
+    Function *function;
+    int codeCapacity;
+    int constantCapacity;
+    int functionCapacity;
+    int captureCapacity;
+    // the variables in scope, innermost first, as a list of PTR_TYPE items
+    // pointing to Variables
+    Item *names;
+    // the point in names where the innermost scope starts
+    Item *scopeStart;
+    // the variables of enclosing functions used so far, in the same form.
+    // their slots are in the environment of the function's closures
+    Item *captured;
+    // the loops whose bodies are being compiled, innermost first, as a
+    // list of PTR_TYPE items pointing to Loops
+    Item *loops;
+    // the current height of the operand stack
+    int depth;
+    // set once the form turns out to use something the compiler does not
+    // handle; the rest of the compile is then a no-op
+    int failed;
+    struct Compiler *enclosing;
+} Compiler;
+
+void compileExpression(Compiler *c, Item *expr, int tail);
+void compileBody(Compiler *c, Item *body, int tail, int definesAllowed);
+
+// create a compiler for a new function. takes in the compiler of the
+// enclosing function, or NULL for a top-level form, and returns it
+Compiler *createCompiler(Compiler *enclosing) {
+    Compiler *c = talloc(sizeof(Compiler));
+    Function *function = talloc(sizeof(Function));
+    function->codeLength = 0;
+    function->prepared = NULL;
+    function->constantCount = 0;
+    function->functionCount = 0;
+    function->captureCount = 0;
+    function->paramCount = 0;
+    function->variadic = 0;
+    function->slotCount = 0;
+    function->maxStack = 0;
+    function->callCount = 0;
+    function->native = NULL;
+    function->nativeEntries = NULL;
+    function->aotEntry = NULL;
+    c->codeCapacity = 32;
+    c->constantCapacity = 8;
+    c->functionCapacity = 4;
+    c->captureCapacity = 8;
+    function->code = talloc(sizeof(intptr_t) * c->codeCapacity);
+    function->constants = talloc(sizeof(Item *) * c->constantCapacity);
+    function->functions = talloc(sizeof(Function *) * c->functionCapacity);
+    function->captures = talloc(sizeof(intptr_t) * c->captureCapacity);
+    c->function = function;
+    c->names = makeNull();
+    c->scopeStart = c->names;
+    c->captured = makeNull();
+    c->loops = makeNull();
+    c->depth = 0;
+    c->failed = 0;
+    c->enclosing = enclosing;
+    return c;
+}
+
+// give up on compiling the form. takes in the compiler and does not return
+// anything; the failure is passed up to every enclosing compiler
+void fail(Compiler *c) {
+    while (c != NULL) {
+        c->failed = 1;
+        c = c->enclosing;
+    }
+}
+
+// grow an array allocated with talloc. takes in the array, the number of
+// elements in use, the size of an element and a pointer to the capacity,
+// which is doubled. returns the new array
+void *growArray(void *array, int count, size_t size, int *capacity) {
+    void *newArray = talloc(size * (*capacity) * 2);
+    memcpy(newArray, array, size * count);
+    *capacity *= 2;
+    return newArray;
+}
+
+// append one word to the code. takes in the compiler and the word and
+// returns its position in the code
+int emitWord(Compiler *c, intptr_t word) {
+    Function *f = c->function;
+    if (f->codeLength == c->codeCapacity) {
+        f->code = growArray(f->code, f->codeLength, sizeof(intptr_t), &c->codeCapacity);
+    }
+    f->code[f->codeLength] = word;
+    return f->codeLength++;
+}
+
+// record a change in the height of the operand stack. takes in the
+// compiler and the change and does not return anything
+void adjustDepth(Compiler *c, int change) {
+    c->depth += change;
+    if (c->depth > c->function->maxStack) {
+        c->function->maxStack = c->depth;
+    }
+}
+
+// emit an instruction. takes in the compiler, the opcode, its operand (if
+// it has one) and the change it makes to the height of the operand stack.
+// returns the position of the operand, so jumps can be patched later
+int emit(Compiler *c, Opcode op, intptr_t operand, int change) {
+    emitWord(c, op);
+    int position = c->function->codeLength;
+    if (opcodeOperands[op] > 0) {
+        emitWord(c, operand);
+    }
+    adjustDepth(c, change);
+    return position;
+}
+
+// point a previously emitted jump at the end of the code so far. takes in
+// the compiler and the position of the jump's operand
+void patchJump(Compiler *c, int position) {
+    c->function->code[position] = c->function->codeLength;
+}
+
+// emit a return if the expression just compiled is in tail position. takes
+// in the compiler and the tail flag
+void finish(Compiler *c, int tail) {
+    if (tail) {
+        emit(c, RETURN_OP, 0, -1);
+    }
+}
+
+// add a constant to the function's constant pool. takes in the compiler and
+// the constant and returns its index
+int addConstant(Compiler *c, Item *constant) {
+    Function *f = c->function;
+    if (f->constantCount == c->constantCapacity) {
+        f->constants = growArray(f->constants, f->constantCount, sizeof(Item *), &c->constantCapacity);
+    }
+    f->constants[f->constantCount] = constant;
+    return f->constantCount++;
+}
+
+// add a global variable reference site to the constant pool. takes in the
+// compiler and the variable's name and returns the constant's index. each
+// site gets its own symbol, so it caches its own binding cell
+int addGlobalSite(Compiler *c, char *name) {
+    Item *site = talloc(sizeof(Item));
+    site->type = SYMBOL_TYPE;
+    site->s = name;
+    site->sc.cell = NULL;
+    site->sc.epoch = 0;
+    return addConstant(c, site);
+}
+
+// checks whether an expression is a special form. takes in the expression
+// and the name of the form and returns true if it is one
+int isForm(Item *expr, const char *name) {
+    return expr->type == CONS_TYPE && car(expr)->type == SYMBOL_TYPE &&
+           strcmp(car(expr)->s, name) == 0;
+}
+
+// checks whether a symbol occurs anywhere in an expression. takes in the
+// expression and an interned name
+int mentions(Item *expr, char *name) {
+    while (expr->type == CONS_TYPE) {
+        if (mentions(car(expr), name)) {
+            return 1;
+        }
+        expr = cdr(expr);
+    }
+    return expr->type == SYMBOL_TYPE && expr->s == name;
+}
+
+// checks whether an expression may assign a variable, with set! or with a
+// define that reuses its slot. takes in the expression and an interned name
+int assigns(Item *expr, char *name) {
+    if (expr->type != CONS_TYPE) {
+        return 0;
+    }
+    if ((isForm(expr, "set!") || isForm(expr, "define")) && cdr(expr)->type == CONS_TYPE &&
+        car(cdr(expr))->type == SYMBOL_TYPE && car(cdr(expr))->s == name) {
+        return 1;
+    }
+    for (; expr->type == CONS_TYPE; expr = cdr(expr)) {
+        if (assigns(car(expr), name)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// checks whether a lambda, or a delayed expression, in an expression may use
+// a variable. takes in the expression and an interned name
+int capturedIn(Item *expr, char *name) {
+    if (expr->type != CONS_TYPE) {
+        return 0;
+    }
+    if (isForm(expr, "lambda") || isForm(expr, "delay") || isForm(expr, "delay-force")) {
+        return mentions(cdr(expr), name);
+    }
+    for (; expr->type == CONS_TYPE; expr = cdr(expr)) {
+        if (capturedIn(car(expr), name)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// decide whether a variable needs a box: when a closure may capture it and
+// it may be assigned after being bound, since the closure gets a copy of
+// the slot. shadowing is ignored, so this errs towards boxing. takes in the
+// expressions the variable is in scope in, its name and whether it is
+// always assigned after being bound (as letrec and define variables are)
+int needsBox(Item *scope, char *name, int assignedLater) {
+    return (assignedLater || assigns(scope, name)) && capturedIn(scope, name);
+}
+
+// create a variable and add it to a list of variables. takes in the list,
+// the variable's name, slot and whether it is boxed, and returns the list
+Item *addToList(Item *list, char *name, int slot, int boxed) {
+    Variable *variable = talloc(sizeof(Variable));
+    variable->name = name;
+    variable->slot = slot;
+    variable->boxed = boxed;
+    Item *item = talloc(sizeof(Item));
+    item->type = PTR_TYPE;
+    item->p = variable;
+    return cons(item, list);
+}
+
+// find a variable in a list of variables. takes in the list, where to stop
+// looking, and a name. returns the variable, or NULL if it is not found
+Variable *findVariable(Item *list, Item *end, char *name) {
+    for (; list != end && !isNull(list); list = cdr(list)) {
+        Variable *variable = car(list)->p;
+        if (variable->name == name) {
+            return variable;
+        }
+    }
+    return NULL;
+}
+
+// bind a variable to a new slot in the current scope. takes in the compiler,
+// the variable's symbol and whether it is boxed, and returns the slot
+int addVariable(Compiler *c, Item *symbol, int boxed) {
+    int slot = c->function->slotCount++;
+    c->names = addToList(c->names, symbol->s, slot, boxed);
+    return slot;
+}
+
+// look a variable up in the current scope only. takes in the compiler and
+// a name and returns its slot, or -1 if the scope does not bind it
+int findInScope(Compiler *c, char *name) {
+    Variable *variable = findVariable(c->names, c->scopeStart, name);
+    return variable ? variable->slot : -1;
+}
+
+// checks whether a name is bound by this function or one it is nested in,
+// without capturing anything. takes in the compiler and the name
+int isLocal(Compiler *c, char *name) {
+    for (; c != NULL; c = c->enclosing) {
+        if (findVariable(c->names, NULL, name) != NULL) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// resolve a variable reference lexically. takes in the compiler, a name and
+// a pointer for the depth. returns the variable, with the depth 0 if this
+// function binds it or 1 if it belongs to an enclosing function, in which
+// case the function's closures capture it. returns NULL if it is global
+Variable *resolve(Compiler *c, char *name, int *depth) {
+    Variable *variable = findVariable(c->names, NULL, name);
+    if (variable != NULL) {
+        *depth = 0;
+        return variable;
+    }
+    *depth = 1;
+    variable = findVariable(c->captured, NULL, name);
+    if (variable != NULL || c->enclosing == NULL) {
+        return variable;
+    }
+    int outerDepth;
+    Variable *outer = resolve(c->enclosing, name, &outerDepth);
+    if (outer == NULL) {
+        return NULL;
+    }
+    Function *f = c->function;
+    if (2 * (f->captureCount + 1) > c->captureCapacity) {
+        f->captures = growArray(f->captures, 2 * f->captureCount, sizeof(intptr_t), &c->captureCapacity);
+    }
+    f->captures[2 * f->captureCount] = outerDepth;
+    f->captures[2 * f->captureCount + 1] = outer->slot;
+    c->captured = addToList(c->captured, name, f->captureCount++, outer->boxed);
+    return car(c->captured)->p;
+}
+
+// emit an instruction that takes a depth and a slot. takes in the compiler,
+// the opcode, the operands and the change to the height of the stack
+void emitSlotOp(Compiler *c, Opcode op, int depth, int slot, int change) {
+    emitWord(c, op);
+    emitWord(c, depth);
+    emitWord(c, slot);
+    adjustDepth(c, change);
+}
+
+// emit the instructions that box the variables a scope just bound, if they
+// need it. takes in the compiler and where the scope's names end
+void boxVariables(Compiler *c, Item *end) {
+    for (Item *names = c->names; names != end; names = cdr(names)) {
+        Variable *variable = car(names)->p;
+        if (variable->boxed) {
+            emit(c, BOX_OP, variable->slot, 0);
+        }
+    }
+}
+
+// find the loop a name calls in the loop bodies being compiled. takes in
+// the compiler and the name, and returns the loop or NULL
+Loop *findLoop(Compiler *c, char *name) {
+    for (Item *loops = c->loops; !isNull(loops); loops = cdr(loops)) {
+        Loop *loop = car(loops)->p;
+        if (loop->name == name) {
+            return loop;
+        }
+    }
+    return NULL;
+}
+
+// compile a variable reference. takes in the compiler, the symbol and the
+// tail flag. a loop's name is only ever called, so any other use of it is
+// left to the tree walker
+void compileReference(Compiler *c, Item *symbol, int tail) {
+    if (findLoop(c, symbol->s) != NULL) {
+        fail(c);
+        return;
+    }
+    int depth;
+    Variable *variable = resolve(c, symbol->s, &depth);
+    if (variable != NULL) {
+        emitSlotOp(c, variable->boxed ? BOX_REF_OP : LOCAL_REF_OP, depth, variable->slot, 1);
+    } else {
+        emit(c, GLOBAL_REF_OP, addGlobalSite(c, symbol->s), 1);
+    }
+    finish(c, tail);
+}
+
+// compile an assignment to a variable of the value on top of the stack.
+// takes in the compiler and the symbol
+void compileAssignment(Compiler *c, Item *symbol) {
+    if (findLoop(c, symbol->s) != NULL) {
+        fail(c);
+        return;
+    }
+    int depth;
+    Variable *variable = resolve(c, symbol->s, &depth);
+    if (variable != NULL) {
+        emitSlotOp(c, variable->boxed ? BOX_SET_OP : LOCAL_SET_OP, depth, variable->slot, -1);
+    } else {
+        emit(c, GLOBAL_SET_OP, addGlobalSite(c, symbol->s), -1);
+    }
+}
+
+// compile a quote expression. takes in the compiler, the arguments and the
+// tail flag
+void compileQuote(Compiler *c, Item *args, int tail) {
+    if (length(args) != 1) {
+        fail(c);
+        return;
+    }
+    emit(c, CONST_OP, addConstant(c, car(args)), 1);
+    finish(c, tail);
+}
+
+// compile an if expression. takes in the compiler, the arguments and the
+// tail flag
+void compileIf(Compiler *c, Item *args, int tail) {
+    if (length(args) != 3) {
+        fail(c);
+        return;
+    }
+    int base = c->depth;
+    compileExpression(c, car(args), 0);
+    int elseJump = emit(c, JUMP_IF_FALSE_OP, 0, -1);
+    compileExpression(c, car(cdr(args)), tail);
+    int endJump = tail ? -1 : emit(c, JUMP_OP, 0, 0);
+    patchJump(c, elseJump);
+    c->depth = base;
+    compileExpression(c, car(cdr(cdr(args))), tail);
+    if (endJump >= 0) {
+        patchJump(c, endJump);
+    }
+}
+
+// compile a cond expression. takes in the compiler, the clauses and the
+// tail flag. a test passes only if it is #t, as in the tree walker
+void compileCond(Compiler *c, Item *clauses, int tail) {
+    int base = c->depth;
+    Item *endJumps = makeNull();
+    while (!isNull(clauses)) {
+        Item *clause = car(clauses);
+        if (clause->type != CONS_TYPE) {
+            fail(c);
+            return;
+        }
+        Item *test = car(clause);
+        if (test->type == SYMBOL_TYPE && strcmp(test->s, "else") == 0) {
+            compileBody(c, cdr(clause), tail, 0);
+            break;
+        }
+        compileExpression(c, test, 0);
+        int nextJump = emit(c, JUMP_UNLESS_TRUE_OP, 0, -1);
+        if (isNull(cdr(clause))) {
+            Item *trueItem = talloc(sizeof(Item));
+            trueItem->type = BOOL_TYPE;
+            trueItem->i = 1;
+            emit(c, CONST_OP, addConstant(c, trueItem), 1);
+            finish(c, tail);
+        } else {
+            compileBody(c, cdr(clause), tail, 0);
+        }
+        if (!tail) {
+            Item *jump = talloc(sizeof(Item));
+            jump->type = INT_TYPE;
+            jump->i = emit(c, JUMP_OP, 0, 0);
+            endJumps = cons(jump, endJumps);
+        }
+        patchJump(c, nextJump);
+        c->depth = base;
+        clauses = cdr(clauses);
+    }
+    if (isNull(clauses)) {
+        emit(c, VOID_OP, 0, 1);
+        finish(c, tail);
+    }
+    while (!isNull(endJumps)) {
+        patchJump(c, car(endJumps)->i);
+        endJumps = cdr(endJumps);
+    }
+    c->depth = base + 1;
+}
+
+// compile an and or an or expression. takes in the compiler, the arguments,
+// the tail flag and the jump that skips the remaining arguments. every
+// argument but the last must be a boolean; the last is in tail position
+void compileAndOr(Compiler *c, Item *args, int tail, Opcode jumpOp) {
+    if (isNull(args)) {
+        Item *value = talloc(sizeof(Item));
+        value->type = BOOL_TYPE;
+        value->i = jumpOp == AND_JUMP_OP;
+        emit(c, CONST_OP, addConstant(c, value), 1);
+        finish(c, tail);
+        return;
+    }
+    int base = c->depth;
+    Item *endJumps = makeNull();
+    while (!isNull(cdr(args))) {
+        compileExpression(c, car(args), 0);
+        Item *jump = talloc(sizeof(Item));
+        jump->type = INT_TYPE;
+        jump->i = emit(c, jumpOp, 0, -1);
+        endJumps = cons(jump, endJumps);
+        args = cdr(args);
+    }
+    compileExpression(c, car(args), tail);
+    // a skipped argument jumps here with its boolean still on the stack,
+    // just as the last argument's value is when it falls through
+    while (!isNull(endJumps)) {
+        patchJump(c, car(endJumps)->i);
+        endJumps = cdr(endJumps);
+    }
+    c->depth = base + 1;
+    finish(c, tail);
+}
+
+// checks a let, let* or letrec binding list, as the tree walker does. takes
+// in the compiler, the list and whether duplicate variables are an error,
+// and returns true if the list is well formed
+int checkBindingList(Compiler *c, Item *bindings, int rejectDuplicates) {
+    if (bindings->type != CONS_TYPE && bindings->type != NULL_TYPE) {
+        fail(c);
+        return 0;
+    }
+    for (Item *current = bindings; !isNull(current); current = cdr(current)) {
+        Item *binding = car(current);
+        if (binding->type != CONS_TYPE || length(binding) != 2 ||
+            car(binding)->type != SYMBOL_TYPE) {
+            fail(c);
+            return 0;
+        }
+        for (Item *inner = bindings; rejectDuplicates && inner != current; inner = cdr(inner)) {
+            if (car(car(inner))->s == car(binding)->s) {
+                fail(c);
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+// start a new scope for a let body. takes in the compiler and returns the
+// state to restore when the scope ends
+Item *enterScope(Compiler *c) {
+    Item *saved = cons(c->names, c->scopeStart);
+    c->scopeStart = c->names;
+    return saved;
+}
+
+// end a scope. takes in the compiler and the state enterScope returned
+void leaveScope(Compiler *c, Item *saved) {
+    c->names = car(saved);
+    c->scopeStart = cdr(saved);
+}
+
+// compile a let expression. takes in the compiler, the arguments and the
+// tail flag. the initial values are all pushed before any variable is
+// bound, then popped into fresh slots of the current environment
+void compileLet(Compiler *c, Item *args, int tail) {
+    if (length(args) < 2 || !checkBindingList(c, car(args), 1)) {
+        fail(c);
+        return;
+    }
+    Item *bindings = car(args);
+    int count = 0;
+    for (Item *b = bindings; !isNull(b); b = cdr(b)) {
+        compileExpression(c, car(cdr(car(b))), 0);
+        count++;
+    }
+    Item *saved = enterScope(c);
+    int firstSlot = c->function->slotCount;
+    for (Item *b = bindings; !isNull(b); b = cdr(b)) {
+        addVariable(c, car(car(b)), needsBox(cdr(args), car(car(b))->s, 0));
+    }
+    for (int i = count - 1; i >= 0; i--) {
+        emitSlotOp(c, LOCAL_SET_OP, 0, firstSlot + i, -1);
+    }
+    boxVariables(c, c->scopeStart);
+    compileBody(c, cdr(args), tail, 1);
+    leaveScope(c, saved);
+}
+
+// compile a named let as a loop. the initial values are pushed, and each
+// iteration starts with a loop instruction followed by the code that pops
+// the values into the variables' slots, so a call of the loop from its
+// body pushes the new values and jumps back there. the expander only
+// leaves a named let in the program where its name is used just that way.
+// takes in the compiler, the arguments and the tail flag, which the body
+// gets, since the loop's value is its body's
+void compileNamedLet(Compiler *c, Item *args, int tail) {
+    if (length(args) < 3 || !checkBindingList(c, car(cdr(args)), 1)) {
+        fail(c);
+        return;
+    }
+    Item *bindings = car(cdr(args));
+    Item *body = cdr(cdr(args));
+    int count = 0;
+    for (Item *b = bindings; !isNull(b); b = cdr(b)) {
+        compileExpression(c, car(cdr(car(b))), 0);
+        count++;
+    }
+    Loop *loop = talloc(sizeof(Loop));
+    loop->name = car(args)->s;
+    loop->start = emit(c, LOOP_OP, 0, 0) - 1;
+    loop->depth = c->depth;
+    loop->count = count;
+
+    Item *saved = enterScope(c);
+    int firstSlot = c->function->slotCount;
+    for (Item *b = bindings; !isNull(b); b = cdr(b)) {
+        if (car(car(b))->s == loop->name) {
+            fail(c);
+            return;
+        }
+        addVariable(c, car(car(b)), needsBox(body, car(car(b))->s, 0));
+    }
+    for (int i = count - 1; i >= 0; i--) {
+        emitSlotOp(c, LOCAL_SET_OP, 0, firstSlot + i, -1);
+    }
+    // a boxed variable gets a new box each iteration, as a new binding
+    boxVariables(c, c->scopeStart);
+    Item *item = talloc(sizeof(Item));
+    item->type = PTR_TYPE;
+    item->p = loop;
+    Item *savedLoops = c->loops;
+    c->loops = cons(item, c->loops);
+    compileBody(c, body, tail, 1);
+    c->loops = savedLoops;
+    leaveScope(c, saved);
+}
+
+// compile a call of a loop from its body: the new values are pushed and
+// the code jumps back to the start of the loop. the call must be in tail
+// position in the body, where the stack is as high as at the start of the
+// body. takes in the compiler, the loop, the call and the tail flag
+void compileLoopCall(Compiler *c, Loop *loop, Item *expr, int tail) {
+    if (length(cdr(expr)) != loop->count || c->depth != loop->depth - loop->count) {
+        fail(c);
+        return;
+    }
+    for (Item *args = cdr(expr); !isNull(args); args = cdr(args)) {
+        compileExpression(c, car(args), 0);
+    }
+    emit(c, JUMP_OP, loop->start, -loop->count);
+    // the code after the jump is never reached, but the stack is accounted
+    // for as though the call had a value like any other expression
+    if (!tail) {
+        adjustDepth(c, 1);
+    }
+}
+
+// compile a let* expression. takes in the compiler, the arguments and the
+// tail flag. each variable is bound before the next initial value
+void compileLetStar(Compiler *c, Item *args, int tail) {
+    if (length(args) < 2 || !checkBindingList(c, car(args), 0)) {
+        fail(c);
+        return;
+    }
+    Item *saved = enterScope(c);
+    for (Item *b = car(args); !isNull(b); b = cdr(b)) {
+        compileExpression(c, car(cdr(car(b))), 0);
+        // each binding is its own scope, so a later one may reuse a name
+        c->scopeStart = c->names;
+        emitSlotOp(c, LOCAL_SET_OP, 0, addVariable(c, car(car(b)), needsBox(args, car(car(b))->s, 0)), -1);
+        boxVariables(c, c->scopeStart);
+    }
+    c->scopeStart = c->names;
+    compileBody(c, cdr(args), tail, 1);
+    leaveScope(c, saved);
+}
+
+// compile a letrec expression. takes in the compiler, the arguments and the
+// tail flag. every variable is in scope while the initial values are
+// evaluated
+void compileLetRec(Compiler *c, Item *args, int tail) {
+    if (length(args) < 2 || !checkBindingList(c, car(args), 0)) {
+        fail(c);
+        return;
+    }
+    Item *saved = enterScope(c);
+    for (Item *b = car(args); !isNull(b); b = cdr(b)) {
+        addVariable(c, car(car(b)), needsBox(args, car(car(b))->s, 1));
+    }
+    boxVariables(c, c->scopeStart);
+    for (Item *b = car(args); !isNull(b); b = cdr(b)) {
+        compileExpression(c, car(cdr(car(b))), 0);
+        compileAssignment(c, car(car(b)));
+    }
+    compileBody(c, cdr(args), tail, 1);
+    leaveScope(c, saved);
+}
+
+// compile a set! expression. takes in the compiler, the arguments and the
+// tail flag
+void compileSet(Compiler *c, Item *args, int tail) {
+    if (length(args) != 2 || car(args)->type != SYMBOL_TYPE) {
+        fail(c);
+        return;
+    }
+    compileExpression(c, car(cdr(args)), 0);
+    compileAssignment(c, car(args));
+    emit(c, VOID_OP, 0, 1);
+    finish(c, tail);
+}
+
+// compile a set-car! or set-cdr! expression. takes in the compiler, the
+// arguments, the tail flag and the instruction that does the mutation
+void compileSetPair(Compiler *c, Item *args, int tail, Opcode op) {
+    if (length(args) != 2) {
+        fail(c);
+        return;
+    }
+    compileExpression(c, car(args), 0);
+    compileExpression(c, car(cdr(args)), 0);
+    emit(c, op, 0, -1);
+    finish(c, tail);
+}
+
+// compile a lambda expression into a nested function. takes in the
+// compiler, the arguments and the tail flag. parameters get the first
+// slots of the new function's environment, a rest parameter the one after.
+// the closure captures the variables of this function, and the ones this
+// function captured, that the nested one uses
+void compileLambda(Compiler *c, Item *args, int tail) {
+    if (length(args) < 2) {
+        fail(c);
+        return;
+    }
+    Compiler *inner = createCompiler(c);
+    Item *params = car(args);
+    while (params->type == CONS_TYPE) {
+        Item *param = car(params);
+        if (param->type != SYMBOL_TYPE || findInScope(inner, param->s) >= 0) {
+            fail(c);
+            return;
+        }
+        addVariable(inner, param, needsBox(cdr(args), param->s, 0));
+        inner->function->paramCount++;
+        params = cdr(params);
+    }
+    if (params->type == SYMBOL_TYPE) {
+        addVariable(inner, params, needsBox(cdr(args), params->s, 0));
+        inner->function->variadic = 1;
+    } else if (params->type != NULL_TYPE) {
+        fail(c);
+        return;
+    }
+    boxVariables(inner, inner->scopeStart);
+    compileBody(inner, cdr(args), 1, 1);
+    if (c->failed) {
+        return;
+    }
+
+    Function *f = c->function;
+    if (f->functionCount == c->functionCapacity) {
+        f->functions = growArray(f->functions, f->functionCount, sizeof(Function *), &c->functionCapacity);
+    }
+    f->functions[f->functionCount] = inner->function;
+    emit(c, MAKE_CLOSURE_OP, f->functionCount++, 1);
+    finish(c, tail);
+}
+
+// compile a delay or delay-force expression: its expression becomes a
+// lambda of no arguments, which the promise calls when it is forced.
+// takes in the compiler, the arguments, the tail flag and whether the
+// promise is made by delay-force
+void compileDelay(Compiler *c, Item *args, int tail, int chained) {
+    if (length(args) != 1) {
+        fail(c);
+        return;
+    }
+    compileLambda(c, cons(makeNull(), args), 0);
+    emit(c, PROMISE_OP, chained, 0);
+    finish(c, tail);
+}
+
+// checks whether an expression is a well-formed (define name value).
+// takes in the expression and returns true if it is
+int isDefinition(Item *expr) {
+    return isForm(expr, "define") && length(cdr(expr)) == 2 &&
+           car(cdr(expr))->type == SYMBOL_TYPE;
+}
+
+// compile a body: a lambda or let body, or a cond clause. takes in the
+// compiler, the list of expressions, the tail flag and whether the body
+// opens a scope of its own. a define at the top level of a lambda or let
+// body binds a slot of that scope; the slots are allocated before the body
+// runs so its expressions can refer to one another, and a name the scope
+// already binds, such as a parameter, reuses its slot. a define anywhere
+// else, or one that shadows an outer binding, is left to the tree walker
+void compileBody(Compiler *c, Item *body, int tail, int definesAllowed) {
+    if (isNull(body)) {
+        fail(c);
+        return;
+    }
+    Item *bodyStart = c->names;
+    for (Item *b = body; !isNull(b); b = cdr(b)) {
+        if (isForm(car(b), "define")) {
+            if (!definesAllowed || !isDefinition(car(b))) {
+                fail(c);
+                return;
+            }
+            char *name = car(cdr(car(b)))->s;
+            if (findInScope(c, name) < 0) {
+                // until a define runs, the tree walker resolves its name
+                // to whatever binding it shadows, while a slot would be
+                // unbound, so shadowing defines stay with the tree walker
+                if (isLocal(c, name) || lookupGlobalCell(name) != NULL) {
+                    fail(c);
+                    return;
+                }
+                addVariable(c, car(cdr(car(b))), needsBox(body, name, 1));
+            }
+        }
+    }
+    boxVariables(c, bodyStart);
+    while (!isNull(body)) {
+        Item *expr = car(body);
+        int last = isNull(cdr(body));
+        if (isForm(expr, "define")) {
+            compileExpression(c, car(cdr(cdr(expr))), 0);
+            compileAssignment(c, car(cdr(expr)));
+            emit(c, VOID_OP, 0, 1);
+            finish(c, tail && last);
+        } else {
+            compileExpression(c, expr, tail && last);
+        }
+        if (!last) {
+            emit(c, POP_OP, 0, -1);
+        }
+        body = cdr(body);
+    }
+}
+
+// compile a call. takes in the compiler, the call expression and the tail
+// flag. the function is pushed, then the arguments left to right
+void compileCall(Compiler *c, Item *expr, int tail) {
+    int argc = 0;
+    compileExpression(c, car(expr), 0);
+    for (Item *args = cdr(expr); !isNull(args); args = cdr(args)) {
+        compileExpression(c, car(args), 0);
+        argc++;
+    }
+    emit(c, tail ? TAIL_CALL_OP : CALL_OP, argc, -argc);
+}
+
+// compile a call through a call site. a site type inference proved is
+// compiled to its operands and the operation on them; any other is called
+// like the symbol it stands for. takes in the compiler, the call and the
+// tail flag
+void compileSiteCall(Compiler *c, Item *expr, int tail) {
+    Item *site = car(expr);
+    if (site->cs.kind != PROVEN_FIXNUM_SITE && site->cs.kind != PROVEN_FLONUM_SITE) {
+        compileCall(c, expr, tail);
+        return;
+    }
+    compileExpression(c, car(cdr(expr)), 0);
+    compileExpression(c, car(cdr(cdr(expr))), 0);
+    emit(c, site->cs.kind == PROVEN_FIXNUM_SITE ? FIXNUM_OP : FLONUM_OP, site->cs.operation, -1);
+    finish(c, tail);
+}
+
+// compile any expression. takes in the compiler, the expression and
+// whether it is in tail position, in which case the code returns its value
+void compileExpression(Compiler *c, Item *expr, int tail) {
+    if (c->failed) {
+        return;
+    }
+    switch (expr->type) {
+        case INT_TYPE:
+        case BIGNUM_TYPE:
+        case VECTOR_TYPE:
+        case DOUBLE_TYPE:
+        case STR_TYPE:
+        case BOOL_TYPE:
+            emit(c, CONST_OP, addConstant(c, expr), 1);
+            finish(c, tail);
+            return;
+        case SYMBOL_TYPE:
+            compileReference(c, expr, tail);
+            return;
+        case CALL_SITE_TYPE:
+            compileReference(c, expr->cs.symbol, tail);
+            return;
+        case CONS_TYPE:
+            break;
+        default:
+            fail(c);
+            return;
+    }
+
+    Item *first = car(expr);
+    Item *args = cdr(expr);
+    if (first->type == SYMBOL_TYPE) {
+        if (strcmp(first->s, "define") == 0) {
+            // only allowed at the top of a body, where compileBody handles it
+            fail(c);
+        } else if (strcmp(first->s, "let") == 0) {
+            if (args->type == CONS_TYPE && car(args)->type == SYMBOL_TYPE) {
+                compileNamedLet(c, args, tail);
+            } else {
+                compileLet(c, args, tail);
+            }
+        } else if (strcmp(first->s, "let*") == 0) {
+            compileLetStar(c, args, tail);
+        } else if (strcmp(first->s, "letrec") == 0) {
+            compileLetRec(c, args, tail);
+        } else if (strcmp(first->s, "set!") == 0) {
+            compileSet(c, args, tail);
+        } else if (strcmp(first->s, "set-car!") == 0) {
+            compileSetPair(c, args, tail, SET_CAR_OP);
+        } else if (strcmp(first->s, "set-cdr!") == 0) {
+            compileSetPair(c, args, tail, SET_CDR_OP);
+        } else if (strcmp(first->s, "lambda") == 0) {
+            compileLambda(c, args, tail);
+        } else if (strcmp(first->s, "delay") == 0) {
+            compileDelay(c, args, tail, 0);
+        } else if (strcmp(first->s, "delay-force") == 0) {
+            compileDelay(c, args, tail, 1);
+        } else if (strcmp(first->s, "cond") == 0) {
+            compileCond(c, args, tail);
+        } else if (strcmp(first->s, "if") == 0) {
+            compileIf(c, args, tail);
+        } else if (strcmp(first->s, "quote") == 0) {
+            compileQuote(c, args, tail);
+        } else if (strcmp(first->s, "and") == 0) {
+            compileAndOr(c, args, tail, AND_JUMP_OP);
+        } else if (strcmp(first->s, "or") == 0) {
+            compileAndOr(c, args, tail, OR_JUMP_OP);
+        } else if (findLoop(c, first->s) != NULL) {
+            compileLoopCall(c, findLoop(c, first->s), expr, tail);
+        } else {
+            compileCall(c, expr, tail);
+        }
+        return;
+    }
+    if (first->type == CALL_SITE_TYPE) {
+        compileSiteCall(c, expr, tail);
+        return;
+    }
+    compileCall(c, expr, tail);
+}
+
+// compile a top-level form into a function of no arguments. takes in the
+// form and returns the function, or NULL if the form cannot be compiled. a
+// define here binds a global; variables bound by a top-level let live in
+// the function's own environment
+Function *compileTopLevel(Item *form) {
+    Compiler *c = createCompiler(NULL);
+    if (isForm(form, "define")) {
+        if (!isDefinition(form)) {
+            return NULL;
+        }
+        compileExpression(c, car(cdr(cdr(form))), 0);
+        emit(c, GLOBAL_DEFINE_OP, addGlobalSite(c, car(cdr(form))->s), -1);
+        emit(c, VOID_OP, 0, 1);
+        finish(c, 1);
+    } else {
+        compileExpression(c, form, 1);
+    }
+    return c->failed ? NULL : c->function;
+}
@@ -0,0 +1,13 @@
+#include "item.h"
+#include "vm.h"
+
+#ifndef COMPILER_H
+#define COMPILER_H
+
+// Compiles one top-level form into a function of no arguments that evaluates
+// it. Returns NULL if the form uses anything the compiler does not handle,
+// including malformed special forms, so that the caller can evaluate it with
+// the tree-walking evaluator instead, which reports errors when they run.
+Function *compileTopLevel(Item *form);
+
+#endif
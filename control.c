@@ -0,0 +1,284 @@
+#include <setjmp.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include "control.h"
+#include "interpreter.h"
+#include "talloc.h"
+
+// the C stack each generator's producer runs on. the memory is only
+// reserved, and pages are used as the stack reaches them. stacks are
+// mapped in chunks, each a single mapping, so that a program with many
+// generators does not run out of the mappings a process may have; the
+// lowest page of a chunk is left unmapped so running off its end faults,
+// and the depth check keeps a producer a margin away from the stack below
+// its own
+#define GENERATOR_STACK_SIZE (16 * 1024 * 1024)
+#define GENERATOR_STACK_MARGIN (1 << 20)
+#define STACKS_PER_CHUNK 16
+#define GUARD_SIZE 4096
+
+// Where an escape continuation escapes to: the call/ec's jump buffer and
+// the heights of the evaluators' stacks when it was called. An escape is
+// active until its call/ec returns, and can only be taken from the
+// generator, or main program, that made it.
+struct Escape {
+    jmp_buf target;
+    Stacks marks;
+    Item *value;
+    int active;
+    struct Generator *owner;
+    struct Escape *next;
+};
+
+typedef struct Escape Escape;
+
+typedef enum {
+    GENERATOR_NEW, GENERATOR_SUSPENDED, GENERATOR_RUNNING, GENERATOR_DONE
+} GeneratorState;
+
+// The state of a generator: its producer, the context the producer runs
+// in and the one that resumed it, the producer's C stack, and, while the
+// producer is suspended, its evaluator stacks, active escapes and stack
+// bounds. While it runs these hold the resumer's instead. value carries a
+// yielded value across a switch.
+struct Generator {
+    GeneratorState state;
+    Item *producer;
+    Item *value;
+    ucontext_t context;
+    ucontext_t caller;
+    char *stack;
+    Stacks stacks;
+    Escape *escapes;
+    char *stackStart;
+    size_t stackBudget;
+    struct Generator *parent;
+};
+
+typedef struct Generator Generator;
+
+// the generator whose producer is running, or NULL for the main program
+Generator *currentGenerator = NULL;
+
+// the escapes whose call/ec has not returned yet, innermost first
+Escape *activeEscapes = NULL;
+
+// the value generators return once their producer has finished
+Item eofObject = {.type = EOF_TYPE};
+
+// the generator stacks not in use, linked through their highest word
+char *freeStacks = NULL;
+
+// implements call/ec and call/cc, whose continuations are escape-only. the
+// continuation is taken with longjmp,
+// which lands back here with the evaluators' stacks cut back to their
+// heights at the call. takes in the procedure to call with the
+// continuation, and returns the procedure's value or the value the
+// continuation was called with
+Item *primitiveCallEc(Item *function) {
+    Escape *escape = talloc(sizeof(Escape));
+    markStacks(&escape->marks);
+    escape->active = 1;
+    escape->owner = currentGenerator;
+    escape->next = activeEscapes;
+    activeEscapes = escape;
+    Item *continuation = talloc(sizeof(Item));
+    continuation->type = CONTINUATION_TYPE;
+    continuation->ec = escape;
+
+    Item *result;
+    if (setjmp(escape->target) == 0) {
+        result = apply(function, 1, &continuation);
+    } else {
+        resetStacks(&escape->marks);
+        result = escape->value;
+    }
+    // an escape past inner call/ecs ends them too
+    for (Escape *e = activeEscapes; e != escape; e = e->next) {
+        e->active = 0;
+    }
+    escape->active = 0;
+    activeEscapes = escape->next;
+    return result;
+}
+
+// take an escape continuation, which is no longer valid once its call/ec
+// or call/cc has returned. takes in the continuation and its argument, and
+// does not return
+void escapeTo(Item *continuation, Item *value) {
+    Escape *escape = continuation->ec;
+    if (!escape->active) {
+        evaluationError("continuation no longer valid: its call/cc has returned");
+    }
+    if (escape->owner != currentGenerator) {
+        evaluationError("continuation called from another generator");
+    }
+    escape->value = value;
+    longjmp(escape->target, 1);
+}
+
+// implements make-generator. takes in the producer and returns the
+// generator, whose producer starts running the first time it is called
+Item *primitiveMakeGenerator(Item *producer) {
+    Generator *generator = talloc(sizeof(Generator));
+    generator->state = GENERATOR_NEW;
+    generator->producer = producer;
+    generator->value = NULL;
+    generator->stack = NULL;
+    generator->stacks = (Stacks){0};
+    generator->escapes = NULL;
+    generator->parent = NULL;
+    Item *item = talloc(sizeof(Item));
+    item->type = GENERATOR_TYPE;
+    item->gn.state = generator;
+    item->gn.yields = 0;
+    return item;
+}
+
+// the entry point of a producer's context. calls the producer of the
+// generator being started with its yield procedure, then marks the
+// generator finished and switches back for good
+void runProducer() {
+    Generator *generator = currentGenerator;
+    Item *yield = talloc(sizeof(Item));
+    yield->type = GENERATOR_TYPE;
+    yield->gn.state = generator;
+    yield->gn.yields = 1;
+    apply(generator->producer, 1, &yield);
+    generator->state = GENERATOR_DONE;
+    generator->value = &eofObject;
+    setcontext(&generator->caller);
+}
+
+// puts a generator stack on the free list. takes in the stack and does
+// not return anything
+void pushFreeStack(char *stack) {
+    *(char **)(stack + GENERATOR_STACK_SIZE - sizeof(char *)) = freeStacks;
+    freeStacks = stack;
+}
+
+// takes a stack for a generator from the free list, mapping a new chunk
+// of them if it is empty. takes in nothing and returns the stack's lowest
+// address
+char *takeStack() {
+    if (freeStacks == NULL) {
+        char *chunk = mmap(NULL, (size_t)GENERATOR_STACK_SIZE * STACKS_PER_CHUNK, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+        if (chunk == MAP_FAILED) {
+            evaluationError("could not allocate a stack for the generator");
+        }
+        mprotect(chunk, GUARD_SIZE, PROT_NONE);
+        for (int i = STACKS_PER_CHUNK - 1; i >= 0; i--) {
+            pushFreeStack(chunk + (size_t)i * GENERATOR_STACK_SIZE);
+        }
+    }
+    char *stack = freeStacks;
+    freeStacks = *(char **)(stack + GENERATOR_STACK_SIZE - sizeof(char *));
+    return stack;
+}
+
+// returns a finished generator's stack to the free list, giving its pages
+// back to the system. takes in the stack and does not return anything
+void releaseStack(char *stack) {
+    madvise(stack + GUARD_SIZE, GENERATOR_STACK_SIZE - GUARD_SIZE, MADV_DONTNEED);
+    pushFreeStack(stack);
+}
+
+// set up the context and stack of a generator's producer. takes in the
+// generator and does not return anything
+void startGenerator(Generator *generator) {
+    generator->stack = takeStack();
+    getcontext(&generator->context);
+    generator->context.uc_stack.ss_sp = generator->stack;
+    generator->context.uc_stack.ss_size = GENERATOR_STACK_SIZE;
+    generator->context.uc_link = NULL;
+    makecontext(&generator->context, runProducer, 0);
+    generator->stackStart = generator->stack + GENERATOR_STACK_SIZE;
+    generator->stackBudget = GENERATOR_STACK_SIZE - GENERATOR_STACK_MARGIN;
+}
+
+// swap the evaluators' state with the one a generator keeps. takes in the
+// generator and does not return anything
+void swapGeneratorState(Generator *generator) {
+    swapStacks(&generator->stacks);
+    swapStackBounds(&generator->stackStart, &generator->stackBudget);
+    Escape *escapes = activeEscapes;
+    activeEscapes = generator->escapes;
+    generator->escapes = escapes;
+}
+
+// call a generator: run its producer until it yields or returns. takes in
+// the generator and returns the value it yielded, or the end of file
+// object once it has returned
+Item *resumeGenerator(Generator *generator) {
+    if (generator->state == GENERATOR_DONE) {
+        return &eofObject;
+    }
+    if (generator->state == GENERATOR_RUNNING) {
+        evaluationError("generator called while it is running");
+    }
+    if (generator->state == GENERATOR_NEW) {
+        startGenerator(generator);
+    }
+    generator->state = GENERATOR_RUNNING;
+    generator->parent = currentGenerator;
+    currentGenerator = generator;
+    swapGeneratorState(generator);
+    swapcontext(&generator->caller, &generator->context);
+    swapGeneratorState(generator);
+    currentGenerator = generator->parent;
+    if (generator->state == GENERATOR_DONE) {
+        releaseStack(generator->stack);
+        generator->stack = NULL;
+        generator->stacks = (Stacks){0};
+    } else {
+        generator->state = GENERATOR_SUSPENDED;
+    }
+    return generator->value;
+}
+
+// yield a value from a producer, switching back to whatever called its
+// generator until the generator is called again. takes in the generator
+// and the value, and returns void
+Item *yieldValue(Generator *generator, Item *value) {
+    if (generator != currentGenerator) {
+        evaluationError("yield called outside its generator's producer");
+    }
+    generator->value = value;
+    swapcontext(&generator->context, &generator->caller);
+    return makeVoid();
+}
+
+// call a continuation, generator or yield procedure. takes in the function
+// and the arguments as a count and a vector, and returns the result
+Item *callControl(Item *function, int argc, Item **argv) {
+    if (function->type == CONTINUATION_TYPE) {
+        if (argc != 1) {
+            evaluationError("a continuation expects one argument");
+        }
+        escapeTo(function, argv[0]);
+    } else if (function->gn.yields) {
+        if (argc != 1) {
+            evaluationError("yield expects one argument");
+        }
+        return yieldValue(function->gn.state, argv[0]);
+    } else if (argc != 0) {
+        evaluationError("a generator expects no arguments");
+    }
+    return resumeGenerator(function->gn.state);
+}
+
+// implements eof-object. takes no arguments and returns the end of file
+// object
+Item *primitiveEofObject(int argc, Item **argv) {
+    return &eofObject;
+}
+
+// implements eof-object?. takes in a value and returns whether it is the
+// end of file object
+Item *primitiveIsEofObject(Item *value) {
+    Item *result = talloc(sizeof(Item));
+    result->type = BOOL_TYPE;
+    result->i = value->type == EOF_TYPE;
+    return result;
+}
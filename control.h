@@ -0,0 +1,30 @@
+#include "item.h"
+
+#ifndef CONTROL_H
+#define CONTROL_H
+
+// Escape continuations and generators. call/ec calls a procedure with a
+// continuation that, when it is called, makes the call/ec return its
+// argument right away, cutting the evaluators' stacks back to where they
+// were instead of unwinding each evaluation in between. call/cc makes the
+// same continuations, so they are escape-only: they only return upward
+// out of a call/cc that has not returned yet, and calling one after that
+// is an error. make-generator takes a producer, a
+// procedure of one argument, and returns a generator; each call of the
+// generator runs the producer until it calls that argument, its yield
+// procedure, with a value for the generator to return, and the next call
+// carries on from there. A producer runs on a C stack and a set of
+// evaluator stacks of its own, so no list of its values is ever built.
+// Once the producer returns, the generator returns the end of file object
+// and its C stack is reused; a generator dropped before then keeps the
+// part of its stack its producer used until the program exits.
+Item *primitiveCallEc(Item *function);
+Item *primitiveMakeGenerator(Item *producer);
+Item *primitiveEofObject(int argc, Item **argv);
+Item *primitiveIsEofObject(Item *value);
+
+// Calls a continuation, a generator or a yield procedure, which apply hands
+// them to. Takes in the function and the arguments as a count and a vector.
+Item *callControl(Item *function, int argc, Item **argv);
+
+#endif
@@ -0,0 +1,1120 @@
+#include <stdio.h>
+#include <string.h>
+#include "expand.h"
+#include "bignum.h"
+#include "linkedlist.h"
+#include "optimizer.h"
+#include "parser.h"
+#include "symtab.h"
+#include "talloc.h"
+
+// A macro defined with syntax-rules: the literals its patterns match by
+// name, its rules as (pattern template) lists, the environment it was
+// defined in, which the identifiers its templates insert refer to, and the
+// names of those identifiers.
+typedef struct {
+    Item *literals;
+    Item *rules;
+    Item *env;
+    Item *templateNames;
+} Macro;
+
+// Environments map identifiers to what they mean. An environment is a list
+// of frames, innermost first, and a frame is a cons cell whose car is a
+// list of (identifier . binding) pairs, so that the defines of a body can
+// be added to its frame after macros defined in the body have captured it.
+// A binding is the symbol a variable is renamed to, or a PTR_TYPE item
+// pointing at a macro.
+
+// the identifiers macro expansions inserted, by name. each is bound to a
+// pair of the identifier in the template it stands for and the
+// environment of the macro that inserted it
+SymbolTable *aliases = NULL;
+
+// how many identifiers have been renamed, to give each a new name
+int aliasCount = 0;
+
+// the most macro uses an expansion may be nested in, each in place of or
+// inside the expansion of the one before, before the expander decides a
+// macro expands into itself forever, and how many the use being expanded
+// is nested in
+#define EXPANSION_LIMIT 1000
+int expansionDepth = 0;
+
+// the forms the evaluators handle specially. an identifier that stands
+// for one of these names means the form wherever it appears, as it does
+// to the evaluators, which never look these names up. do is rewritten
+// into a named let here, cons-stream into a cons of a delay,
+// define-memoized into a define of a call of memoize, and
+// define-record-type into the defines of its type and procedures
+const char *specialForms[] = {
+    "define", "let", "let*", "letrec", "set!", "set-car!", "set-cdr!", "lambda",
+    "cond", "if", "quote", "and", "or", "define-syntax", "do", "delay", "delay-force",
+    "cons-stream", "define-memoized", "define-record-type"
+};
+
+Item *expandExpression(Item *expr, Item *env);
+Item *expandBody(Item *body, Item *env);
+int mentionsSymbol(Item *template, Item *symbol);
+
+// makes a symbol with nothing cached on it. takes in its name
+Item *newSymbol(const char *name) {
+    Item *item = talloc(sizeof(Item));
+    item->type = SYMBOL_TYPE;
+    item->s = intern(name);
+    item->sc.cell = NULL;
+    item->sc.epoch = 0;
+    return item;
+}
+
+// make a new frame holding no bindings on top of an environment
+Item *pushFrame(Item *env) {
+    return cons(cons(makeNull(), makeNull()), env);
+}
+
+// bind an identifier in the innermost frame of an environment. takes in
+// the environment, the identifier and the binding
+void addToFrame(Item *env, Item *identifier, Item *binding) {
+    Item *frame = car(env);
+    frame->c.car = cons(cons(identifier, binding), car(frame));
+}
+
+// find an identifier's binding in an environment, without following
+// aliases. returns NULL if the environment does not bind it
+Item *findInEnvironment(Item *identifier, Item *env) {
+    for (; !isNull(env); env = cdr(env)) {
+        for (Item *b = car(car(env)); !isNull(b); b = cdr(b)) {
+            if (car(car(b))->s == identifier->s) {
+                return cdr(car(b));
+            }
+        }
+    }
+    return NULL;
+}
+
+// find what an identifier means. an identifier a macro inserted that no
+// binding made by the same expansion captured means what the identifier in
+// the template meant where the macro was defined. takes in the identifier
+// and the environment it appears in, and returns its binding, or NULL if
+// it is free and so refers to a global or a special form
+Item *resolveIdentifier(Item *identifier, Item *env) {
+    while (1) {
+        Item *binding = findInEnvironment(identifier, env);
+        if (binding != NULL) {
+            return binding;
+        }
+        Item *alias = tableLookup(aliases, identifier->s);
+        if (alias == NULL) {
+            return NULL;
+        }
+        identifier = car(alias->c.cdr);
+        env = cdr(alias->c.cdr);
+    }
+}
+
+// find the identifier the program's text has for an identifier, following
+// any aliases back to it
+Item *sourceIdentifier(Item *identifier) {
+    Item *alias;
+    while ((alias = tableLookup(aliases, identifier->s)) != NULL) {
+        identifier = car(alias->c.cdr);
+    }
+    return identifier;
+}
+
+int isMacro(Item *binding) {
+    return binding != NULL && binding->type == PTR_TYPE;
+}
+
+// find the special form a form's keyword stands for. takes in the keyword
+// and the environment, and returns the form's name, or NULL if it is not
+// one
+const char *specialFormName(Item *keyword, Item *env) {
+    if (keyword->type != SYMBOL_TYPE || isMacro(resolveIdentifier(keyword, env))) {
+        return NULL;
+    }
+    char *name = sourceIdentifier(keyword)->s;
+    for (size_t i = 0; i < sizeof(specialForms) / sizeof(specialForms[0]); i++) {
+        if (strcmp(name, specialForms[i]) == 0) {
+            return specialForms[i];
+        }
+    }
+    return NULL;
+}
+
+// find the macro a form uses. takes in the form and the environment, and
+// returns the macro, or NULL if the form is not a macro use
+Macro *findMacro(Item *form, Item *env) {
+    if (form->type != CONS_TYPE || car(form)->type != SYMBOL_TYPE) {
+        return NULL;
+    }
+    Item *binding = resolveIdentifier(car(form), env);
+    return isMacro(binding) ? binding->p : NULL;
+}
+
+// checks whether a new variable with a name could capture an identifier
+// that a macro visible in an environment inserts, which it must not: the
+// identifier means what it meant where the macro was defined
+int isCapturable(char *name, Item *env) {
+    for (; !isNull(env); env = cdr(env)) {
+        for (Item *b = car(car(env)); !isNull(b); b = cdr(b)) {
+            if (!isMacro(cdr(car(b)))) {
+                continue;
+            }
+            Macro *macro = cdr(car(b))->p;
+            for (Item *names = macro->templateNames; !isNull(names); names = cdr(names)) {
+                if (car(names)->s == name) {
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+// give a variable a new name. takes in the identifier and returns a symbol
+// of the same name followed by # and a number, which no program can spell
+Item *renameIdentifier(Item *identifier) {
+    char *name = sourceIdentifier(identifier)->s;
+    char *renamed = talloc(strlen(name) + 16);
+    sprintf(renamed, "%s#m%d", name, ++aliasCount);
+    return newSymbol(renamed);
+}
+
+// bind a variable in the innermost frame of an environment. a variable a
+// macro inserted is renamed, so it only captures what the same expansion
+// inserted, and so is one that could capture what a macro inserts. takes
+// in the environment and the identifier, and returns the symbol the
+// variable is known by from now on
+Item *bindVariableName(Item *env, Item *identifier) {
+    Item *name = identifier;
+    if (tableLookup(aliases, identifier->s) != NULL || isCapturable(identifier->s, env)) {
+        name = renameIdentifier(identifier);
+    }
+    addToFrame(env, identifier, name);
+    return newSymbol(name->s);
+}
+
+// replace a variable reference by the symbol the variable is known by.
+// takes in the identifier and the environment, and returns a new symbol
+Item *expandReference(Item *identifier, Item *env) {
+    Item *binding = resolveIdentifier(identifier, env);
+    if (isMacro(binding)) {
+        syntaxError("a macro's keyword is used as a variable");
+    }
+    return newSymbol(binding != NULL ? binding->s : sourceIdentifier(identifier)->s);
+}
+
+// strip the aliases from quoted data, giving back the identifiers the
+// templates had. takes in the datum and returns a copy
+Item *stripAliases(Item *datum) {
+    if (datum->type == SYMBOL_TYPE) {
+        return newSymbol(sourceIdentifier(datum)->s);
+    }
+    if (datum->type != CONS_TYPE) {
+        return datum;
+    }
+    return cons(stripAliases(car(datum)), stripAliases(cdr(datum)));
+}
+
+// expand every expression of a list, its improper tail included. takes in
+// the list and the environment and returns a new list
+Item *expandList(Item *exprs, Item *env) {
+    if (exprs->type != CONS_TYPE) {
+        return exprs->type == NULL_TYPE ? makeNull() : expandExpression(exprs, env);
+    }
+    Item *first = expandExpression(car(exprs), env);
+    return cons(first, expandList(cdr(exprs), env));
+}
+
+// checks whether an item is an identifier or a list of identifiers,
+// proper or not, as lambda parameters are
+int isParameterList(Item *params) {
+    for (; params->type == CONS_TYPE; params = cdr(params)) {
+        if (car(params)->type != SYMBOL_TYPE) {
+            return 0;
+        }
+    }
+    return params->type == SYMBOL_TYPE || params->type == NULL_TYPE;
+}
+
+// checks whether an item is a list of (identifier expression) bindings
+int isBindingList(Item *bindings) {
+    for (; bindings->type == CONS_TYPE; bindings = cdr(bindings)) {
+        Item *binding = car(bindings);
+        if (binding->type != CONS_TYPE || car(binding)->type != SYMBOL_TYPE ||
+            cdr(binding)->type != CONS_TYPE || cdr(cdr(binding))->type != NULL_TYPE) {
+            return 0;
+        }
+    }
+    return bindings->type == NULL_TYPE;
+}
+
+// expand a lambda expression, binding its parameters in a new frame that
+// its body's defines share. takes in the keyword, the rest of the form
+// and the environment
+Item *expandLambda(Item *keyword, Item *args, Item *env) {
+    Item *inner = pushFrame(env);
+    Item *params = makeNull();
+    Item *rest = car(args);
+    for (; rest->type == CONS_TYPE; rest = cdr(rest)) {
+        params = cons(bindVariableName(inner, car(rest)), params);
+    }
+    Item *tail = rest->type == SYMBOL_TYPE ? bindVariableName(inner, rest) : makeNull();
+    for (; !isNull(params); params = cdr(params)) {
+        tail = cons(car(params), tail);
+    }
+    return cons(keyword, cons(tail, expandBody(cdr(args), inner)));
+}
+
+// expand a let, let* or letrec form. takes in the keyword, the rest of the
+// form, the environment and the form's name
+Item *expandLet(Item *keyword, Item *args, Item *env, const char *kind) {
+    Item *inner = pushFrame(env);
+    Item *bindings = makeNull();
+    if (strcmp(kind, "letrec") == 0) {
+        Item *names = makeNull();
+        for (Item *b = car(args); !isNull(b); b = cdr(b)) {
+            names = cons(bindVariableName(inner, car(car(b))), names);
+        }
+        names = reverse(names);
+        for (Item *b = car(args); !isNull(b); b = cdr(b), names = cdr(names)) {
+            bindings = cons(cons(car(names), cons(expandExpression(car(cdr(car(b))), inner), makeNull())),
+                            bindings);
+        }
+    } else {
+        int sequential = strcmp(kind, "let*") == 0;
+        for (Item *b = car(args); !isNull(b); b = cdr(b)) {
+            Item *value = expandExpression(car(cdr(car(b))), sequential ? inner : env);
+            if (sequential) {
+                inner = pushFrame(inner);
+            }
+            Item *name = bindVariableName(inner, car(car(b)));
+            bindings = cons(cons(name, cons(value, makeNull())), bindings);
+        }
+    }
+    return cons(keyword, cons(reverse(bindings), expandBody(cdr(args), inner)));
+}
+
+// expand a cond form. an else that no binding captured stays an else.
+// takes in the keyword, the clauses and the environment
+Item *expandCond(Item *keyword, Item *clauses, Item *env) {
+    Item *expanded = makeNull();
+    for (; clauses->type == CONS_TYPE; clauses = cdr(clauses)) {
+        Item *clause = car(clauses);
+        if (clause->type != CONS_TYPE) {
+            expanded = cons(clause, expanded);
+            continue;
+        }
+        Item *test = car(clause);
+        if (test->type == SYMBOL_TYPE && resolveIdentifier(test, env) == NULL &&
+            strcmp(sourceIdentifier(test)->s, "else") == 0) {
+            test = newSymbol("else");
+        } else {
+            test = expandExpression(test, env);
+        }
+        expanded = cons(cons(test, expandList(cdr(clause), env)), expanded);
+    }
+    return cons(keyword, reverse(expanded));
+}
+
+// make an identifier that means what a name means where nothing is bound,
+// whatever the program binds the name to. the forms a rewrite builds use
+// these for the special forms they need. takes in the name
+Item *coreIdentifier(const char *name) {
+    char *aliasName = talloc(strlen(name) + 16);
+    sprintf(aliasName, "%s#m%d", name, ++aliasCount);
+    Item *symbol = newSymbol(aliasName);
+    tableDefine(aliases, symbol->s, cons(newSymbol(name), makeNull()));
+    return symbol;
+}
+
+int isLoopExpression(Item *expr, Item *name, Item *vars, int tail);
+
+// checks isLoopExpression for each expression of a list, of which only the
+// last can be in tail position. takes in the list, the loop's name and
+// variables, and whether the list ends in tail position
+int isLoopSequence(Item *exprs, Item *name, Item *vars, int tail) {
+    for (; exprs->type == CONS_TYPE; exprs = cdr(exprs)) {
+        if (!isLoopExpression(car(exprs), name, vars, tail && cdr(exprs)->type == NULL_TYPE)) {
+            return 0;
+        }
+    }
+    return exprs->type != SYMBOL_TYPE || exprs->s != name->s;
+}
+
+// checks whether the binders of a let form leave a loop's name alone, and
+// its initial values and body pass isLoopExpression. takes in the let
+// form's arguments, the loop's name and variables, and the tail flag
+int isLoopLet(Item *args, Item *name, Item *vars, int tail) {
+    if (args->type != CONS_TYPE) {
+        return isLoopSequence(args, name, vars, 0);
+    }
+    if (car(args)->type == SYMBOL_TYPE) {
+        if (car(args)->s == name->s || cdr(args)->type != CONS_TYPE) {
+            return 0;
+        }
+        args = cdr(args);
+    }
+    for (Item *b = car(args); b->type == CONS_TYPE; b = cdr(b)) {
+        Item *binding = car(b);
+        if (binding->type == CONS_TYPE && car(binding)->type == SYMBOL_TYPE &&
+            car(binding)->s == name->s) {
+            return 0;
+        }
+        if (binding->type == CONS_TYPE && !isLoopSequence(cdr(binding), name, vars, 0)) {
+            return 0;
+        }
+    }
+    return isLoopSequence(cdr(args), name, vars, tail);
+}
+
+// checks whether every use of a named let's name in an expression of its
+// body can jump back to the start of the loop: each is the head of a call
+// with one argument per variable, in tail position in the body. a lambda
+// that mentions the name or the variables rules the loop out, since every
+// iteration reuses the variables' bindings. takes in the expression, the
+// loop's name and variables, and whether the expression is in tail
+// position in the body
+int isLoopExpression(Item *expr, Item *name, Item *vars, int tail) {
+    if (expr->type == SYMBOL_TYPE) {
+        return expr->s != name->s;
+    }
+    if (expr->type != CONS_TYPE) {
+        return 1;
+    }
+    Item *head = car(expr);
+    Item *args = cdr(expr);
+    if (head->type != SYMBOL_TYPE) {
+        return isLoopSequence(expr, name, vars, 0);
+    }
+    if (head->s == name->s) {
+        return tail && isProperList(args) && length(args) == length(vars) &&
+               isLoopSequence(args, name, vars, 0);
+    }
+    if (strcmp(head->s, "quote") == 0) {
+        return 1;
+    } else if (strcmp(head->s, "lambda") == 0 || strcmp(head->s, "delay") == 0 ||
+               strcmp(head->s, "delay-force") == 0 || strcmp(head->s, "cons-stream") == 0) {
+        // a delayed expression runs later, like a lambda body
+        for (Item *v = vars; !isNull(v); v = cdr(v)) {
+            if (mentionsSymbol(args, car(v))) {
+                return 0;
+            }
+        }
+        return !mentionsSymbol(args, name);
+    } else if (strcmp(head->s, "if") == 0) {
+        if (args->type != CONS_TYPE || !isLoopExpression(car(args), name, vars, 0)) {
+            return args->type != CONS_TYPE;
+        }
+        for (Item *branches = cdr(args); branches->type == CONS_TYPE; branches = cdr(branches)) {
+            if (!isLoopExpression(car(branches), name, vars, tail)) {
+                return 0;
+            }
+        }
+        return 1;
+    } else if (strcmp(head->s, "cond") == 0) {
+        for (; args->type == CONS_TYPE; args = cdr(args)) {
+            Item *clause = car(args);
+            if (clause->type == CONS_TYPE &&
+                (!isLoopExpression(car(clause), name, vars, 0) ||
+                 !isLoopSequence(cdr(clause), name, vars, tail))) {
+                return 0;
+            }
+        }
+        return 1;
+    } else if (strcmp(head->s, "and") == 0 || strcmp(head->s, "or") == 0) {
+        return isLoopSequence(args, name, vars, tail);
+    } else if (strcmp(head->s, "let") == 0 || strcmp(head->s, "let*") == 0 ||
+               strcmp(head->s, "letrec") == 0) {
+        return isLoopLet(args, name, vars, tail);
+    }
+    return isLoopSequence(expr, name, vars, 0);
+}
+
+// expand a named let. the initial values are outside the scope of the
+// loop's name, which is outside the scope of the variables. where every
+// use of the name passes isLoopExpression, the form stays a named let,
+// which the evaluators run as a loop over the same bindings; otherwise it
+// becomes ((letrec ((name (lambda (var ...) body ...))) name) init ...).
+// takes in the keyword, the rest of the form and the environment
+Item *expandNamedLet(Item *keyword, Item *args, Item *env) {
+    Item *inits = makeNull();
+    for (Item *b = car(cdr(args)); !isNull(b); b = cdr(b)) {
+        inits = cons(expandExpression(car(cdr(car(b))), env), inits);
+    }
+    Item *outer = pushFrame(env);
+    Item *name = bindVariableName(outer, car(args));
+    Item *inner = pushFrame(outer);
+    Item *vars = makeNull();
+    for (Item *b = car(cdr(args)); !isNull(b); b = cdr(b)) {
+        vars = cons(bindVariableName(inner, car(car(b))), vars);
+    }
+    vars = reverse(vars);
+    Item *body = expandBody(cdr(cdr(args)), inner);
+
+    int isLoop = 1;
+    for (Item *forms = body; !isNull(forms); forms = cdr(forms)) {
+        isLoop = isLoop && !isSpecialForm(car(forms), "define");
+    }
+    for (Item *v = vars; !isNull(v); v = cdr(v)) {
+        isLoop = isLoop && car(v)->s != name->s;
+    }
+    if (isLoop && isLoopSequence(body, name, vars, 1)) {
+        Item *bindings = makeNull();
+        for (inits = reverse(inits); !isNull(inits); inits = cdr(inits), vars = cdr(vars)) {
+            bindings = cons(cons(car(vars), cons(car(inits), makeNull())), bindings);
+        }
+        return cons(keyword, cons(name, cons(reverse(bindings), body)));
+    }
+    Item *lambda = cons(newSymbol("lambda"), cons(vars, body));
+    Item *binding = cons(newSymbol(name->s), cons(lambda, makeNull()));
+    Item *letrec = cons(newSymbol("letrec"), cons(cons(binding, makeNull()),
+                                                  cons(newSymbol(name->s), makeNull())));
+    return cons(letrec, reverse(inits));
+}
+
+// expand a do loop by rewriting it as the named let
+// (let loop ((var init) ...)
+//   (cond (test result ...)
+//         (else command ... (loop step ...))))
+// where a variable without a step keeps its value, and a test without
+// results gets the result (cond), which is void. the rewrite's own
+// identifiers are core identifiers, so no binding in the program captures
+// them. takes in the rest of the form and the environment
+Item *expandDo(Item *args, Item *env) {
+    if (!isProperList(args) || length(args) < 2 || !isProperList(car(args)) ||
+        car(cdr(args))->type != CONS_TYPE || !isProperList(car(cdr(args)))) {
+        syntaxError("do expects a list of variables, a test clause and a body");
+    }
+    Item *loop = coreIdentifier("do-loop");
+    Item *bindings = makeNull();
+    Item *steps = makeNull();
+    for (Item *specs = car(args); !isNull(specs); specs = cdr(specs)) {
+        Item *spec = car(specs);
+        if (spec->type != CONS_TYPE || car(spec)->type != SYMBOL_TYPE || !isProperList(spec) ||
+            length(spec) < 2 || length(spec) > 3) {
+            syntaxError("a do variable must have an initial value and at most one step");
+        }
+        bindings = cons(cons(car(spec), cons(car(cdr(spec)), makeNull())), bindings);
+        steps = cons(length(spec) == 3 ? car(cdr(cdr(spec))) : car(spec), steps);
+    }
+    Item *next = cons(loop, reverse(steps));
+    Item *commands = cons(next, makeNull());
+    for (Item *body = reverse(cdr(cdr(args))); !isNull(body); body = cdr(body)) {
+        commands = cons(car(body), commands);
+    }
+    Item *elseClause = cons(coreIdentifier("else"), commands);
+    Item *testClause = car(cdr(args));
+    if (isNull(cdr(testClause))) {
+        testClause = cons(car(testClause), cons(cons(coreIdentifier("cond"), makeNull()), makeNull()));
+    }
+    Item *cond = cons(coreIdentifier("cond"), cons(testClause, cons(elseClause, makeNull())));
+    return expandExpression(cons(coreIdentifier("let"),
+                                 cons(loop, cons(reverse(bindings), cons(cond, makeNull())))), env);
+}
+
+// rewrite a cons-stream form, (cons-stream a b), into (cons a (delay b)),
+// so the rest of the stream is only computed when it is forced. as in
+// SICP, cons is whatever the name means where the form is. takes in the
+// rest of the form and the environment
+Item *expandConsStream(Item *args, Item *env) {
+    if (!isProperList(args) || length(args) != 2) {
+        syntaxError("cons-stream expects two expressions");
+    }
+    Item *rest = cons(coreIdentifier("delay"), cdr(args));
+    return expandExpression(cons(newSymbol("cons"), cons(car(args), cons(rest, makeNull()))), env);
+}
+
+// rewrite a define-memoized form, (define-memoized name procedure), into
+// (define name (memoize procedure)), so calls of the name, the recursive
+// ones in the procedure's body included, go through the memo table. as
+// with cons-stream, memoize is whatever the name means where the form is.
+// takes in the rest of the form and returns the define, to be expanded as
+// one
+Item *expandDefineMemoized(Item *args) {
+    if (!isProperList(args) || length(args) != 2 || car(args)->type != SYMBOL_TYPE) {
+        syntaxError("define-memoized expects a name and a procedure");
+    }
+    Item *call = cons(newSymbol("memoize"), cdr(args));
+    return cons(coreIdentifier("define"), cons(car(args), cons(call, makeNull())));
+}
+
+// quote a datum with the quote the program cannot rebind. takes in the
+// datum and returns the quotation
+Item *quoteDatum(Item *datum) {
+    return cons(coreIdentifier("quote"), cons(datum, makeNull()));
+}
+
+// make a define of a name as a call of a record procedure. takes in the
+// name, the procedure's name and the rest of the call and returns the
+// define
+Item *recordDefinition(Item *name, const char *procedure, Item *args) {
+    Item *call = cons(coreIdentifier(procedure), args);
+    return cons(coreIdentifier("define"), cons(name, cons(call, makeNull())));
+}
+
+// rewrite a define-record-type form,
+//   (define-record-type type (constructor field ...) predicate
+//     (field accessor [modifier]) ...),
+// into defines of the type, as a call of make-record-type, and of each of
+// its procedures, as a call of record-constructor, record-predicate,
+// record-accessor or record-modifier on the type, which checks the field
+// names the procedure was given against the type's. the procedures are
+// passed their names to report errors with. takes in the rest of the form
+// and returns the list of defines, to be expanded as if each were in the
+// body in its place
+Item *expandDefineRecordType(Item *args) {
+    if (!isProperList(args) || length(args) < 3 || car(args)->type != SYMBOL_TYPE) {
+        syntaxError("define-record-type expects a type name, a constructor, a predicate and fields");
+    }
+    Item *type = car(args);
+    Item *constructor = car(cdr(args));
+    Item *predicate = car(cdr(cdr(args)));
+    if (constructor->type != CONS_TYPE || !isProperList(constructor) ||
+        car(constructor)->type != SYMBOL_TYPE) {
+        syntaxError("define-record-type expects a constructor of the form (name field ...)");
+    }
+    if (predicate->type != SYMBOL_TYPE) {
+        syntaxError("define-record-type expects a predicate name");
+    }
+    Item *fields = makeNull();
+    Item *procedures = makeNull();
+    for (Item *specs = cdr(cdr(cdr(args))); !isNull(specs); specs = cdr(specs)) {
+        Item *spec = car(specs);
+        if (!isProperList(spec) || (length(spec) != 2 && length(spec) != 3) ||
+            car(spec)->type != SYMBOL_TYPE || car(cdr(spec))->type != SYMBOL_TYPE ||
+            (length(spec) == 3 && car(cdr(cdr(spec)))->type != SYMBOL_TYPE)) {
+            syntaxError("define-record-type expects fields of the form (field accessor [modifier])");
+        }
+        Item *field = car(spec);
+        fields = cons(field, fields);
+        Item *accessor = car(cdr(spec));
+        Item *rest = cons(quoteDatum(accessor), cons(quoteDatum(field), makeNull()));
+        procedures = cons(recordDefinition(accessor, "record-accessor", cons(type, rest)), procedures);
+        if (length(spec) == 3) {
+            Item *modifier = car(cdr(cdr(spec)));
+            rest = cons(quoteDatum(modifier), cons(quoteDatum(field), makeNull()));
+            procedures = cons(recordDefinition(modifier, "record-modifier", cons(type, rest)), procedures);
+        }
+    }
+    Item *rest = cons(quoteDatum(car(constructor)), cons(quoteDatum(cdr(constructor)), makeNull()));
+    procedures = cons(recordDefinition(car(constructor), "record-constructor", cons(type, rest)), procedures);
+    rest = cons(quoteDatum(predicate), makeNull());
+    procedures = cons(recordDefinition(predicate, "record-predicate", cons(type, rest)), procedures);
+    rest = cons(quoteDatum(type), cons(quoteDatum(reverse(fields)), makeNull()));
+    return cons(recordDefinition(type, "make-record-type", rest), reverse(procedures));
+}
+
+// checks whether a form is a define-record-type, whatever identifier stands
+// for define-record-type in it
+int isRecordDefinition(Item *form, Item *env) {
+    const char *name = form->type == CONS_TYPE ? specialFormName(car(form), env) : NULL;
+    return name != NULL && strcmp(name, "define-record-type") == 0;
+}
+
+// put a list of forms in front of the rest of a body. takes in the forms
+// and the rest and returns the body
+Item *spliceForms(Item *forms, Item *rest) {
+    Item *body = rest;
+    for (forms = reverse(forms); !isNull(forms); forms = cdr(forms)) {
+        body = cons(car(forms), body);
+    }
+    return body;
+}
+
+// The macro expander proper: patterns are matched against a use, and the
+// matching rule's template is instantiated with what the pattern variables
+// matched. Pattern variables are bound in a list of (name depth . value)
+// entries, where a variable under n ellipses has depth n and a value that
+// is a list of the values of depth n - 1 it matched.
+
+// checks whether an item is the ellipsis identifier
+int isEllipsis(Item *item) {
+    return item->type == SYMBOL_TYPE && strcmp(item->s, "...") == 0;
+}
+
+// checks whether a pattern symbol is one of a macro's literals
+int isMacroLiteral(Macro *macro, Item *symbol) {
+    for (Item *l = macro->literals; !isNull(l); l = cdr(l)) {
+        if (car(l)->s == symbol->s) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// checks whether a symbol is a pattern variable of a pattern
+int isPatternVariable(Macro *macro, Item *symbol) {
+    return !isEllipsis(symbol) && strcmp(symbol->s, "_") != 0 && !isMacroLiteral(macro, symbol);
+}
+
+// collect the pattern variables of a pattern with their depths. takes in
+// the macro, the pattern, the depth it is at and the list so far, and
+// returns the list of (name . depth) pairs
+Item *patternVariables(Macro *macro, Item *pattern, int depth, Item *vars) {
+    if (pattern->type == SYMBOL_TYPE) {
+        if (isPatternVariable(macro, pattern)) {
+            Item *count = talloc(sizeof(Item));
+            count->type = INT_TYPE;
+            count->i = depth;
+            vars = cons(cons(pattern, count), vars);
+        }
+        return vars;
+    }
+    if (pattern->type != CONS_TYPE) {
+        return vars;
+    }
+    int repeated = cdr(pattern)->type == CONS_TYPE && isEllipsis(car(cdr(pattern)));
+    vars = patternVariables(macro, car(pattern), depth + repeated, vars);
+    return patternVariables(macro, repeated ? cdr(cdr(pattern)) : cdr(pattern), depth, vars);
+}
+
+// find a pattern variable's entry in a list of bindings, or NULL
+Item *findPatternBinding(Item *binds, Item *symbol) {
+    for (; !isNull(binds); binds = cdr(binds)) {
+        if (car(car(binds))->s == symbol->s) {
+            return car(binds);
+        }
+    }
+    return NULL;
+}
+
+// add a pattern variable's binding to a list of bindings
+Item *addPatternBinding(Item *binds, Item *symbol, int depth, Item *value) {
+    Item *count = talloc(sizeof(Item));
+    count->type = INT_TYPE;
+    count->i = depth;
+    return cons(cons(symbol, cons(count, value)), binds);
+}
+
+// checks whether an identifier in a use matches a literal, which it does
+// when both mean the same thing where they appear
+int matchesLiteral(Item *form, Item *literal, Macro *macro, Item *env) {
+    if (form->type != SYMBOL_TYPE) {
+        return 0;
+    }
+    Item *formBinding = resolveIdentifier(form, env);
+    Item *literalBinding = resolveIdentifier(literal, macro->env);
+    if (formBinding == NULL && literalBinding == NULL) {
+        return sourceIdentifier(form)->s == sourceIdentifier(literal)->s;
+    }
+    return formBinding == literalBinding;
+}
+
+// checks whether two literal data are the same
+int isSameDatum(Item *a, Item *b) {
+    if (a->type != b->type) {
+        return 0;
+    }
+    switch (a->type) {
+        case INT_TYPE:
+        case BOOL_TYPE:
+            return a->i == b->i;
+        case BIGNUM_TYPE:
+            return integerCompare(a, b) == 0;
+        case DOUBLE_TYPE:
+            return a->d == b->d;
+        case STR_TYPE:
+            return strcmp(a->s, b->s) == 0;
+        case NULL_TYPE:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// match a form against a pattern. takes in the macro, the pattern, the
+// form, the environment of the use and a pointer to the bindings so far,
+// which it adds to, and returns whether the form matches
+int matchPattern(Macro *macro, Item *pattern, Item *form, Item *env, Item **binds) {
+    if (pattern->type == SYMBOL_TYPE) {
+        if (isMacroLiteral(macro, pattern)) {
+            return matchesLiteral(form, pattern, macro, env);
+        }
+        if (strcmp(pattern->s, "_") != 0) {
+            *binds = addPatternBinding(*binds, pattern, 0, form);
+        }
+        return 1;
+    }
+    if (pattern->type != CONS_TYPE) {
+        return isSameDatum(pattern, form);
+    }
+    if (cdr(pattern)->type == CONS_TYPE && isEllipsis(car(cdr(pattern)))) {
+        Item *after = cdr(cdr(pattern));
+        int count = 0;
+        for (Item *f = form; f->type == CONS_TYPE; f = cdr(f)) {
+            count++;
+        }
+        count -= length(after);
+        if (count < 0) {
+            return 0;
+        }
+        Item *vars = patternVariables(macro, car(pattern), 0, makeNull());
+        Item *matches = makeNull();
+        for (int i = 0; i < count; i++, form = cdr(form)) {
+            Item *inner = makeNull();
+            if (!matchPattern(macro, car(pattern), car(form), env, &inner)) {
+                return 0;
+            }
+            matches = cons(inner, matches);
+        }
+        for (; !isNull(vars); vars = cdr(vars)) {
+            Item *values = makeNull();
+            for (Item *m = matches; !isNull(m); m = cdr(m)) {
+                values = cons(cdr(cdr(findPatternBinding(car(m), car(car(vars))))), values);
+            }
+            *binds = addPatternBinding(*binds, car(car(vars)), cdr(car(vars))->i + 1, values);
+        }
+        return matchPattern(macro, after, form, env, binds);
+    }
+    return form->type == CONS_TYPE && matchPattern(macro, car(pattern), car(form), env, binds) &&
+           matchPattern(macro, cdr(pattern), cdr(form), env, binds);
+}
+
+// checks whether a template mentions a symbol
+int mentionsSymbol(Item *template, Item *symbol) {
+    if (template->type == SYMBOL_TYPE) {
+        return template->s == symbol->s;
+    }
+    return template->type == CONS_TYPE &&
+           (mentionsSymbol(car(template), symbol) || mentionsSymbol(cdr(template), symbol));
+}
+
+Item *instantiate(Item *template, Item *binds, Item **inserted, Macro *macro, int ellipses);
+
+// instantiate a template followed by some number of ellipses once for
+// each of the values its pattern variables matched. takes in the template,
+// the number of ellipses, the bindings, the identifiers inserted so far
+// and the macro, and returns the list of instances
+Item *instantiateRepeated(Item *template, int repeats, Item *binds, Item **inserted, Macro *macro) {
+    if (repeats == 0) {
+        return cons(instantiate(template, binds, inserted, macro, 1), makeNull());
+    }
+    Item *driving = makeNull();
+    int count = -1;
+    for (Item *b = binds; !isNull(b); b = cdr(b)) {
+        Item *entry = car(b);
+        if (car(cdr(entry))->i > 0 && findPatternBinding(driving, car(entry)) == NULL &&
+            findPatternBinding(binds, car(entry)) == entry && mentionsSymbol(template, car(entry))) {
+            int values = length(cdr(cdr(entry)));
+            if (count >= 0 && values != count) {
+                syntaxError("pattern variables under the same ellipsis matched different numbers of forms");
+            }
+            count = values;
+            driving = cons(entry, driving);
+        }
+    }
+    if (isNull(driving)) {
+        syntaxError("a template ellipsis follows no pattern variable that an ellipsis followed");
+    }
+    Item *instances = makeNull();
+    for (int i = 0; i < count; i++) {
+        Item *iteration = binds;
+        for (Item *d = driving; !isNull(d); d = cdr(d)) {
+            Item *values = cdr(cdr(car(d)));
+            for (int j = 0; j < i; j++) {
+                values = cdr(values);
+            }
+            iteration = addPatternBinding(iteration, car(car(d)), car(cdr(car(d)))->i - 1, car(values));
+        }
+        Item *more = instantiateRepeated(template, repeats - 1, iteration, inserted, macro);
+        for (; !isNull(more); more = cdr(more)) {
+            instances = cons(car(more), instances);
+        }
+    }
+    return reverse(instances);
+}
+
+// instantiate a template. pattern variables are replaced by what they
+// matched, and every other identifier by an alias for it, the same alias
+// throughout one expansion. takes in the template, the bindings, a pointer
+// to the list of (identifier . alias) pairs made so far, the macro, and
+// whether ellipses are special, which (... template) turns off
+Item *instantiate(Item *template, Item *binds, Item **inserted, Macro *macro, int ellipses) {
+    if (template->type == SYMBOL_TYPE) {
+        Item *entry = findPatternBinding(binds, template);
+        if (entry != NULL) {
+            if (car(cdr(entry))->i != 0) {
+                syntaxError("a pattern variable is used with too few ellipses");
+            }
+            return cdr(cdr(entry));
+        }
+        Item *alias = findPatternBinding(*inserted, template);
+        if (alias != NULL) {
+            return cdr(alias);
+        }
+        char *name = talloc(strlen(template->s) + 16);
+        sprintf(name, "%s#m%d", sourceIdentifier(template)->s, ++aliasCount);
+        Item *symbol = newSymbol(name);
+        tableDefine(aliases, symbol->s, cons(template, macro->env));
+        *inserted = cons(cons(template, symbol), *inserted);
+        return symbol;
+    }
+    if (template->type != CONS_TYPE) {
+        return template;
+    }
+    if (ellipses && isEllipsis(car(template)) && cdr(template)->type == CONS_TYPE) {
+        return instantiate(car(cdr(template)), binds, inserted, macro, 0);
+    }
+    if (ellipses && cdr(template)->type == CONS_TYPE && isEllipsis(car(cdr(template)))) {
+        int repeats = 0;
+        Item *rest = cdr(template);
+        for (; rest->type == CONS_TYPE && isEllipsis(car(rest)); rest = cdr(rest)) {
+            repeats++;
+        }
+        Item *instances = instantiateRepeated(car(template), repeats, binds, inserted, macro);
+        Item *tail = instantiate(rest, binds, inserted, macro, ellipses);
+        for (instances = reverse(instances); !isNull(instances); instances = cdr(instances)) {
+            tail = cons(car(instances), tail);
+        }
+        return tail;
+    }
+    return cons(instantiate(car(template), binds, inserted, macro, ellipses),
+                instantiate(cdr(template), binds, inserted, macro, ellipses));
+}
+
+// expand one use of a macro by its first rule whose pattern matches. the
+// keyword at the head of a pattern is not matched. takes in the macro, the
+// use and its environment, and returns the expansion
+Item *expandMacroUse(Macro *macro, Item *form, Item *env) {
+    for (Item *rules = macro->rules; !isNull(rules); rules = cdr(rules)) {
+        Item *binds = makeNull();
+        Item *pattern = car(car(rules));
+        if (matchPattern(macro, cdr(pattern), cdr(form), env, &binds)) {
+            Item *inserted = makeNull();
+            return instantiate(car(cdr(car(rules))), binds, &inserted, macro, 1);
+        }
+    }
+    char *keyword = sourceIdentifier(car(form))->s;
+    char *message = talloc(strlen(keyword) + 64);
+    sprintf(message, "no syntax-rules pattern matches this use of %s", keyword);
+    syntaxError(message);
+    return NULL;
+}
+
+// collect the identifiers a template inserts, those that are not pattern
+// variables. takes in the macro, the template, the pattern's variables and
+// the list so far, and returns the list
+Item *collectTemplateNames(Macro *macro, Item *template, Item *vars, Item *names) {
+    if (template->type == SYMBOL_TYPE) {
+        if (!isEllipsis(template) && findPatternBinding(vars, template) == NULL) {
+            names = cons(sourceIdentifier(template), names);
+        }
+        return names;
+    }
+    if (template->type != CONS_TYPE) {
+        return names;
+    }
+    names = collectTemplateNames(macro, car(template), vars, names);
+    return collectTemplateNames(macro, cdr(template), vars, names);
+}
+
+// make a macro from a syntax-rules form. takes in the form and the
+// environment it is defined in, and returns the macro
+Macro *makeMacro(Item *spec, Item *env) {
+    const char *name = spec->type == CONS_TYPE ? specialFormName(car(spec), env) : NULL;
+    if (!(spec->type == CONS_TYPE && car(spec)->type == SYMBOL_TYPE &&
+          strcmp(sourceIdentifier(car(spec))->s, "syntax-rules") == 0 && name == NULL &&
+          cdr(spec)->type == CONS_TYPE && isParameterList(car(cdr(spec))) &&
+          car(cdr(spec))->type != SYMBOL_TYPE)) {
+        syntaxError("define-syntax expects a syntax-rules form with a list of literals");
+    }
+    Macro *macro = talloc(sizeof(Macro));
+    macro->literals = car(cdr(spec));
+    macro->rules = cdr(cdr(spec));
+    macro->env = env;
+    macro->templateNames = makeNull();
+    for (Item *rules = macro->rules; rules->type == CONS_TYPE; rules = cdr(rules)) {
+        Item *rule = car(rules);
+        if (rule->type != CONS_TYPE || length(rule) != 2 || cdr(cdr(rule))->type != NULL_TYPE ||
+            car(rule)->type != CONS_TYPE) {
+            syntaxError("a syntax-rules rule must be a pattern list and a template");
+        }
+        Item *vars = patternVariables(macro, cdr(car(rule)), 0, makeNull());
+        macro->templateNames = collectTemplateNames(macro, car(cdr(rule)), vars, macro->templateNames);
+    }
+    if (macro->rules->type != CONS_TYPE && macro->rules->type != NULL_TYPE) {
+        syntaxError("a syntax-rules rule must be a pattern list and a template");
+    }
+    return macro;
+}
+
+// define a macro in the innermost frame of an environment. takes in the
+// define-syntax form and the environment, and the keyword to bind it to
+void defineMacro(Item *form, Item *env, Item *keyword) {
+    Item *args = cdr(form);
+    if (length(form) != 3 || cdr(cdr(args))->type != NULL_TYPE || car(args)->type != SYMBOL_TYPE) {
+        syntaxError("define-syntax expects a keyword and a syntax-rules form");
+    }
+    Item *binding = talloc(sizeof(Item));
+    binding->type = PTR_TYPE;
+    binding->p = makeMacro(car(cdr(args)), env);
+    addToFrame(env, keyword, binding);
+}
+
+// expand a macro use nested in the expansions of others, counting it
+// against the expansion limit, and report an error naming the macro once
+// the limit is passed. takes in the macro, the use and the environment, and
+// returns the expansion
+Item *expandNestedUse(Macro *macro, Item *form, Item *env) {
+    if (++expansionDepth > EXPANSION_LIMIT) {
+        char *keyword = sourceIdentifier(car(form))->s;
+        char *message = talloc(strlen(keyword) + 96);
+        sprintf(message, "expanding %s nested more than %d macro uses; it may expand into itself forever",
+                keyword, EXPANSION_LIMIT);
+        syntaxError(message);
+    }
+    return expandMacroUse(macro, form, env);
+}
+
+// expand the uses of macros at the head of a form until it is no longer
+// one. takes in the form and the environment and returns the form
+Item *expandHead(Item *form, Item *env) {
+    Macro *macro;
+    int depth = expansionDepth;
+    while ((macro = findMacro(form, env)) != NULL) {
+        form = expandNestedUse(macro, form, env);
+    }
+    expansionDepth = depth;
+    const char *name = form->type == CONS_TYPE ? specialFormName(car(form), env) : NULL;
+    if (name != NULL && strcmp(name, "define-memoized") == 0) {
+        return expandDefineMemoized(cdr(form));
+    }
+    return form;
+}
+
+// checks whether a form is a define of a variable, whatever identifier
+// stands for define in it
+int isVariableDefinition(Item *form, Item *env) {
+    const char *name = form->type == CONS_TYPE ? specialFormName(car(form), env) : NULL;
+    return name != NULL && strcmp(name, "define") == 0 && length(form) == 3 &&
+           cdr(cdr(cdr(form)))->type == NULL_TYPE && car(cdr(form))->type == SYMBOL_TYPE;
+}
+
+int isMacroDefinition(Item *form, Item *env) {
+    const char *name = form->type == CONS_TYPE ? specialFormName(car(form), env) : NULL;
+    return name != NULL && strcmp(name, "define-syntax") == 0;
+}
+
+// expand a body. macros its define-syntax forms define are visible in the
+// rest of the body, and the variables its defines bind in the whole of it,
+// as the evaluators bind them up front. takes in the body and the
+// environment, whose innermost frame is the body's, and returns the body
+Item *expandBody(Item *body, Item *env) {
+    Item *forms = makeNull();
+    while (body->type == CONS_TYPE) {
+        Item *form = expandHead(car(body), env);
+        body = cdr(body);
+        if (isRecordDefinition(form, env)) {
+            body = spliceForms(expandDefineRecordType(cdr(form)), body);
+        } else if (isMacroDefinition(form, env)) {
+            defineMacro(form, env, car(cdr(form)));
+        } else {
+            forms = cons(form, forms);
+        }
+    }
+    forms = reverse(forms);
+    Item *names = makeNull();
+    for (Item *f = forms; !isNull(f); f = cdr(f)) {
+        if (isVariableDefinition(car(f), env)) {
+            names = cons(bindVariableName(env, car(cdr(car(f)))), names);
+        }
+    }
+    names = reverse(names);
+    Item *expanded = makeNull();
+    for (; !isNull(forms); forms = cdr(forms)) {
+        Item *form = car(forms);
+        if (isVariableDefinition(form, env)) {
+            Item *value = expandExpression(car(cdr(cdr(form))), env);
+            form = cons(newSymbol("define"), cons(car(names), cons(value, makeNull())));
+            names = cdr(names);
+        } else {
+            form = expandExpression(form, env);
+        }
+        expanded = cons(form, expanded);
+    }
+    return reverse(expanded);
+}
+
+// expand an expression. takes in the expression and the environment, and
+// returns a copy with every macro use replaced by its expansion and every
+// variable by the symbol it is known by
+Item *expandExpression(Item *expr, Item *env) {
+    if (expr->type == SYMBOL_TYPE) {
+        return expandReference(expr, env);
+    }
+    if (expr->type != CONS_TYPE) {
+        return expr;
+    }
+    Macro *macro = findMacro(expr, env);
+    if (macro != NULL) {
+        Item *expanded = expandExpression(expandNestedUse(macro, expr, env), env);
+        expansionDepth--;
+        return expanded;
+    }
+    const char *name = specialFormName(car(expr), env);
+    if (name == NULL) {
+        return expandList(expr, env);
+    }
+    Item *keyword = newSymbol(name);
+    Item *args = cdr(expr);
+    if (strcmp(name, "quote") == 0) {
+        return cons(keyword, stripAliases(args));
+    } else if (strcmp(name, "lambda") == 0 && args->type == CONS_TYPE && isParameterList(car(args))) {
+        return expandLambda(keyword, args, env);
+    } else if (strcmp(name, "let") == 0 && args->type == CONS_TYPE && car(args)->type == SYMBOL_TYPE &&
+               cdr(args)->type == CONS_TYPE && isBindingList(car(cdr(args)))) {
+        return expandNamedLet(keyword, args, env);
+    } else if (strcmp(name, "do") == 0) {
+        return expandDo(args, env);
+    } else if (strcmp(name, "cons-stream") == 0) {
+        return expandConsStream(args, env);
+    } else if (strcmp(name, "define-memoized") == 0) {
+        return expandExpression(expandDefineMemoized(args), env);
+    } else if ((strcmp(name, "let") == 0 || strcmp(name, "let*") == 0 || strcmp(name, "letrec") == 0) &&
+               args->type == CONS_TYPE && isBindingList(car(args))) {
+        return expandLet(keyword, args, env, name);
+    } else if (strcmp(name, "cond") == 0) {
+        return expandCond(keyword, args, env);
+    } else if (strcmp(name, "define-syntax") == 0) {
+        syntaxError("define-syntax is only allowed at the top of a body or the program");
+    } else if (strcmp(name, "define-record-type") == 0) {
+        syntaxError("define-record-type is only allowed at the top of a body or the program");
+    }
+    return cons(keyword, expandList(args, env));
+}
+
+// expand the macros of a program. each top-level form is expanded in turn,
+// so a macro can be used in the forms after its definition. a variable a
+// top-level define binds is global, and keeps the name the program gave
+// it even when a macro inserted it
+Item *expandProgram(Item *tree) {
+    aliases = createSymbolTable();
+    Item *env = pushFrame(makeNull());
+    Item *forms = makeNull();
+    while (tree->type == CONS_TYPE) {
+        Item *form = expandHead(car(tree), env);
+        tree = cdr(tree);
+        if (isRecordDefinition(form, env)) {
+            tree = spliceForms(expandDefineRecordType(cdr(form)), tree);
+            continue;
+        }
+        if (isMacroDefinition(form, env)) {
+            defineMacro(form, env, sourceIdentifier(car(cdr(form))));
+            continue;
+        }
+        if (isVariableDefinition(form, env)) {
+            Item *name = sourceIdentifier(car(cdr(form)));
+            Item *value = expandExpression(car(cdr(cdr(form))), env);
+            if (isMacro(findInEnvironment(name, env))) {
+                addToFrame(env, name, name);
+            }
+            form = cons(newSymbol("define"), cons(newSymbol(name->s), cons(value, makeNull())));
+        } else {
+            form = expandExpression(form, env);
+        }
+        forms = cons(form, forms);
+    }
+    return reverse(forms);
+}
@@ -0,0 +1,17 @@
+#include "item.h"
+
+#ifndef EXPAND_H
+#define EXPAND_H
+
+// Expands the macros a program defines with define-syntax and
+// syntax-rules, once, before the program is evaluated, so no evaluator
+// sees a macro use. Expansion is hygienic: a variable a macro's template
+// binds captures only the identifiers the same expansion inserted, and an
+// identifier the template inserts means what it meant where the macro was
+// defined, even where the use binds the same name, so variables are
+// renamed to names with a # in them where needed. The special forms and
+// the globals keep their names. Takes in the list of top-level forms and
+// returns the expanded list.
+Item *expandProgram(Item *tree);
+
+#endif
@@ -0,0 +1,579 @@
+#include <stdint.h>
+#include <string.h>
+#include "hashtable.h"
+#include "bignum.h"
+#include "interpreter.h"
+#include "linkedlist.h"
+#include "persistent.h"
+#include "str.h"
+#include "talloc.h"
+
+#define INITIAL_TABLE_CAPACITY 16
+
+// how many slots of the old array each insertion or deletion moves during
+// a resize. the new array is twice the size of the old one and grows again
+// once it is half full, so moving at least two per operation always
+// empties the old array first
+#define MIGRATION_STEP 8
+
+// how many pairs and elements equal-hashing looks at, so that hashing a
+// long list does not cost as much as comparing it
+#define HASH_BUDGET 32
+
+typedef enum {
+    EQ_TABLE, EQV_TABLE, EQUAL_TABLE
+} Equivalence;
+
+// A slot of a table: its key, or NULL if it is empty, the key's value,
+// and its hash, kept so that probing and moving never hash a key again.
+typedef struct {
+    Item *key;
+    Item *value;
+    unsigned long hash;
+} Slot;
+
+// A hash table: how it compares keys, its array of slots and how many are
+// in use, and while it is resizing, the array it is moving out of and how
+// many of that array's slots it has moved. Deleting from the old array
+// leaves a tombstone, so that its probe sequences stay whole while the
+// slots before migrated are emptied by the move.
+struct HashTable {
+    Equivalence equivalence;
+    Slot *slots;
+    long capacity;
+    long used;
+    Slot *old;
+    long oldCapacity;
+    long migrated;
+    long count;
+};
+
+typedef struct HashTable HashTable;
+
+// the key a deletion leaves in the old array
+static Item tombstone;
+
+// returns whether two values are eq?
+int isEq(Item *a, Item *b) {
+    if (a == b) {
+        return 1;
+    }
+    if (a->type != b->type) {
+        return 0;
+    }
+    switch (a->type) {
+        case INT_TYPE:
+        case BOOL_TYPE:
+            return a->i == b->i;
+        case SYMBOL_TYPE:
+            return a->s == b->s || strcmp(a->s, b->s) == 0;
+        case NULL_TYPE:
+        case VOID_TYPE:
+        case EOF_TYPE:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// returns whether two values are eqv?
+int isEqv(Item *a, Item *b) {
+    if (isEq(a, b)) {
+        return 1;
+    }
+    if (a->type != b->type) {
+        return 0;
+    }
+    if (a->type == BIGNUM_TYPE) {
+        return integerCompare(a, b) == 0;
+    } else if (a->type == DOUBLE_TYPE) {
+        return memcmp(&a->d, &b->d, sizeof(double)) == 0;
+    }
+    return 0;
+}
+
+// returns whether two values are equal?. a list is compared along its
+// cdrs in a loop, so only nesting in cars and vectors recurses, and each
+// level of that checks the C stack depth
+int isEqual(Item *a, Item *b) {
+    checkStackDepth();
+    while (1) {
+        if (isEqv(a, b)) {
+            return 1;
+        }
+        if (a->type != b->type) {
+            return 0;
+        }
+        switch (a->type) {
+            case STR_TYPE:
+                return a->str.length == b->str.length &&
+                       memcmp(stringChars(a), stringChars(b), a->str.length) == 0;
+            case CONS_TYPE:
+                if (!isEqual(car(a), car(b))) {
+                    return 0;
+                }
+                a = cdr(a);
+                b = cdr(b);
+                break;
+            case VECTOR_TYPE:
+                if (a->v.length != b->v.length) {
+                    return 0;
+                }
+                for (long i = 0; i < a->v.length; i++) {
+                    if (!isEqual(a->v.elements[i], b->v.elements[i])) {
+                        return 0;
+                    }
+                }
+                return 1;
+            case BYTEVECTOR_TYPE:
+                return a->nv.length == b->nv.length && memcmp(a->nv.data, b->nv.data, a->nv.length) == 0;
+            case S64VECTOR_TYPE:
+            case F64VECTOR_TYPE:
+                return a->nv.length == b->nv.length && memcmp(a->nv.data, b->nv.data, a->nv.length * 8) == 0;
+            case PMAP_TYPE:
+            case PVECTOR_TYPE:
+                return persistentEqual(a, b);
+            default:
+                return 0;
+        }
+    }
+}
+
+// makes a boolean item. takes in its value
+static Item *makeTruth(int value) {
+    Item *result = talloc(sizeof(Item));
+    result->type = BOOL_TYPE;
+    result->i = value != 0;
+    return result;
+}
+
+Item *primitiveIsEq(Item *a, Item *b) {
+    return makeTruth(isEq(a, b));
+}
+
+Item *primitiveIsEqv(Item *a, Item *b) {
+    return makeTruth(isEqv(a, b));
+}
+
+Item *primitiveIsEqual(Item *a, Item *b) {
+    return makeTruth(isEqual(a, b));
+}
+
+// mixes a word into a hash. takes in the hash and the word and returns the
+// new hash
+unsigned long mixWord(unsigned long hash, unsigned long word) {
+    hash = (hash ^ word) * 0x9e3779b97f4a7c15ul;
+    return hash ^ (hash >> 29);
+}
+
+// mixes bytes into a hash. takes in the hash, the bytes and their number
+// and returns the new hash
+static unsigned long mixBytes(unsigned long hash, const void *bytes, long length) {
+    const unsigned char *b = bytes;
+    long i = 0;
+    for (; i + 8 <= length; i += 8) {
+        unsigned long word;
+        memcpy(&word, b + i, 8);
+        hash = mixWord(hash, word);
+    }
+    unsigned long tail = 0;
+    memcpy(&tail, b + i, length - i);
+    return mixWord(hash, tail ^ ((unsigned long)length << 56));
+}
+
+// hashes a value so that values the equivalence finds the same hash the
+// same. takes in the value, the equivalence, the hash so far and how many
+// more pairs and elements to look at, and returns the new hash
+static unsigned long hashKey(Item *key, Equivalence equivalence, unsigned long hash, int *budget) {
+    while (1) {
+        hash = mixWord(hash, key->type);
+        switch (key->type) {
+            case INT_TYPE:
+            case BOOL_TYPE:
+                return mixWord(hash, key->i);
+            case SYMBOL_TYPE:
+                return mixBytes(hash, key->s, strlen(key->s));
+            case NULL_TYPE:
+            case VOID_TYPE:
+            case EOF_TYPE:
+                return hash;
+            default:
+                break;
+        }
+        if (equivalence != EQ_TABLE) {
+            switch (key->type) {
+                case BIGNUM_TYPE:
+                    return mixBytes(mixWord(hash, key->bn->sign), key->bn->limbs,
+                                    key->bn->length * sizeof(uint32_t));
+                case DOUBLE_TYPE:
+                    return mixBytes(hash, &key->d, sizeof(double));
+                default:
+                    break;
+            }
+        }
+        if (equivalence == EQUAL_TABLE) {
+            switch (key->type) {
+                case STR_TYPE:
+                    return mixBytes(hash, stringChars(key), key->str.length);
+                case CONS_TYPE:
+                    if (--*budget < 0) {
+                        return hash;
+                    }
+                    hash = hashKey(car(key), equivalence, hash, budget);
+                    key = cdr(key);
+                    continue;
+                case VECTOR_TYPE:
+                    hash = mixWord(hash, key->v.length);
+                    for (long i = 0; i < key->v.length && --*budget >= 0; i++) {
+                        hash = hashKey(key->v.elements[i], equivalence, hash, budget);
+                    }
+                    return hash;
+                case BYTEVECTOR_TYPE:
+                    return mixBytes(hash, key->nv.data, key->nv.length);
+                case S64VECTOR_TYPE:
+                case F64VECTOR_TYPE:
+                    return mixBytes(hash, key->nv.data, key->nv.length * 8);
+                case PMAP_TYPE:
+                case PVECTOR_TYPE:
+                    return mixWord(hash, persistentHash(key));
+                default:
+                    break;
+            }
+        }
+        return mixWord(hash, (uintptr_t)key);
+    }
+}
+
+// hashes a value to match equal?. takes in the value
+unsigned long equalHash(Item *value) {
+    int budget = HASH_BUDGET;
+    return hashKey(value, EQUAL_TABLE, 0, &budget);
+}
+
+// hashes a key of a table. takes in the table and the key
+static unsigned long tableHash(HashTable *table, Item *key) {
+    int budget = HASH_BUDGET;
+    return hashKey(key, table->equivalence, 0, &budget);
+}
+
+// compares two keys of a table. takes in the table and the keys and
+// returns whether they are the same key
+static int sameTableKey(HashTable *table, Item *a, Item *b) {
+    switch (table->equivalence) {
+        case EQ_TABLE:
+            return isEq(a, b);
+        case EQV_TABLE:
+            return isEqv(a, b);
+        default:
+            return isEqual(a, b);
+    }
+}
+
+// finds a key in the current array. takes in the table, the key and its
+// hash, and returns the index of the key's slot, or of the empty slot it
+// would go in
+static long probeSlots(HashTable *table, Item *key, unsigned long hash) {
+    long mask = table->capacity - 1;
+    long i = hash & mask;
+    while (table->slots[i].key != NULL) {
+        if (table->slots[i].hash == hash && sameTableKey(table, table->slots[i].key, key)) {
+            return i;
+        }
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+// finds a key in the old array of a resizing table, passing over the
+// slots already moved and tombstones. takes in the table, the key and its
+// hash, and returns the index of the key's slot, or -1
+static long probeOld(HashTable *table, Item *key, unsigned long hash) {
+    if (table->old == NULL) {
+        return -1;
+    }
+    long mask = table->oldCapacity - 1;
+    long i = hash & mask;
+    for (long n = 0; n < table->oldCapacity; n++, i = (i + 1) & mask) {
+        Slot *slot = &table->old[i];
+        if (i < table->migrated || slot->key == &tombstone) {
+            continue;
+        }
+        if (slot->key == NULL) {
+            return -1;
+        }
+        if (slot->hash == hash && sameTableKey(table, slot->key, key)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// moves some of the old array's slots into the current array. takes in the
+// table and how many slots to move
+static void migrateSlots(HashTable *table, long step) {
+    for (; step > 0 && table->old != NULL; step--) {
+        Slot *slot = &table->old[table->migrated];
+        if (slot->key != NULL && slot->key != &tombstone) {
+            table->slots[probeSlots(table, slot->key, slot->hash)] = *slot;
+            table->used++;
+        }
+        slot->key = NULL;
+        table->migrated++;
+        if (table->migrated == table->oldCapacity) {
+            table->old = NULL;
+        }
+    }
+}
+
+// starts moving a table into an array twice the size of its current one,
+// first finishing any earlier move. takes in the table
+void growTable(HashTable *table) {
+    if (table->old != NULL) {
+        migrateSlots(table, table->oldCapacity - table->migrated);
+    }
+    table->old = table->slots;
+    table->oldCapacity = table->capacity;
+    table->migrated = 0;
+    table->capacity *= 2;
+    table->slots = talloc(sizeof(Slot) * table->capacity);
+    memset(table->slots, 0, sizeof(Slot) * table->capacity);
+    table->used = 0;
+}
+
+// looks up a key. takes in the table and the key and returns its slot, or
+// NULL if it is not there
+static Slot *lookupEntry(HashTable *table, Item *key) {
+    unsigned long hash = tableHash(table, key);
+    long i = probeSlots(table, key, hash);
+    if (table->slots[i].key != NULL) {
+        return &table->slots[i];
+    }
+    long j = probeOld(table, key, hash);
+    return j >= 0 ? &table->old[j] : NULL;
+}
+
+// stores a value under a key, replacing any value it had. takes in the
+// table, the key and the value
+static void storeEntry(HashTable *table, Item *key, Item *value) {
+    unsigned long hash = tableHash(table, key);
+    long i = probeSlots(table, key, hash);
+    if (table->slots[i].key != NULL) {
+        table->slots[i].value = value;
+        return;
+    }
+    long j = probeOld(table, key, hash);
+    if (j >= 0) {
+        table->old[j].value = value;
+        return;
+    }
+    if (2 * (table->used + 1) > table->capacity) {
+        growTable(table);
+        i = probeSlots(table, key, hash);
+    }
+    table->slots[i].key = key;
+    table->slots[i].value = value;
+    table->slots[i].hash = hash;
+    table->used++;
+    table->count++;
+    migrateSlots(table, MIGRATION_STEP);
+}
+
+// empties a slot of the current array, moving later slots of the same
+// probe sequence back so that none of them is cut off from its home.
+// takes in the table and the slot's index
+static void removeSlot(HashTable *table, long i) {
+    long mask = table->capacity - 1;
+    long j = i;
+    while (1) {
+        j = (j + 1) & mask;
+        if (table->slots[j].key == NULL) {
+            break;
+        }
+        long home = table->slots[j].hash & mask;
+        int movable = i <= j ? (home <= i || home > j) : (home <= i && home > j);
+        if (movable) {
+            table->slots[i] = table->slots[j];
+            i = j;
+        }
+    }
+    table->slots[i].key = NULL;
+}
+
+// removes a key and its value, if it is there. takes in the table and the
+// key
+static void deleteEntry(HashTable *table, Item *key) {
+    unsigned long hash = tableHash(table, key);
+    long i = probeSlots(table, key, hash);
+    if (table->slots[i].key != NULL) {
+        removeSlot(table, i);
+        table->used--;
+        table->count--;
+    } else {
+        long j = probeOld(table, key, hash);
+        if (j < 0) {
+            return;
+        }
+        table->old[j].key = &tombstone;
+        table->count--;
+    }
+    migrateSlots(table, MIGRATION_STEP);
+}
+
+// checks that a value is a hash table. takes in the value and the error
+// to report if it is not, and returns the table
+static HashTable *checkTable(Item *value, const char *message) {
+    if (value->type != HASHTABLE_TYPE) {
+        evaluationError(message);
+    }
+    return value->ht;
+}
+
+// copies the entries of a table, so that procedures called on them may
+// change the table. takes in the table and returns its keys and values
+// alternately, count pairs of them
+static Item **tableEntries(HashTable *table) {
+    Item **entries = talloc(sizeof(Item *) * 2 * (table->count > 0 ? table->count : 1));
+    long n = 0;
+    for (long i = 0; i < table->capacity; i++) {
+        if (table->slots[i].key != NULL) {
+            entries[n++] = table->slots[i].key;
+            entries[n++] = table->slots[i].value;
+        }
+    }
+    for (long i = table->migrated; table->old != NULL && i < table->oldCapacity; i++) {
+        if (table->old[i].key != NULL && table->old[i].key != &tombstone) {
+            entries[n++] = table->old[i].key;
+            entries[n++] = table->old[i].value;
+        }
+    }
+    return entries;
+}
+
+// implements make-hash-table. takes in optionally the procedure keys are
+// compared with, and returns an empty table
+Item *primitiveMakeHashTable(int argc, Item **argv) {
+    HashTable *table = talloc(sizeof(HashTable));
+    table->equivalence = EQUAL_TABLE;
+    if (argc > 0) {
+        Primitive *compare = argv[0]->type == PRIMITIVE_TYPE ? argv[0]->pr : NULL;
+        if (compare != NULL && compare->call2 == primitiveIsEq) {
+            table->equivalence = EQ_TABLE;
+        } else if (compare != NULL && compare->call2 == primitiveIsEqv) {
+            table->equivalence = EQV_TABLE;
+        } else if (compare == NULL || (compare->call2 != primitiveIsEqual && compare->call != primitiveStringEqual)) {
+            evaluationError("make-hash-table expects eq?, eqv?, equal? or string=?");
+        }
+    }
+    table->capacity = INITIAL_TABLE_CAPACITY;
+    table->slots = talloc(sizeof(Slot) * table->capacity);
+    memset(table->slots, 0, sizeof(Slot) * table->capacity);
+    table->used = 0;
+    table->old = NULL;
+    table->oldCapacity = 0;
+    table->migrated = 0;
+    table->count = 0;
+    Item *result = talloc(sizeof(Item));
+    result->type = HASHTABLE_TYPE;
+    result->ht = table;
+    return result;
+}
+
+// implements hash-table?. takes in a value and returns whether it is a
+// hash table
+Item *primitiveIsHashTable(Item *value) {
+    return makeTruth(value->type == HASHTABLE_TYPE);
+}
+
+// implements hash-table-ref. takes in a table, a key and optionally a
+// procedure to call if the key is missing, and returns the key's value
+Item *primitiveHashTableRef(int argc, Item **argv) {
+    Slot *slot = lookupEntry(checkTable(argv[0], "hash-table-ref expects a hash table"), argv[1]);
+    if (slot != NULL) {
+        return slot->value;
+    }
+    if (argc < 3) {
+        evaluationError("hash-table-ref key not found");
+    }
+    return apply(argv[2], 0, NULL);
+}
+
+// implements hash-table-ref/default. takes in a table, a key and a
+// default, and returns the key's value, or the default if it has none
+Item *primitiveHashTableRefDefault(int argc, Item **argv) {
+    Slot *slot = lookupEntry(checkTable(argv[0], "hash-table-ref/default expects a hash table"), argv[1]);
+    return slot != NULL ? slot->value : argv[2];
+}
+
+// implements hash-table-set!. takes in a table, a key and a value, and
+// returns void
+Item *primitiveHashTableSet(int argc, Item **argv) {
+    storeEntry(checkTable(argv[0], "hash-table-set! expects a hash table"), argv[1], argv[2]);
+    return makeVoid();
+}
+
+// implements hash-table-delete!. takes in a table and a key, and returns
+// void
+Item *primitiveHashTableDelete(Item *table, Item *key) {
+    deleteEntry(checkTable(table, "hash-table-delete! expects a hash table"), key);
+    return makeVoid();
+}
+
+// implements hash-table-contains?. takes in a table and a key and returns
+// whether the key has a value
+Item *primitiveHashTableContains(Item *table, Item *key) {
+    return makeTruth(lookupEntry(checkTable(table, "hash-table-contains? expects a hash table"), key) != NULL);
+}
+
+// implements hash-table-update!/default. takes in a table, a key, a
+// procedure and a default, and stores the procedure's result on the key's
+// value, or on the default, under the key. returns void
+Item *primitiveHashTableUpdateDefault(int argc, Item **argv) {
+    HashTable *table = checkTable(argv[0], "hash-table-update!/default expects a hash table");
+    Slot *slot = lookupEntry(table, argv[1]);
+    Item *value = slot != NULL ? slot->value : argv[3];
+    // the procedure may change the table, so the key is looked up again
+    storeEntry(table, argv[1], apply(argv[2], 1, &value));
+    return makeVoid();
+}
+
+// implements hash-table-count. takes in a table and returns how many keys
+// it has
+Item *primitiveHashTableCount(Item *table) {
+    return makeFixnum(checkTable(table, "hash-table-count expects a hash table")->count);
+}
+
+// implements hash-table-walk. takes in a table and a procedure, calls the
+// procedure on each key and its value, and returns void
+Item *primitiveHashTableWalk(Item *table, Item *procedure) {
+    HashTable *walked = checkTable(table, "hash-table-walk expects a hash table");
+    long count = walked->count;
+    Item **entries = tableEntries(walked);
+    for (long i = 0; i < count; i++) {
+        apply(procedure, 2, entries + 2 * i);
+    }
+    return makeVoid();
+}
+
+// implements hash-table-keys. takes in a table and returns a list of its
+// keys
+Item *primitiveHashTableKeys(Item *table) {
+    HashTable *listed = checkTable(table, "hash-table-keys expects a hash table");
+    Item **entries = tableEntries(listed);
+    Item *keys = makeNull();
+    for (long i = listed->count - 1; i >= 0; i--) {
+        keys = cons(entries[2 * i], keys);
+    }
+    return keys;
+}
+
+// implements hash-table->alist. takes in a table and returns a list of
+// pairs of its keys and their values
+Item *primitiveHashTableToAlist(Item *table) {
+    HashTable *listed = checkTable(table, "hash-table->alist expects a hash table");
+    Item **entries = tableEntries(listed);
+    Item *alist = makeNull();
+    for (long i = listed->count - 1; i >= 0; i--) {
+        alist = cons(cons(entries[2 * i], entries[2 * i + 1]), alist);
+    }
+    return alist;
+}
@@ -0,0 +1,55 @@
+#include "item.h"
+
+#ifndef HASHTABLE_H
+#define HASHTABLE_H
+
+// Equality. eq? is identity, except that integers that fit in a fixnum,
+// booleans, symbols of the same name, and the empty list are eq? to
+// themselves however many items they are boxed in. eqv? is eq? but also
+// compares bignums and doubles by value, and equal? compares strings,
+// pairs, vectors, numeric vectors and persistent maps and vectors by
+// contents and everything else by eqv?. Each returns true or false.
+int isEq(Item *a, Item *b);
+int isEqv(Item *a, Item *b);
+int isEqual(Item *a, Item *b);
+
+// Hashes a value to match equal?, and mixes a word into a hash, such as
+// another value's hash. mixWord multiplies by a 64-bit constant and folds
+// the high bits back down, so every bit of the word reaches the low bits
+// that pick a bucket.
+unsigned long equalHash(Item *value);
+unsigned long mixWord(unsigned long hash, unsigned long word);
+
+Item *primitiveIsEq(Item *a, Item *b);
+Item *primitiveIsEqv(Item *a, Item *b);
+Item *primitiveIsEqual(Item *a, Item *b);
+
+// Mutable hash tables, after SRFI 69. make-hash-table takes the procedure
+// keys are compared with, eq?, eqv?, equal? (the default) or string=?,
+// and hashes them to match. A table is open-addressed with linear probing
+// and grows once it is half full, to twice its size; rather than moving
+// every entry at once, it keeps the smaller array and moves a few of its
+// entries into the larger one on each insertion or deletion after that,
+// looking keys up in both until they are all moved, so no one operation
+// pays for a whole resize.
+//
+// hash-table-ref takes an optional procedure of no arguments to call if
+// the key is missing, and is an error if there is none; -ref/default
+// returns a default instead. hash-table-update!/default calls a procedure
+// on the key's value, or on a default if it has none, and stores the
+// result. hash-table-walk calls a procedure on each key and value, of the
+// entries the table held when the walk began.
+Item *primitiveMakeHashTable(int argc, Item **argv);
+Item *primitiveIsHashTable(Item *value);
+Item *primitiveHashTableRef(int argc, Item **argv);
+Item *primitiveHashTableRefDefault(int argc, Item **argv);
+Item *primitiveHashTableSet(int argc, Item **argv);
+Item *primitiveHashTableDelete(Item *table, Item *key);
+Item *primitiveHashTableContains(Item *table, Item *key);
+Item *primitiveHashTableUpdateDefault(int argc, Item **argv);
+Item *primitiveHashTableCount(Item *table);
+Item *primitiveHashTableWalk(Item *table, Item *procedure);
+Item *primitiveHashTableKeys(Item *table);
+Item *primitiveHashTableToAlist(Item *table);
+
+#endif
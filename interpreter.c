@@ -1,9 +1,45 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <sys/resource.h>
 #include "interpreter.h"
 #include "linkedlist.h"
 #include "talloc.h"
+#include "symtab.h"
+#include "compiler.h"
+#include "vm.h"
+#include "control.h"
+#include "memo.h"
+#include "bignum.h"
+#include "vector.h"
+#include "numvec.h"
+#include "str.h"
+#include "hashtable.h"
+#include "persistent.h"
+#include "records.h"
+
+// the bindings of the global frame, and a counter that is bumped whenever a
+// define could change which binding a variable reference resolves to. any
+// reference site cached under an older epoch has to look its binding up again
+SymbolTable *globalTable = NULL;
+Frame *globalFrame = NULL;
+unsigned long globalEpoch = 1;
+
+// the value of a variable a body defines, from when the body starts until
+// the define runs. a binding holding it is skipped by lookups, so the name
+// still resolves to whatever the define will shadow
+Item unassigned;
+
+// whether to evaluate every top-level form with the tree walker instead of
+// compiling it to bytecode
+int useTreeWalker = 0;
+
+// choose whether interpret uses the tree walker for every form. takes in a
+// flag and does not return anything
+void setTreeWalker(int enabled) {
+    useTreeWalker = enabled;
+}
 
 // a version of strdup but with talloc. takes in a string
 // and returns a newly allocated copy of that string using talloc
@@ -25,86 +61,386 @@ void evaluationError(const char *message) {
     texit(1);
 }
 
+// look up a global binding. takes in an interned name and returns its
+// binding cell, or NULL if it is unbound
+Item *lookupGlobalCell(char *name) {
+    return tableLookup(globalTable, name);
+}
+
+// define a global variable from compiled code, which updates an existing
+// binding in place just like a top-level define. takes in an interned name
+// and a value and does not return anything
+void defineGlobal(char *name, Item *value) {
+    tableDefine(globalTable, name, value);
+}
+
 // create a new frame with a specified parent. takes
 // in the parents and returns the frame
 Frame *createFrame(Frame *parent) {
     Frame *frame = talloc(sizeof(Frame));
     frame->bindings = makeNull();
     frame->parent = parent;
+    frame->table = NULL;
+    return frame;
+}
+
+// create the global frame, whose bindings live in a hash table rather
+// than a list. returns the frame
+Frame *createGlobalFrame() {
+    Frame *frame = createFrame(NULL);
+    frame->table = createSymbolTable();
+    globalTable = frame->table;
+    globalFrame = frame;
     return frame;
 }
 
 // add a binding of a variable to a value in a frame. takes in a frame pointer, 
-// a variable name, and a value pointer. does not return anything
+// an interned variable name, and a value pointer. in the global frame an
+// existing binding is updated in place. does not return anything
 void addBinding(Frame *frame, char *var, Item *value) {
+    if (frame->table != NULL) {
+        tableDefine(frame->table, var, value);
+        return;
+    }
     Item *symbol = talloc(sizeof(Item));
     symbol->type = SYMBOL_TYPE;
-    symbol->s = talloc_strdup(var);
+    symbol->s = var;
     Item *binding = cons(symbol, value);
     frame->bindings = cons(binding, frame->bindings);
 }
 
-// look up a binding in the current frame or its parents.
-Item *lookupSymbol(char *symbol, Frame *frame) {
+// look up the binding cell of a symbol in the current frame or its parents.
+// symbol names are interned, so they are compared by pointer. returns the
+// (symbol . value) cell, whose cdr can be overwritten to update the binding
+Item *lookupBinding(char *symbol, Frame *frame) {
     while (frame != NULL) {
+        if (frame->table != NULL) {
+            Item *cell = tableLookup(frame->table, symbol);
+            if (cell != NULL) {
+                return cell;
+            }
+        } else {
+            Item *binding = frame->bindings;
+            while (!isNull(binding)) {
+                Item *currentBinding = car(binding);
+                if (car(currentBinding)->s == symbol && cdr(currentBinding) != &unassigned) {
+                    return currentBinding;
+                }
+                binding = cdr(binding);
+            }
+        }
+        frame = frame->parent;
+    }
+    evaluationError("Unbound symbol");
+    return NULL;
+}
+
+// look up the value of a variable reference in the parse tree. takes in the
+// symbol being referenced and a frame, and returns the bound value. a
+// reference that falls through every local frame to a global binding caches
+// that binding's cell on the symbol, so until the global epoch moves on it
+// costs one load and one compare. local bindings are never cached, since
+// each call creates fresh frames for them.
+Item *lookupVariable(Item *site, Frame *frame) {
+    if (site->sc.epoch == globalEpoch) {
+        return cdr(site->sc.cell);
+    }
+    while (frame->table == NULL) {
         Item *binding = frame->bindings;
         while (!isNull(binding)) {
             Item *currentBinding = car(binding);
-            if (strcmp(car(currentBinding)->s, symbol) == 0) {
+            if (car(currentBinding)->s == site->s && cdr(currentBinding) != &unassigned) {
                 return cdr(currentBinding);
             }
             binding = cdr(binding);
         }
         frame = frame->parent;
     }
-    evaluationError("Unbound symbol");
+    Item *cell = tableLookup(frame->table, site->s);
+    if (cell == NULL) {
+        evaluationError("Unbound symbol");
+    }
+    site->sc.cell = cell;
+    site->sc.epoch = globalEpoch;
+    return cdr(cell);
+}
+
+
+// The evaluator is an explicit-control machine. Instead of recursing in C to
+// get the value of a subexpression, a special form saves the work that is
+// left to do once that value is known as a continuation on a heap stack,
+// and the machine moves on to the subexpression. When an expression produces
+// a value, the machine pops the top continuation and resumes it with that
+// value. Deep non-tail recursion in Scheme therefore grows the heap stack
+// rather than the C stack, up to a configurable limit, and expressions in
+// tail position push nothing at all.
+
+// the kinds of pending work a continuation can hold
+typedef enum {
+    BODY_CONT, IF_CONT, DEFINE_CONT, SET_CONT, SETCAR_CONT, SETCDR_CONT,
+    LET_CONT, LETSTAR_CONT, LETREC_CONT, COND_CONT, AND_CONT, OR_CONT,
+    ARGS_CONT, MEMO_CONT
+} ContinuationKind;
+
+// A continuation: the expressions a form still has to evaluate, the frame
+// to evaluate them in, the frame being filled in (for let and letrec), and
+// whatever else the form needs to finish (a let body, a pair being
+// mutated). a call keeps the values of its operator and operands so far on
+// the argument stack, starting at base.
+typedef struct {
+    ContinuationKind kind;
+    Item *rest;
+    Frame *frame;
+    Frame *target;
+    Item *data;
+    int base;
+} Continuation;
+
+#define DEFAULT_STACK_LIMIT (256 * 1024 * 1024)
+#define INITIAL_STACK_CAPACITY 1024
+
+Item *run(Item *tree, Frame *frame, int base);
+
+Continuation *contStack = NULL;
+int contTop = 0;
+int contCapacity = 0;
+size_t stackLimit = DEFAULT_STACK_LIMIT;
+
+// set the most memory, in bytes, the continuation stack may grow to. takes
+// in the limit and does not return anything
+void setStackLimit(size_t bytes) {
+    stackLimit = bytes;
+}
+
+// get the stack limit set by setStackLimit. the bytecode VM's stacks are
+// held to the same limit
+size_t getStackLimit() {
+    return stackLimit;
+}
+
+// where the C stack the program runs on starts and how far it may grow
+char *stackStart = NULL;
+size_t stackBudget = 0;
+
+#define STACK_MARGIN (1 << 20)
+
+void (*programToRun)() = NULL;
+
+// run the program, noting where its stack starts
+void *runProgram(void *unused) {
+    char start;
+    stackStart = &start;
+    programToRun();
     return NULL;
 }
 
-// Evaluate the body of a lambda function. Takes in a list of expressions
-// and a frame pointer. Returns the result of evaluating the body.
-Item *evalBody(Item *body, Frame *frame) {
-    Item *result = makeNull();
-    while (!isNull(body)) {
-        result = eval(car(body), frame);
-        body = cdr(body);
+// run a program on a C stack the size of the stack limit. takes in the
+// program and does not return anything
+void runOnProgramStack(void (*program)()) {
+    programToRun = program;
+    pthread_attr_t attr;
+    pthread_t thread;
+    pthread_attr_init(&attr);
+    stackBudget = stackLimit;
+    if (pthread_attr_setstacksize(&attr, stackBudget + STACK_MARGIN) == 0 &&
+        pthread_create(&thread, &attr, runProgram, NULL) == 0) {
+        pthread_join(thread, NULL);
+    } else {
+        struct rlimit limit;
+        getrlimit(RLIMIT_STACK, &limit);
+        if (limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur < stackBudget + STACK_MARGIN) {
+            stackBudget = limit.rlim_cur - STACK_MARGIN;
+        }
+        runProgram(NULL);
     }
-    return result;
 }
 
-// evaluate an if expression. takes in a list of arguments and a frame pointer, 
-// returns the result of evaluating the right branch
-Item *evalIf(Item *args, Frame *frame) {
-    if (length(args) != 3) {
-        evaluationError("if expects exactly 3 arguments");
+// check that the C stack has room for another call back into the
+// evaluators. exits with an evaluation error if it does not, rather than
+// letting deep recursion through C overflow it
+void checkStackDepth() {
+    char here;
+    if (stackStart != NULL && (size_t)(stackStart - &here) > stackBudget) {
+        evaluationError("recursion too deep (stack limit reached)");
     }
-    Item *test = eval(car(args), frame);
-    if (test->type != BOOL_TYPE) {
-        evaluationError("if expects a boolean as the first argument");
+}
+
+// swap the stack bounds with a generator's. takes in pointers to the other
+// bounds and does not return anything
+void swapStackBounds(char **start, size_t *budget) {
+    char *oldStart = stackStart;
+    size_t oldBudget = stackBudget;
+    stackStart = *start;
+    stackBudget = *budget;
+    *start = oldStart;
+    *budget = oldBudget;
+}
+
+// grows the continuation stack to twice its size, or to the stack limit
+// if that is smaller. exits with an evaluation error once the limit is
+// reached, rather than letting deep recursion crash the interpreter
+void growContinuationStack() {
+    size_t maxCapacity = stackLimit / sizeof(Continuation);
+    if ((size_t)contCapacity >= maxCapacity) {
+        evaluationError("recursion too deep (stack limit reached)");
     }
-    if (test->i) {
-        return eval(car(cdr(args)), frame);
-    } else {
-        return eval(car(cdr(cdr(args))), frame);
+    size_t newCapacity = contCapacity ? 2 * (size_t)contCapacity : INITIAL_STACK_CAPACITY;
+    if (newCapacity > maxCapacity) {
+        newCapacity = maxCapacity;
     }
+    Continuation *newStack = talloc(sizeof(Continuation) * newCapacity);
+    if (contTop > 0) {
+        memcpy(newStack, contStack, sizeof(Continuation) * contTop);
+    }
+    contStack = newStack;
+    contCapacity = (int)newCapacity;
 }
 
-// evaluate a let expression. takes in a list of arguments and a frame pointer,
-// returns the result of evaluating the body in a new frame
-Item *evalLet(Item *args, Frame *frame) {
-    if (length(args) < 2) {
-        evaluationError("let expects at least 2 arguments");
+// push a continuation onto the stack. takes in its kind, the expressions
+// still to be evaluated and the frame to evaluate them in, and returns the
+// new continuation so the caller can fill in the rest of it. the pointer is
+// only valid until the next push
+Continuation *pushContinuation(ContinuationKind kind, Item *rest, Frame *frame) {
+    if (contTop == contCapacity) {
+        growContinuationStack();
+    }
+    Continuation *k = &contStack[contTop++];
+    k->kind = kind;
+    k->rest = rest;
+    k->frame = frame;
+    k->target = NULL;
+    k->data = NULL;
+    return k;
+}
+
+// the values of the operators and operands of calls being evaluated. each
+// call pushes its values here and pops them once the function has been
+// called, so no call conses up a list of its arguments
+Item **argStack = NULL;
+int argTop = 0;
+int argCapacity = 0;
+
+// push a value onto the argument stack, growing it if needed. takes in the
+// value and does not return anything
+void pushArgument(Item *value) {
+    if (argTop == argCapacity) {
+        size_t newCapacity = argCapacity ? 2 * (size_t)argCapacity : INITIAL_STACK_CAPACITY;
+        if (newCapacity * sizeof(Item *) > stackLimit) {
+            evaluationError("recursion too deep (stack limit reached)");
+        }
+        Item **newStack = talloc(sizeof(Item *) * newCapacity);
+        if (argTop > 0) {
+            memcpy(newStack, argStack, sizeof(Item *) * argTop);
+        }
+        argStack = newStack;
+        argCapacity = (int)newCapacity;
     }
+    argStack[argTop++] = value;
+}
 
-    Item *bindings = car(args);
-    Item *body = cdr(args);
+// swaps the evaluators' stacks with a saved set. takes in the set and does
+// not return anything
+void swapStacks(Stacks *other) {
+    Continuation *continuations = contStack;
+    int top = contTop, capacity = contCapacity;
+    contStack = other->continuations;
+    contTop = other->continuationTop;
+    contCapacity = other->continuationCapacity;
+    other->continuations = continuations;
+    other->continuationTop = top;
+    other->continuationCapacity = capacity;
+
+    Item **arguments = argStack;
+    top = argTop;
+    capacity = argCapacity;
+    argStack = other->arguments;
+    argTop = other->argumentTop;
+    argCapacity = other->argumentCapacity;
+    other->arguments = arguments;
+    other->argumentTop = top;
+    other->argumentCapacity = capacity;
+
+    swapVmStacks(other);
+}
+
+// records the heights of the evaluators' stacks. takes in where to record
+// them
+void markStacks(Stacks *marks) {
+    marks->continuationTop = contTop;
+    marks->argumentTop = argTop;
+    markVmStacks(marks);
+}
+
+// cuts the evaluators' stacks back to recorded heights. takes in the
+// heights
+void resetStacks(Stacks *marks) {
+    contTop = marks->continuationTop;
+    argTop = marks->argumentTop;
+    resetVmStacks(marks);
+}
+
+// create a void item, the value of forms evaluated only for their effect
+Item *makeVoid() {
+    Item *voidReturn = talloc(sizeof(Item));
+    voidReturn->type = VOID_TYPE;
+    return voidReturn;
+}
+
+// The functions below start a special form. Each takes in the arguments of
+// the form and the frame it is evaluated in, pushes whatever continuation
+// the form needs, and returns the next expression for the machine to
+// evaluate. Forms that are already finished return a self-evaluating item
+// holding their value.
+
+// checks whether an expression is a well-formed (define name value). takes
+// in the expression and returns true if it is
+int isDefineForm(Item *expr) {
+    return expr->type == CONS_TYPE && car(expr)->type == SYMBOL_TYPE &&
+           strcmp(car(expr)->s, "define") == 0 && length(expr) == 3 &&
+           car(cdr(expr))->type == SYMBOL_TYPE;
+}
+
+// start evaluating a body. takes in a list of expressions and a frame
+// pointer. returns the first expression; the rest are saved to be evaluated
+// in turn, the last of them in tail position. the names the body defines
+// are bound in a local frame up front, unassigned, so that a closure made
+// earlier in the body captures the binding the define fills in
+Item *evalBody(Item *body, Frame *frame) {
+    if (isNull(body)) {
+        evaluationError("body must not be empty");
+    }
+    if (frame->table == NULL) {
+        for (Item *expr = body; !isNull(expr); expr = cdr(expr)) {
+            if (isDefineForm(car(expr))) {
+                addBinding(frame, car(cdr(car(expr)))->s, &unassigned);
+            }
+        }
+    }
+    if (!isNull(cdr(body))) {
+        pushContinuation(BODY_CONT, cdr(body), frame);
+    }
+    return car(body);
+}
+
+// start an if expression. takes in a list of arguments and a frame pointer,
+// and returns the test, saving the branches for when its value is known
+Item *evalIf(Item *args, Frame *frame) {
+    if (length(args) != 3) {
+        evaluationError("if expects exactly 3 arguments");
+    }
+    pushContinuation(IF_CONT, cdr(args), frame);
+    return car(args);
+}
+
+// checks a let, let* or letrec binding list. takes in the list and whether
+// duplicate variables are an error, and does not return anything
+void checkBindings(Item *bindings, int rejectDuplicates) {
     if (bindings->type != CONS_TYPE && bindings->type != NULL_TYPE) {
         evaluationError("not a list");
     }
-
-    Frame *letFrame = createFrame(frame);
-    while (!isNull(bindings)) {
-        Item *currentBinding = car(bindings);
+    Item *current = bindings;
+    while (!isNull(current)) {
+        Item *currentBinding = car(current);
         if (currentBinding->type != CONS_TYPE || length(currentBinding) != 2) {
             evaluationError("binding invalid");
         }
@@ -112,25 +448,157 @@ Item *evalLet(Item *args, Frame *frame) {
         if (var->type != SYMBOL_TYPE) {
             evaluationError("variable doesn't exist");
         }
-
-        Item *innerBindings = car(args);
-        while (innerBindings != bindings) {
-            if (strcmp(car(car(innerBindings))->s, var->s) == 0) {
-                evaluationError("variable duplicate");
+        if (rejectDuplicates) {
+            Item *innerBindings = bindings;
+            while (innerBindings != current) {
+                if (car(car(innerBindings))->s == var->s) {
+                    evaluationError("variable duplicate");
+                }
+                innerBindings = cdr(innerBindings);
             }
-            innerBindings = cdr(innerBindings);
         }
+        current = cdr(current);
+    }
+}
+
+// start a let expression. takes in a list of arguments and a pointer to the
+// current frame. returns the first initial value to evaluate, or, if there
+// are no bindings, the start of the body, with the frame replaced by the
+// new let frame
+Item *evalLet(Item *args, Frame **framePointer) {
+    if (length(args) < 2) {
+        evaluationError("let expects at least 2 arguments");
+    }
+    Item *bindings = car(args);
+    checkBindings(bindings, 1);
+
+    Frame *letFrame = createFrame(*framePointer);
+    if (isNull(bindings)) {
+        *framePointer = letFrame;
+        return evalBody(cdr(args), letFrame);
+    }
+    Continuation *k = pushContinuation(LET_CONT, bindings, *framePointer);
+    k->target = letFrame;
+    k->data = cdr(args);
+    return car(cdr(car(bindings)));
+}
+
+// start a let* expression. takes in a list of arguments and a pointer to the
+// current frame. returns the first initial value to evaluate, or the start
+// of the body if there are no bindings
+Item *evalLetStar(Item *args, Frame **framePointer) {
+    if (length(args) < 2) {
+        evaluationError("not 2 arguments");
+    }
+    Item *bindings = car(args);
+    checkBindings(bindings, 0);
+
+    if (isNull(bindings)) {
+        *framePointer = createFrame(*framePointer);
+        return evalBody(cdr(args), *framePointer);
+    }
+    Continuation *k = pushContinuation(LETSTAR_CONT, bindings, *framePointer);
+    k->data = cdr(args);
+    return car(cdr(car(bindings)));
+}
+
+// start a letrec expression. takes in a list of arguments and a pointer to
+// the current frame, which is replaced by the letrec frame. every variable is
+// bound to a placeholder first, so the initial values can refer to each
+// other. returns the first initial value to evaluate, or the start of the
+// body if there are no bindings
+Item *evalLetRec(Item *args, Frame **framePointer) {
+    if (length(args) < 2) {
+        evaluationError("not 2 arguments");
+    }
+    Item *bindings = car(args);
+    checkBindings(bindings, 0);
+
+    Frame *letRecFrame = createFrame(*framePointer);
+    Item *tempBindings = bindings;
+    while (!isNull(tempBindings)) {
+        Item *nullItem = talloc(sizeof(Item));
+        nullItem->type = NULL_TYPE;
+        addBinding(letRecFrame, car(car(tempBindings))->s, nullItem);
+        tempBindings = cdr(tempBindings);
+    }
+
+    *framePointer = letRecFrame;
+    if (isNull(bindings)) {
+        return evalBody(cdr(args), letRecFrame);
+    }
+    Continuation *k = pushContinuation(LETREC_CONT, bindings, letRecFrame);
+    k->data = cdr(args);
+    return car(cdr(car(bindings)));
+}
 
-        Item *value = eval(car(cdr(currentBinding)), frame);
-        addBinding(letFrame, var->s, value);
-        bindings = cdr(bindings);
+Item *callFunction(Item *call, int base, Item **tree, Frame **frame);
+void evalAtomicOperands(Continuation *k);
+
+// start a named let. the expander only leaves one in the program where its
+// name is used just to call it from tail position in its body, so it runs
+// as a loop: a LOOP_TYPE item bound to the name in a frame that also holds
+// the variables' binding cells, which each call of the loop overwrites
+// before jumping back to the start of the body. the loop is entered by
+// calling it with the initial values. takes in the form and pointers to
+// the machine's expression and frame, and returns as evalCall does
+Item *evalNamedLet(Item *form, Item **tree, Frame **frame) {
+    Item *args = cdr(form);
+    if (length(args) < 3) {
+        evaluationError("named let expects a name, bindings and a body");
+    }
+    Item *bindings = car(cdr(args));
+    checkBindings(bindings, 1);
+
+    Frame *loopFrame = createFrame(*frame);
+    Item *loop = talloc(sizeof(Item));
+    loop->type = LOOP_TYPE;
+    loop->cl.functionCode = cdr(cdr(args));
+    loop->cl.frame = loopFrame;
+    addBinding(loopFrame, car(args)->s, loop);
+    Item *cells = makeNull();
+    Item *inits = makeNull();
+    for (Item *b = bindings; !isNull(b); b = cdr(b)) {
+        addBinding(loopFrame, car(car(b))->s, &unassigned);
+        cells = cons(car(loopFrame->bindings), cells);
+        inits = cons(car(cdr(car(b))), inits);
+    }
+    loop->cl.paramNames = reverse(cells);
+
+    Continuation *k = pushContinuation(ARGS_CONT, reverse(inits), *frame);
+    k->base = argTop;
+    k->data = form;
+    pushArgument(loop);
+    evalAtomicOperands(k);
+    if (!isNull(k->rest)) {
+        *tree = car(k->rest);
+        k->rest = cdr(k->rest);
+        return NULL;
     }
+    contTop--;
+    return callFunction(form, k->base, tree, frame);
+}
 
-    return evalBody(body, letFrame);
+// start the next iteration of a named let's loop. the values are written
+// into the binding cells of its variables, so no frame is made. takes in
+// the loop and the values as a count and a vector, and returns the frame
+// its body runs in
+Frame *startIteration(Item *loop, int argc, Item **argv) {
+    Item *cells = loop->cl.paramNames;
+    for (int i = 0; i < argc; i++, cells = cdr(cells)) {
+        if (isNull(cells)) {
+            evaluationError("too many arguments");
+        }
+        car(cells)->c.cdr = argv[i];
+    }
+    if (!isNull(cells)) {
+        evaluationError("too few arguments");
+    }
+    return loop->cl.frame;
 }
 
-// evaluate a define expression. takes in arguments pointer and a frame 
-// pointer, returns a void type pointer
+// start a define expression. takes in arguments pointer and a frame pointer,
+// and returns the expression whose value is to be bound
 Item *evalDefine(Item *args, Frame *frame) {
     if (length(args) != 2) {
         evaluationError("there must be 2 arguments for define");
@@ -139,17 +607,298 @@ Item *evalDefine(Item *args, Frame *frame) {
     if (varName->type != SYMBOL_TYPE) {
         evaluationError("the first argument must be symbol");
     }
-    Item *expression = car(cdr(args));
-    Item *result = eval(expression, frame);
-    addBinding(frame, varName->s, result);
-    Item *voidReturn = talloc(sizeof(Item));
-    voidReturn->type = VOID_TYPE;
-    return voidReturn;
+    pushContinuation(DEFINE_CONT, varName, frame);
+    return car(cdr(args));
+}
+
+// finish a define expression once its value is known. takes in the variable,
+// the value and the frame to bind it in, and returns a void type
+Item *defineVariable(Item *varName, Item *value, Frame *frame) {
+    // redefining a global writes through its existing cell, which cached
+    // references already see. a local define that shadows a global is what
+    // invalidates them, since references in this scope that resolved to the
+    // global must now resolve to the new local binding instead
+    if (frame->table == NULL && tableLookup(globalTable, varName->s) != NULL) {
+        globalEpoch++;
+    }
+    // a local define fills in the binding its body made for it, which
+    // closures may already share
+    if (frame->table == NULL) {
+        for (Item *binding = frame->bindings; !isNull(binding); binding = cdr(binding)) {
+            if (car(car(binding))->s == varName->s) {
+                car(binding)->c.cdr = value;
+                return makeVoid();
+            }
+        }
+    }
+    addBinding(frame, varName->s, value);
+    return makeVoid();
+}
+
+// start a set! expression. takes in two arguments and a frame, and returns
+// the expression whose value is to be assigned
+Item *evalSet(Item *args, Frame *frame) {
+    if (length(args) != 2) {
+        evaluationError("not 2 arguments");
+    }
+    Item *var = car(args);
+    if (var->type != SYMBOL_TYPE) {
+        evaluationError("not a symbol");
+    }
+    pushContinuation(SET_CONT, var, frame);
+    return car(cdr(args));
+}
+
+// start a set-car! expression. takes in two arguments and a frame, and
+// returns the pair expression, saving the value expression for later
+Item *evalSetCar(Item *args, Frame *frame) {
+    if (length(args) != 2) {
+        evaluationError("not 2 arguments");
+    }
+    pushContinuation(SETCAR_CONT, cdr(args), frame);
+    return car(args);
+}
+
+// start a set-cdr! expression. takes in 2 arguments and a frame, and
+// returns the pair expression, saving the value expression for later
+Item *evalSetCdr(Item *args, Frame *frame) {
+    if (length(args) != 2) {
+        evaluationError("set-cdr! expects exactly 2 arguments");
+    }
+    pushContinuation(SETCDR_CONT, cdr(args), frame);
+    return car(args);
+}
+
+// start the next clause of a cond. takes in the clauses not yet tried and a
+// frame, and returns the test of the first one, or the body of an else
+// clause, or a void type if no clauses are left
+Item *evalCond(Item *args, Frame *frame) {
+    if (isNull(args)) {
+        return makeVoid();
+    }
+    Item *clause = car(args);
+    if (clause->type != CONS_TYPE || length(clause) < 1) {
+        evaluationError("clauses can't be empty lists");
+    }
+    Item *test = car(clause);
+    if (test->type == SYMBOL_TYPE && strcmp(test->s, "else") == 0) {
+        return evalBody(cdr(clause), frame);
+    }
+    pushContinuation(COND_CONT, args, frame);
+    return test;
+}
+
+// start the rest of an and expression. takes in the arguments not yet
+// evaluated and a frame, and returns the next one. the last argument is in
+// tail position, so nothing is saved for it
+Item *evalAnd(Item *args, Frame *frame) {
+    if (isNull(args)) {
+        Item *trueItem = talloc(sizeof(Item));
+        trueItem->type = BOOL_TYPE;
+        trueItem->i = 1;
+        return trueItem;
+    }
+    if (!isNull(cdr(args))) {
+        pushContinuation(AND_CONT, cdr(args), frame);
+    }
+    return car(args);
+}
+
+// start the rest of an or expression. takes in the arguments not yet
+// evaluated and a frame, and returns the next one. the last argument is in
+// tail position, so nothing is saved for it
+Item *evalOr(Item *args, Frame *frame) {
+    if (isNull(args)) {
+        Item *falseItem = talloc(sizeof(Item));
+        falseItem->type = BOOL_TYPE;
+        falseItem->i = 0;
+        return falseItem;
+    }
+    if (!isNull(cdr(args))) {
+        pushContinuation(OR_CONT, cdr(args), frame);
+    }
+    return car(args);
+}
+
+// checks whether a list of symbols holds a name. takes in the list and an
+// interned name
+int containsName(Item *names, char *name) {
+    for (; !isNull(names); names = cdr(names)) {
+        if (car(names)->s == name) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// add a list of parameters, which may end in a rest parameter, to a list of
+// names. takes in both lists and returns the new list of names
+Item *addParams(Item *params, Item *names) {
+    for (; params->type == CONS_TYPE; params = cdr(params)) {
+        if (car(params)->type == SYMBOL_TYPE) {
+            names = cons(car(params), names);
+        }
+    }
+    return params->type == SYMBOL_TYPE ? cons(params, names) : names;
 }
 
-// evaluate a lambda expression. takes in arguments pointer and a frame 
-// pointer, returns a closure type pointer
-Item *evalLambda(Item *args, Frame *frame) {
+Item *addFreeVariables(Item *expr, Item *bound, Item *free);
+
+// add the free variables of each expression in a list to a list of names.
+// takes in the expressions, the names bound around them and the list so
+// far, and returns the list
+Item *addFreeVariablesOfList(Item *exprs, Item *bound, Item *free) {
+    for (; exprs->type == CONS_TYPE; exprs = cdr(exprs)) {
+        free = addFreeVariables(car(exprs), bound, free);
+    }
+    return addFreeVariables(exprs, bound, free);
+}
+
+// add the free variables of an expression to a list of names. takes in the
+// expression, the names bound around it inside the lambda being analyzed
+// and the list so far, and returns the list. the forms that bind variables
+// are followed so their variables are not counted, and quoted data is
+// skipped. anything else counts, a define's name included, since counting
+// too much only captures a binding that is never used, while missing a
+// variable would lose it
+Item *addFreeVariables(Item *expr, Item *bound, Item *free) {
+    if (expr->type == CALL_SITE_TYPE) {
+        expr = expr->cs.symbol;
+    }
+    if (expr->type == SYMBOL_TYPE) {
+        if (!containsName(bound, expr->s) && !containsName(free, expr->s)) {
+            free = cons(expr, free);
+        }
+        return free;
+    }
+    if (expr->type != CONS_TYPE) {
+        return free;
+    }
+    Item *first = car(expr);
+    Item *args = cdr(expr);
+    if (first->type != SYMBOL_TYPE || args->type != CONS_TYPE) {
+        return addFreeVariablesOfList(expr, bound, free);
+    }
+    if (strcmp(first->s, "quote") == 0) {
+        return free;
+    } else if (strcmp(first->s, "lambda") == 0) {
+        return addFreeVariablesOfList(cdr(args), addParams(car(args), bound), free);
+    } else if (strcmp(first->s, "let") == 0 && car(args)->type == SYMBOL_TYPE &&
+               cdr(args)->type == CONS_TYPE) {
+        // a named let binds its name and then its variables around its body
+        Item *inner = cons(car(args), bound);
+        for (Item *b = car(cdr(args)); b->type == CONS_TYPE; b = cdr(b)) {
+            if (car(b)->type == CONS_TYPE) {
+                free = addFreeVariablesOfList(cdr(car(b)), bound, free);
+                if (car(car(b))->type == SYMBOL_TYPE) {
+                    inner = cons(car(car(b)), inner);
+                }
+            }
+        }
+        return addFreeVariablesOfList(cdr(cdr(args)), inner, free);
+    } else if (strcmp(first->s, "let") == 0 || strcmp(first->s, "let*") == 0 ||
+               strcmp(first->s, "letrec") == 0) {
+        int sequential = strcmp(first->s, "let*") == 0;
+        int recursive = strcmp(first->s, "letrec") == 0;
+        Item *inner = bound;
+        for (Item *b = car(args); b->type == CONS_TYPE; b = cdr(b)) {
+            if (car(b)->type == CONS_TYPE && car(car(b))->type == SYMBOL_TYPE) {
+                inner = cons(car(car(b)), inner);
+            }
+        }
+        for (Item *b = car(args); b->type == CONS_TYPE; b = cdr(b)) {
+            if (car(b)->type != CONS_TYPE) {
+                continue;
+            }
+            free = addFreeVariablesOfList(cdr(car(b)), recursive ? inner : bound, free);
+            if (sequential && car(car(b))->type == SYMBOL_TYPE) {
+                bound = cons(car(car(b)), bound);
+            }
+        }
+        return addFreeVariablesOfList(cdr(args), inner, free);
+    } else if (strcmp(first->s, "cond") == 0) {
+        for (Item *clauses = args; clauses->type == CONS_TYPE; clauses = cdr(clauses)) {
+            Item *clause = car(clauses);
+            if (clause->type == CONS_TYPE && car(clause)->type == SYMBOL_TYPE &&
+                strcmp(car(clause)->s, "else") == 0) {
+                clause = cdr(clause);
+            }
+            free = addFreeVariablesOfList(clause, bound, free);
+        }
+        return free;
+    } else if (strcmp(first->s, "define") == 0 || strcmp(first->s, "set!") == 0 ||
+               strcmp(first->s, "set-car!") == 0 || strcmp(first->s, "set-cdr!") == 0 ||
+               strcmp(first->s, "if") == 0 || strcmp(first->s, "and") == 0 ||
+               strcmp(first->s, "or") == 0) {
+        return addFreeVariablesOfList(args, bound, free);
+    }
+    return addFreeVariablesOfList(expr, bound, free);
+}
+
+// make the frame a closure keeps: a frame below the global one holding
+// just the binding cells of the closure's free variables, shared with the
+// frames they came from, so that assignments on either side are seen by
+// both. a name bound in several local frames gets each binding up to the
+// first that is not unassigned, in order, so a lookup finds the same one
+// it would have found in the full chain. takes in the free variables and
+// the frame the closure is made in, and returns the frame
+Frame *captureFrame(Item *free, Frame *frame) {
+    Item *cells = makeNull();
+    for (; !isNull(free); free = cdr(free)) {
+        char *name = car(free)->s;
+        Item *found = makeNull();
+        int assigned = 0;
+        for (Frame *f = frame; f->table == NULL && !assigned; f = f->parent) {
+            for (Item *b = f->bindings; !isNull(b) && !assigned; b = cdr(b)) {
+                if (car(car(b))->s == name) {
+                    found = cons(car(b), found);
+                    assigned = cdr(car(b)) != &unassigned;
+                }
+            }
+        }
+        for (; !isNull(found); found = cdr(found)) {
+            cells = cons(car(found), cells);
+        }
+    }
+    if (isNull(cells)) {
+        return globalFrame;
+    }
+    Frame *captured = createFrame(globalFrame);
+    captured->bindings = cells;
+    return captured;
+}
+
+// make a promise. takes in the expression to evaluate in a frame when it
+// is forced, or a procedure of no arguments and a NULL frame, and whether
+// the expression produces the promise to force in its place, as that of a
+// delay-force does. returns the promise
+Item *makePromise(Item *code, Frame *frame, int chained) {
+    Promise *state = talloc(sizeof(Promise));
+    state->done = 0;
+    state->chained = chained;
+    state->value = code;
+    state->frame = frame;
+    Item *promise = talloc(sizeof(Item));
+    promise->type = PROMISE_TYPE;
+    promise->pm = state;
+    return promise;
+}
+
+// evaluate a delay or delay-force expression, which makes a promise of its
+// expression in the current frame. takes in the keyword, the arguments and
+// the frame, and returns the promise
+Item *evalDelay(Item *keyword, Item *args, Frame *frame) {
+    if (args->type != CONS_TYPE || !isNull(cdr(args))) {
+        evaluationError("delay expects exactly one expression");
+    }
+    return makePromise(car(args), frame, strcmp(keyword->s, "delay-force") == 0);
+}
+
+// evaluate a lambda expression. takes in the lambda keyword of the
+// expression, its arguments and a frame pointer, and returns a closure
+// type pointer. the free variables of the expression are found the first
+// time it is evaluated and cached on its keyword
+Item *evalLambda(Item *keyword, Item *args, Frame *frame) {
     if (length(args) < 2) {
         evaluationError("there must be at least 2 arguments");
     }
@@ -184,11 +933,15 @@ Item *evalLambda(Item *args, Frame *frame) {
         evaluationError("must be list of symbols or single symbol");
     }
 
+    if (keyword->sc.cell == NULL) {
+        keyword->sc.cell = addFreeVariablesOfList(body, addParams(params, makeNull()), makeNull());
+    }
+
     Item *closure = talloc(sizeof(Item));
     closure->type = CLOSURE_TYPE;
     closure->cl.paramNames = params;
     closure->cl.functionCode = body;
-    closure->cl.frame = frame;
+    closure->cl.frame = frame->table != NULL ? frame : captureFrame(keyword->sc.cell, frame);
     return closure;
 }
 
@@ -201,324 +954,592 @@ Item *evalQuote(Item *args) {
     return car(args);
 }
 
-// apply a function to arguments. takes in a function pointer and an 
-// arguments pointer. returns the result of applying the function 
-Item *apply(Item *function, Item *args) {
-    if (function->type == PRIMITIVE_TYPE) {
-        return function->pf(args);
-    } else if (function->type != CLOSURE_TYPE) {
-        evaluationError("not a function");
-    }
-    
+// bind the arguments of a closure call. takes in a closure and a list of
+// evaluated arguments, and returns a new frame, below the closure's own,
+// binding each parameter to its argument. a rest parameter is bound to the
+// list of the remaining arguments
+Frame *bindArguments(Item *function, int argc, Item **argv) {
     Frame *newFrame = createFrame(function->cl.frame);
     Item *paramNames = function->cl.paramNames;
+    int i = 0;
 
-    while (!isNull(paramNames)) {
-        if (paramNames->type == SYMBOL_TYPE) {
-            addBinding(newFrame, paramNames->s, args);
-            return evalBody(function->cl.functionCode, newFrame);
-        }
-        if (isNull(args)) {
+    while (paramNames->type == CONS_TYPE) {
+        if (i == argc) {
             evaluationError("too few arguments");
         }
-        addBinding(newFrame, car(paramNames)->s, car(args));
+        addBinding(newFrame, car(paramNames)->s, argv[i++]);
         paramNames = cdr(paramNames);
-        args = cdr(args);
     }
 
-    if (!isNull(args)) {
+    if (paramNames->type == SYMBOL_TYPE) {
+        Item *rest = makeNull();
+        for (int j = argc - 1; j >= i; j--) {
+            rest = cons(argv[j], rest);
+        }
+        addBinding(newFrame, paramNames->s, rest);
+    } else if (i < argc) {
         evaluationError("too many arguments");
     }
-
-    return evalBody(function->cl.functionCode, newFrame);
+    return newFrame;
 }
 
-// recursively evaluate each element in a given list
-// in a frame. takes in a list and a frame and evaluates the list's
-// arguments
-Item *evalList(Item *list, Frame *frame) {
-    if (isNull(list)) {
-        return makeNull();
-    } else {
-        Item *evaluatedCar = eval(car(list), frame);
-        Item *evaluatedCdr = evalList(cdr(list), frame);
-        return cons(evaluatedCar, evaluatedCdr);
-    }
-}
 
-// implement let* special form. takes in at least 2 arguments
-// and a frame and returns their letstar evaluation
-Item *evalLetStar(Item *args, Frame *frame) {
-    if (length(args) < 2) {
-        evaluationError("not 2 arguments");
+// apply a function to arguments. a closure is run by a nested run of an
+// evaluator, on the C stack, so its depth is checked first, wherever the
+// call comes from. takes in a function pointer and the arguments as a
+// count and a vector. returns the result of applying the function
+Item *apply(Item *function, int argc, Item **argv) {
+    if (function->type == PRIMITIVE_TYPE) {
+        return callPrimitive(function->pr, argc, argv);
+    } else if (function->type == COMPILED_TYPE) {
+        return vmApply(function, argc, argv);
+    } else if (function->type == CONTINUATION_TYPE || function->type == GENERATOR_TYPE) {
+        return callControl(function, argc, argv);
+    } else if (function->type == MEMOIZED_TYPE) {
+        return callMemoized(function, argc, argv);
+    } else if (function->type != CLOSURE_TYPE) {
+        evaluationError("not a function");
     }
-    
-    Item *bindings = car(args);
-    Item *body = cdr(args);
-    Frame *letStarFrame = frame;
 
-    while (!isNull(bindings)) {
-        Item *currentBinding = car(bindings);
-        if (currentBinding->type != CONS_TYPE || length(currentBinding) != 2) {
-            evaluationError("binding invalid");
-        }
-        Item *var = car(currentBinding);
-        if (var->type != SYMBOL_TYPE) {
-            evaluationError("variable doesn't exist");
-        }
-        Item *value = eval(car(cdr(currentBinding)), letStarFrame);
-        letStarFrame = createFrame(letStarFrame);
-        addBinding(letStarFrame, var->s, value);
-        bindings = cdr(bindings);
+    checkStackDepth();
+    Frame *newFrame = bindArguments(function, argc, argv);
+    int base = contTop;
+    return run(evalBody(function->cl.functionCode, newFrame), newFrame, base);
+}
+
+// evaluate an atom: a constant or a variable reference. takes in the atom
+// and a frame and returns its value
+Item *evalAtom(Item *tree, Frame *frame) {
+    switch (tree->type) {
+        case INT_TYPE:
+        case BIGNUM_TYPE:
+        case VECTOR_TYPE:
+        case DOUBLE_TYPE:
+        case STR_TYPE:
+        case BOOL_TYPE:
+        case VOID_TYPE:
+            return tree;
+        case SYMBOL_TYPE:
+            return lookupVariable(tree, frame);
+        case CALL_SITE_TYPE:
+            return lookupVariable(tree->cs.symbol, frame);
+        default:
+            evaluationError("unknown type");
+            return NULL;
     }
-    
-    return evalBody(body, letStarFrame);
 }
 
-// implement letrec special form. takes in at least 2 arguments
-// and a frame and returns an evaluation of these 2 arguments'
-// body recursively
-Item *evalLetRec(Item *args, Frame *frame) {
-    if (length(args) < 2) {
-        evaluationError("not 2 arguments");
+// evaluate as many of a call's remaining operands as can be evaluated
+// without the machine, i.e. atoms. takes in the continuation for the call
+// and does not return anything; the values are pushed on the argument stack
+void evalAtomicOperands(Continuation *k) {
+    while (!isNull(k->rest) && car(k->rest)->type != CONS_TYPE) {
+        pushArgument(evalAtom(car(k->rest), k->frame));
+        k->rest = cdr(k->rest);
     }
+}
 
-    Item *bindings = car(args);
-    Item *body = cdr(args);
-    Frame *letRecFrame = createFrame(frame);
+// Calls of the arithmetic and comparison primitives specialize themselves
+// to the operand types they see. The first time such a call is made with
+// two operands, the operator symbol at its head in the parse tree is
+// replaced by a call site recording the primitive and whether the operands
+// were both integers or both doubles. Calls through the site check that the
+// operator is still bound to that primitive and the operands still have
+// those types, and then compute the result directly, skipping the argument
+// stack, the arity check and the primitive's own type dispatch. A call that
+// fails the check turns the site generic for good, after which it is made
+// like any other call. Sites that type inference proved are in the tree
+// before the program runs, and are computed without any check.
+
+// the names of the primitives the site operations compute
+const char *siteOperationNames[] = {"+", "-", "*", "<", ">", "=", "modulo"};
+
+// find the operation a call site of a primitive can compute. takes in the
+// primitive and returns the operation, or -1 if it has no specialized
+// versions
+int siteOperation(Primitive *primitive) {
+    if (primitive->call == primitivePlus) {
+        return SITE_ADD;
+    } else if (primitive->call2 == primitiveMinus) {
+        return SITE_SUBTRACT;
+    } else if (primitive->call == primitiveMultiply) {
+        return SITE_MULTIPLY;
+    } else if (primitive->call2 == primitiveLess) {
+        return SITE_LESS;
+    } else if (primitive->call2 == primitiveGreater) {
+        return SITE_GREATER;
+    } else if (primitive->call2 == primitiveEqual) {
+        return SITE_EQUAL;
+    } else if (primitive->call2 == primitiveModulo) {
+        return SITE_MODULO;
+    }
+    return -1;
+}
 
-    Item *tempBindings = bindings;
-    while (!isNull(tempBindings)) {
-        Item *currentBinding = car(tempBindings);
-        if (currentBinding->type != CONS_TYPE || length(currentBinding) != 2) {
-            evaluationError("binding invalid");
-        }
-        Item *var = car(currentBinding);
-        if (var->type != SYMBOL_TYPE) {
-            evaluationError("variable doesn't exist");
-        }
-        Item *nullItem = talloc(sizeof(Item));
-        nullItem->type = NULL_TYPE;
-        addBinding(letRecFrame, var->s, nullItem);
-        tempBindings = cdr(tempBindings);
+// give a primitive call a call site the first time it is made, if its
+// operator is a global variable bound to a primitive with specialized
+// versions. takes in the call, the primitive and the two operands, and
+// does not return anything
+void specializeCall(Item *call, Item *function, Item **argv) {
+    Item *symbol = car(call);
+    if (symbol->type != SYMBOL_TYPE || symbol->sc.epoch != globalEpoch ||
+        cdr(symbol->sc.cell) != function) {
+        return;
     }
+    int operation = siteOperation(function->pr);
+    if (operation < 0) {
+        return;
+    }
+    Item *site = talloc(sizeof(Item));
+    site->type = CALL_SITE_TYPE;
+    site->cs.symbol = symbol;
+    site->cs.primitive = function->pr;
+    site->cs.operation = operation;
+    site->cs.kind = GENERIC_SITE;
+    if (argv[0]->type == INT_TYPE && argv[1]->type == INT_TYPE) {
+        site->cs.kind = FIXNUM_SITE;
+    } else if (argv[0]->type == DOUBLE_TYPE && argv[1]->type == DOUBLE_TYPE &&
+               operation != SITE_MODULO) {
+        site->cs.kind = FLONUM_SITE;
+    }
+    call->c.car = site;
+}
 
-    tempBindings = bindings;
-    while (!isNull(tempBindings)) {
-        Item *currentBinding = car(tempBindings);
-        Item *var = car(currentBinding);
-        Item *value = eval(car(cdr(currentBinding)), letRecFrame);
-
-        if (value->type == NULL_TYPE) {
-            evaluationError("variable cannot be NULL");
-        }
+// compute an operation on two integers. takes in the operation and the
+// operands and returns the result. bignums and results that overflow are
+// left to the primitive, as is modulo by zero, which it reports
+Item *computeFixnum(int operation, Item **argv) {
+    Item *a = argv[0];
+    Item *b = argv[1];
+    if (a->type != INT_TYPE || b->type != INT_TYPE) {
+        return callPrimitive(findPrimitive(siteOperationNames[operation]), 2, argv);
+    }
+    Item *result = talloc(sizeof(Item));
+    result->type = BOOL_TYPE;
+    int overflow = 0;
+    switch (operation) {
+        case SITE_ADD:
+            overflow = __builtin_add_overflow(a->i, b->i, &result->i);
+            break;
+        case SITE_SUBTRACT:
+            overflow = __builtin_sub_overflow(a->i, b->i, &result->i);
+            break;
+        case SITE_MULTIPLY:
+            overflow = __builtin_mul_overflow(a->i, b->i, &result->i);
+            break;
+        case SITE_MODULO:
+            overflow = b->i == 0 || b->i == -1;
+            if (!overflow) {
+                result->i = a->i % b->i;
+            }
+            break;
+        case SITE_LESS:
+            result->i = a->i < b->i;
+            return result;
+        case SITE_GREATER:
+            result->i = a->i > b->i;
+            return result;
+        default:
+            result->i = a->i == b->i;
+            return result;
+    }
+    if (overflow) {
+        return callPrimitive(findPrimitive(siteOperationNames[operation]), 2, argv);
+    }
+    result->type = INT_TYPE;
+    return result;
+}
 
-        Item *binding = lookupSymbol(var->s, letRecFrame);
-        binding->type = value->type;
-        switch (value->type) {
-            case INT_TYPE:
-                binding->i = value->i;
-                break;
-            case DOUBLE_TYPE:
-                binding->d = value->d;
-                break;
-            case STR_TYPE:
-            case SYMBOL_TYPE:
-                binding->s = talloc_strdup(value->s);
-                break;
-            case CONS_TYPE:
-                binding->c.car = value->c.car;
-                binding->c.cdr = value->c.cdr;
-                break;
-            case CLOSURE_TYPE:
-                binding->cl.paramNames = value->cl.paramNames;
-                binding->cl.functionCode = value->cl.functionCode;
-                binding->cl.frame = value->cl.frame;
-                break;
-            case PRIMITIVE_TYPE:
-                binding->pf = value->pf;
-                break;
-            default:
-                evaluationError("type unknown");
-        }
-        tempBindings = cdr(tempBindings);
+// compute an operation on two doubles. takes in the operation and the
+// operands and returns the result. sums start from 0.0 and products from
+// 1.0, as the primitives' do
+Item *computeFlonum(int operation, Item **argv) {
+    Item *a = argv[0];
+    Item *b = argv[1];
+    Item *result = talloc(sizeof(Item));
+    result->type = BOOL_TYPE;
+    switch (operation) {
+        case SITE_ADD:
+            result->d = 0.0 + a->d + b->d;
+            break;
+        case SITE_SUBTRACT:
+            result->d = a->d - b->d;
+            break;
+        case SITE_MULTIPLY:
+            result->d = 1.0 * a->d * b->d;
+            break;
+        case SITE_LESS:
+            result->i = a->d < b->d;
+            return result;
+        case SITE_GREATER:
+            result->i = a->d > b->d;
+            return result;
+        default:
+            result->i = a->d == b->d;
+            return result;
     }
-
-    return evalBody(body, letRecFrame);
+    result->type = DOUBLE_TYPE;
+    return result;
 }
 
-// implement set! special form. takes in two arguments and a frame
-// and returns a void_type
-Item *evalSet(Item *args, Frame *frame) {
-    if (length(args) != 2) {
-        evaluationError("not 2 arguments");
+// compute a specialized call site's operation. takes in the site and its
+// two operands and returns the result, or NULL if the operands are not of
+// the kind the site expects. proven sites take the operands on trust
+Item *computeSpecialized(Item *site, Item **argv) {
+    switch (site->cs.kind) {
+        case PROVEN_FIXNUM_SITE:
+            return computeFixnum(site->cs.operation, argv);
+        case PROVEN_FLONUM_SITE:
+            return computeFlonum(site->cs.operation, argv);
+        case FIXNUM_SITE:
+            if (argv[0]->type != INT_TYPE || argv[1]->type != INT_TYPE) {
+                return NULL;
+            }
+            return computeFixnum(site->cs.operation, argv);
+        default:
+            if (argv[0]->type != DOUBLE_TYPE || argv[1]->type != DOUBLE_TYPE) {
+                return NULL;
+            }
+            return computeFlonum(site->cs.operation, argv);
     }
-    Item *var = car(args);
-    if (var->type != SYMBOL_TYPE) {
-        evaluationError("not a symbol");
+}
+
+// call a primitive with two operands through the call's site, giving the
+// call a site first if it has none. takes in the call, the primitive and
+// the operands, and returns the result
+Item *callPrimitiveSite(Item *call, Item *function, Item **argv) {
+    if (car(call)->type == SYMBOL_TYPE) {
+        specializeCall(call, function, argv);
+    }
+    Item *site = car(call);
+    if (site->type == CALL_SITE_TYPE && site->cs.kind != GENERIC_SITE) {
+        Item *result = function->pr == site->cs.primitive ? computeSpecialized(site, argv) : NULL;
+        if (result != NULL) {
+            return result;
+        }
+        site->cs.kind = GENERIC_SITE;
     }
-    Item *value = eval(car(cdr(args)), frame);
-    Item *binding = lookupSymbol(var->s, frame);
-    binding->type = value->type;
-    binding->s = value->s;
-    Item *voidReturn = talloc(sizeof(Item));
-    voidReturn->type = VOID_TYPE;
-    return voidReturn;
+    return callPrimitive(function->pr, 2, argv);
 }
 
-// implement set-car! special form. takes in two arguments and a frame
-// and returns void type
-Item *evalSetCar(Item *args, Frame *frame) {
-    if (length(args) != 2) {
-        evaluationError("not 2 arguments");
+// make a call through a specialized call site without the machine, when
+// its operands are atoms. takes in the call and a frame, and returns the
+// value, or NULL if the call has to be made the general way
+Item *evalSpecializedCall(Item *call, Frame *frame) {
+    Item *site = car(call);
+    Item *first = car(cdr(call));
+    Item *second = car(cdr(cdr(call)));
+    if (site->cs.kind == GENERIC_SITE || first->type == CONS_TYPE || second->type == CONS_TYPE) {
+        return NULL;
     }
-    Item *pair = eval(car(args), frame);
-    if (pair->type != CONS_TYPE) {
-        evaluationError("not a pair");
+    if (site->cs.kind == PROVEN_FIXNUM_SITE || site->cs.kind == PROVEN_FLONUM_SITE) {
+        Item *argv[2] = {evalAtom(first, frame), evalAtom(second, frame)};
+        return computeSpecialized(site, argv);
     }
-    Item *value = eval(car(cdr(args)), frame);
-    pair->c.car = value;
-    Item *voidReturn = talloc(sizeof(Item));
-    voidReturn->type = VOID_TYPE;
-    return voidReturn;
+    Item *function = lookupVariable(site->cs.symbol, frame);
+    if (function->type != PRIMITIVE_TYPE || function->pr != site->cs.primitive) {
+        site->cs.kind = GENERIC_SITE;
+        return NULL;
+    }
+    Item *argv[2] = {evalAtom(first, frame), evalAtom(second, frame)};
+    Item *result = computeSpecialized(site, argv);
+    if (result == NULL) {
+        site->cs.kind = GENERIC_SITE;
+        return callPrimitive(function->pr, 2, argv);
+    }
+    return result;
 }
 
-// implements cond special form. takes in arguments that are clauses
-// and a frame and returns a void type
-Item *evalCond(Item *args, Frame *frame) {
-    while (!isNull(args)) {
-        Item *clause = car(args);
-        if (clause->type != CONS_TYPE || length(clause) < 1) {
-            evaluationError("clauses can't be empty lists");
-        }
-        Item *test = car(clause);
-        if (test->type == SYMBOL_TYPE && strcmp(test->s, "else") == 0) {
-            return evalBody(cdr(clause), frame);
-        }
-        Item *result = eval(test, frame);
-        if (result->type == BOOL_TYPE && result->i) {
-            return evalBody(cdr(clause), frame);
+// finish a call once the operator and all operands have values. takes in
+// the call, where those values start on the argument stack, and pointers
+// to the machine's expression and frame. a primitive is applied right away
+// and its value returned. a closure call is a jump: its arguments are
+// bound, the machine is pointed at its body, and NULL is returned. either
+// way the values are popped
+Item *callFunction(Item *call, int base, Item **tree, Frame **frame) {
+    Item *function = argStack[base];
+    int argc = argTop - base - 1;
+    Item **argv = argStack + base + 1;
+    if (function->type == PRIMITIVE_TYPE && argc == 2) {
+        Item *result = callPrimitiveSite(call, function, argv);
+        argTop = base;
+        return result;
+    }
+    if (function->type == LOOP_TYPE) {
+        *frame = startIteration(function, argc, argv);
+        argTop = base;
+        *tree = evalBody(function->cl.functionCode, *frame);
+        return NULL;
+    }
+    if (function->type == MEMOIZED_TYPE && function->mo.function->type == CLOSURE_TYPE) {
+        // a miss runs the closure's body on the machine, like any call,
+        // and keeps its value once the body returns
+        Item *pending;
+        Item *result = memoLookup(function, argc, argv, &pending);
+        if (result != NULL) {
+            argTop = base;
+            return result;
         }
-        args = cdr(args);
+        pushContinuation(MEMO_CONT, makeNull(), *frame)->data = pending;
+        function = function->mo.function;
     }
-    Item *voidReturn = talloc(sizeof(Item));
-    voidReturn->type = VOID_TYPE;
-    return voidReturn;
+    if (function->type != CLOSURE_TYPE) {
+        Item *result = apply(function, argc, argv);
+        argTop = base;
+        return result;
+    }
+    *frame = bindArguments(function, argc, argv);
+    argTop = base;
+    *tree = evalBody(function->cl.functionCode, *frame);
+    return NULL;
 }
 
-
-// implement set-cdr! special form. takes in 2 arguments
-// and a frame and returns a void_type
-Item *evalSetCdr(Item *args, Frame *frame) {
-    if (length(args) != 2) {
-        evaluationError("set-cdr! expects exactly 2 arguments");
+// start a call. takes in the call expression and pointers to the machine's
+// expression and frame. atomic operands are evaluated right away; if any
+// operand needs the machine, the call is saved as a continuation and the
+// machine is pointed at that operand. returns a value as callFunction does,
+// or NULL when the machine has an expression to evaluate
+Item *evalCall(Item *call, Item **tree, Frame **frame) {
+    if (car(call)->type == CALL_SITE_TYPE) {
+        Item *value = evalSpecializedCall(call, *frame);
+        if (value != NULL) {
+            return value;
+        }
     }
-    Item *pair = eval(car(args), frame);
-    if (pair->type != CONS_TYPE) {
-        evaluationError("set-cdr! expects a pair as the first argument");
+    Continuation *k = pushContinuation(ARGS_CONT, call, *frame);
+    k->base = argTop;
+    k->data = call;
+    evalAtomicOperands(k);
+    if (!isNull(k->rest)) {
+        *tree = car(k->rest);
+        k->rest = cdr(k->rest);
+        return NULL;
     }
-    Item *value = eval(car(cdr(args)), frame);
-    pair->c.cdr = value;
-    Item *voidReturn = talloc(sizeof(Item));
-    voidReturn->type = VOID_TYPE;
-    return voidReturn;
+    contTop--;
+    return callFunction(call, k->base, tree, frame);
 }
 
-// implement and special form. takes in boolean arguments
-// and returns true if all are true.
-Item *evalAnd(Item *args, Frame *frame) {
-    while (!isNull(args)) {
-        Item *result = eval(car(args), frame);
-        if (result->type != BOOL_TYPE) {
-            evaluationError("boolean arguments expected");
-        }
-        if (!result->i) {
-            return result;
+// evaluate one step of an expression. takes in pointers to the machine's
+// expression and frame. returns the value of the expression if it has one
+// right away; otherwise moves the machine on to the next expression to
+// evaluate and returns NULL
+Item *evalStep(Item **tree, Frame **frame) {
+    if ((*tree)->type != CONS_TYPE) {
+        return evalAtom(*tree, *frame);
+    }
+    Item *first = car(*tree);
+    Item *args = cdr(*tree);
+    if (first->type == SYMBOL_TYPE) {
+        if (strcmp(first->s, "define") == 0) {
+            *tree = evalDefine(args, *frame);
+            return NULL;
+        } else if (strcmp(first->s, "let") == 0) {
+            if (args->type == CONS_TYPE && car(args)->type == SYMBOL_TYPE) {
+                return evalNamedLet(*tree, tree, frame);
+            }
+            *tree = evalLet(args, frame);
+            return NULL;
+        } else if (strcmp(first->s, "let*") == 0) {
+            *tree = evalLetStar(args, frame);
+            return NULL;
+        } else if (strcmp(first->s, "letrec") == 0) {
+            *tree = evalLetRec(args, frame);
+            return NULL;
+        } else if (strcmp(first->s, "set!") == 0) {
+            *tree = evalSet(args, *frame);
+            return NULL;
+        } else if (strcmp(first->s, "set-car!") == 0) {
+            *tree = evalSetCar(args, *frame);
+            return NULL;
+        } else if (strcmp(first->s, "set-cdr!") == 0) {
+            *tree = evalSetCdr(args, *frame);
+            return NULL;
+        } else if (strcmp(first->s, "lambda") == 0) {
+            return evalLambda(first, args, *frame);
+        } else if (strcmp(first->s, "delay") == 0 || strcmp(first->s, "delay-force") == 0) {
+            return evalDelay(first, args, *frame);
+        } else if (strcmp(first->s, "cond") == 0) {
+            *tree = evalCond(args, *frame);
+            return NULL;
+        } else if (strcmp(first->s, "if") == 0) {
+            *tree = evalIf(args, *frame);
+            return NULL;
+        } else if (strcmp(first->s, "quote") == 0) {
+            return evalQuote(args);
+        } else if (strcmp(first->s, "and") == 0) {
+            *tree = evalAnd(args, *frame);
+            return NULL;
+        } else if (strcmp(first->s, "or") == 0) {
+            *tree = evalOr(args, *frame);
+            return NULL;
         }
-        args = cdr(args);
     }
-    Item *trueItem = talloc(sizeof(Item));
-    trueItem->type = BOOL_TYPE;
-    trueItem->i = 1;
-    return trueItem;
+    return evalCall(*tree, tree, frame);
 }
 
-// implements or. takes in boolean arguments and a frame
-// and returns true if one of them is true
-Item *evalOr(Item *args, Frame *frame) {
-    while (!isNull(args)) {
-        Item *result = eval(car(args), frame);
-        if (result->type != BOOL_TYPE) {
-            evaluationError("boolean arguments expected");
+// hand a value to the continuation on top of the stack. takes in the value
+// and pointers to the machine's expression and frame. returns the value of
+// the continuation if it finishes with one, in which case it has been
+// popped; otherwise moves the machine on to the next expression to evaluate
+// and returns NULL
+Item *resume(Item *value, Item **tree, Frame **frame) {
+    Continuation *k = &contStack[contTop - 1];
+    Item *rest = k->rest;
+    *frame = k->frame;
+
+    switch (k->kind) {
+        case BODY_CONT:
+            if (isNull(cdr(rest))) {
+                contTop--;
+            } else {
+                k->rest = cdr(rest);
+            }
+            *tree = car(rest);
+            return NULL;
+        case IF_CONT:
+            contTop--;
+            if (value->type != BOOL_TYPE) {
+                evaluationError("if expects a boolean as the first argument");
+            }
+            *tree = value->i ? car(rest) : car(cdr(rest));
+            return NULL;
+        case DEFINE_CONT:
+            contTop--;
+            return defineVariable(rest, value, *frame);
+        case SET_CONT:
+            contTop--;
+            // assigning writes through the binding cell, so references that
+            // cached the cell see the new value without invalidating anything
+            lookupBinding(rest->s, *frame)->c.cdr = value;
+            return makeVoid();
+        case SETCAR_CONT:
+        case SETCDR_CONT:
+            // the pair is evaluated first and saved in data while the new
+            // value is evaluated
+            if (k->data == NULL) {
+                if (value->type != CONS_TYPE) {
+                    evaluationError(k->kind == SETCAR_CONT ? "not a pair" :
+                                    "set-cdr! expects a pair as the first argument");
+                }
+                k->data = value;
+                *tree = car(rest);
+                return NULL;
+            }
+            contTop--;
+            if (k->kind == SETCAR_CONT) {
+                k->data->c.car = value;
+            } else {
+                k->data->c.cdr = value;
+            }
+            return makeVoid();
+        case LET_CONT:
+            addBinding(k->target, car(car(rest))->s, value);
+            k->rest = cdr(rest);
+            if (!isNull(k->rest)) {
+                *tree = car(cdr(car(k->rest)));
+                return NULL;
+            }
+            contTop--;
+            *frame = k->target;
+            *tree = evalBody(k->data, *frame);
+            return NULL;
+        case LETSTAR_CONT:
+            *frame = createFrame(*frame);
+            addBinding(*frame, car(car(rest))->s, value);
+            k->frame = *frame;
+            k->rest = cdr(rest);
+            if (!isNull(k->rest)) {
+                *tree = car(cdr(car(k->rest)));
+                return NULL;
+            }
+            contTop--;
+            *tree = evalBody(k->data, *frame);
+            return NULL;
+        case LETREC_CONT:
+            if (value->type == NULL_TYPE) {
+                evaluationError("variable cannot be NULL");
+            }
+            // the placeholder's binding cell is updated, so closures that
+            // already captured the letrec frame see the value
+            lookupBinding(car(car(rest))->s, *frame)->c.cdr = value;
+            k->rest = cdr(rest);
+            if (!isNull(k->rest)) {
+                *tree = car(cdr(car(k->rest)));
+                return NULL;
+            }
+            contTop--;
+            *tree = evalBody(k->data, *frame);
+            return NULL;
+        case COND_CONT:
+            contTop--;
+            if (value->type == BOOL_TYPE && value->i) {
+                if (isNull(cdr(car(rest)))) {
+                    return value;
+                }
+                *tree = evalBody(cdr(car(rest)), *frame);
+            } else {
+                *tree = evalCond(cdr(rest), *frame);
+            }
+            return NULL;
+        case AND_CONT:
+        case OR_CONT:
+            contTop--;
+            if (value->type != BOOL_TYPE) {
+                evaluationError("boolean arguments expected");
+            }
+            if (value->i == (k->kind == OR_CONT)) {
+                return value;
+            }
+            *tree = k->kind == AND_CONT ? evalAnd(rest, *frame) : evalOr(rest, *frame);
+            return NULL;
+        case ARGS_CONT:
+            pushArgument(value);
+            evalAtomicOperands(k);
+            if (!isNull(k->rest)) {
+                *tree = car(k->rest);
+                k->rest = cdr(k->rest);
+                return NULL;
+            }
+            contTop--;
+            return callFunction(k->data, k->base, tree, frame);
+        case MEMO_CONT:
+            contTop--;
+            memoStore(k->data, value);
+            return value;
+    }
+    return NULL;
+}
+
+// the number of times the machine has called evalStep
+long evalSteps = 0;
+
+// get the number of steps the machine has taken
+long getEvalSteps() {
+    return evalSteps;
+}
+
+// run the machine. takes in an expression, the frame to evaluate it in, and
+// the height of the continuation stack below which this run must not pop,
+// and returns the value of the expression. runs nest: a primitive that
+// calls back into the evaluator starts a new run above the current one
+Item *run(Item *tree, Frame *frame, int base) {
+    while (1) {
+        evalSteps++;
+        Item *value = evalStep(&tree, &frame);
+        while (value != NULL && contTop > base) {
+            value = resume(value, &tree, &frame);
         }
-        if (result->i) {
-            return result;
+        if (value != NULL) {
+            return value;
         }
-        args = cdr(args);
     }
-    Item *falseItem = talloc(sizeof(Item));
-    falseItem->type = BOOL_TYPE;
-    falseItem->i = 0;
-    return falseItem;
 }
 
 // evaluate an expression in a given frame. takes in a parsed tree
 // and a frame and returns what it evaluates to
 Item *eval(Item *tree, Frame *frame) {
     if (tree == NULL) return NULL;
-
-    switch (tree->type) {
-        case INT_TYPE:
-        case DOUBLE_TYPE:
-        case STR_TYPE:
-        case BOOL_TYPE:
-            return tree;
-        case SYMBOL_TYPE:
-            return lookupSymbol(tree->s, frame);
-        case CONS_TYPE: {
-            Item *first = car(tree);
-            Item *args = cdr(tree);
-            if (first->type != SYMBOL_TYPE) {
-                Item *function = eval(first, frame);
-                Item *evaluatedArgs = evalList(args, frame);
-                return apply(function, evaluatedArgs);
-            }
-            if (strcmp(first->s, "define") == 0) {
-                return evalDefine(args, frame);
-            } else if (strcmp(first->s, "let") == 0) {
-                return evalLet(args, frame);
-            } else if (strcmp(first->s, "let*") == 0) {
-                return evalLetStar(args, frame);
-            } else if (strcmp(first->s, "letrec") == 0) {
-                return evalLetRec(args, frame);
-            } else if (strcmp(first->s, "set!") == 0) {
-                return evalSet(args, frame);
-            } else if (strcmp(first->s, "set-car!") == 0) {
-                return evalSetCar(args, frame);
-            } else if (strcmp(first->s, "set-cdr!") == 0) {
-                return evalSetCdr(args, frame);
-            } else if (strcmp(first->s, "lambda") == 0) {
-                return evalLambda(args, frame);
-            } else if (strcmp(first->s, "cond") == 0) {
-                return evalCond(args, frame);
-            } else if (strcmp(first->s, "if") == 0) {
-                return evalIf(args, frame);
-            } else if (strcmp(first->s, "quote") == 0) {
-                return evalQuote(args);
-            } else if (strcmp(first->s, "and") == 0) {
-                return evalAnd(args, frame);
-            } else if (strcmp(first->s, "or") == 0) {
-                return evalOr(args, frame);
-            } else {
-                Item *function = eval(first, frame);
-                Item *evaluatedArgs = evalList(args, frame);
-                return apply(function, evaluatedArgs);
-            }
-        }
-        default:
-            evaluationError("unknown type");
-            return NULL;
-    }
+    return run(tree, frame, contTop);
 }
 
 void printItem(Item *item);
@@ -551,13 +1572,18 @@ void printItem(Item *item) {
 
     switch (item->type) {
         case INT_TYPE:
-            printf("%d", item->i);
+            printf("%ld", item->i);
+            break;
+        case BIGNUM_TYPE:
+            printf("%s", integerToString(item));
             break;
         case DOUBLE_TYPE:
             printf("%f", item->d);
             break;
         case STR_TYPE:
-            printf("\"%s\"", item->s);
+            printf("\"");
+            fwrite(stringChars(item), 1, item->str.length, stdout);
+            printf("\"");
             break;
         case BOOL_TYPE:
             if (item->i) {
@@ -580,207 +1606,171 @@ void printItem(Item *item) {
         case VOID_TYPE:
             break;
         case CLOSURE_TYPE:
+        case COMPILED_TYPE:
+        case CONTINUATION_TYPE:
+        case GENERATOR_TYPE:
+        case MEMOIZED_TYPE:
             printf("#<procedure>");
             break;
+        case EOF_TYPE:
+            printf("#<eof>");
+            break;
+        case HASHTABLE_TYPE:
+            printf("#<hash-table>");
+            break;
+        case PMAP_TYPE:
+        case PVECTOR_TYPE:
+            printPersistent(item);
+            break;
+        case RECORD_TYPE:
+        case RECORD_TYPE_TYPE:
+            printRecord(item);
+            break;
+        case VECTOR_TYPE:
+            printf("#(");
+            for (long i = 0; i < item->v.length; i++) {
+                if (i > 0) {
+                    printf(" ");
+                }
+                printItem(item->v.elements[i]);
+            }
+            printf(")");
+            break;
+        case BYTEVECTOR_TYPE:
+        case S64VECTOR_TYPE:
+        case F64VECTOR_TYPE:
+            printNumericVector(item);
+            break;
+        case PROMISE_TYPE:
+            printf("#<promise>");
+            break;
         default:
             printf("Unknown type");
             break;
     }
 }
 
-// implements minus. takes in two argument sand returns their minus.
-Item *primitiveMinus(Item *args) {
-    if (length(args) != 2) {
-        evaluationError("not 2 arguments");
-    }
-    
-    Item *a = car(args);
-    Item *b = car(cdr(args));
-    Item *result = talloc(sizeof(Item));
+// checks whether a value is an exact integer, a fixnum or a bignum
+int isInteger(Item *value) {
+    return value->type == INT_TYPE || value->type == BIGNUM_TYPE;
+}
 
-    double aVal, bVal;
-    
-    if (a->type == DOUBLE_TYPE) {
-        aVal = a->d;
-    } else if (a->type == INT_TYPE) {
-        aVal = a->i;
-    } else {
-        evaluationError("first argument must be a number");
+// converts a number to a double. takes in the number and the error to
+// report if it is not one, and returns its value
+double numberValue(Item *value, const char *message) {
+    if (value->type == DOUBLE_TYPE) {
+        return value->d;
+    } else if (!isInteger(value)) {
+        evaluationError(message);
     }
-    
-    if (b->type == DOUBLE_TYPE) {
-        bVal = b->d;
-    } else if (b->type == INT_TYPE) {
-        bVal = b->i;
-    } else {
-        evaluationError("second argument must be a number");
-    }
-    
-    if (a->type == DOUBLE_TYPE || b->type == DOUBLE_TYPE) {
-        result->type = DOUBLE_TYPE;
-        result->d = aVal - bVal;
-    } else {
-        result->type = INT_TYPE;
-        result->i = (int)(aVal - bVal);
+    return integerToDouble(value);
+}
+
+// implements minus. takes in two argument sand returns their minus.
+Item *primitiveMinus(Item *a, Item *b) {
+    if (isInteger(a) && isInteger(b)) {
+        return integerSubtract(a, b);
     }
-    
+    double aVal = numberValue(a, "first argument must be a number");
+    double bVal = numberValue(b, "second argument must be a number");
+    Item *result = talloc(sizeof(Item));
+    result->type = DOUBLE_TYPE;
+    result->d = aVal - bVal;
     return result;
 }
 // implements less. takes in two arguments and returns 
 // a boolean whether one is less than the other
-Item *primitiveLess(Item *args) {
-    if (length(args) != 2) {
-        evaluationError("not 2 arguments");
-    }
-    Item *a = car(args);
-    Item *b = car(cdr(args));
+Item *primitiveLess(Item *a, Item *b) {
     Item *result = talloc(sizeof(Item));
     result->type = BOOL_TYPE;
-    if (a->type == DOUBLE_TYPE || b->type == DOUBLE_TYPE) {
-        double aVal, bVal;
-
-        if (a->type == DOUBLE_TYPE) {
-            aVal = a->d;
-        } else {
-            aVal = a->i;
-        }
-
-        if (b->type == DOUBLE_TYPE) {
-            bVal = b->d;
-        } else {
-            bVal = b->i;
-        }
-
-        result->i = aVal < bVal;
-    } else if (a->type == INT_TYPE && b->type == INT_TYPE) {
-        result->i = a->i < b->i;
+    if (isInteger(a) && isInteger(b)) {
+        result->i = integerCompare(a, b) < 0;
     } else {
-        evaluationError("not a number");
+        result->i = numberValue(a, "not a number") < numberValue(b, "not a number");
     }
     return result;
 }
 
 // implements less. takes in two arguments and returns 
 // a boolean whether one is greater than the other
-Item *primitiveGreater(Item *args) {
-    if (length(args) != 2) {
-        evaluationError("not 2 arguments");
-    }
-
-    Item *a = car(args);
-    Item *b = car(cdr(args));
+Item *primitiveGreater(Item *a, Item *b) {
     Item *result = talloc(sizeof(Item));
     result->type = BOOL_TYPE;
-
-    double aVal, bVal;
-
-    if (a->type == DOUBLE_TYPE) {
-        aVal = a->d;
-    } else if (a->type == INT_TYPE) {
-        aVal = a->i;
-    } else {
-        evaluationError("first argument must be a number");
-    }
-
-    if (b->type == DOUBLE_TYPE) {
-        bVal = b->d;
-    } else if (b->type == INT_TYPE) {
-        bVal = b->i;
+    if (isInteger(a) && isInteger(b)) {
+        result->i = integerCompare(a, b) > 0;
     } else {
-        evaluationError("second argument must be a number");
-    }
-
-    if (a->type == DOUBLE_TYPE || b->type == DOUBLE_TYPE) {
+        double aVal = numberValue(a, "first argument must be a number");
+        double bVal = numberValue(b, "second argument must be a number");
         result->i = aVal > bVal;
-    } else {
-        result->i = a->i > b->i;
     }
-
     return result;
 }
 
 // primitive function for equal. takes in 2 args and returns
 // a boolean whether they are equal or not
-Item *primitiveEqual(Item *args) {
-    if (length(args) != 2) {
-        evaluationError("not 2 arguments");
-    }
-    Item *a = car(args);
-    Item *b = car(cdr(args));
+Item *primitiveEqual(Item *a, Item *b) {
     Item *result = talloc(sizeof(Item));
     result->type = BOOL_TYPE;
-
-    double aVal, bVal;
-
-    if (a->type == DOUBLE_TYPE) {
-        aVal = a->d;
-    } else if (a->type == INT_TYPE) {
-        aVal = a->i;
-    } else {
-        evaluationError("first argument must be a number");
-    }
-
-    if (b->type == DOUBLE_TYPE) {
-        bVal = b->d;
-    } else if (b->type == INT_TYPE) {
-        bVal = b->i;
+    if (isInteger(a) && isInteger(b)) {
+        result->i = integerCompare(a, b) == 0;
     } else {
-        evaluationError("second argument must be a number");
-    }
-
-    if (a->type == DOUBLE_TYPE || b->type == DOUBLE_TYPE) {
+        double aVal = numberValue(a, "first argument must be a number");
+        double bVal = numberValue(b, "second argument must be a number");
         result->i = aVal == bVal;
-    } else {
-        result->i = a->i == b->i;
     }
-
     return result;
 }
 
 // primitive function for +. takes in arguments and
-// returns their summation
-Item *primitivePlus(Item *args) {
-    Item *currentArg;
-    double total = 0.0;
+// returns their summation. integers are added exactly and doubles
+// separately, and the two are only combined at the end
+Item *primitivePlus(int argc, Item **argv) {
+    // the common case, fixnums whose sum fits in one, allocates nothing but
+    // the result
+    long total = 0;
+    long sum;
+    int i = 0;
+    while (i < argc && argv[i]->type == INT_TYPE && !__builtin_add_overflow(total, argv[i]->i, &sum)) {
+        total = sum;
+        i++;
+    }
+    if (i == argc) {
+        return makeFixnum(total);
+    }
+
+    Item *exact = makeFixnum(total);
+    double inexact = 0.0;
     int hasDouble = 0;
-
-    while (!isNull(args)) {
-        currentArg = car(args);
+    for (; i < argc; i++) {
+        Item *currentArg = argv[i];
         switch (currentArg->type) {
             case DOUBLE_TYPE:
-                total += currentArg->d;
+                inexact += currentArg->d;
                 hasDouble = 1;
                 break;
             case INT_TYPE:
-                total += currentArg->i;
+            case BIGNUM_TYPE:
+                exact = integerAdd(exact, currentArg);
                 break;
             default:
                 evaluationError("not numbers");
                 break;
         }
-        args = cdr(args);
     }
 
-    Item *finalResult = talloc(sizeof(Item));
-    if (hasDouble) {
-        finalResult->type = DOUBLE_TYPE;
-        finalResult->d = total;
-    } else {
-        finalResult->type = INT_TYPE;
-        finalResult->i = (int)total;
+    if (!hasDouble) {
+        return exact;
     }
-
+    Item *finalResult = talloc(sizeof(Item));
+    finalResult->type = DOUBLE_TYPE;
+    finalResult->d = integerToDouble(exact) + inexact;
     return finalResult;
 }
 
 // primitive function for 'null?'. takes in one argument
 // and returns a boolean of whether or not it evaluated 
 // to null
-Item *primitiveNull(Item *args) {
-    if (length(args) != 1) {
-        evaluationError("null? expects one argument");
-    }
-    Item *arg = car(args);
+Item *primitiveNull(Item *arg) {
     Item *result = talloc(sizeof(Item));
     result->type = BOOL_TYPE;
     result->i = isNull(arg);
@@ -789,11 +1779,7 @@ Item *primitiveNull(Item *args) {
 
 // primitive function for 'car'. takes in one argument
 // and finds the car of it, then returns it
-Item *primitiveCar(Item *args) {
-    if (length(args) != 1) {
-        evaluationError("car expects one argument");
-    }
-    Item *arg = car(args);
+Item *primitiveCar(Item *arg) {
     if (arg->type != CONS_TYPE) {
         evaluationError("car expects a list");
     }
@@ -802,160 +1788,393 @@ Item *primitiveCar(Item *args) {
 
 // primitive function for 'cdr'. takes in one argument
 // and finds the cdr of it, then returns it
-Item *primitiveCdr(Item *args) {
-    if (length(args) != 1) {
-        evaluationError("cdr expects one argument");
-    }
-    Item *arg = car(args);
+Item *primitiveCdr(Item *arg) {
     if (arg->type != CONS_TYPE) {
         evaluationError("cdr expects a list");
     }
     return cdr(arg);
 }
 
+// implements force. a promise's expression is evaluated the first time it
+// is forced and its value kept. forcing a chained promise forces the
+// promise its expression produces in a loop rather than by recursion, as
+// R7RS defines it, so a stream whose tails are made with delay-force is
+// forced in constant stack. the chained promise takes over the state of
+// the promise it produced, and that promise shares it from then on. takes
+// in the promise, or any other value, which is returned as it is
+Item *primitiveForce(Item *promise) {
+    if (promise->type != PROMISE_TYPE) {
+        return promise;
+    }
+    while (!promise->pm->done) {
+        Promise *state = promise->pm;
+        checkStackDepth();
+        Item *value = state->frame != NULL ? eval(state->value, state->frame)
+                                           : apply(state->value, 0, NULL);
+        // forcing the expression may have forced the promise itself
+        if (state->done) {
+            break;
+        }
+        if (!state->chained) {
+            state->done = 1;
+            state->value = value;
+            state->frame = NULL;
+        } else if (value->type != PROMISE_TYPE) {
+            evaluationError("delay-force expects its expression to produce a promise");
+        } else {
+            *state = *value->pm;
+            value->pm = state;
+        }
+    }
+    return promise->pm->value;
+}
+
+// implements make-promise. takes in a value and returns it if it is a
+// promise, or else a promise already forced to it
+Item *primitiveMakePromise(Item *value) {
+    if (value->type == PROMISE_TYPE) {
+        return value;
+    }
+    Item *promise = makePromise(value, NULL, 0);
+    promise->pm->done = 1;
+    return promise;
+}
+
+// implements promise?. takes in a value and returns whether it is a
+// promise
+Item *primitiveIsPromise(Item *value) {
+    Item *result = talloc(sizeof(Item));
+    result->type = BOOL_TYPE;
+    result->i = value->type == PROMISE_TYPE;
+    return result;
+}
+
+// implements stream-cdr: the cdr of a stream, made by cons-stream, is a
+// promise of the rest of the stream, which is forced. takes in the stream
+Item *primitiveStreamCdr(Item *stream) {
+    if (stream->type != CONS_TYPE) {
+        evaluationError("stream-cdr expects a stream");
+    }
+    return primitiveForce(cdr(stream));
+}
+
 // primitive function for 'cons'. takes in 2 arguments
 // and returns a cons cell of both.
-Item *primitiveCons(Item *args) {
-    if (length(args) != 2) {
-        evaluationError("cons expects two arguments");
-    }
-    Item *first = car(args);
-    Item *second = car(cdr(args));
+Item *primitiveCons(Item *first, Item *second) {
     return cons(first, second);
 }
 
 // primitive function for 'append'. takes in 2 arguments
 // and returns an appended version of both.
-Item *primitiveAppend(Item *args) {
-    if (length(args) != 2) {
-        evaluationError("append expects two arguments");
-    }
-    Item *first = car(args);
-    Item *second = car(cdr(args));
+Item *primitiveAppend(Item *first, Item *second) {
     if (first->type != CONS_TYPE && first->type != NULL_TYPE) {
         evaluationError("first argument of append must be a list");
     }
-    if (isNull(first)) {
-        return second;
-    } else {
-        return cons(car(first), primitiveAppend(cons(cdr(first), cons(second, makeNull()))));
+    // copy the first list front to back, keeping a pointer to the last cell
+    // so the copy is built without recursion
+    Item *result = second;
+    Item *last = NULL;
+    while (!isNull(first)) {
+        Item *cell = cons(car(first), second);
+        if (last == NULL) {
+            result = cell;
+        } else {
+            last->c.cdr = cell;
+        }
+        last = cell;
+        first = cdr(first);
     }
+    return result;
 }
 
 // implements multiply. takes in >2 arguments and returns
-// their multiplication
-Item *primitiveMultiply(Item *args) {
-    if (length(args) < 2) {
-        evaluationError("requires at least 2 arguments");
-    }
-
-    double result = 1;
+// their multiplication. as with +, integers and doubles are multiplied
+// separately
+Item *primitiveMultiply(int argc, Item **argv) {
+    long product = 1;
+    long next;
+    int i = 0;
+    while (i < argc && argv[i]->type == INT_TYPE &&
+           !__builtin_mul_overflow(product, argv[i]->i, &next)) {
+        product = next;
+        i++;
+    }
+    if (i == argc) {
+        return makeFixnum(product);
+    }
+
+    Item *exact = makeFixnum(product);
+    double inexact = 1.0;
     int containsDouble = 0;
-
-    while (!isNull(args)) {
-        Item *currentArg = car(args);
+    for (; i < argc; i++) {
+        Item *currentArg = argv[i];
         if (currentArg->type == DOUBLE_TYPE) {
-            result *= currentArg->d;
+            inexact *= currentArg->d;
             containsDouble = 1;
-        } else if (currentArg->type == INT_TYPE) {
-            result *= currentArg->i;
+        } else if (isInteger(currentArg)) {
+            exact = integerMultiply(exact, currentArg);
         } else {
             evaluationError("all arguments must be numbers");
         }
-        args = cdr(args);
     }
 
-    Item *finalResult = talloc(sizeof(Item));
-    finalResult->type = containsDouble ? DOUBLE_TYPE : INT_TYPE;
-    if (containsDouble) {
-        finalResult->d = result;
-    } else {
-        finalResult->i = (int)result;
+    if (!containsDouble) {
+        return exact;
     }
+    Item *finalResult = talloc(sizeof(Item));
+    finalResult->type = DOUBLE_TYPE;
+    finalResult->d = integerToDouble(exact) * inexact;
     return finalResult;
 }
 
 // implements division. takes in 2 arguments and returns
 // their divison.
-Item *primitiveDivide(Item *args) {
-    if (length(args) != 2) {
-        evaluationError("2 arguments needed");
+Item *primitiveDivide(Item *a, Item *b) {
+    double numerator = numberValue(a, "not a number");
+    double denominator = numberValue(b, "not a number");
+    if (denominator == 0) {
+        evaluationError("can't divide by zero");
     }
-    Item *a = car(args);
-    Item *b = car(cdr(args));
     Item *result = talloc(sizeof(Item));
-    if ((a->type == INT_TYPE || a->type == DOUBLE_TYPE) &&
-        (b->type == INT_TYPE || b->type == DOUBLE_TYPE)) {
-        double numerator = (a->type == DOUBLE_TYPE) ? a->d : a->i;
-        double denominator = (b->type == DOUBLE_TYPE) ? b->d : b->i;
-        if (denominator == 0) {
-            evaluationError("can't divide by zero");
-        }
-        result->type = DOUBLE_TYPE;
-        result->d = numerator / denominator;
-    } else {
-        evaluationError("not a number");
-    }
+    result->type = DOUBLE_TYPE;
+    result->d = numerator / denominator;
     return result;
 }
 
 // implements modulo. takes in 2 arguments and returns
-// the modulo result
-Item *primitiveModulo(Item *args) {
-    if (length(args) != 2) {
-        evaluationError("2 arguments needed");
-    }
-    Item *result = talloc(sizeof(Item));
-    Item *a = car(args);
-    Item *b = car(cdr(args));
-    if (a->type != INT_TYPE || b->type != INT_TYPE) {
+// the modulo result, which has the sign of the first
+Item *primitiveModulo(Item *a, Item *b) {
+    if (!isInteger(a) || !isInteger(b)) {
         evaluationError("invalid arguments");
     }
-    result->type = INT_TYPE;
-    result->i = a->i % b->i;
-    return result;
+    if (isZeroInteger(b)) {
+        evaluationError("can't take the modulo by zero");
+    }
+    return integerRemainder(a, b);
 }
 
-
-// binds a primitive function to a symbol in a frame,
-// takes in the name of the symbol to which the primitive
-// function will be bound,  pointer to the primitive function,
-// and a pointer to the frame in which this binding should be
-// made
-void bind(char *name, Item *(*function)(Item *), Frame *frame) {
-    Item *symbol = talloc(sizeof(Item));
-    symbol->type = SYMBOL_TYPE;
-    symbol->s = talloc_strdup(name);
-
+// the primitives bound in the global frame. each gives the fewest and most
+// arguments it takes (-1 for no limit), the error reported when a call
+// passes a different number, and its entry point: one taking the
+// arguments directly if its arity is fixed, an argument vector otherwise
+Primitive primitives[] = {
+    {"+", primitivePlus, NULL, NULL, 0, -1, NULL},
+    {"-", NULL, NULL, primitiveMinus, 2, 2, "not 2 arguments"},
+    {"*", primitiveMultiply, NULL, NULL, 2, -1, "requires at least 2 arguments"},
+    {"/", NULL, NULL, primitiveDivide, 2, 2, "2 arguments needed"},
+    {"modulo", NULL, NULL, primitiveModulo, 2, 2, "2 arguments needed"},
+    {"<", NULL, NULL, primitiveLess, 2, 2, "not 2 arguments"},
+    {">", NULL, NULL, primitiveGreater, 2, 2, "not 2 arguments"},
+    {"=", NULL, NULL, primitiveEqual, 2, 2, "not 2 arguments"},
+    {"null?", NULL, primitiveNull, NULL, 1, 1, "null? expects one argument"},
+    {"eq?", NULL, NULL, primitiveIsEq, 2, 2, "eq? expects two arguments"},
+    {"eqv?", NULL, NULL, primitiveIsEqv, 2, 2, "eqv? expects two arguments"},
+    {"equal?", NULL, NULL, primitiveIsEqual, 2, 2, "equal? expects two arguments"},
+    {"car", NULL, primitiveCar, NULL, 1, 1, "car expects one argument"},
+    {"cdr", NULL, primitiveCdr, NULL, 1, 1, "cdr expects one argument"},
+    {"cons", NULL, NULL, primitiveCons, 2, 2, "cons expects two arguments"},
+    {"append", NULL, NULL, primitiveAppend, 2, 2, "append expects two arguments"},
+    {"force", NULL, primitiveForce, NULL, 1, 1, "force expects one argument"},
+    {"make-promise", NULL, primitiveMakePromise, NULL, 1, 1, "make-promise expects one argument"},
+    {"promise?", NULL, primitiveIsPromise, NULL, 1, 1, "promise? expects one argument"},
+    {"stream-car", NULL, primitiveCar, NULL, 1, 1, "stream-car expects one argument"},
+    {"stream-cdr", NULL, primitiveStreamCdr, NULL, 1, 1, "stream-cdr expects one argument"},
+    {"call/ec", NULL, primitiveCallEc, NULL, 1, 1, "call/ec expects one argument"},
+    // call/cc gives escape-only continuations, which only return upward
+    // out of a call/cc that has not returned yet
+    {"call/cc", NULL, primitiveCallEc, NULL, 1, 1, "call/cc expects one argument"},
+    {"call-with-current-continuation", NULL, primitiveCallEc, NULL, 1, 1,
+     "call-with-current-continuation expects one argument"},
+    {"make-generator", NULL, primitiveMakeGenerator, NULL, 1, 1, "make-generator expects one argument"},
+    {"eof-object", primitiveEofObject, NULL, NULL, 0, 0, "eof-object expects no arguments"},
+    {"eof-object?", NULL, primitiveIsEofObject, NULL, 1, 1, "eof-object? expects one argument"},
+    {"memoize", primitiveMemoize, NULL, NULL, 1, 3, "memoize expects a procedure, a size and a policy"},
+    {"memo-stats", NULL, primitiveMemoStats, NULL, 1, 1, "memo-stats expects one argument"},
+    {"memo-clear!", NULL, primitiveMemoClear, NULL, 1, 1, "memo-clear! expects one argument"},
+    {"make-vector", primitiveMakeVector, NULL, NULL, 1, 2, "make-vector expects a length and a value"},
+    {"vector", primitiveVector, NULL, NULL, 0, -1, NULL},
+    {"vector?", NULL, primitiveIsVector, NULL, 1, 1, "vector? expects one argument"},
+    {"vector-length", NULL, primitiveVectorLength, NULL, 1, 1, "vector-length expects one argument"},
+    {"vector-ref", NULL, NULL, primitiveVectorRef, 2, 2, "vector-ref expects two arguments"},
+    {"vector-set!", primitiveVectorSet, NULL, NULL, 3, 3, "vector-set! expects three arguments"},
+    {"vector-fill!", primitiveVectorFill, NULL, NULL, 2, 4,
+     "vector-fill! expects a vector, a value, a start and an end"},
+    {"vector-copy", primitiveVectorCopy, NULL, NULL, 1, 3, "vector-copy expects a vector, a start and an end"},
+    {"vector->list", primitiveVectorToList, NULL, NULL, 1, 3,
+     "vector->list expects a vector, a start and an end"},
+    {"list->vector", NULL, primitiveListToVector, NULL, 1, 1, "list->vector expects one argument"},
+    {"string?", NULL, primitiveIsString, NULL, 1, 1, "string? expects one argument"},
+    {"string-length", NULL, primitiveStringLength, NULL, 1, 1, "string-length expects one argument"},
+    {"string-ref", NULL, NULL, primitiveStringRef, 2, 2, "string-ref expects two arguments"},
+    {"substring", primitiveSubstring, NULL, NULL, 2, 3, "substring expects a string, a start and an end"},
+    {"string-append", primitiveStringAppend, NULL, NULL, 0, -1, NULL},
+    {"string=?", primitiveStringEqual, NULL, NULL, 1, -1, "string=? expects at least one argument"},
+    {"string<?", primitiveStringLess, NULL, NULL, 1, -1, "string<? expects at least one argument"},
+    {"string->symbol", NULL, primitiveStringToSymbol, NULL, 1, 1, "string->symbol expects one argument"},
+    {"symbol->string", NULL, primitiveSymbolToString, NULL, 1, 1, "symbol->string expects one argument"},
+    {"number->string", NULL, primitiveNumberToString, NULL, 1, 1, "number->string expects one argument"},
+    {"string-split", NULL, NULL, primitiveStringSplit, 2, 2, "string-split expects two arguments"},
+    {"make-bytevector", primitiveMakeBytevector, NULL, NULL, 1, 2, "make-bytevector expects a length and a value"},
+    {"bytevector", primitiveBytevector, NULL, NULL, 0, -1, NULL},
+    {"bytevector?", NULL, primitiveIsBytevector, NULL, 1, 1, "bytevector? expects one argument"},
+    {"bytevector-length", NULL, primitiveBytevectorLength, NULL, 1, 1, "bytevector-length expects one argument"},
+    {"bytevector-u8-ref", NULL, NULL, primitiveBytevectorRef, 2, 2, "bytevector-u8-ref expects two arguments"},
+    {"bytevector-u8-set!", primitiveBytevectorSet, NULL, NULL, 3, 3, "bytevector-u8-set! expects three arguments"},
+    {"bytevector-copy", primitiveBytevectorCopy, NULL, NULL, 1, 3,
+     "bytevector-copy expects a bytevector, a start and an end"},
+    {"bytevector-fill!", primitiveBytevectorFill, NULL, NULL, 2, 4,
+     "bytevector-fill! expects a bytevector, a value, a start and an end"},
+    {"make-s64vector", primitiveMakeS64vector, NULL, NULL, 1, 2, "make-s64vector expects a length and a value"},
+    {"s64vector", primitiveS64vector, NULL, NULL, 0, -1, NULL},
+    {"s64vector?", NULL, primitiveIsS64vector, NULL, 1, 1, "s64vector? expects one argument"},
+    {"s64vector-length", NULL, primitiveS64vectorLength, NULL, 1, 1, "s64vector-length expects one argument"},
+    {"s64vector-ref", NULL, NULL, primitiveS64vectorRef, 2, 2, "s64vector-ref expects two arguments"},
+    {"s64vector-set!", primitiveS64vectorSet, NULL, NULL, 3, 3, "s64vector-set! expects three arguments"},
+    {"s64vector-copy", primitiveS64vectorCopy, NULL, NULL, 1, 3,
+     "s64vector-copy expects an s64vector, a start and an end"},
+    {"s64vector-fill!", primitiveS64vectorFill, NULL, NULL, 2, 4,
+     "s64vector-fill! expects an s64vector, a value, a start and an end"},
+    {"s64vector->list", NULL, primitiveS64vectorToList, NULL, 1, 1, "s64vector->list expects one argument"},
+    {"list->s64vector", NULL, primitiveListToS64vector, NULL, 1, 1, "list->s64vector expects one argument"},
+    {"s64vector-add", NULL, NULL, primitiveS64vectorAdd, 2, 2, "s64vector-add expects two arguments"},
+    {"s64vector-mul", NULL, NULL, primitiveS64vectorMul, 2, 2, "s64vector-mul expects two arguments"},
+    {"s64vector-scale", NULL, NULL, primitiveS64vectorScale, 2, 2, "s64vector-scale expects two arguments"},
+    {"s64vector-dot", NULL, NULL, primitiveS64vectorDot, 2, 2, "s64vector-dot expects two arguments"},
+    {"s64vector-sum", NULL, primitiveS64vectorSum, NULL, 1, 1, "s64vector-sum expects one argument"},
+    {"s64vector-min", NULL, primitiveS64vectorMin, NULL, 1, 1, "s64vector-min expects one argument"},
+    {"s64vector-max", NULL, primitiveS64vectorMax, NULL, 1, 1, "s64vector-max expects one argument"},
+    {"make-f64vector", primitiveMakeF64vector, NULL, NULL, 1, 2, "make-f64vector expects a length and a value"},
+    {"f64vector", primitiveF64vector, NULL, NULL, 0, -1, NULL},
+    {"f64vector?", NULL, primitiveIsF64vector, NULL, 1, 1, "f64vector? expects one argument"},
+    {"f64vector-length", NULL, primitiveF64vectorLength, NULL, 1, 1, "f64vector-length expects one argument"},
+    {"f64vector-ref", NULL, NULL, primitiveF64vectorRef, 2, 2, "f64vector-ref expects two arguments"},
+    {"f64vector-set!", primitiveF64vectorSet, NULL, NULL, 3, 3, "f64vector-set! expects three arguments"},
+    {"f64vector-copy", primitiveF64vectorCopy, NULL, NULL, 1, 3,
+     "f64vector-copy expects an f64vector, a start and an end"},
+    {"f64vector-fill!", primitiveF64vectorFill, NULL, NULL, 2, 4,
+     "f64vector-fill! expects an f64vector, a value, a start and an end"},
+    {"f64vector->list", NULL, primitiveF64vectorToList, NULL, 1, 1, "f64vector->list expects one argument"},
+    {"list->f64vector", NULL, primitiveListToF64vector, NULL, 1, 1, "list->f64vector expects one argument"},
+    {"f64vector-add", NULL, NULL, primitiveF64vectorAdd, 2, 2, "f64vector-add expects two arguments"},
+    {"f64vector-mul", NULL, NULL, primitiveF64vectorMul, 2, 2, "f64vector-mul expects two arguments"},
+    {"f64vector-scale", NULL, NULL, primitiveF64vectorScale, 2, 2, "f64vector-scale expects two arguments"},
+    {"f64vector-dot", NULL, NULL, primitiveF64vectorDot, 2, 2, "f64vector-dot expects two arguments"},
+    {"f64vector-sum", NULL, primitiveF64vectorSum, NULL, 1, 1, "f64vector-sum expects one argument"},
+    {"f64vector-min", NULL, primitiveF64vectorMin, NULL, 1, 1, "f64vector-min expects one argument"},
+    {"f64vector-max", NULL, primitiveF64vectorMax, NULL, 1, 1, "f64vector-max expects one argument"},
+    {"make-hash-table", primitiveMakeHashTable, NULL, NULL, 0, 1, "make-hash-table expects one argument"},
+    {"hash-table?", NULL, primitiveIsHashTable, NULL, 1, 1, "hash-table? expects one argument"},
+    {"hash-table-ref", primitiveHashTableRef, NULL, NULL, 2, 3,
+     "hash-table-ref expects a hash table, a key and a procedure"},
+    {"hash-table-ref/default", primitiveHashTableRefDefault, NULL, NULL, 3, 3,
+     "hash-table-ref/default expects three arguments"},
+    {"hash-table-set!", primitiveHashTableSet, NULL, NULL, 3, 3, "hash-table-set! expects three arguments"},
+    {"hash-table-delete!", NULL, NULL, primitiveHashTableDelete, 2, 2, "hash-table-delete! expects two arguments"},
+    {"hash-table-contains?", NULL, NULL, primitiveHashTableContains, 2, 2,
+     "hash-table-contains? expects two arguments"},
+    {"hash-table-update!/default", primitiveHashTableUpdateDefault, NULL, NULL, 4, 4,
+     "hash-table-update!/default expects four arguments"},
+    {"hash-table-count", NULL, primitiveHashTableCount, NULL, 1, 1, "hash-table-count expects one argument"},
+    {"hash-table-walk", NULL, NULL, primitiveHashTableWalk, 2, 2, "hash-table-walk expects two arguments"},
+    {"hash-table-keys", NULL, primitiveHashTableKeys, NULL, 1, 1, "hash-table-keys expects one argument"},
+    {"hash-table->alist", NULL, primitiveHashTableToAlist, NULL, 1, 1, "hash-table->alist expects one argument"},
+    {"pmap", primitivePmap, NULL, NULL, 0, -1, NULL},
+    {"pmap?", NULL, primitiveIsPmap, NULL, 1, 1, "pmap? expects one argument"},
+    {"pmap-count", NULL, primitivePmapCount, NULL, 1, 1, "pmap-count expects one argument"},
+    {"pmap-ref", primitivePmapRef, NULL, NULL, 2, 3, "pmap-ref expects a map, a key and a default"},
+    {"pmap-set", primitivePmapSet, NULL, NULL, 3, 3, "pmap-set expects three arguments"},
+    {"pmap-delete", NULL, NULL, primitivePmapDelete, 2, 2, "pmap-delete expects two arguments"},
+    {"pmap-contains?", NULL, NULL, primitivePmapContains, 2, 2, "pmap-contains? expects two arguments"},
+    {"pmap-walk", NULL, NULL, primitivePmapWalk, 2, 2, "pmap-walk expects two arguments"},
+    {"pmap-keys", NULL, primitivePmapKeys, NULL, 1, 1, "pmap-keys expects one argument"},
+    {"pmap->alist", NULL, primitivePmapToAlist, NULL, 1, 1, "pmap->alist expects one argument"},
+    {"pvector", primitivePvector, NULL, NULL, 0, -1, NULL},
+    {"pvector?", NULL, primitiveIsPvector, NULL, 1, 1, "pvector? expects one argument"},
+    {"pvector-length", NULL, primitivePvectorLength, NULL, 1, 1, "pvector-length expects one argument"},
+    {"pvector-ref", NULL, NULL, primitivePvectorRef, 2, 2, "pvector-ref expects two arguments"},
+    {"pvector-set", primitivePvectorSet, NULL, NULL, 3, 3, "pvector-set expects three arguments"},
+    {"pvector-push", NULL, NULL, primitivePvectorPush, 2, 2, "pvector-push expects two arguments"},
+    {"pvector-pop", NULL, primitivePvectorPop, NULL, 1, 1, "pvector-pop expects one argument"},
+    {"pvector-append", NULL, NULL, primitivePvectorAppend, 2, 2, "pvector-append expects two arguments"},
+    {"pvector->list", NULL, primitivePvectorToList, NULL, 1, 1, "pvector->list expects one argument"},
+    {"list->pvector", NULL, primitiveListToPvector, NULL, 1, 1, "list->pvector expects one argument"},
+    {"transient", NULL, primitiveTransient, NULL, 1, 1, "transient expects one argument"},
+    {"persistent!", NULL, primitivePersistent, NULL, 1, 1, "persistent! expects one argument"},
+    {"pmap-set!", primitivePmapSetInPlace, NULL, NULL, 3, 3, "pmap-set! expects three arguments"},
+    {"pmap-delete!", NULL, NULL, primitivePmapDeleteInPlace, 2, 2, "pmap-delete! expects two arguments"},
+    {"pvector-set!", primitivePvectorSetInPlace, NULL, NULL, 3, 3, "pvector-set! expects three arguments"},
+    {"pvector-push!", NULL, NULL, primitivePvectorPushInPlace, 2, 2, "pvector-push! expects two arguments"},
+    {"pvector-pop!", NULL, primitivePvectorPopInPlace, NULL, 1, 1, "pvector-pop! expects one argument"},
+    {"make-record-type", NULL, NULL, primitiveMakeRecordType, 2, 2, "make-record-type expects two arguments"},
+    {"record-constructor", primitiveRecordConstructor, NULL, NULL, 3, 3, "record-constructor expects three arguments"},
+    {"record-predicate", NULL, NULL, primitiveRecordPredicate, 2, 2, "record-predicate expects two arguments"},
+    {"record-accessor", primitiveRecordAccessor, NULL, NULL, 3, 3, "record-accessor expects three arguments"},
+    {"record-modifier", primitiveRecordModifier, NULL, NULL, 3, 3, "record-modifier expects three arguments"},
+    {"record?", NULL, primitiveIsRecord, NULL, 1, 1, "record? expects one argument"},
+};
+
+// binds a primitive function to its name in a frame. takes in
+// the primitive and a pointer to the frame in which this
+// binding should be made
+void bind(Primitive *primitive, Frame *frame) {
     Item *prim = talloc(sizeof(Item));
     prim->type = PRIMITIVE_TYPE;
-    prim->pf = function;
+    prim->pr = primitive;
+    addBinding(frame, intern(primitive->name), prim);
+}
 
-    Item *binding = cons(symbol, prim);
-    frame->bindings = cons(binding, frame->bindings);
+// call a primitive. takes in the primitive and the arguments as a count and
+// a vector, checks the count against the primitive's arity and returns the
+// result
+Item *callPrimitive(Primitive *primitive, int argc, Item **argv) {
+    if (argc < primitive->minArgs || (primitive->maxArgs >= 0 && argc > primitive->maxArgs)) {
+        evaluationError(primitive->arityError);
+    }
+    if (primitive->call1 != NULL) {
+        return primitive->call1(argv[0]);
+    } else if (primitive->call2 != NULL) {
+        return primitive->call2(argv[0], argv[1]);
+    } else if (primitive->callRecord != NULL) {
+        return primitive->callRecord(primitive, argv);
+    }
+    return primitive->call(argc, argv);
 }
 
-// main function to interpret the Scheme program. takes in
-// a parse tree, evaluates it in a global frame, and prints
-// what it evaluates to
-void interpret(Item *tree) {
-    Frame *globalFrame = createFrame(NULL);
-    bind("+", primitivePlus, globalFrame);
-    bind("-", primitiveMinus, globalFrame);
-    bind("*", primitiveMultiply, globalFrame);
-    bind("/", primitiveDivide, globalFrame);
-    bind("modulo", primitiveModulo, globalFrame);
-    bind("<", primitiveLess, globalFrame);
-    bind(">", primitiveGreater, globalFrame);
-    bind("=", primitiveEqual, globalFrame);
-    bind("null?", primitiveNull, globalFrame);
-    bind("car", primitiveCar, globalFrame);
-    bind("cdr", primitiveCdr, globalFrame);
-    bind("cons", primitiveCons, globalFrame);
-    bind("append", primitiveAppend, globalFrame);
+// find a primitive by the name it is bound to. takes in the name and
+// returns the primitive, or NULL if there is none by that name
+Primitive *findPrimitive(const char *name) {
+    for (size_t i = 0; i < sizeof(primitives) / sizeof(primitives[0]); i++) {
+        if (strcmp(primitives[i].name, name) == 0) {
+            return &primitives[i];
+        }
+    }
+    return NULL;
+}
+
+// create the global frame with every primitive bound in it. returns the
+// frame
+Frame *initializeGlobals() {
+    Frame *globalFrame = createGlobalFrame();
+    for (size_t i = 0; i < sizeof(primitives) / sizeof(primitives[0]); i++) {
+        bind(&primitives[i], globalFrame);
+    }
+    return globalFrame;
+}
+
+// the program interpret runs
+Item *programForms = NULL;
+
+// evaluate each top-level form of the program in the global frame, and
+// print what it evaluates to
+void interpretForms() {
+    Frame *globalFrame = initializeGlobals();
+    Item *tree = programForms;
 
     while (tree != NULL && tree->type == CONS_TYPE) {
-        Item *result = eval(car(tree), globalFrame);
+        // forms the compiler does not handle are evaluated by the tree
+        // walker, which shares the global frame with compiled code
+        Function *function = useTreeWalker ? NULL : compileTopLevel(car(tree));
+        Item *result = function ? vmRun(function) : eval(car(tree), globalFrame);
         if (result->type != VOID_TYPE) {
             printItem(result);
             printf("\n"); 
@@ -964,3 +2183,10 @@ void interpret(Item *tree) {
     }
 }
 
+// main function to interpret the Scheme program. takes in
+// a parse tree and evaluates it on a stack the size of the stack limit
+void interpret(Item *tree) {
+    programForms = tree;
+    runOnProgramStack(interpretForms);
+}
+
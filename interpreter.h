@@ -1,3 +1,4 @@
+#include <stddef.h>
 #include "item.h"
 
 #ifndef INTERPRETER_H
@@ -5,6 +6,111 @@
 
 void interpret(Item *tree);
 Item *eval(Item *tree, Frame *frame);
+void printItem(Item *item);
+
+// Creates the global frame with the primitives bound, as interpret does
+// before evaluating a program, and returns it.
+Frame *initializeGlobals();
+
+// The stacks the evaluators keep their state on: the tree walker's
+// continuation and argument stacks, and the VM's operand and call stacks.
+// Each generator runs on a set of its own (see control.h), which starts
+// out empty and grows as it is used.
+typedef struct {
+    void *continuations;
+    int continuationTop;
+    int continuationCapacity;
+    Item **arguments;
+    int argumentTop;
+    int argumentCapacity;
+    Item **values;
+    int valueTop;
+    int valueCapacity;
+    void *calls;
+    int callTop;
+    int callCapacity;
+} Stacks;
+
+// Swaps the stacks the evaluators are running on with a saved set.
+void swapStacks(Stacks *other);
+
+// Records how high each of the evaluators' stacks is, and cuts them back
+// to the recorded heights, dropping whatever was pushed since.
+void markStacks(Stacks *marks);
+void resetStacks(Stacks *marks);
+
+// Sets the most memory, in bytes, the evaluator's continuation stack may use.
+// Recursion deeper than this stops with an evaluation error.
+void setStackLimit(size_t bytes);
+size_t getStackLimit();
+
+// The C stack. The evaluators keep their own stacks on the heap, but a call
+// from C back into them, from a primitive like force or from compiled code,
+// nests on the C stack, so a program runs on a thread whose stack is the
+// size of the stack limit, or on the main stack within its rlimit if there
+// can be no such thread, and those calls check its depth first, stopping
+// with an evaluation error once the stack is within a margin of its end.
+// A generator's producer runs on a stack of its own, whose bounds are
+// swapped in while it runs.
+void runOnProgramStack(void (*program)());
+void checkStackDepth();
+void swapStackBounds(char **start, size_t *budget);
+
+// Makes interpret evaluate every form with the tree-walking evaluator rather
+// than compiling it to bytecode first.
+void setTreeWalker(int enabled);
+
+// The number of steps the tree walker has taken, one for each expression it
+// evaluates. --count-steps reports it, to show how much work the optimizer
+// saves.
+long getEvalSteps();
+
+// Shared with the bytecode VM, which uses the same global bindings,
+// primitives and error reporting as the tree walker.
+void evaluationError(const char *message);
+Item *apply(Item *function, int argc, Item **argv);
+Item *callPrimitive(Primitive *primitive, int argc, Item **argv);
+Primitive *findPrimitive(const char *name);
+Item *makeVoid();
+double numberValue(Item *value, const char *message);
+Item *makePromise(Item *code, Frame *frame, int chained);
+Item *lookupGlobalCell(char *name);
+void defineGlobal(char *name, Item *value);
+
+// Primitives the JIT and compiled programs call directly for integer
+// arguments.
+Item *primitivePlus(int argc, Item **argv);
+Item *primitiveMinus(Item *a, Item *b);
+Item *primitiveMultiply(int argc, Item **argv);
+Item *primitiveLess(Item *a, Item *b);
+Item *primitiveGreater(Item *a, Item *b);
+Item *primitiveEqual(Item *a, Item *b);
+Item *primitiveModulo(Item *a, Item *b);
+
+// The kinds of operands a call site of an arithmetic or comparison
+// primitive expects. Fixnum and flonum sites were specialized to the
+// operands they saw at run time and check them on every call; proven sites
+// were marked by type inference, which showed that the operator is always
+// the primitive and the operands always have that type, so they check
+// nothing but, for integers, that neither has grown into a bignum.
+typedef enum {
+    GENERIC_SITE, FIXNUM_SITE, FLONUM_SITE, PROVEN_FIXNUM_SITE, PROVEN_FLONUM_SITE
+} SiteKind;
+
+// The operations a call site computes itself, in the order of
+// siteOperationNames.
+typedef enum {
+    SITE_ADD, SITE_SUBTRACT, SITE_MULTIPLY, SITE_LESS, SITE_GREATER, SITE_EQUAL,
+    SITE_MODULO
+} SiteOperation;
+
+extern const char *siteOperationNames[];
+
+// Computes an operation on two integers, or two doubles, without checking
+// their types. Bignum operands, fixnum results that overflow, and anything
+// else the primitive would handle differently, are left to the primitive.
+Item *computeFixnum(int operation, Item **argv);
+Item *computeFlonum(int operation, Item **argv);
 
 #endif
 
@@ -12,16 +12,86 @@ typedef enum {
     VOID_TYPE, CLOSURE_TYPE,
 
     // Type below is new for primitive portion
-    PRIMITIVE_TYPE
+    PRIMITIVE_TYPE,
+
+    // A closure made by the bytecode compiler (see vm.h)
+    COMPILED_TYPE,
+
+    // The operator of a primitive call in the parse tree, once the call has
+    // specialized itself (see interpreter.c)
+    CALL_SITE_TYPE,
+
+    // The loop of a named let in the tree walker, bound to the let's name
+    // while its body runs (see interpreter.c)
+    LOOP_TYPE,
+
+    // A promise made by delay or delay-force
+    PROMISE_TYPE,
+
+    // An escape continuation made by call/ec or call/cc, a generator made by
+    // make-generator or the yield procedure of one, and the value a
+    // generator returns once its producer has finished (see control.c)
+    CONTINUATION_TYPE,
+    GENERATOR_TYPE,
+    EOF_TYPE,
+
+    // A procedure made by memoize (see memo.c)
+    MEMOIZED_TYPE,
+
+    // An integer too large for a fixnum (see bignum.h)
+    BIGNUM_TYPE,
+
+    // A vector, and the token that opens a vector literal (see vector.h)
+    VECTOR_TYPE,
+    OPENVECTOR_TYPE,
+
+    // Vectors of unboxed bytes, 64-bit integers and doubles (see numvec.h)
+    BYTEVECTOR_TYPE,
+    S64VECTOR_TYPE,
+    F64VECTOR_TYPE,
+
+    // A hash table made by make-hash-table (see hashtable.h)
+    HASHTABLE_TYPE,
+
+    // A persistent map or vector, or a transient one, its contents kept
+    // behind p (see persistent.h)
+    PMAP_TYPE,
+    PVECTOR_TYPE,
+
+    // A record made by a constructor define-record-type defined, and the
+    // type it belongs to (see records.h)
+    RECORD_TYPE,
+    RECORD_TYPE_TYPE
 } itemType;
 
 struct Item {
     itemType type;
     union {
-        int i;
+        long i;
         double d;
         char *s;
         void *p;
+        // A string: its characters, followed by a NUL, and how many there
+        // are, not counting the NUL. The characters share their storage
+        // with s. A long string made by string-append starts out as a rope
+        // of the strings it joins, with no characters until something
+        // needs them (see str.h).
+        struct String {
+            char *chars;
+            long length;
+            struct Rope *rope;
+        } str;
+        // A symbol in the parse tree is also a variable reference. When a
+        // reference resolves to a global binding, the binding cell is cached
+        // on the symbol together with the global epoch it was found in, so
+        // later evaluations skip the lookup until the epoch changes. The name
+        // shares its storage with s. The keyword of a lambda expression uses
+        // cell to cache the expression's free variables instead.
+        struct SymbolCache {
+            char *name;
+            struct Item *cell;
+            unsigned long epoch;
+        } sc;
         struct ConsCell {
             struct Item *car;
             struct Item *cdr;
@@ -29,22 +99,134 @@ struct Item {
         // For purposes of this project a closure is just another type of value,
         // containing everything needed to execute a user-defined function: (1)
         // a list of formal parameter names; (2) a pointer to the function body;
-        // (3) a pointer to the environment frame in which the function was
-        // created.
+        // (3) a pointer to a frame holding the bindings of its free variables,
+        // shared with the frame in which the function was created. A loop
+        // keeps the binding cells of its variables, its body and the frame
+        // that holds those cells in the same fields.
         struct Closure {
             struct Item *paramNames;
             struct Item *functionCode;
             struct Frame *frame;
         } cl;
         
-        // A primitive style function; just a pointer to it, with the right
-        // signature (pf = primitive function)
-        struct Item *(*pf)(struct Item *);
+        // A primitive style function; a pointer to its description (pr =
+        // primitive)
+        struct Primitive *pr;
+
+        // A compiled closure: the compiled lambda and the environment of
+        // variable slots it was created in.
+        struct CompiledClosure {
+            struct Function *function;
+            struct Env *env;
+        } cc;
+
+        // A specialized call site: the operator symbol it replaced, the
+        // primitive that symbol was bound to, the operation the site
+        // computes itself and the kind of operands it expects.
+        struct CallSite {
+            struct Item *symbol;
+            struct Primitive *primitive;
+            int operation;
+            int kind;
+        } cs;
+
+        // A promise; a pointer to its state, which promises linked by
+        // delay-force come to share as they are forced (see interpreter.c)
+        struct Promise *pm;
+
+        // An escape continuation; a pointer to where it escapes to
+        struct Escape *ec;
+
+        // A generator, or with yields set the procedure its producer yields
+        // values with; a pointer to the generator's state
+        struct GeneratorRef {
+            struct Generator *state;
+            int yields;
+        } gn;
+
+        // A memoized procedure: the procedure it wraps and the table of
+        // values it has returned
+        struct Memoized {
+            struct Item *function;
+            struct Memo *cache;
+        } mo;
+
+        // An integer too large for a fixnum; a pointer to its sign and
+        // limbs
+        struct Bignum *bn;
+
+        // A vector: its elements, stored contiguously, and how many there
+        // are, which never changes
+        struct Vector {
+            struct Item **elements;
+            long length;
+        } v;
+
+        // A bytevector, s64vector or f64vector: its elements, unboxed and
+        // stored contiguously, and how many there are
+        struct NumericVector {
+            void *data;
+            long length;
+        } nv;
+
+        // A hash table; a pointer to its slots and counts
+        struct HashTable *ht;
+
+        // A record: its type and its fields, stored contiguously in the
+        // order the type lists them
+        struct Record {
+            struct RecordType *type;
+            struct Item **slots;
+        } rc;
+
+        // A record type; a pointer to its name and fields
+        struct RecordType *rt;
     };
 };
 
 typedef struct Item Item;
 
+// A primitive function. Arguments are passed as a count and a vector of
+// values rather than a list, and the caller checks the count against the
+// primitive's arity, so the primitive itself never has to. A primitive of
+// fixed arity has an entry point taking its one or two arguments directly
+// instead. The procedures define-record-type makes are primitives made at
+// run time, and reach the record type and field they were made for through
+// the primitive itself.
+struct Primitive {
+    const char *name;
+    Item *(*call)(int argc, Item **argv);
+    Item *(*call1)(Item *a);
+    Item *(*call2)(Item *a, Item *b);
+    int minArgs;
+    // -1 if there is no limit
+    int maxArgs;
+    const char *arityError;
+    // set for the procedures define-record-type makes, which are called
+    // with the primitive and the arguments instead of the entry points
+    // above: the record type, and the field an accessor or modifier reads
+    // or writes or the fields a constructor fills from its arguments
+    Item *(*callRecord)(struct Primitive *self, Item **argv);
+    struct RecordType *record;
+    int *fields;
+};
+
+typedef struct Primitive Primitive;
+
+// The state of a promise. Until it is forced, value is the expression to
+// evaluate in frame, or, with no frame, a procedure of no arguments to call
+// instead. Once it is done, value is the promise's value. The expression of
+// a chained promise, made by delay-force, produces another promise, whose
+// value is this one's.
+struct Promise {
+    int done;
+    int chained;
+    struct Item *value;
+    struct Frame *frame;
+};
+
+typedef struct Promise Promise;
+
 
 // A frame is a linked list of bindings, and a pointer to another frame.  A
 // binding is a variable name (represented as a string), and a pointer to the
@@ -54,9 +236,14 @@ typedef struct Item Item;
 // ultimately take less coding. It also will require less modification of
 // existing code.
 
+// The global frame is the exception: it is looked up far more than any other
+// frame and can grow to thousands of bindings, so it keeps its bindings in a
+// hash table instead (see symtab.h) and leaves the list empty.
+
 struct Frame {
     struct Item *bindings;
     struct Frame *parent;
+    struct SymbolTable *table;
 };
 
 typedef struct Frame Frame;
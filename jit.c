@@ -0,0 +1,748 @@
+#include <stddef.h>
+#include <string.h>
+#include "jit.h"
+#include "interpreter.h"
+#include "talloc.h"
+
+static int jitEnabled = 1;
+int jitThreshold = JIT_THRESHOLD;
+
+// turn the JIT on or off. takes in a flag and does not return anything
+void setJitEnabled(int enabled) {
+    jitEnabled = enabled;
+}
+
+// set how many times a function runs before it is compiled. takes in the
+// count and does not return anything
+void setJitThreshold(int threshold) {
+    jitThreshold = threshold;
+}
+
+#if defined(__x86_64__) && defined(__linux__)
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Native code is called from C as
+//
+//     intptr_t code(Item **sp, Env *env, void *entry, Item ***spOut)
+//
+// and keeps the operand stack pointer in rbx, the environment in r13 and
+// spOut in r14, all callee-saved, so helpers written in C can be called
+// between instructions without saving anything. It returns the code position
+// of the instruction the interpreter runs next, after storing rbx in *spOut.
+typedef intptr_t (*NativeCode)(Item **sp, Env *env, void *entry, Item ***spOut);
+
+// A buffer of machine code being generated.
+typedef struct {
+    unsigned char *bytes;
+    int length;
+    int capacity;
+} CodeBuffer;
+
+// append bytes to a code buffer, growing it if needed. takes in the buffer,
+// the bytes and how many there are
+static void emitBytes(CodeBuffer *b, const unsigned char *bytes, int count) {
+    if (b->length + count > b->capacity) {
+        int newCapacity = b->capacity ? 2 * b->capacity : 1024;
+        while (newCapacity < b->length + count) {
+            newCapacity *= 2;
+        }
+        unsigned char *newBytes = talloc(newCapacity);
+        memcpy(newBytes, b->bytes, b->length);
+        b->bytes = newBytes;
+        b->capacity = newCapacity;
+    }
+    memcpy(b->bytes + b->length, bytes, count);
+    b->length += count;
+}
+
+#define EMIT(b, ...) do { \
+        const unsigned char bytes[] = {__VA_ARGS__}; \
+        emitBytes(b, bytes, sizeof(bytes)); \
+    } while (0)
+
+static void emitInt32(CodeBuffer *b, int32_t value) {
+    emitBytes(b, (unsigned char *)&value, 4);
+}
+
+static void emitInt64(CodeBuffer *b, int64_t value) {
+    emitBytes(b, (unsigned char *)&value, 8);
+}
+
+// emit a jump with a 32-bit displacement to be patched later. takes in the
+// buffer and the opcode bytes, and returns the offset of the displacement
+static int emitJump32(CodeBuffer *b, const unsigned char *opcode, int count) {
+    emitBytes(b, opcode, count);
+    int at = b->length;
+    emitInt32(b, 0);
+    return at;
+}
+
+// point a jump's 32-bit displacement at an offset in the buffer
+static void patchJump32(CodeBuffer *b, int at, int target) {
+    int32_t displacement = target - (at + 4);
+    memcpy(b->bytes + at, &displacement, 4);
+}
+
+// emit a short conditional jump to be patched later. takes in the buffer
+// and the opcode, and returns the offset of the displacement
+static int emitJump8(CodeBuffer *b, unsigned char opcode) {
+    EMIT(b, opcode, 0);
+    return b->length - 1;
+}
+
+// point a short jump at the end of the code so far
+static void patchJump8(CodeBuffer *b, int at) {
+    b->bytes[at] = (unsigned char)(b->length - (at + 1));
+}
+
+static const unsigned char JMP[] = {0xE9};
+static const unsigned char JE[] = {0x0F, 0x84};
+static const unsigned char JNE[] = {0x0F, 0x85};
+static const unsigned char JO[] = {0x0F, 0x80};
+#define JE8 0x74
+#define JNE8 0x75
+
+// mov rax, imm64
+static void emitLoadRax(CodeBuffer *b, intptr_t value) {
+    EMIT(b, 0x48, 0xB8);
+    emitInt64(b, value);
+}
+
+// push rax onto the operand stack: mov [rbx], rax; add rbx, 8
+static void emitPushRax(CodeBuffer *b) {
+    EMIT(b, 0x48, 0x89, 0x03, 0x48, 0x83, 0xC3, 0x08);
+}
+
+// pop the operand stack into rax: mov rax, [rbx-8]; sub rbx, 8
+static void emitPopRax(CodeBuffer *b) {
+    EMIT(b, 0x48, 0x8B, 0x43, 0xF8, 0x48, 0x83, 0xEB, 0x08);
+}
+
+// call a C function of the form Item **helper(Item **sp, Env *env,
+// intptr_t a, intptr_t b) and take the stack pointer it returns
+static void emitHelper(CodeBuffer *b, void *helper, intptr_t a, intptr_t x) {
+    EMIT(b, 0x48, 0x89, 0xDF);      // mov rdi, rbx
+    EMIT(b, 0x4C, 0x89, 0xEE);      // mov rsi, r13
+    EMIT(b, 0x48, 0xBA);            // mov rdx, a
+    emitInt64(b, a);
+    EMIT(b, 0x48, 0xB9);            // mov rcx, x
+    emitInt64(b, x);
+    emitLoadRax(b, (intptr_t)helper);
+    EMIT(b, 0xFF, 0xD0);            // call rax
+    EMIT(b, 0x48, 0x89, 0xC3);      // mov rbx, rax
+}
+
+// hand control back to the interpreter at a code position: mov eax,
+// position; jmp to the epilogue, which is at the start of the buffer
+static void emitExit(CodeBuffer *b, int position) {
+    EMIT(b, 0xB8);
+    emitInt32(b, position);
+    patchJump32(b, emitJump32(b, JMP, 1), 0);
+}
+
+// The helpers below implement the instructions that are not worth
+// generating code for. Each takes in the operand stack pointer, the
+// environment and up to two operands, and returns the new stack pointer.
+
+static Item **jitError(Item **sp, Env *env, intptr_t message, intptr_t unused) {
+    evaluationError((const char *)message);
+    return sp;
+}
+
+static Item **jitLocalSet(Item **sp, Env *env, intptr_t depth, intptr_t slot) {
+    while (depth-- > 0) {
+        env = env->parent;
+    }
+    env->slots[slot] = *--sp;
+    return sp;
+}
+
+static Item **jitBox(Item **sp, Env *env, intptr_t slot, intptr_t unused) {
+    env->slots[slot] = makeBox(env->slots[slot]);
+    return sp;
+}
+
+static Item **jitBoxSet(Item **sp, Env *env, intptr_t depth, intptr_t slot) {
+    while (depth-- > 0) {
+        env = env->parent;
+    }
+    env->slots[slot]->c.cdr = *--sp;
+    return sp;
+}
+
+static Item **jitGlobalRef(Item **sp, Env *env, intptr_t site, intptr_t unused) {
+    *sp++ = resolveGlobal((Item *)site)->c.cdr;
+    return sp;
+}
+
+static Item **jitGlobalSet(Item **sp, Env *env, intptr_t site, intptr_t unused) {
+    resolveGlobal((Item *)site)->c.cdr = *--sp;
+    return sp;
+}
+
+static Item **jitGlobalDefine(Item **sp, Env *env, intptr_t site, intptr_t unused) {
+    defineGlobal(((Item *)site)->s, *--sp);
+    return sp;
+}
+
+static Item **jitMakeClosure(Item **sp, Env *env, intptr_t function, intptr_t unused) {
+    *sp++ = makeClosure((Function *)function, env);
+    return sp;
+}
+
+static Item **jitPromise(Item **sp, Env *env, intptr_t chained, intptr_t unused) {
+    sp[-1] = makePromise(sp[-1], NULL, chained);
+    return sp;
+}
+
+static Item **jitSetPair(Item **sp, Env *env, intptr_t isCar, intptr_t unused) {
+    Item *value = *--sp;
+    Item *pair = *--sp;
+    if (pair->type != CONS_TYPE) {
+        evaluationError(isCar ? "not a pair" : "set-cdr! expects a pair as the first argument");
+    }
+    if (isCar) {
+        pair->c.car = value;
+    } else {
+        pair->c.cdr = value;
+    }
+    *sp++ = voidItem;
+    return sp;
+}
+
+// calls out to a primitive or tree-walker closure, which may start a nested
+// run of the VM and move the operand stack, so the stack pointer is found
+// again from its index afterwards
+static Item **jitCallOut(Item **sp, Env *env, intptr_t argc, intptr_t unused) {
+    int spIndex = sp - valueStack;
+    valueTop = spIndex;
+    Item *result = callOut(sp[-argc - 1], sp - argc, argc);
+    sp = valueStack + spIndex - argc - 1;
+    *sp++ = result;
+    return sp;
+}
+
+// make the result of an inlined primitive. takes in the value
+static Item *jitMakeInt(long value) {
+    Item *result = talloc(sizeof(Item));
+    result->type = INT_TYPE;
+    result->i = value;
+    return result;
+}
+
+static Item *jitMakeBool(int value) {
+    Item *result = talloc(sizeof(Item));
+    result->type = BOOL_TYPE;
+    result->i = value;
+    return result;
+}
+
+static Item **jitFixnum(Item **sp, Env *env, intptr_t operation, intptr_t unused) {
+    sp--;
+    sp[-1] = computeFixnum(operation, sp - 1);
+    return sp;
+}
+
+static Item **jitFlonum(Item **sp, Env *env, intptr_t operation, intptr_t unused) {
+    sp--;
+    sp[-1] = computeFlonum(operation, sp - 1);
+    return sp;
+}
+
+// The primitives inlined for two integer arguments, with the instruction
+// that combines rax with the second argument at [rdx+offset], and the
+// setcc that turns flags into a boolean for comparisons. They are in the
+// order of the site operations, so a proven fixnum operation indexes them.
+typedef struct {
+    void *entry;
+    unsigned char op[4];
+    int opLength;
+    unsigned char setcc;
+} InlinePrimitive;
+
+#define INT_OFFSET ((unsigned char)offsetof(Item, i))
+
+static const InlinePrimitive inlinePrimitives[] = {
+    {(void *)primitivePlus, {0x48, 0x03, 0x42}, 3, 0},              // add rax, [rdx+i]
+    {(void *)primitiveMinus, {0x48, 0x2B, 0x42}, 3, 0},             // sub rax, [rdx+i]
+    {(void *)primitiveMultiply, {0x48, 0x0F, 0xAF, 0x42}, 4, 0},    // imul rax, [rdx+i]
+    {(void *)primitiveLess, {0x48, 0x3B, 0x42}, 3, 0x9C},           // cmp; setl
+    {(void *)primitiveGreater, {0x48, 0x3B, 0x42}, 3, 0x9F},        // cmp; setg
+    {(void *)primitiveEqual, {0x48, 0x3B, 0x42}, 3, 0x94},          // cmp; sete
+};
+
+// find the inline template for the function a call site would call right
+// now. takes in the instruction that pushed the function, or -1 if that is
+// not known, and returns the template or NULL
+static const InlinePrimitive *findInlinePrimitive(Function *function, int producer) {
+    if (producer < 0 || function->code[producer] != GLOBAL_REF_OP) {
+        return NULL;
+    }
+    Item *cell = function->constants[function->code[producer + 1]]->sc.cell;
+    if (cell == NULL || cell->c.cdr->type != PRIMITIVE_TYPE) {
+        return NULL;
+    }
+    Primitive *primitive = cell->c.cdr->pr;
+    for (size_t i = 0; i < sizeof(inlinePrimitives) / sizeof(inlinePrimitives[0]); i++) {
+        if (inlinePrimitives[i].entry == (void *)primitive->call ||
+            inlinePrimitives[i].entry == (void *)primitive->call2) {
+            return &inlinePrimitives[i];
+        }
+    }
+    return NULL;
+}
+
+// record the operand stack at a jump for its target, merging with what
+// other jumps there recorded. positions where they disagree become -1
+static void saveStack(int **saved, int *savedDepth, int target, int *stack, int depth) {
+    if (saved[target] == NULL) {
+        saved[target] = talloc(sizeof(int) * (depth + 1));
+        memcpy(saved[target], stack, sizeof(int) * depth);
+        savedDepth[target] = depth;
+        return;
+    }
+    for (int i = 0; i < depth; i++) {
+        if (saved[target][i] != stack[i]) {
+            saved[target][i] = -1;
+        }
+    }
+}
+
+// find the instruction that pushed the function each call calls, by
+// following the operand stack through the code. takes in the function and
+// returns an array that holds, at the position of each call, the position
+// of that instruction or -1 if it depends on the path taken
+static int *findCallees(Function *function) {
+    int length = function->codeLength;
+    int *callees = talloc(sizeof(int) * (length + 1));
+    int **saved = talloc(sizeof(int *) * (length + 1));
+    int *savedDepth = talloc(sizeof(int) * (length + 1));
+    int *stack = talloc(sizeof(int) * (function->maxStack + 1));
+    for (int i = 0; i <= length; i++) {
+        callees[i] = -1;
+        saved[i] = NULL;
+    }
+    int depth = 0;
+    int live = 1;
+    for (int pc = 0; pc < length; pc += 1 + opcodeOperands[function->code[pc]]) {
+        Opcode op = function->code[pc];
+        intptr_t operand = function->code[pc + 1];
+        if (saved[pc] != NULL) {
+            if (live) {
+                saveStack(saved, savedDepth, pc, stack, depth);
+            }
+            memcpy(stack, saved[pc], sizeof(int) * savedDepth[pc]);
+            depth = savedDepth[pc];
+            live = 1;
+        }
+        if (!live) {
+            continue;
+        }
+        switch (op) {
+            case CONST_OP:
+            case LOCAL_REF_OP:
+            case BOX_REF_OP:
+            case GLOBAL_REF_OP:
+            case VOID_OP:
+            case MAKE_CLOSURE_OP:
+                stack[depth++] = pc;
+                break;
+            case POP_OP:
+            case LOCAL_SET_OP:
+            case BOX_SET_OP:
+            case GLOBAL_SET_OP:
+            case GLOBAL_DEFINE_OP:
+                depth--;
+                break;
+            case JUMP_OP:
+                saveStack(saved, savedDepth, operand, stack, depth);
+                live = 0;
+                break;
+            case JUMP_IF_FALSE_OP:
+            case JUMP_UNLESS_TRUE_OP:
+                depth--;
+                saveStack(saved, savedDepth, operand, stack, depth);
+                break;
+            case AND_JUMP_OP:
+            case OR_JUMP_OP:
+                saveStack(saved, savedDepth, operand, stack, depth);
+                depth--;
+                break;
+            case CALL_OP:
+                callees[pc] = stack[depth - operand - 1];
+                depth -= operand + 1;
+                stack[depth++] = pc;
+                break;
+            case TAIL_CALL_OP:
+                callees[pc] = stack[depth - operand - 1];
+                live = 0;
+                break;
+            case RETURN_OP:
+                live = 0;
+                break;
+            case SET_CAR_OP:
+            case SET_CDR_OP:
+            case FIXNUM_OP:
+            case FLONUM_OP:
+                depth -= 2;
+                stack[depth++] = pc;
+                break;
+            case PROMISE_OP:
+                stack[depth - 1] = pc;
+                break;
+            default:
+                break;
+        }
+    }
+    return callees;
+}
+
+// emit a call. the generic path hands calls to compiled closures and
+// memoized procedures back to the interpreter and calls anything else out; a call to an arithmetic or
+// comparison primitive first tries the inlined version, guarded on the
+// function still being that primitive and both arguments being integers
+static void emitCall(CodeBuffer *b, Function *function, int pc, int producer) {
+    int argc = function->code[pc + 1];
+    EMIT(b, 0x48, 0x8B, 0x83);          // mov rax, [rbx - 8*(argc+1)]
+    emitInt32(b, -8 * (argc + 1));
+
+    const InlinePrimitive *inlined = argc == 2 ? findInlinePrimitive(function, producer) : NULL;
+    int guards[4];
+    int guardCount = 0;
+    int done = -1;
+    if (inlined != NULL) {
+        Item *primitive = function->constants[function->code[producer + 1]]->sc.cell->c.cdr;
+        EMIT(b, 0x48, 0xB9);            // mov rcx, primitive
+        emitInt64(b, (intptr_t)primitive);
+        EMIT(b, 0x48, 0x39, 0xC8);      // cmp rax, rcx
+        guards[guardCount++] = emitJump32(b, JNE, 2);
+        EMIT(b, 0x48, 0x8B, 0x4B, 0xF0);    // mov rcx, [rbx-16]
+        EMIT(b, 0x48, 0x8B, 0x53, 0xF8);    // mov rdx, [rbx-8]
+        EMIT(b, 0x83, 0x39, INT_TYPE);      // cmp dword [rcx], INT_TYPE
+        guards[guardCount++] = emitJump32(b, JNE, 2);
+        EMIT(b, 0x83, 0x3A, INT_TYPE);      // cmp dword [rdx], INT_TYPE
+        guards[guardCount++] = emitJump32(b, JNE, 2);
+        EMIT(b, 0x48, 0x8B, 0x41, INT_OFFSET);  // mov rax, [rcx+i]
+        emitBytes(b, inlined->op, inlined->opLength);
+        EMIT(b, INT_OFFSET);
+        if (inlined->setcc) {
+            EMIT(b, 0x0F, inlined->setcc, 0xC0);    // setcc al
+            EMIT(b, 0x0F, 0xB6, 0xF8);              // movzx edi, al
+            emitLoadRax(b, (intptr_t)jitMakeBool);
+        } else {
+            guards[guardCount++] = emitJump32(b, JO, 2);
+            EMIT(b, 0x48, 0x89, 0xC7);              // mov rdi, rax
+            emitLoadRax(b, (intptr_t)jitMakeInt);
+        }
+        EMIT(b, 0xFF, 0xD0);                // call rax
+        EMIT(b, 0x48, 0x83, 0xEB, 0x18);    // sub rbx, 24
+        emitPushRax(b);
+        done = emitJump32(b, JMP, 1);
+        for (int i = 0; i < guardCount; i++) {
+            patchJump32(b, guards[i], b->length);
+        }
+        EMIT(b, 0x48, 0x8B, 0x83);          // reload the function
+        emitInt32(b, -8 * (argc + 1));
+    }
+    EMIT(b, 0x83, 0x38, COMPILED_TYPE);     // cmp dword [rax], COMPILED_TYPE
+    int compiled = emitJump8(b, JE8);
+    EMIT(b, 0x83, 0x38, MEMOIZED_TYPE);     // cmp dword [rax], MEMOIZED_TYPE
+    int callOut = emitJump8(b, JNE8);
+    patchJump8(b, compiled);
+    emitExit(b, pc);
+    patchJump8(b, callOut);
+    emitHelper(b, jitCallOut, argc, 0);
+    if (done >= 0) {
+        patchJump32(b, done, b->length);
+    }
+}
+
+// emit a fixnum operation type inference proved. the operands are known to
+// be integers, so only a bignum operand or an overflow leaves the inlined
+// code, for the helper to hand to the primitive. operations with no
+// template use the helper
+static void emitFixnum(CodeBuffer *b, int operation) {
+    if (operation >= (int)(sizeof(inlinePrimitives) / sizeof(inlinePrimitives[0]))) {
+        emitHelper(b, jitFixnum, operation, 0);
+        return;
+    }
+    const InlinePrimitive *inlined = &inlinePrimitives[operation];
+    int slow[3];
+    int slowCount = 0;
+    EMIT(b, 0x48, 0x8B, 0x4B, 0xF0);    // mov rcx, [rbx-16]
+    EMIT(b, 0x48, 0x8B, 0x53, 0xF8);    // mov rdx, [rbx-8]
+    EMIT(b, 0x83, 0x39, INT_TYPE);      // cmp dword [rcx], INT_TYPE
+    slow[slowCount++] = emitJump32(b, JNE, 2);
+    EMIT(b, 0x83, 0x3A, INT_TYPE);      // cmp dword [rdx], INT_TYPE
+    slow[slowCount++] = emitJump32(b, JNE, 2);
+    EMIT(b, 0x48, 0x8B, 0x41, INT_OFFSET);  // mov rax, [rcx+i]
+    emitBytes(b, inlined->op, inlined->opLength);
+    EMIT(b, INT_OFFSET);
+    if (inlined->setcc) {
+        EMIT(b, 0x0F, inlined->setcc, 0xC0);    // setcc al
+        EMIT(b, 0x0F, 0xB6, 0xF8);              // movzx edi, al
+        emitLoadRax(b, (intptr_t)jitMakeBool);
+    } else {
+        slow[slowCount++] = emitJump32(b, JO, 2);
+        EMIT(b, 0x48, 0x89, 0xC7);              // mov rdi, rax
+        emitLoadRax(b, (intptr_t)jitMakeInt);
+    }
+    EMIT(b, 0xFF, 0xD0);                // call rax
+    EMIT(b, 0x48, 0x83, 0xEB, 0x10);    // sub rbx, 16
+    emitPushRax(b);
+    int done = emitJump32(b, JMP, 1);
+    for (int i = 0; i < slowCount; i++) {
+        patchJump32(b, slow[i], b->length);
+    }
+    emitHelper(b, jitFixnum, operation, 0);
+    patchJump32(b, done, b->length);
+}
+
+// check that the value in rax is a boolean, or report an error
+static void emitBoolCheck(CodeBuffer *b, const char *message) {
+    EMIT(b, 0x83, 0x38, BOOL_TYPE);         // cmp dword [rax], BOOL_TYPE
+    int ok = emitJump8(b, JE8);
+    emitHelper(b, jitError, (intptr_t)message, 0);
+    patchJump8(b, ok);
+}
+
+// compare the boolean in rax with false: cmp dword [rax+i], 0
+static void emitTestFalse(CodeBuffer *b) {
+    EMIT(b, 0x83, 0x78, INT_OFFSET, 0x00);
+}
+
+// translate a function's bytecode into native code. takes in the function
+// and the buffer, and returns the offsets of its entry points: the native
+// address of the start, and of every instruction after a call, which is
+// where the interpreter re-enters after running a compiled callee
+static int *translate(Function *function, CodeBuffer *b) {
+    int length = function->codeLength;
+    int *offsets = talloc(sizeof(int) * (length + 1));
+    int *jumps = talloc(sizeof(int) * (length + 1));
+    int *jumpTargets = talloc(sizeof(int) * (length + 1));
+    int jumpCount = 0;
+    int *callees = findCallees(function);
+
+    for (int pc = 0; pc < length; pc += 1 + opcodeOperands[function->code[pc]]) {
+        offsets[pc] = b->length;
+        Opcode op = function->code[pc];
+        intptr_t operand = function->code[pc + 1];
+        switch (op) {
+            case CONST_OP:
+                emitLoadRax(b, (intptr_t)function->constants[operand]);
+                emitPushRax(b);
+                break;
+            case LOCAL_REF_OP:
+            case BOX_REF_OP: {
+                EMIT(b, 0x4C, 0x89, 0xE8);      // mov rax, r13
+                for (intptr_t depth = operand; depth > 0; depth--) {
+                    EMIT(b, 0x48, 0x8B, 0x40, (unsigned char)offsetof(Env, parent));
+                }
+                EMIT(b, 0x48, 0x8B, 0x80);      // mov rax, [rax + slot]
+                emitInt32(b, offsetof(Env, slots) + sizeof(Item *) * function->code[pc + 2]);
+                if (op == BOX_REF_OP) {
+                    EMIT(b, 0x48, 0x8B, 0x40, (unsigned char)offsetof(Item, c.cdr));
+                }
+                EMIT(b, 0x48, 0x85, 0xC0);      // test rax, rax
+                int bound = emitJump8(b, JNE8);
+                emitHelper(b, jitError, (intptr_t)"Unbound symbol", 0);
+                patchJump8(b, bound);
+                emitPushRax(b);
+                break;
+            }
+            case LOCAL_SET_OP:
+                emitHelper(b, jitLocalSet, operand, function->code[pc + 2]);
+                break;
+            case BOX_OP:
+                emitHelper(b, jitBox, operand, 0);
+                break;
+            case BOX_SET_OP:
+                emitHelper(b, jitBoxSet, operand, function->code[pc + 2]);
+                break;
+            case GLOBAL_REF_OP: {
+                // a resolved site's binding cell never changes, since
+                // redefinition and set! update the cell in place
+                Item *cell = function->constants[operand]->sc.cell;
+                if (cell != NULL) {
+                    emitLoadRax(b, (intptr_t)cell);
+                    EMIT(b, 0x48, 0x8B, 0x40, (unsigned char)offsetof(Item, c.cdr));
+                    emitPushRax(b);
+                } else {
+                    emitHelper(b, jitGlobalRef, (intptr_t)function->constants[operand], 0);
+                }
+                break;
+            }
+            case GLOBAL_SET_OP:
+                emitHelper(b, jitGlobalSet, (intptr_t)function->constants[operand], 0);
+                break;
+            case GLOBAL_DEFINE_OP:
+                emitHelper(b, jitGlobalDefine, (intptr_t)function->constants[operand], 0);
+                break;
+            case VOID_OP:
+                emitLoadRax(b, (intptr_t)voidItem);
+                emitPushRax(b);
+                break;
+            case POP_OP:
+                EMIT(b, 0x48, 0x83, 0xEB, 0x08);    // sub rbx, 8
+                break;
+            case JUMP_OP:
+                jumps[jumpCount] = emitJump32(b, JMP, 1);
+                jumpTargets[jumpCount++] = operand;
+                break;
+            case JUMP_IF_FALSE_OP:
+                emitPopRax(b);
+                emitBoolCheck(b, "if expects a boolean as the first argument");
+                emitTestFalse(b);
+                jumps[jumpCount] = emitJump32(b, JE, 2);
+                jumpTargets[jumpCount++] = operand;
+                break;
+            case JUMP_UNLESS_TRUE_OP:
+                emitPopRax(b);
+                EMIT(b, 0x83, 0x38, BOOL_TYPE);
+                jumps[jumpCount] = emitJump32(b, JNE, 2);
+                jumpTargets[jumpCount++] = operand;
+                emitTestFalse(b);
+                jumps[jumpCount] = emitJump32(b, JE, 2);
+                jumpTargets[jumpCount++] = operand;
+                break;
+            case AND_JUMP_OP:
+            case OR_JUMP_OP:
+                EMIT(b, 0x48, 0x8B, 0x43, 0xF8);    // mov rax, [rbx-8]
+                emitBoolCheck(b, "boolean arguments expected");
+                emitTestFalse(b);
+                jumps[jumpCount] = emitJump32(b, op == AND_JUMP_OP ? JE : JNE, 2);
+                jumpTargets[jumpCount++] = operand;
+                EMIT(b, 0x48, 0x83, 0xEB, 0x08);    // sub rbx, 8
+                break;
+            case MAKE_CLOSURE_OP:
+                emitHelper(b, jitMakeClosure, (intptr_t)function->functions[operand], 0);
+                break;
+            case CALL_OP:
+                emitCall(b, function, pc, callees[pc]);
+                break;
+            case TAIL_CALL_OP:
+            case RETURN_OP:
+                emitExit(b, pc);
+                break;
+            case SET_CAR_OP:
+            case SET_CDR_OP:
+                emitHelper(b, jitSetPair, op == SET_CAR_OP, 0);
+                break;
+            case PROMISE_OP:
+                emitHelper(b, jitPromise, operand, 0);
+                break;
+            case FIXNUM_OP:
+                emitFixnum(b, operand);
+                break;
+            case FLONUM_OP:
+                emitHelper(b, jitFlonum, operand, 0);
+                break;
+            default:
+                break;
+        }
+    }
+    offsets[length] = b->length;
+    for (int i = 0; i < jumpCount; i++) {
+        patchJump32(b, jumps[i], offsets[jumpTargets[i]]);
+    }
+    return offsets;
+}
+
+#define REGION_SIZE (1 << 20)
+
+// the executable region native code is copied into, and how much of it
+// has been used
+static unsigned char *region = NULL;
+static size_t regionSize = 0;
+static size_t regionUsed = 0;
+
+// copy finished code into executable memory. the region is only writable
+// while code is being copied in. takes in the buffer and returns the
+// address of the copy, or NULL if no memory could be mapped
+static unsigned char *installCode(CodeBuffer *b) {
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    size_t size = (b->length + 15) & ~(size_t)15;
+    if (region == NULL || regionUsed + size > regionSize) {
+        size_t newSize = size > REGION_SIZE ? (size + pageSize - 1) & ~(pageSize - 1) : REGION_SIZE;
+        void *mapped = mmap(NULL, newSize, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapped == MAP_FAILED) {
+            return NULL;
+        }
+        region = mapped;
+        regionSize = newSize;
+        regionUsed = 0;
+    }
+    unsigned char *code = region + regionUsed;
+    unsigned char *firstPage = (unsigned char *)((uintptr_t)code & ~(pageSize - 1));
+    size_t span = (code + size) - firstPage;
+    if (mprotect(firstPage, span, PROT_READ | PROT_WRITE) != 0) {
+        return NULL;
+    }
+    memcpy(code, b->bytes, b->length);
+    mprotect(firstPage, span, PROT_READ | PROT_EXEC);
+    regionUsed += size;
+    return code;
+}
+
+// compile a function to native code. takes in the function and does not
+// return anything; on success its native fields are filled in
+void jitCompile(Function *function) {
+    if (!jitEnabled || voidItem == NULL) {
+        return;
+    }
+    CodeBuffer buffer = {NULL, 0, 0};
+    CodeBuffer *b = &buffer;
+
+    // the epilogue comes first so every exit can jump back to offset 0
+    EMIT(b, 0x49, 0x89, 0x1E);              // mov [r14], rbx
+    EMIT(b, 0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B);  // pop r15..rbx
+    EMIT(b, 0xC3);                          // ret
+    int prologue = b->length;
+    // push rbx, r12-r15, which also aligns the stack for helper calls
+    EMIT(b, 0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57);
+    EMIT(b, 0x48, 0x89, 0xFB);              // mov rbx, rdi
+    EMIT(b, 0x49, 0x89, 0xF5);              // mov r13, rsi
+    EMIT(b, 0x49, 0x89, 0xCE);              // mov r14, rcx
+    EMIT(b, 0xFF, 0xE2);                    // jmp rdx
+
+    int *offsets = translate(function, b);
+    unsigned char *code = installCode(b);
+    if (code == NULL) {
+        return;
+    }
+    void **entries = talloc(sizeof(void *) * (function->codeLength + 1));
+    for (int i = 0; i <= function->codeLength; i++) {
+        entries[i] = NULL;
+    }
+    entries[0] = code + offsets[0];
+    for (int pc = 0; pc < function->codeLength; pc += 1 + opcodeOperands[function->code[pc]]) {
+        if (function->code[pc] == CALL_OP) {
+            entries[pc + 2] = code + offsets[pc + 2];
+        } else if (function->code[pc] == LOOP_OP) {
+            entries[pc] = code + offsets[pc];
+        }
+    }
+    function->nativeEntries = entries;
+    function->native = code + prologue;
+}
+
+// run native code. takes in the function, a pointer to the operand stack
+// pointer, the environment and the code position to start at, and returns
+// the code position the interpreter continues from
+intptr_t jitEnter(Function *function, Item ***sp, Env *env, int position) {
+    NativeCode code = (NativeCode)function->native;
+    return code(*sp, env, function->nativeEntries[position], sp);
+}
+
+#else
+
+void jitCompile(Function *function) {
+}
+
+intptr_t jitEnter(Function *function, Item ***sp, Env *env, int position) {
+    return position;
+}
+
+#endif
@@ -0,0 +1,43 @@
+#include <stdint.h>
+#include "item.h"
+#include "vm.h"
+
+#ifndef JIT_H
+#define JIT_H
+
+// A baseline JIT for compiled functions. Once a function has been entered
+// jitThreshold times its bytecode is translated, one template per
+// instruction, into x86-64 code in an executable mmap region. Simple
+// instructions run inline and the rest call small C helpers. Calls to
+// arithmetic and comparison primitives are inlined behind guards on the
+// callee and the argument types; when a guard fails the call goes the
+// generic way. Native code hands control back to the interpreter for calls
+// to compiled closures, tail calls and returns, and the interpreter
+// re-enters it after those calls. A function whose loops run jitThreshold
+// iterations is compiled too, and enters native code at the next iteration.
+// On other platforms nothing is compiled.
+#define JIT_THRESHOLD 1000
+
+extern int jitThreshold;
+
+// Turns the JIT on or off. It is on by default.
+void setJitEnabled(int enabled);
+
+// Sets how many entries or loop iterations it takes for a function to be
+// compiled, JIT_THRESHOLD by default. A threshold of 1 compiles every
+// function the first time it runs, which tests use to run everything
+// native.
+void setJitThreshold(int threshold);
+
+// Compiles a function to native code, filling in its native fields. Leaves
+// them NULL if the JIT is disabled or cannot run on this platform.
+void jitCompile(Function *function);
+
+// Runs a function's native code from the instruction at the given code
+// position, which must have a native entry. Takes in a pointer to the
+// operand stack pointer, which is updated, and the function's environment.
+// Returns the code position of the instruction the interpreter must run
+// next.
+intptr_t jitEnter(Function *function, Item ***sp, Env *env, int position);
+
+#endif
@@ -34,7 +34,7 @@ void display(Item *list) {
         } else {
             switch (element->type) {
                 case INT_TYPE:
-                    printf("%d ", element->i);
+                    printf("%ld ", element->i);
                     break;
                 case DOUBLE_TYPE:
                     printf("%f ", element->d);
@@ -82,6 +82,8 @@ Item *cloneItem(Item *source) {
                 free(newItem);
                 exit(EXIT_FAILURE);
             }
+            newItem->str.length = source->str.length;
+            newItem->str.rope = NULL;
             break;
         default:
             free(newItem);
@@ -90,13 +92,12 @@ Item *cloneItem(Item *source) {
     return newItem;
 }
 
-// takes in a list and returns a new reversed list by using
-// the helper function defined above.
+// takes in a list and returns a new reversed list. the new cons cells
+// point at the items of the original list rather than copies of them.
 Item *reverse(Item *list) {
     Item *reversed = makeNull();
     while (!isNull(list)) {
-        Item *clonedItem = cloneItem(car(list));
-        reversed = cons(clonedItem, reversed); 
+        reversed = cons(car(list), reversed); 
         list = cdr(list);
     }
     return reversed;
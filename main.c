@@ -1,16 +1,81 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "tokenizer.h"
 #include "item.h"
 #include "linkedlist.h"
 #include "parser.h"
 #include "talloc.h"
 #include "interpreter.h"
+#include "jit.h"
+#include "aot.h"
+#include "optimizer.h"
+#include "types.h"
+#include "expand.h"
 
-int main() {
+int main(int argc, char **argv) {
+    int compileOnly = 0;
+    int optimizeTree = 1;
+    int dumpOptimized = 0;
+    int typeReport = 0;
+    int countSteps = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--stack-limit=", 14) == 0 && atol(argv[i] + 14) > 0) {
+            setStackLimit((size_t)atol(argv[i] + 14) * 1024 * 1024);
+        } else if (strcmp(argv[i], "--tree-walk") == 0) {
+            setTreeWalker(1);
+        } else if (strcmp(argv[i], "--no-jit") == 0) {
+            setJitEnabled(0);
+        } else if (strncmp(argv[i], "--jit-threshold=", 16) == 0 && atoi(argv[i] + 16) > 0) {
+            setJitThreshold(atoi(argv[i] + 16));
+        } else if (strcmp(argv[i], "--compile-to-c") == 0) {
+            compileOnly = 1;
+        } else if (strcmp(argv[i], "--no-optimize") == 0) {
+            optimizeTree = 0;
+        } else if (strcmp(argv[i], "--dump-optimized") == 0) {
+            dumpOptimized = 1;
+        } else if (strcmp(argv[i], "--type-report") == 0) {
+            typeReport = 1;
+        } else if (strcmp(argv[i], "--count-steps") == 0) {
+            countSteps = 1;
+        } else {
+            printf("Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
 
     Item *list = tokenize();
-    Item *tree = parse(list);
-    interpret(tree);
+    Item *tree = expandProgram(parse(list));
+    if (optimizeTree) {
+        tree = optimize(tree);
+    }
+    if (typeReport) {
+        inferTypes(tree, 1);
+        tfree();
+        return 0;
+    }
+    if (optimizeTree) {
+        tree = inferTypes(tree, 0);
+    }
+    if (dumpOptimized) {
+        // a list form is wrapped so printTree keeps its outer parentheses
+        for (Item *forms = tree; !isNull(forms); forms = cdr(forms)) {
+            Item *form = car(forms);
+            printTree(form->type == CONS_TYPE ? cons(form, makeNull()) : form);
+            printf("\n");
+        }
+        tfree();
+        return 0;
+    }
+    if (compileOnly) {
+        compileToC(tree);
+    } else {
+        interpret(tree);
+        if (countSteps) {
+            fflush(stdout);
+            fprintf(stderr, "evaluation steps: %ld\n", getEvalSteps());
+        }
+    }
 
     tfree();
     return 0;
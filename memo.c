@@ -0,0 +1,285 @@
+#include <string.h>
+#include "memo.h"
+#include "bignum.h"
+#include "hashtable.h"
+#include "interpreter.h"
+#include "linkedlist.h"
+#include "talloc.h"
+
+#define INITIAL_MEMO_CAPACITY 64
+
+// An entry of a memo table: the arguments of a call and its value, the
+// next entry in the same bucket, and its neighbours in the table's order
+// of use, from newest to oldest.
+struct MemoEntry {
+    unsigned long hash;
+    int argc;
+    Item **argv;
+    Item *value;
+    struct Memo *memo;
+    struct MemoEntry *chain;
+    struct MemoEntry *newer;
+    struct MemoEntry *older;
+};
+
+typedef struct MemoEntry MemoEntry;
+
+typedef enum {
+    LRU_EVICTION, FIFO_EVICTION
+} EvictionPolicy;
+
+// The table of a memoized procedure: buckets of chained entries, a list of
+// the entries by use, the most entries it may hold, or 0 for no limit, and
+// how it evicts them and its counters.
+struct Memo {
+    MemoEntry **buckets;
+    int capacity;
+    int count;
+    int limit;
+    EvictionPolicy policy;
+    MemoEntry *newest;
+    MemoEntry *oldest;
+    long hits;
+    long misses;
+};
+
+typedef struct Memo Memo;
+
+// hashes the arguments of a call to match equal?. takes in the arguments
+// as a count and a vector and returns the hash
+unsigned long hashArguments(int argc, Item **argv) {
+    unsigned long hash = mixWord(0, argc);
+    for (int i = 0; i < argc; i++) {
+        hash = mixWord(hash, equalHash(argv[i]));
+    }
+    return hash;
+}
+
+// unlinks an entry from a table's order of use. takes in the table and the
+// entry and does not return anything
+void unlinkEntry(Memo *memo, MemoEntry *entry) {
+    if (entry->newer != NULL) {
+        entry->newer->older = entry->older;
+    } else {
+        memo->newest = entry->older;
+    }
+    if (entry->older != NULL) {
+        entry->older->newer = entry->newer;
+    } else {
+        memo->oldest = entry->newer;
+    }
+}
+
+// makes an entry the newest in a table's order of use. takes in the table
+// and the entry and does not return anything
+void linkNewest(Memo *memo, MemoEntry *entry) {
+    entry->newer = NULL;
+    entry->older = memo->newest;
+    if (memo->newest != NULL) {
+        memo->newest->newer = entry;
+    } else {
+        memo->oldest = entry;
+    }
+    memo->newest = entry;
+}
+
+// makes an empty bucket array for a table. takes in the table and the
+// number of buckets, a power of two, and does not return anything
+void allocateBuckets(Memo *memo, int capacity) {
+    memo->buckets = talloc(sizeof(MemoEntry *) * capacity);
+    memset(memo->buckets, 0, sizeof(MemoEntry *) * capacity);
+    memo->capacity = capacity;
+}
+
+// doubles a table's buckets, moving each entry to its new bucket. takes in
+// the table and does not return anything
+void growMemo(Memo *memo) {
+    MemoEntry **old = memo->buckets;
+    int oldCapacity = memo->capacity;
+    allocateBuckets(memo, 2 * oldCapacity);
+    for (int i = 0; i < oldCapacity; i++) {
+        MemoEntry *entry = old[i];
+        while (entry != NULL) {
+            MemoEntry *next = entry->chain;
+            int bucket = entry->hash & (memo->capacity - 1);
+            entry->chain = memo->buckets[bucket];
+            memo->buckets[bucket] = entry;
+            entry = next;
+        }
+    }
+}
+
+// removes the entry a table evicts first, its oldest. takes in the table
+// and does not return anything
+void evictEntry(Memo *memo) {
+    MemoEntry *victim = memo->oldest;
+    unlinkEntry(memo, victim);
+    MemoEntry **link = &memo->buckets[victim->hash & (memo->capacity - 1)];
+    while (*link != victim) {
+        link = &(*link)->chain;
+    }
+    *link = victim->chain;
+    memo->count--;
+}
+
+// finds the entry for the arguments of a call. takes in the table, the
+// hash of the arguments and the arguments as a count and a vector, and
+// returns the entry, or NULL if there is none
+MemoEntry *findEntry(Memo *memo, unsigned long hash, int argc, Item **argv) {
+    for (MemoEntry *entry = memo->buckets[hash & (memo->capacity - 1)]; entry != NULL; entry = entry->chain) {
+        if (entry->hash != hash || entry->argc != argc) {
+            continue;
+        }
+        int i = 0;
+        while (i < argc && isEqual(entry->argv[i], argv[i])) {
+            i++;
+        }
+        if (i == argc) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+// looks up a call in a memoized procedure's table, counting a hit or a
+// miss. on a miss, makes an entry for the call that is not in the table
+// yet. takes in the procedure, the arguments as a count and a vector, and
+// where to put the new entry, wrapped in an item. returns the value kept
+// for the call, or NULL on a miss
+Item *memoLookup(Item *function, int argc, Item **argv, Item **pending) {
+    Memo *memo = function->mo.cache;
+    unsigned long hash = hashArguments(argc, argv);
+    MemoEntry *entry = findEntry(memo, hash, argc, argv);
+    if (entry != NULL) {
+        memo->hits++;
+        if (memo->policy == LRU_EVICTION) {
+            unlinkEntry(memo, entry);
+            linkNewest(memo, entry);
+        }
+        return entry->value;
+    }
+    memo->misses++;
+    entry = talloc(sizeof(MemoEntry));
+    entry->hash = hash;
+    entry->argc = argc;
+    entry->argv = talloc(sizeof(Item *) * (argc > 0 ? argc : 1));
+    memcpy(entry->argv, argv, sizeof(Item *) * argc);
+    entry->value = NULL;
+    entry->memo = memo;
+    *pending = talloc(sizeof(Item));
+    (*pending)->type = PTR_TYPE;
+    (*pending)->p = entry;
+    return NULL;
+}
+
+// adds the entry made by a miss to its table, now that the call has
+// returned. the call may have added an entry for the same arguments
+// itself, which is then updated instead. takes in the entry, wrapped in an
+// item, and the value of the call, and does not return anything
+void memoStore(Item *pending, Item *value) {
+    MemoEntry *entry = pending->p;
+    Memo *memo = entry->memo;
+    MemoEntry *existing = findEntry(memo, entry->hash, entry->argc, entry->argv);
+    if (existing != NULL) {
+        existing->value = value;
+        return;
+    }
+    if (memo->limit > 0 && memo->count == memo->limit) {
+        evictEntry(memo);
+    }
+    if (memo->count == memo->capacity) {
+        growMemo(memo);
+    }
+    entry->value = value;
+    int bucket = entry->hash & (memo->capacity - 1);
+    entry->chain = memo->buckets[bucket];
+    memo->buckets[bucket] = entry;
+    linkNewest(memo, entry);
+    memo->count++;
+}
+
+// calls a memoized procedure, calling the procedure it wraps on a miss.
+// takes in the procedure and the arguments as a count and a vector, and
+// returns the value
+Item *callMemoized(Item *function, int argc, Item **argv) {
+    Item *pending;
+    Item *value = memoLookup(function, argc, argv, &pending);
+    if (value != NULL) {
+        return value;
+    }
+    MemoEntry *entry = pending->p;
+    value = apply(function->mo.function, argc, entry->argv);
+    memoStore(pending, value);
+    return value;
+}
+
+// checks whether a value can be called. takes in the value and returns
+// true if it is a procedure
+int isProcedure(Item *value) {
+    return value->type == CLOSURE_TYPE || value->type == COMPILED_TYPE ||
+           value->type == PRIMITIVE_TYPE || value->type == MEMOIZED_TYPE ||
+           value->type == CONTINUATION_TYPE || value->type == GENERATOR_TYPE;
+}
+
+// implements memoize. takes in the procedure, and optionally the most
+// entries the table may hold, 0 for no limit, and the symbol lru or fifo
+// for how it evicts them. returns the memoized procedure
+Item *primitiveMemoize(int argc, Item **argv) {
+    if (!isProcedure(argv[0])) {
+        evaluationError("memoize expects a procedure");
+    }
+    Memo *memo = talloc(sizeof(Memo));
+    memo->count = 0;
+    memo->limit = 0;
+    memo->policy = LRU_EVICTION;
+    memo->newest = NULL;
+    memo->oldest = NULL;
+    memo->hits = 0;
+    memo->misses = 0;
+    if (argc > 1) {
+        if (argv[1]->type != INT_TYPE || argv[1]->i < 0) {
+            evaluationError("memoize expects a size of at least 0");
+        }
+        memo->limit = argv[1]->i;
+    }
+    if (argc > 2) {
+        if (argv[2]->type == SYMBOL_TYPE && strcmp(argv[2]->s, "fifo") == 0) {
+            memo->policy = FIFO_EVICTION;
+        } else if (argv[2]->type != SYMBOL_TYPE || strcmp(argv[2]->s, "lru") != 0) {
+            evaluationError("memoize expects lru or fifo as the eviction policy");
+        }
+    }
+    allocateBuckets(memo, INITIAL_MEMO_CAPACITY);
+    Item *memoized = talloc(sizeof(Item));
+    memoized->type = MEMOIZED_TYPE;
+    memoized->mo.function = argv[0];
+    memoized->mo.cache = memo;
+    return memoized;
+}
+
+// implements memo-stats. takes in a memoized procedure and returns the
+// list of its hits, misses and entries
+Item *primitiveMemoStats(Item *function) {
+    if (function->type != MEMOIZED_TYPE) {
+        evaluationError("memo-stats expects a memoized procedure");
+    }
+    Memo *memo = function->mo.cache;
+    return cons(makeFixnum(memo->hits),
+                cons(makeFixnum(memo->misses), cons(makeFixnum(memo->count), makeNull())));
+}
+
+// implements memo-clear!. takes in a memoized procedure, empties its table
+// and counters, and returns void
+Item *primitiveMemoClear(Item *function) {
+    if (function->type != MEMOIZED_TYPE) {
+        evaluationError("memo-clear! expects a memoized procedure");
+    }
+    Memo *memo = function->mo.cache;
+    allocateBuckets(memo, INITIAL_MEMO_CAPACITY);
+    memo->count = 0;
+    memo->newest = NULL;
+    memo->oldest = NULL;
+    memo->hits = 0;
+    memo->misses = 0;
+    return makeVoid();
+}
@@ -0,0 +1,34 @@
+#include "item.h"
+
+#ifndef MEMO_H
+#define MEMO_H
+
+// Memoized procedures. memoize wraps a procedure with a hash table of the
+// values it has returned, keyed by the arguments of each call, which
+// are compared and hashed as equal? and hash tables do: numbers, strings,
+// symbols and booleans by value, pairs, vectors and other containers by
+// their contents, and anything else by identity. A call whose arguments are in the table
+// returns the value kept for them without calling the procedure. The
+// table is unbounded unless given a size, in which case adding to a full
+// table evicts the least recently used entry (lru, the default) or the
+// oldest one (fifo). memo-stats returns a memoized procedure's hits,
+// misses and entries as a list, and memo-clear! empties its table and
+// counters. A pair passed as an argument is not copied, so mutating it
+// later changes the key it was stored under.
+Item *primitiveMemoize(int argc, Item **argv);
+Item *primitiveMemoStats(Item *function);
+Item *primitiveMemoClear(Item *function);
+
+// Looks up a call of a memoized procedure. Takes in the procedure and the
+// arguments as a count and a vector, and returns the value kept for them,
+// or NULL if there is none, in which case pending is set to an entry
+// holding a copy of the arguments, for memoStore to add to the table once
+// the value is known.
+Item *memoLookup(Item *function, int argc, Item **argv, Item **pending);
+void memoStore(Item *pending, Item *value);
+
+// Calls a memoized procedure, which apply hands them to. Takes in the
+// procedure and the arguments as a count and a vector.
+Item *callMemoized(Item *function, int argc, Item **argv);
+
+#endif
@@ -0,0 +1,884 @@
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include "numvec.h"
+#include "bignum.h"
+#include "interpreter.h"
+#include "linkedlist.h"
+#include "talloc.h"
+#include "vector.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+// how many partial results the f64vector reductions keep, one for each
+// element index modulo this
+#define LANES 16
+
+// A kind of numeric vector: its item type, the size of an element, its
+// name and how errors describe it, and the error for an element it cannot
+// hold.
+typedef struct {
+    itemType type;
+    size_t size;
+    const char *name;
+    const char *description;
+    const char *elementError;
+} VectorKind;
+
+static VectorKind bytevectorKind = {BYTEVECTOR_TYPE, sizeof(unsigned char), "bytevector", "a bytevector",
+                             "bytevector elements must be integers from 0 to 255"};
+static VectorKind s64vectorKind = {S64VECTOR_TYPE, sizeof(long), "s64vector", "an s64vector",
+                            "s64vector elements must be integers that fit in 64 bits"};
+static VectorKind f64vectorKind = {F64VECTOR_TYPE, sizeof(double), "f64vector", "an f64vector",
+                            "f64vector elements must be numbers"};
+
+// reports an error about a numeric vector procedure. takes in a format
+// that uses, in order, as many as it needs of the kind's name, the rest of
+// the procedure's name and the kind's description, and does not return
+static void numericError(const char *format, VectorKind *kind, const char *suffix) {
+    int size = snprintf(NULL, 0, format, kind->name, suffix, kind->description) + 1;
+    char *message = talloc(size);
+    snprintf(message, size, format, kind->name, suffix, kind->description);
+    evaluationError(message);
+}
+
+// checks that a value is a numeric vector of a kind. takes in the value,
+// the kind and the rest of the name of the procedure that expects it
+static void checkKind(Item *value, VectorKind *kind, const char *suffix) {
+    if (value->type != kind->type) {
+        numericError("%s%s expects %s", kind, suffix);
+    }
+}
+
+// makes a double item. takes in its value
+static Item *makeFlonum(double value) {
+    Item *result = talloc(sizeof(Item));
+    result->type = DOUBLE_TYPE;
+    result->d = value;
+    return result;
+}
+
+// makes a numeric vector whose elements are left for the caller to fill
+// in. takes in the kind and the length. a length whose size in bytes does
+// not fit in a long, or that there is not the memory for, is an error
+static Item *makeNumericVector(VectorKind *kind, long length) {
+    if (length > LONG_MAX / (long)kind->size) {
+        numericError("%s is too long", kind, "");
+    }
+    Item *vector = talloc(sizeof(Item));
+    vector->type = kind->type;
+    vector->nv.length = length;
+    vector->nv.data = talloc(kind->size * (length > 0 ? length : 1));
+    if (vector->nv.data == NULL) {
+        numericError("not enough memory for the %s", kind, "");
+    }
+    return vector;
+}
+
+// stores values in a range of a numeric vector's elements, converting the
+// value once. takes in the kind, the vector, the range and the value, and
+// does not return anything
+static void storeElements(VectorKind *kind, Item *vector, long start, long end, Item *value) {
+    if (kind->type == F64VECTOR_TYPE) {
+        double element = numberValue(value, kind->elementError);
+        double *data = vector->nv.data;
+        for (long i = start; i < end; i++) {
+            data[i] = element;
+        }
+        return;
+    }
+    if (value->type != INT_TYPE || (kind->type == BYTEVECTOR_TYPE && (value->i < 0 || value->i > 255))) {
+        evaluationError(kind->elementError);
+    }
+    if (kind->type == BYTEVECTOR_TYPE) {
+        memset((unsigned char *)vector->nv.data + start, (int)value->i, end - start);
+        return;
+    }
+    long *data = vector->nv.data;
+    for (long i = start; i < end; i++) {
+        data[i] = value->i;
+    }
+}
+
+// boxes an element of a numeric vector. takes in the vector and the index
+// and returns the element as an item
+static Item *loadElement(Item *vector, long index) {
+    switch (vector->type) {
+        case BYTEVECTOR_TYPE:
+            return makeFixnum(((unsigned char *)vector->nv.data)[index]);
+        case S64VECTOR_TYPE:
+            return makeFixnum(((long *)vector->nv.data)[index]);
+        default:
+            return makeFlonum(((double *)vector->nv.data)[index]);
+    }
+}
+
+// implements make- of a kind. takes in the kind, the length and
+// optionally the value of every element, 0 if there is none
+static Item *numericMake(VectorKind *kind, int argc, Item **argv) {
+    if (argv[0]->type != INT_TYPE || argv[0]->i < 0) {
+        numericError("make-%s expects a length of at least 0", kind, "");
+    }
+    Item *vector = makeNumericVector(kind, argv[0]->i);
+    storeElements(kind, vector, 0, vector->nv.length, argc > 1 ? argv[1] : makeFixnum(0));
+    return vector;
+}
+
+// implements the constructor of a kind. takes in the kind and the
+// elements and returns a vector of them
+static Item *numericFromArguments(VectorKind *kind, int argc, Item **argv) {
+    Item *vector = makeNumericVector(kind, argc);
+    for (int i = 0; i < argc; i++) {
+        storeElements(kind, vector, i, i + 1, argv[i]);
+    }
+    return vector;
+}
+
+// implements the predicate of a kind. takes in the kind and a value
+static Item *numericIs(VectorKind *kind, Item *value) {
+    Item *result = talloc(sizeof(Item));
+    result->type = BOOL_TYPE;
+    result->i = value->type == kind->type;
+    return result;
+}
+
+// implements -length. takes in the kind and a vector
+static Item *numericLength(VectorKind *kind, Item *vector) {
+    checkKind(vector, kind, "-length");
+    return makeFixnum(vector->nv.length);
+}
+
+// implements -ref. takes in the kind, the rest of the procedure's name, a
+// vector and an index, and returns the element at the index
+static Item *numericRef(VectorKind *kind, const char *suffix, Item *vector, Item *index) {
+    checkKind(vector, kind, suffix);
+    return loadElement(vector, checkIndex(index, vector->nv.length, 0));
+}
+
+// implements -set!. takes in the kind, the rest of the procedure's name,
+// and a vector, an index and a value, and returns void
+static Item *numericSet(VectorKind *kind, const char *suffix, Item **argv) {
+    checkKind(argv[0], kind, suffix);
+    long index = checkIndex(argv[1], argv[0]->nv.length, 0);
+    storeElements(kind, argv[0], index, index + 1, argv[2]);
+    return makeVoid();
+}
+
+// implements -copy. takes in the kind, and a vector and optionally a
+// range, and returns a new vector of the elements in the range
+static Item *numericCopy(VectorKind *kind, int argc, Item **argv) {
+    checkKind(argv[0], kind, "-copy");
+    long start, end;
+    checkRange(argc, argv, 1, argv[0]->nv.length, &start, &end);
+    Item *copy = makeNumericVector(kind, end - start);
+    memcpy(copy->nv.data, (char *)argv[0]->nv.data + start * kind->size, (end - start) * kind->size);
+    return copy;
+}
+
+// implements -fill!. takes in the kind, and a vector, a value and
+// optionally a range, and returns void
+static Item *numericFill(VectorKind *kind, int argc, Item **argv) {
+    checkKind(argv[0], kind, "-fill!");
+    long start, end;
+    checkRange(argc, argv, 2, argv[0]->nv.length, &start, &end);
+    storeElements(kind, argv[0], start, end, argv[1]);
+    return makeVoid();
+}
+
+// implements ->list. takes in the kind and a vector and returns a list of
+// its elements
+static Item *numericToList(VectorKind *kind, Item *vector) {
+    checkKind(vector, kind, "->list");
+    Item *list = makeNull();
+    for (long i = vector->nv.length - 1; i >= 0; i--) {
+        list = cons(loadElement(vector, i), list);
+    }
+    return list;
+}
+
+// implements list->. takes in the kind and a list and returns a vector of
+// its elements
+static Item *numericFromList(VectorKind *kind, Item *list) {
+    long length = 0;
+    Item *rest = list;
+    for (; rest->type == CONS_TYPE; rest = cdr(rest)) {
+        length++;
+    }
+    if (rest->type != NULL_TYPE) {
+        numericError("list->%s expects a list", kind, "");
+    }
+    Item *vector = makeNumericVector(kind, length);
+    for (long i = 0; i < length; i++) {
+        storeElements(kind, vector, i, i + 1, car(list));
+        list = cdr(list);
+    }
+    return vector;
+}
+
+// checks the two vectors of an elementwise operation. takes in the kind,
+// the rest of the procedure's name and the vectors
+static void checkSameLength(VectorKind *kind, const char *suffix, Item *a, Item *b) {
+    checkKind(a, kind, suffix);
+    checkKind(b, kind, suffix);
+    if (a->nv.length != b->nv.length) {
+        numericError("%s%s expects vectors of the same length", kind, suffix);
+    }
+}
+
+// The f64vector kernels for one instruction set. The reductions take a
+// number of blocks of LANES elements, and partial results for each lane
+// to carry on from, which they update; min and max combine them as the
+// SSE2 minpd and maxpd instructions do, so a lane's result does not
+// depend on the instruction set. The elementwise operations write their
+// results to out.
+typedef struct {
+    void (*sum)(const double *x, long blocks, double *lanes);
+    void (*dot)(const double *x, const double *y, long blocks, double *lanes);
+    void (*min)(const double *x, long blocks, double *lanes);
+    void (*max)(const double *x, long blocks, double *lanes);
+    void (*add)(const double *x, const double *y, double *out, long length);
+    void (*mul)(const double *x, const double *y, double *out, long length);
+    void (*scale)(const double *x, double factor, double *out, long length);
+} F64Kernels;
+
+static double minDouble(double a, double b) {
+    return a < b ? a : b;
+}
+
+static double maxDouble(double a, double b) {
+    return a > b ? a : b;
+}
+
+static void sumScalar(const double *x, long blocks, double *lanes) {
+    for (long b = 0; b < blocks; b++, x += LANES) {
+        for (int j = 0; j < LANES; j++) {
+            lanes[j] += x[j];
+        }
+    }
+}
+
+static void dotScalar(const double *x, const double *y, long blocks, double *lanes) {
+    for (long b = 0; b < blocks; b++, x += LANES, y += LANES) {
+        for (int j = 0; j < LANES; j++) {
+            lanes[j] += x[j] * y[j];
+        }
+    }
+}
+
+static void minScalar(const double *x, long blocks, double *lanes) {
+    for (long b = 0; b < blocks; b++, x += LANES) {
+        for (int j = 0; j < LANES; j++) {
+            lanes[j] = minDouble(lanes[j], x[j]);
+        }
+    }
+}
+
+static void maxScalar(const double *x, long blocks, double *lanes) {
+    for (long b = 0; b < blocks; b++, x += LANES) {
+        for (int j = 0; j < LANES; j++) {
+            lanes[j] = maxDouble(lanes[j], x[j]);
+        }
+    }
+}
+
+static void addScalar(const double *x, const double *y, double *out, long length) {
+    for (long i = 0; i < length; i++) {
+        out[i] = x[i] + y[i];
+    }
+}
+
+static void mulScalar(const double *x, const double *y, double *out, long length) {
+    for (long i = 0; i < length; i++) {
+        out[i] = x[i] * y[i];
+    }
+}
+
+static void scaleScalar(const double *x, double factor, double *out, long length) {
+    for (long i = 0; i < length; i++) {
+        out[i] = x[i] * factor;
+    }
+}
+
+// only picked off x86-64, but compiled everywhere so the scalar kernels
+// stay checked
+__attribute__((unused))
+static F64Kernels scalarKernels = {sumScalar, dotScalar, minScalar, maxScalar, addScalar, mulScalar, scaleScalar};
+
+#if defined(__x86_64__)
+
+// SSE2 is part of x86-64, so these need no check. Each reduction keeps the
+// sixteen lanes in eight registers of two.
+static void sumSse2(const double *x, long blocks, double *lanes) {
+    __m128d a0 = _mm_loadu_pd(lanes), a1 = _mm_loadu_pd(lanes + 2);
+    __m128d a2 = _mm_loadu_pd(lanes + 4), a3 = _mm_loadu_pd(lanes + 6);
+    __m128d a4 = _mm_loadu_pd(lanes + 8), a5 = _mm_loadu_pd(lanes + 10);
+    __m128d a6 = _mm_loadu_pd(lanes + 12), a7 = _mm_loadu_pd(lanes + 14);
+    for (long b = 0; b < blocks; b++, x += LANES) {
+        a0 = _mm_add_pd(a0, _mm_loadu_pd(x));
+        a1 = _mm_add_pd(a1, _mm_loadu_pd(x + 2));
+        a2 = _mm_add_pd(a2, _mm_loadu_pd(x + 4));
+        a3 = _mm_add_pd(a3, _mm_loadu_pd(x + 6));
+        a4 = _mm_add_pd(a4, _mm_loadu_pd(x + 8));
+        a5 = _mm_add_pd(a5, _mm_loadu_pd(x + 10));
+        a6 = _mm_add_pd(a6, _mm_loadu_pd(x + 12));
+        a7 = _mm_add_pd(a7, _mm_loadu_pd(x + 14));
+    }
+    _mm_storeu_pd(lanes, a0);
+    _mm_storeu_pd(lanes + 2, a1);
+    _mm_storeu_pd(lanes + 4, a2);
+    _mm_storeu_pd(lanes + 6, a3);
+    _mm_storeu_pd(lanes + 8, a4);
+    _mm_storeu_pd(lanes + 10, a5);
+    _mm_storeu_pd(lanes + 12, a6);
+    _mm_storeu_pd(lanes + 14, a7);
+}
+
+static void dotSse2(const double *x, const double *y, long blocks, double *lanes) {
+    __m128d a0 = _mm_loadu_pd(lanes), a1 = _mm_loadu_pd(lanes + 2);
+    __m128d a2 = _mm_loadu_pd(lanes + 4), a3 = _mm_loadu_pd(lanes + 6);
+    __m128d a4 = _mm_loadu_pd(lanes + 8), a5 = _mm_loadu_pd(lanes + 10);
+    __m128d a6 = _mm_loadu_pd(lanes + 12), a7 = _mm_loadu_pd(lanes + 14);
+    for (long b = 0; b < blocks; b++, x += LANES, y += LANES) {
+        a0 = _mm_add_pd(a0, _mm_mul_pd(_mm_loadu_pd(x), _mm_loadu_pd(y)));
+        a1 = _mm_add_pd(a1, _mm_mul_pd(_mm_loadu_pd(x + 2), _mm_loadu_pd(y + 2)));
+        a2 = _mm_add_pd(a2, _mm_mul_pd(_mm_loadu_pd(x + 4), _mm_loadu_pd(y + 4)));
+        a3 = _mm_add_pd(a3, _mm_mul_pd(_mm_loadu_pd(x + 6), _mm_loadu_pd(y + 6)));
+        a4 = _mm_add_pd(a4, _mm_mul_pd(_mm_loadu_pd(x + 8), _mm_loadu_pd(y + 8)));
+        a5 = _mm_add_pd(a5, _mm_mul_pd(_mm_loadu_pd(x + 10), _mm_loadu_pd(y + 10)));
+        a6 = _mm_add_pd(a6, _mm_mul_pd(_mm_loadu_pd(x + 12), _mm_loadu_pd(y + 12)));
+        a7 = _mm_add_pd(a7, _mm_mul_pd(_mm_loadu_pd(x + 14), _mm_loadu_pd(y + 14)));
+    }
+    _mm_storeu_pd(lanes, a0);
+    _mm_storeu_pd(lanes + 2, a1);
+    _mm_storeu_pd(lanes + 4, a2);
+    _mm_storeu_pd(lanes + 6, a3);
+    _mm_storeu_pd(lanes + 8, a4);
+    _mm_storeu_pd(lanes + 10, a5);
+    _mm_storeu_pd(lanes + 12, a6);
+    _mm_storeu_pd(lanes + 14, a7);
+}
+
+static void minSse2(const double *x, long blocks, double *lanes) {
+    __m128d a0 = _mm_loadu_pd(lanes), a1 = _mm_loadu_pd(lanes + 2);
+    __m128d a2 = _mm_loadu_pd(lanes + 4), a3 = _mm_loadu_pd(lanes + 6);
+    __m128d a4 = _mm_loadu_pd(lanes + 8), a5 = _mm_loadu_pd(lanes + 10);
+    __m128d a6 = _mm_loadu_pd(lanes + 12), a7 = _mm_loadu_pd(lanes + 14);
+    for (long b = 0; b < blocks; b++, x += LANES) {
+        a0 = _mm_min_pd(a0, _mm_loadu_pd(x));
+        a1 = _mm_min_pd(a1, _mm_loadu_pd(x + 2));
+        a2 = _mm_min_pd(a2, _mm_loadu_pd(x + 4));
+        a3 = _mm_min_pd(a3, _mm_loadu_pd(x + 6));
+        a4 = _mm_min_pd(a4, _mm_loadu_pd(x + 8));
+        a5 = _mm_min_pd(a5, _mm_loadu_pd(x + 10));
+        a6 = _mm_min_pd(a6, _mm_loadu_pd(x + 12));
+        a7 = _mm_min_pd(a7, _mm_loadu_pd(x + 14));
+    }
+    _mm_storeu_pd(lanes, a0);
+    _mm_storeu_pd(lanes + 2, a1);
+    _mm_storeu_pd(lanes + 4, a2);
+    _mm_storeu_pd(lanes + 6, a3);
+    _mm_storeu_pd(lanes + 8, a4);
+    _mm_storeu_pd(lanes + 10, a5);
+    _mm_storeu_pd(lanes + 12, a6);
+    _mm_storeu_pd(lanes + 14, a7);
+}
+
+static void maxSse2(const double *x, long blocks, double *lanes) {
+    __m128d a0 = _mm_loadu_pd(lanes), a1 = _mm_loadu_pd(lanes + 2);
+    __m128d a2 = _mm_loadu_pd(lanes + 4), a3 = _mm_loadu_pd(lanes + 6);
+    __m128d a4 = _mm_loadu_pd(lanes + 8), a5 = _mm_loadu_pd(lanes + 10);
+    __m128d a6 = _mm_loadu_pd(lanes + 12), a7 = _mm_loadu_pd(lanes + 14);
+    for (long b = 0; b < blocks; b++, x += LANES) {
+        a0 = _mm_max_pd(a0, _mm_loadu_pd(x));
+        a1 = _mm_max_pd(a1, _mm_loadu_pd(x + 2));
+        a2 = _mm_max_pd(a2, _mm_loadu_pd(x + 4));
+        a3 = _mm_max_pd(a3, _mm_loadu_pd(x + 6));
+        a4 = _mm_max_pd(a4, _mm_loadu_pd(x + 8));
+        a5 = _mm_max_pd(a5, _mm_loadu_pd(x + 10));
+        a6 = _mm_max_pd(a6, _mm_loadu_pd(x + 12));
+        a7 = _mm_max_pd(a7, _mm_loadu_pd(x + 14));
+    }
+    _mm_storeu_pd(lanes, a0);
+    _mm_storeu_pd(lanes + 2, a1);
+    _mm_storeu_pd(lanes + 4, a2);
+    _mm_storeu_pd(lanes + 6, a3);
+    _mm_storeu_pd(lanes + 8, a4);
+    _mm_storeu_pd(lanes + 10, a5);
+    _mm_storeu_pd(lanes + 12, a6);
+    _mm_storeu_pd(lanes + 14, a7);
+}
+
+static void addSse2(const double *x, const double *y, double *out, long length) {
+    long i = 0;
+    for (; i + 2 <= length; i += 2) {
+        _mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+    }
+    addScalar(x + i, y + i, out + i, length - i);
+}
+
+static void mulSse2(const double *x, const double *y, double *out, long length) {
+    long i = 0;
+    for (; i + 2 <= length; i += 2) {
+        _mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+    }
+    mulScalar(x + i, y + i, out + i, length - i);
+}
+
+static void scaleSse2(const double *x, double factor, double *out, long length) {
+    __m128d k = _mm_set1_pd(factor);
+    long i = 0;
+    for (; i + 2 <= length; i += 2) {
+        _mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(x + i), k));
+    }
+    scaleScalar(x + i, factor, out + i, length - i);
+}
+
+static F64Kernels sse2Kernels = {sumSse2, dotSse2, minSse2, maxSse2, addSse2, mulSse2, scaleSse2};
+
+// The AVX2 kernels are compiled for AVX2 whatever the rest of the file is
+// compiled for, and only run once the CPU is known to have it. Each
+// reduction keeps the sixteen lanes in four registers of four.
+__attribute__((target("avx2")))
+static void sumAvx2(const double *x, long blocks, double *lanes) {
+    __m256d a0 = _mm256_loadu_pd(lanes), a1 = _mm256_loadu_pd(lanes + 4);
+    __m256d a2 = _mm256_loadu_pd(lanes + 8), a3 = _mm256_loadu_pd(lanes + 12);
+    for (long b = 0; b < blocks; b++, x += LANES) {
+        a0 = _mm256_add_pd(a0, _mm256_loadu_pd(x));
+        a1 = _mm256_add_pd(a1, _mm256_loadu_pd(x + 4));
+        a2 = _mm256_add_pd(a2, _mm256_loadu_pd(x + 8));
+        a3 = _mm256_add_pd(a3, _mm256_loadu_pd(x + 12));
+    }
+    _mm256_storeu_pd(lanes, a0);
+    _mm256_storeu_pd(lanes + 4, a1);
+    _mm256_storeu_pd(lanes + 8, a2);
+    _mm256_storeu_pd(lanes + 12, a3);
+}
+
+__attribute__((target("avx2")))
+static void dotAvx2(const double *x, const double *y, long blocks, double *lanes) {
+    __m256d a0 = _mm256_loadu_pd(lanes), a1 = _mm256_loadu_pd(lanes + 4);
+    __m256d a2 = _mm256_loadu_pd(lanes + 8), a3 = _mm256_loadu_pd(lanes + 12);
+    for (long b = 0; b < blocks; b++, x += LANES, y += LANES) {
+        a0 = _mm256_add_pd(a0, _mm256_mul_pd(_mm256_loadu_pd(x), _mm256_loadu_pd(y)));
+        a1 = _mm256_add_pd(a1, _mm256_mul_pd(_mm256_loadu_pd(x + 4), _mm256_loadu_pd(y + 4)));
+        a2 = _mm256_add_pd(a2, _mm256_mul_pd(_mm256_loadu_pd(x + 8), _mm256_loadu_pd(y + 8)));
+        a3 = _mm256_add_pd(a3, _mm256_mul_pd(_mm256_loadu_pd(x + 12), _mm256_loadu_pd(y + 12)));
+    }
+    _mm256_storeu_pd(lanes, a0);
+    _mm256_storeu_pd(lanes + 4, a1);
+    _mm256_storeu_pd(lanes + 8, a2);
+    _mm256_storeu_pd(lanes + 12, a3);
+}
+
+__attribute__((target("avx2")))
+static void minAvx2(const double *x, long blocks, double *lanes) {
+    __m256d a0 = _mm256_loadu_pd(lanes), a1 = _mm256_loadu_pd(lanes + 4);
+    __m256d a2 = _mm256_loadu_pd(lanes + 8), a3 = _mm256_loadu_pd(lanes + 12);
+    for (long b = 0; b < blocks; b++, x += LANES) {
+        a0 = _mm256_min_pd(a0, _mm256_loadu_pd(x));
+        a1 = _mm256_min_pd(a1, _mm256_loadu_pd(x + 4));
+        a2 = _mm256_min_pd(a2, _mm256_loadu_pd(x + 8));
+        a3 = _mm256_min_pd(a3, _mm256_loadu_pd(x + 12));
+    }
+    _mm256_storeu_pd(lanes, a0);
+    _mm256_storeu_pd(lanes + 4, a1);
+    _mm256_storeu_pd(lanes + 8, a2);
+    _mm256_storeu_pd(lanes + 12, a3);
+}
+
+__attribute__((target("avx2")))
+static void maxAvx2(const double *x, long blocks, double *lanes) {
+    __m256d a0 = _mm256_loadu_pd(lanes), a1 = _mm256_loadu_pd(lanes + 4);
+    __m256d a2 = _mm256_loadu_pd(lanes + 8), a3 = _mm256_loadu_pd(lanes + 12);
+    for (long b = 0; b < blocks; b++, x += LANES) {
+        a0 = _mm256_max_pd(a0, _mm256_loadu_pd(x));
+        a1 = _mm256_max_pd(a1, _mm256_loadu_pd(x + 4));
+        a2 = _mm256_max_pd(a2, _mm256_loadu_pd(x + 8));
+        a3 = _mm256_max_pd(a3, _mm256_loadu_pd(x + 12));
+    }
+    _mm256_storeu_pd(lanes, a0);
+    _mm256_storeu_pd(lanes + 4, a1);
+    _mm256_storeu_pd(lanes + 8, a2);
+    _mm256_storeu_pd(lanes + 12, a3);
+}
+
+__attribute__((target("avx2")))
+static void addAvx2(const double *x, const double *y, double *out, long length) {
+    long i = 0;
+    for (; i + 4 <= length; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+    }
+    addScalar(x + i, y + i, out + i, length - i);
+}
+
+__attribute__((target("avx2")))
+static void mulAvx2(const double *x, const double *y, double *out, long length) {
+    long i = 0;
+    for (; i + 4 <= length; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+    }
+    mulScalar(x + i, y + i, out + i, length - i);
+}
+
+__attribute__((target("avx2")))
+static void scaleAvx2(const double *x, double factor, double *out, long length) {
+    __m256d k = _mm256_set1_pd(factor);
+    long i = 0;
+    for (; i + 4 <= length; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(x + i), k));
+    }
+    scaleScalar(x + i, factor, out + i, length - i);
+}
+
+static F64Kernels avx2Kernels = {sumAvx2, dotAvx2, minAvx2, maxAvx2, addAvx2, mulAvx2, scaleAvx2};
+
+#endif
+
+// the kernels in use, picked the first time one is needed
+static F64Kernels *activeKernels = NULL;
+
+// find the kernels for the best instruction set the CPU has. takes no
+// arguments and returns the kernels
+static F64Kernels *f64Kernels() {
+    if (activeKernels == NULL) {
+#if defined(__x86_64__)
+        activeKernels = __builtin_cpu_supports("avx2") ? &avx2Kernels : &sse2Kernels;
+#else
+        activeKernels = &scalarKernels;
+#endif
+    }
+    return activeKernels;
+}
+
+// combine the lanes of a reduction, in the same order whatever kernel
+// filled them. takes in the lanes and how to combine two partial results,
+// and returns the result
+static double combineLanes(double *lanes, double (*combine)(double, double)) {
+    for (int width = LANES / 2; width > 0; width /= 2) {
+        for (int j = 0; j < width; j++) {
+            lanes[j] = combine(lanes[j], lanes[j + width]);
+        }
+    }
+    return lanes[0];
+}
+
+static double addDoubles(double a, double b) {
+    return a + b;
+}
+
+// implements s64vector-add and s64vector-mul. takes in the vectors, the
+// rest of the procedure's name and whether to multiply, and returns the
+// vector of results
+static Item *s64Elementwise(Item *a, Item *b, const char *suffix, int multiply) {
+    checkSameLength(&s64vectorKind, suffix, a, b);
+    Item *result = makeNumericVector(&s64vectorKind, a->nv.length);
+    long *x = a->nv.data, *y = b->nv.data, *out = result->nv.data;
+    for (long i = 0; i < a->nv.length; i++) {
+        int overflow = multiply ? __builtin_mul_overflow(x[i], y[i], &out[i])
+                                : __builtin_add_overflow(x[i], y[i], &out[i]);
+        if (overflow) {
+            numericError("%s%s result does not fit in an s64vector", &s64vectorKind, suffix);
+        }
+    }
+    return result;
+}
+
+Item *primitiveS64vectorAdd(Item *a, Item *b) {
+    return s64Elementwise(a, b, "-add", 0);
+}
+
+Item *primitiveS64vectorMul(Item *a, Item *b) {
+    return s64Elementwise(a, b, "-mul", 1);
+}
+
+Item *primitiveS64vectorScale(Item *vector, Item *factor) {
+    checkKind(vector, &s64vectorKind, "-scale");
+    if (factor->type != INT_TYPE) {
+        numericError("%s%s expects an integer that fits in 64 bits as the factor", &s64vectorKind, "-scale");
+    }
+    Item *result = makeNumericVector(&s64vectorKind, vector->nv.length);
+    long *x = vector->nv.data, *out = result->nv.data;
+    for (long i = 0; i < vector->nv.length; i++) {
+        if (__builtin_mul_overflow(x[i], factor->i, &out[i])) {
+            numericError("%s%s result does not fit in an s64vector", &s64vectorKind, "-scale");
+        }
+    }
+    return result;
+}
+
+// implements s64vector-dot and s64vector-sum: adds up the elements of a
+// vector, or the products of two vectors' elements, in a long until that
+// overflows and exactly from there on. takes in the vectors, the second
+// NULL for a sum, and returns the result
+static Item *s64Total(Item *a, Item *b) {
+    long *x = a->nv.data, *y = b != NULL ? b->nv.data : NULL;
+    long total = 0;
+    long i = 0;
+    for (; i < a->nv.length; i++) {
+        long term = x[i];
+        long next;
+        if ((y != NULL && __builtin_mul_overflow(x[i], y[i], &term)) ||
+            __builtin_add_overflow(total, term, &next)) {
+            break;
+        }
+        total = next;
+    }
+    Item *exact = makeFixnum(total);
+    for (; i < a->nv.length; i++) {
+        Item *term = makeFixnum(x[i]);
+        if (y != NULL) {
+            term = integerMultiply(term, makeFixnum(y[i]));
+        }
+        exact = integerAdd(exact, term);
+    }
+    return exact;
+}
+
+Item *primitiveS64vectorDot(Item *a, Item *b) {
+    checkSameLength(&s64vectorKind, "-dot", a, b);
+    return s64Total(a, b);
+}
+
+Item *primitiveS64vectorSum(Item *vector) {
+    checkKind(vector, &s64vectorKind, "-sum");
+    return s64Total(vector, NULL);
+}
+
+// implements s64vector-min and s64vector-max. takes in the vector, the
+// rest of the procedure's name and whether to find the largest element
+static Item *s64Extreme(Item *vector, const char *suffix, int largest) {
+    checkKind(vector, &s64vectorKind, suffix);
+    if (vector->nv.length == 0) {
+        numericError("%s%s expects a non-empty vector", &s64vectorKind, suffix);
+    }
+    long *x = vector->nv.data;
+    long extreme = x[0];
+    for (long i = 1; i < vector->nv.length; i++) {
+        if (largest ? x[i] > extreme : x[i] < extreme) {
+            extreme = x[i];
+        }
+    }
+    return makeFixnum(extreme);
+}
+
+Item *primitiveS64vectorMin(Item *vector) {
+    return s64Extreme(vector, "-min", 0);
+}
+
+Item *primitiveS64vectorMax(Item *vector) {
+    return s64Extreme(vector, "-max", 1);
+}
+
+Item *primitiveF64vectorAdd(Item *a, Item *b) {
+    checkSameLength(&f64vectorKind, "-add", a, b);
+    Item *result = makeNumericVector(&f64vectorKind, a->nv.length);
+    f64Kernels()->add(a->nv.data, b->nv.data, result->nv.data, a->nv.length);
+    return result;
+}
+
+Item *primitiveF64vectorMul(Item *a, Item *b) {
+    checkSameLength(&f64vectorKind, "-mul", a, b);
+    Item *result = makeNumericVector(&f64vectorKind, a->nv.length);
+    f64Kernels()->mul(a->nv.data, b->nv.data, result->nv.data, a->nv.length);
+    return result;
+}
+
+Item *primitiveF64vectorScale(Item *vector, Item *factor) {
+    checkKind(vector, &f64vectorKind, "-scale");
+    double k = numberValue(factor, "f64vector-scale expects a number as the factor");
+    Item *result = makeNumericVector(&f64vectorKind, vector->nv.length);
+    f64Kernels()->scale(vector->nv.data, k, result->nv.data, vector->nv.length);
+    return result;
+}
+
+Item *primitiveF64vectorDot(Item *a, Item *b) {
+    checkSameLength(&f64vectorKind, "-dot", a, b);
+    const double *x = a->nv.data, *y = b->nv.data;
+    long blocks = a->nv.length / LANES;
+    double lanes[LANES] = {0.0};
+    f64Kernels()->dot(x, y, blocks, lanes);
+    double total = combineLanes(lanes, addDoubles);
+    for (long i = blocks * LANES; i < a->nv.length; i++) {
+        total += x[i] * y[i];
+    }
+    return makeFlonum(total);
+}
+
+Item *primitiveF64vectorSum(Item *vector) {
+    checkKind(vector, &f64vectorKind, "-sum");
+    const double *x = vector->nv.data;
+    long blocks = vector->nv.length / LANES;
+    double lanes[LANES] = {0.0};
+    f64Kernels()->sum(x, blocks, lanes);
+    double total = combineLanes(lanes, addDoubles);
+    for (long i = blocks * LANES; i < vector->nv.length; i++) {
+        total += x[i];
+    }
+    return makeFlonum(total);
+}
+
+// implements f64vector-min and f64vector-max. every lane starts from the
+// first element. takes in the vector, the rest of the procedure's name and
+// whether to find the largest element
+static Item *f64Extreme(Item *vector, const char *suffix, int largest) {
+    checkKind(vector, &f64vectorKind, suffix);
+    if (vector->nv.length == 0) {
+        numericError("%s%s expects a non-empty vector", &f64vectorKind, suffix);
+    }
+    const double *x = vector->nv.data;
+    long blocks = vector->nv.length / LANES;
+    double lanes[LANES];
+    for (int j = 0; j < LANES; j++) {
+        lanes[j] = x[0];
+    }
+    double (*combine)(double, double) = largest ? maxDouble : minDouble;
+    if (largest) {
+        f64Kernels()->max(x, blocks, lanes);
+    } else {
+        f64Kernels()->min(x, blocks, lanes);
+    }
+    double extreme = combineLanes(lanes, combine);
+    for (long i = blocks * LANES; i < vector->nv.length; i++) {
+        extreme = combine(extreme, x[i]);
+    }
+    return makeFlonum(extreme);
+}
+
+Item *primitiveF64vectorMin(Item *vector) {
+    return f64Extreme(vector, "-min", 0);
+}
+
+Item *primitiveF64vectorMax(Item *vector) {
+    return f64Extreme(vector, "-max", 1);
+}
+
+// the procedures of each kind, which hand their kind to the ones above
+
+Item *primitiveMakeBytevector(int argc, Item **argv) {
+    return numericMake(&bytevectorKind, argc, argv);
+}
+
+Item *primitiveBytevector(int argc, Item **argv) {
+    return numericFromArguments(&bytevectorKind, argc, argv);
+}
+
+Item *primitiveIsBytevector(Item *value) {
+    return numericIs(&bytevectorKind, value);
+}
+
+Item *primitiveBytevectorLength(Item *vector) {
+    return numericLength(&bytevectorKind, vector);
+}
+
+Item *primitiveBytevectorRef(Item *vector, Item *index) {
+    return numericRef(&bytevectorKind, "-u8-ref", vector, index);
+}
+
+Item *primitiveBytevectorSet(int argc, Item **argv) {
+    return numericSet(&bytevectorKind, "-u8-set!", argv);
+}
+
+Item *primitiveBytevectorCopy(int argc, Item **argv) {
+    return numericCopy(&bytevectorKind, argc, argv);
+}
+
+Item *primitiveBytevectorFill(int argc, Item **argv) {
+    return numericFill(&bytevectorKind, argc, argv);
+}
+
+Item *primitiveMakeS64vector(int argc, Item **argv) {
+    return numericMake(&s64vectorKind, argc, argv);
+}
+
+Item *primitiveS64vector(int argc, Item **argv) {
+    return numericFromArguments(&s64vectorKind, argc, argv);
+}
+
+Item *primitiveIsS64vector(Item *value) {
+    return numericIs(&s64vectorKind, value);
+}
+
+Item *primitiveS64vectorLength(Item *vector) {
+    return numericLength(&s64vectorKind, vector);
+}
+
+Item *primitiveS64vectorRef(Item *vector, Item *index) {
+    return numericRef(&s64vectorKind, "-ref", vector, index);
+}
+
+Item *primitiveS64vectorSet(int argc, Item **argv) {
+    return numericSet(&s64vectorKind, "-set!", argv);
+}
+
+Item *primitiveS64vectorCopy(int argc, Item **argv) {
+    return numericCopy(&s64vectorKind, argc, argv);
+}
+
+Item *primitiveS64vectorFill(int argc, Item **argv) {
+    return numericFill(&s64vectorKind, argc, argv);
+}
+
+Item *primitiveS64vectorToList(Item *vector) {
+    return numericToList(&s64vectorKind, vector);
+}
+
+Item *primitiveListToS64vector(Item *list) {
+    return numericFromList(&s64vectorKind, list);
+}
+
+Item *primitiveMakeF64vector(int argc, Item **argv) {
+    return numericMake(&f64vectorKind, argc, argv);
+}
+
+Item *primitiveF64vector(int argc, Item **argv) {
+    return numericFromArguments(&f64vectorKind, argc, argv);
+}
+
+Item *primitiveIsF64vector(Item *value) {
+    return numericIs(&f64vectorKind, value);
+}
+
+Item *primitiveF64vectorLength(Item *vector) {
+    return numericLength(&f64vectorKind, vector);
+}
+
+Item *primitiveF64vectorRef(Item *vector, Item *index) {
+    return numericRef(&f64vectorKind, "-ref", vector, index);
+}
+
+Item *primitiveF64vectorSet(int argc, Item **argv) {
+    return numericSet(&f64vectorKind, "-set!", argv);
+}
+
+Item *primitiveF64vectorCopy(int argc, Item **argv) {
+    return numericCopy(&f64vectorKind, argc, argv);
+}
+
+Item *primitiveF64vectorFill(int argc, Item **argv) {
+    return numericFill(&f64vectorKind, argc, argv);
+}
+
+Item *primitiveF64vectorToList(Item *vector) {
+    return numericToList(&f64vectorKind, vector);
+}
+
+Item *primitiveListToF64vector(Item *list) {
+    return numericFromList(&f64vectorKind, list);
+}
+
+// prints a numeric vector. takes in the vector and does not return
+// anything
+void printNumericVector(Item *vector) {
+    const char *prefix = vector->type == BYTEVECTOR_TYPE ? "#u8(" :
+                         vector->type == S64VECTOR_TYPE ? "#s64(" : "#f64(";
+    printf("%s", prefix);
+    for (long i = 0; i < vector->nv.length; i++) {
+        if (i > 0) {
+            printf(" ");
+        }
+        printItem(loadElement(vector, i));
+    }
+    printf(")");
+}
@@ -0,0 +1,74 @@
+#include "item.h"
+
+#ifndef NUMVEC_H
+#define NUMVEC_H
+
+// Homogeneous numeric vectors, after SRFI 4: bytevectors of integers from
+// 0 to 255, s64vectors of integers that fit in a fixnum and f64vectors of
+// doubles, all stored unboxed and side by side. Each kind has a
+// constructor taking its elements, make-, a predicate, -length, -ref,
+// -set!, -copy and -fill!, and s64vectors and f64vectors also convert to
+// and from lists. An f64vector accepts any number as an element and keeps
+// it as a double.
+Item *primitiveMakeBytevector(int argc, Item **argv);
+Item *primitiveBytevector(int argc, Item **argv);
+Item *primitiveIsBytevector(Item *value);
+Item *primitiveBytevectorLength(Item *vector);
+Item *primitiveBytevectorRef(Item *vector, Item *index);
+Item *primitiveBytevectorSet(int argc, Item **argv);
+Item *primitiveBytevectorCopy(int argc, Item **argv);
+Item *primitiveBytevectorFill(int argc, Item **argv);
+
+Item *primitiveMakeS64vector(int argc, Item **argv);
+Item *primitiveS64vector(int argc, Item **argv);
+Item *primitiveIsS64vector(Item *value);
+Item *primitiveS64vectorLength(Item *vector);
+Item *primitiveS64vectorRef(Item *vector, Item *index);
+Item *primitiveS64vectorSet(int argc, Item **argv);
+Item *primitiveS64vectorCopy(int argc, Item **argv);
+Item *primitiveS64vectorFill(int argc, Item **argv);
+Item *primitiveS64vectorToList(Item *vector);
+Item *primitiveListToS64vector(Item *list);
+
+Item *primitiveMakeF64vector(int argc, Item **argv);
+Item *primitiveF64vector(int argc, Item **argv);
+Item *primitiveIsF64vector(Item *value);
+Item *primitiveF64vectorLength(Item *vector);
+Item *primitiveF64vectorRef(Item *vector, Item *index);
+Item *primitiveF64vectorSet(int argc, Item **argv);
+Item *primitiveF64vectorCopy(int argc, Item **argv);
+Item *primitiveF64vectorFill(int argc, Item **argv);
+Item *primitiveF64vectorToList(Item *vector);
+Item *primitiveListToF64vector(Item *list);
+
+// Bulk operations on whole vectors. -add and -mul combine two vectors of
+// the same length element by element and -scale multiplies each element
+// by a number, each returning a new vector; -dot, -sum, -min and -max
+// reduce vectors to a number, -min and -max only non-empty ones. The
+// f64vector operations run as SSE2 or AVX2 kernels, picked by what the CPU
+// supports when the first one runs, with a scalar version elsewhere. The
+// kernels add up sums in sixteen lanes, whichever instruction set they
+// use, so they give the same results on every CPU, but not always the
+// same as adding left to right. The s64vector operations are exact: sums
+// and dot products that overflow carry on as bignums, and an element
+// of -add, -mul or -scale that does not fit is an error.
+Item *primitiveS64vectorAdd(Item *a, Item *b);
+Item *primitiveS64vectorMul(Item *a, Item *b);
+Item *primitiveS64vectorScale(Item *vector, Item *factor);
+Item *primitiveS64vectorDot(Item *a, Item *b);
+Item *primitiveS64vectorSum(Item *vector);
+Item *primitiveS64vectorMin(Item *vector);
+Item *primitiveS64vectorMax(Item *vector);
+
+Item *primitiveF64vectorAdd(Item *a, Item *b);
+Item *primitiveF64vectorMul(Item *a, Item *b);
+Item *primitiveF64vectorScale(Item *vector, Item *factor);
+Item *primitiveF64vectorDot(Item *a, Item *b);
+Item *primitiveF64vectorSum(Item *vector);
+Item *primitiveF64vectorMin(Item *vector);
+Item *primitiveF64vectorMax(Item *vector);
+
+// Prints a numeric vector as #u8(...), #s64(...) or #f64(...).
+void printNumericVector(Item *vector);
+
+#endif
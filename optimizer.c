@@ -0,0 +1,844 @@
+#include <stdio.h>
+#include <string.h>
+#include "optimizer.h"
+#include "interpreter.h"
+#include "linkedlist.h"
+#include "symtab.h"
+#include "talloc.h"
+
+// how many define and set! forms assign each name anywhere in the program.
+// a name assigned more than once can refer to different values over time,
+// so neither its calls nor its references are replaced by values
+SymbolTable *assignedNames = NULL;
+
+// the functions whose calls are inlined, by name. each is the lambda
+// expression a top-level define binds the name to, for a name nothing
+// else assigns or binds
+SymbolTable *inlinableFunctions = NULL;
+
+// the names of the functions being inlined, innermost first, so that
+// functions calling each other are not inlined into each other forever
+Item *inlining = NULL;
+
+// the most pairs a function's body may have for its calls to be inlined
+#define INLINE_SIZE_LIMIT 24
+
+// the variables of the named let loops being optimized. an iteration
+// reuses their bindings, so no lambda may refer to one, and inlining a
+// function must not substitute one for a parameter the body captures
+Item *loopVariables = NULL;
+
+// how many parameters have been renamed for inlining, to give each a new
+// name
+int renamedCount = 0;
+
+// the primitives whose calls are folded. they only ever fail on arguments
+// that are not numbers or on division by zero, which folding checks for
+const char *foldablePrimitives[] = {"+", "-", "*", "/", "modulo", "<", ">", "="};
+
+// the special forms, whose keywords are never replaced by a value
+const char *keywords[] = {
+    "define", "let", "let*", "letrec", "set!", "set-car!", "set-cdr!", "lambda",
+    "cond", "if", "quote", "and", "or", "else", "delay", "delay-force"
+};
+
+Item *optimizeExpression(Item *expr, Item *scope);
+
+// checks whether an expression is a special form. takes in the expression
+// and the name of the form and returns true if it is one
+int isSpecialForm(Item *expr, const char *name) {
+    return expr->type == CONS_TYPE && car(expr)->type == SYMBOL_TYPE &&
+           strcmp(car(expr)->s, name) == 0;
+}
+
+// checks whether an item is a proper list
+int isProperList(Item *item) {
+    while (item->type == CONS_TYPE) {
+        item = cdr(item);
+    }
+    return item->type == NULL_TYPE;
+}
+
+// checks whether an expression is a literal that evaluates to itself
+int isLiteral(Item *expr) {
+    return expr->type == INT_TYPE || expr->type == BIGNUM_TYPE || expr->type == DOUBLE_TYPE ||
+           expr->type == STR_TYPE || expr->type == BOOL_TYPE;
+}
+
+int isNumber(Item *expr) {
+    return expr->type == INT_TYPE || expr->type == BIGNUM_TYPE || expr->type == DOUBLE_TYPE;
+}
+
+// makes a symbol with nothing cached on it. takes in its name
+Item *makeSymbol(const char *name) {
+    Item *item = talloc(sizeof(Item));
+    item->type = SYMBOL_TYPE;
+    item->s = intern(name);
+    item->sc.cell = NULL;
+    item->sc.epoch = 0;
+    return item;
+}
+
+// makes a boolean literal. takes in its value
+Item *makeBoolean(int value) {
+    Item *item = talloc(sizeof(Item));
+    item->type = BOOL_TYPE;
+    item->i = value;
+    return item;
+}
+
+// count the define and set! forms that assign each name in an expression.
+// takes in the expression and the table of counts so far, and does not
+// return anything. quoted data is skipped
+void scanAssignments(Item *expr, SymbolTable *counts) {
+    if (expr->type != CONS_TYPE || isSpecialForm(expr, "quote")) {
+        return;
+    }
+    if ((isSpecialForm(expr, "define") || isSpecialForm(expr, "set!")) &&
+        cdr(expr)->type == CONS_TYPE && car(cdr(expr))->type == SYMBOL_TYPE) {
+        Item *cell = tableLookup(counts, car(cdr(expr))->s);
+        if (cell == NULL) {
+            Item *count = talloc(sizeof(Item));
+            count->type = INT_TYPE;
+            count->i = 1;
+            tableDefine(counts, car(cdr(expr))->s, count);
+        } else {
+            cell->c.cdr->i++;
+        }
+    }
+    for (; expr->type == CONS_TYPE; expr = cdr(expr)) {
+        scanAssignments(car(expr), counts);
+    }
+}
+
+// checks whether a name is bound in a scope. takes in the name and the
+// list of symbols the enclosing forms bind
+int isBoundIn(char *name, Item *scope) {
+    for (; !isNull(scope); scope = cdr(scope)) {
+        if (car(scope)->s == name) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// add the parameters of a lambda expression to a scope, its rest
+// parameter included. takes in the parameters and the scope and returns
+// the new scope
+Item *bindParameters(Item *params, Item *scope) {
+    for (; params->type == CONS_TYPE; params = cdr(params)) {
+        if (car(params)->type == SYMBOL_TYPE) {
+            scope = cons(car(params), scope);
+        }
+    }
+    if (params->type == SYMBOL_TYPE) {
+        scope = cons(params, scope);
+    }
+    return scope;
+}
+
+// checks whether a symbol is the keyword of a special form
+int isKeyword(Item *symbol) {
+    for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+        if (strcmp(symbol->s, keywords[i]) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// add the names a body defines to a scope. a define binds in the frame of
+// the body it runs in however deeply it is nested in other forms, so every
+// define in the body is counted, even those that inner lambdas make.
+// takes in the body and the scope and returns the new scope
+Item *bindDefinitions(Item *body, Item *scope) {
+    for (; body->type == CONS_TYPE; body = cdr(body)) {
+        Item *expr = car(body);
+        if (expr->type != CONS_TYPE || isSpecialForm(expr, "quote")) {
+            continue;
+        }
+        if (isSpecialForm(expr, "define") && cdr(expr)->type == CONS_TYPE &&
+            car(cdr(expr))->type == SYMBOL_TYPE) {
+            scope = cons(car(cdr(expr)), scope);
+        }
+        scope = bindDefinitions(expr, scope);
+    }
+    return scope;
+}
+
+// checks whether a let or let* variable bound to a literal can have its
+// references replaced by the literal: nothing assigns the name and it is
+// not a keyword
+int isSubstitutable(Item *symbol) {
+    return !isKeyword(symbol) && tableLookup(assignedNames, symbol->s) == NULL;
+}
+
+// checks a let, let* or letrec binding list as the tree walker does. takes
+// in the list and whether a name may be bound twice
+int isWellFormedBindingList(Item *bindings, int allowDuplicates) {
+    if (!isProperList(bindings)) {
+        return 0;
+    }
+    for (Item *b = bindings; !isNull(b); b = cdr(b)) {
+        Item *binding = car(b);
+        if (binding->type != CONS_TYPE || !isProperList(binding) || length(binding) != 2 ||
+            car(binding)->type != SYMBOL_TYPE) {
+            return 0;
+        }
+        for (Item *other = bindings; !allowDuplicates && other != b; other = cdr(other)) {
+            if (car(car(other))->s == car(binding)->s) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+// checks whether an expression is a named let with a well-formed binding
+// list and a body
+int isNamedLet(Item *expr) {
+    return isSpecialForm(expr, "let") && isProperList(cdr(expr)) && length(cdr(expr)) >= 3 &&
+           car(cdr(expr))->type == SYMBOL_TYPE && isWellFormedBindingList(car(cdr(cdr(expr))), 1);
+}
+
+// remove a variable from a list of (symbol . literal) pairs, where a form
+// binds it again. takes in the list and the symbol and returns the list
+// without it
+Item *withoutVariable(Item *literals, Item *symbol) {
+    if (isNull(literals)) {
+        return literals;
+    }
+    Item *rest = withoutVariable(cdr(literals), symbol);
+    if (car(car(literals))->s == symbol->s) {
+        return rest;
+    }
+    return rest == cdr(literals) ? literals : cons(car(literals), rest);
+}
+
+Item *substituteList(Item *exprs, Item *literals);
+
+// replace variables by the literals they are bound to, leaving alone the
+// places where an inner form binds the same name. takes in an expression
+// and a list of (symbol . literal) pairs, and returns the new expression,
+// sharing whatever did not change, or NULL if a binding form in it is
+// malformed and so its scope is unknown
+Item *substitute(Item *expr, Item *literals) {
+    if (expr->type == SYMBOL_TYPE) {
+        for (Item *l = literals; !isNull(l); l = cdr(l)) {
+            if (car(car(l))->s == expr->s) {
+                return cdr(car(l));
+            }
+        }
+        return expr;
+    }
+    if (expr->type != CONS_TYPE || isSpecialForm(expr, "quote") || isNull(literals)) {
+        return expr;
+    }
+    Item *args = cdr(expr);
+    if (isSpecialForm(expr, "lambda")) {
+        if (args->type != CONS_TYPE) {
+            return NULL;
+        }
+        Item *inner = literals;
+        for (Item *params = bindParameters(car(args), makeNull()); !isNull(params); params = cdr(params)) {
+            inner = withoutVariable(inner, car(params));
+        }
+        Item *body = substituteList(cdr(args), inner);
+        return body == NULL ? NULL : cons(car(expr), cons(car(args), body));
+    }
+    if (isNamedLet(expr)) {
+        // the initial values are outside the scope of the name and the
+        // variables, and the body inside it
+        Item *inner = withoutVariable(literals, car(args));
+        Item *bindings = makeNull();
+        for (Item *b = car(cdr(args)); !isNull(b); b = cdr(b)) {
+            Item *init = substitute(car(cdr(car(b))), literals);
+            if (init == NULL) {
+                return NULL;
+            }
+            bindings = cons(cons(car(car(b)), cons(init, makeNull())), bindings);
+            inner = withoutVariable(inner, car(car(b)));
+        }
+        Item *body = substituteList(cdr(cdr(args)), inner);
+        return body == NULL ? NULL : cons(car(expr), cons(car(args), cons(reverse(bindings), body)));
+    }
+    int isLet = isSpecialForm(expr, "let");
+    int isLetStar = isSpecialForm(expr, "let*");
+    if (isLet || isLetStar || isSpecialForm(expr, "letrec")) {
+        if (args->type != CONS_TYPE || !isWellFormedBindingList(car(args), 1)) {
+            return NULL;
+        }
+        Item *inner = literals;
+        if (!isLetStar) {
+            for (Item *b = car(args); !isNull(b); b = cdr(b)) {
+                inner = withoutVariable(inner, car(car(b)));
+            }
+        }
+        Item *bindings = makeNull();
+        for (Item *b = car(args); !isNull(b); b = cdr(b)) {
+            Item *init = substitute(car(cdr(car(b))), isLet ? literals : inner);
+            if (init == NULL) {
+                return NULL;
+            }
+            bindings = cons(cons(car(car(b)), cons(init, makeNull())), bindings);
+            if (isLetStar) {
+                inner = withoutVariable(inner, car(car(b)));
+            }
+        }
+        Item *body = substituteList(cdr(args), inner);
+        return body == NULL ? NULL : cons(car(expr), cons(reverse(bindings), body));
+    }
+    return substituteList(expr, literals);
+}
+
+// substitute literals into each expression of a list. takes in the list
+// and the (symbol . literal) pairs and returns the new list, or NULL if
+// substitute fails on one of the expressions
+Item *substituteList(Item *exprs, Item *literals) {
+    if (exprs->type != CONS_TYPE) {
+        return exprs;
+    }
+    Item *first = substitute(car(exprs), literals);
+    Item *rest = substituteList(cdr(exprs), literals);
+    if (first == NULL || rest == NULL) {
+        return NULL;
+    }
+    if (first == car(exprs) && rest == cdr(exprs)) {
+        return exprs;
+    }
+    return cons(first, rest);
+}
+
+// optimize each expression of a proper list. takes in the list and the
+// names the enclosing forms bind, and returns a new list of the optimized
+// expressions
+Item *optimizeList(Item *exprs, Item *scope) {
+    if (exprs->type != CONS_TYPE) {
+        return exprs;
+    }
+    Item *first = optimizeExpression(car(exprs), scope);
+    return cons(first, optimizeList(cdr(exprs), scope));
+}
+
+// optimize the inits and body of a let, let* or letrec expression whose
+// binding list is well-formed, without removing any binding. takes in the
+// expression, the scope around it and whether each init sees the
+// variables bound before it, and returns the rebuilt expression
+Item *optimizeBindings(Item *expr, Item *scope, int sequential) {
+    Item *args = cdr(expr);
+    Item *inner = scope;
+    int isLetrec = isSpecialForm(expr, "letrec");
+    if (isLetrec) {
+        for (Item *b = car(args); !isNull(b); b = cdr(b)) {
+            inner = cons(car(car(b)), inner);
+        }
+    }
+    Item *bindings = makeNull();
+    for (Item *b = car(args); !isNull(b); b = cdr(b)) {
+        Item *init = optimizeExpression(car(cdr(car(b))), sequential || isLetrec ? inner : scope);
+        bindings = cons(cons(car(car(b)), cons(init, makeNull())), bindings);
+        if (!isLetrec) {
+            inner = cons(car(car(b)), inner);
+        }
+    }
+    return cons(car(expr), cons(reverse(bindings), optimizeList(cdr(args), bindDefinitions(cdr(args), inner))));
+}
+
+// optimize a let or let* expression. its variables that are bound to
+// literals are substituted into the rest of the form and dropped, and a
+// form left binding nothing around a single expression becomes that
+// expression, as does (let ((x e)) x). takes in the expression, the scope
+// around it and whether it is a let*
+Item *optimizeLet(Item *expr, Item *scope, int sequential) {
+    Item *keyword = car(expr);
+    Item *args = cdr(expr);
+    if (!isProperList(args) || length(args) < 2) {
+        return cons(keyword, optimizeList(args, scope));
+    }
+    if (!isWellFormedBindingList(car(args), sequential)) {
+        return expr;
+    }
+    Item *literals = makeNull();
+    Item *kept = makeNull();
+    Item *inner = scope;
+    for (Item *b = car(args); !isNull(b); b = cdr(b)) {
+        Item *name = car(car(b));
+        Item *init = car(cdr(car(b)));
+        if (sequential) {
+            init = substitute(init, literals);
+            if (init == NULL) {
+                return optimizeBindings(expr, scope, sequential);
+            }
+        }
+        init = optimizeExpression(init, sequential ? inner : scope);
+        literals = withoutVariable(literals, name);
+        if (isLiteral(init) && isSubstitutable(name)) {
+            literals = cons(cons(name, init), literals);
+        } else {
+            kept = cons(cons(name, cons(init, makeNull())), kept);
+        }
+        inner = cons(name, inner);
+    }
+    Item *body = substituteList(cdr(args), literals);
+    if (body == NULL) {
+        return optimizeBindings(expr, scope, sequential);
+    }
+    Item *bindings = reverse(kept);
+    body = optimizeList(body, bindDefinitions(body, inner));
+    if (length(bindings) == 1 && isNull(cdr(body)) && car(body)->type == SYMBOL_TYPE &&
+        car(body)->s == car(car(bindings))->s) {
+        return car(cdr(car(bindings)));
+    }
+    // a define in the body binds in the form's own frame, which it needs
+    if (isNull(bindings) && isNull(cdr(body)) && !isSpecialForm(car(body), "define")) {
+        return car(body);
+    }
+    return cons(keyword, cons(bindings, body));
+}
+
+// optimize a named let, keeping all of its variables: a literal bound to
+// one is only its first value. takes in the expression and the scope
+// around it
+Item *optimizeNamedLet(Item *expr, Item *scope) {
+    Item *args = cdr(expr);
+    Item *inner = cons(car(args), scope);
+    Item *bindings = makeNull();
+    Item *savedLoopVariables = loopVariables;
+    for (Item *b = car(cdr(args)); !isNull(b); b = cdr(b)) {
+        Item *init = optimizeExpression(car(cdr(car(b))), scope);
+        bindings = cons(cons(car(car(b)), cons(init, makeNull())), bindings);
+        inner = cons(car(car(b)), inner);
+        loopVariables = cons(car(car(b)), loopVariables);
+    }
+    Item *body = optimizeList(cdr(cdr(args)), bindDefinitions(cdr(cdr(args)), inner));
+    loopVariables = savedLoopVariables;
+    return cons(car(expr), cons(car(args), cons(reverse(bindings), body)));
+}
+
+// optimize an if expression. a literal boolean test selects its branch
+Item *optimizeIf(Item *expr, Item *scope) {
+    Item *args = cdr(expr);
+    if (!isProperList(args) || length(args) != 3) {
+        return cons(car(expr), optimizeList(args, scope));
+    }
+    Item *test = optimizeExpression(car(args), scope);
+    if (test->type == BOOL_TYPE) {
+        Item *branch = test->i ? car(cdr(args)) : car(cdr(cdr(args)));
+        // a define in a branch is left where it is, as a body would treat
+        // it differently
+        if (!isSpecialForm(branch, "define")) {
+            return optimizeExpression(branch, scope);
+        }
+    }
+    return cons(car(expr), cons(test, optimizeList(cdr(args), scope)));
+}
+
+// optimize a cond expression. a clause whose test is a literal is dropped
+// unless the test is #t, in which case it becomes the else clause. a cond
+// left with just an else clause around one expression becomes that
+// expression
+Item *optimizeCond(Item *expr, Item *scope) {
+    Item *clauses = cdr(expr);
+    if (!isProperList(clauses)) {
+        return expr;
+    }
+    for (Item *c = clauses; !isNull(c); c = cdr(c)) {
+        if (car(c)->type != CONS_TYPE || !isProperList(car(c))) {
+            return cons(car(expr), optimizeList(clauses, scope));
+        }
+    }
+    Item *kept = makeNull();
+    for (; !isNull(clauses); clauses = cdr(clauses)) {
+        Item *clause = car(clauses);
+        Item *test = car(clause);
+        if (test->type == SYMBOL_TYPE && strcmp(test->s, "else") == 0) {
+            kept = cons(cons(test, optimizeList(cdr(clause), scope)), kept);
+            break;
+        }
+        test = optimizeExpression(test, scope);
+        if (!isLiteral(test)) {
+            kept = cons(cons(test, optimizeList(cdr(clause), scope)), kept);
+        } else if (test->type == BOOL_TYPE && test->i) {
+            // a clause with no body has its test as its value
+            Item *body = isNull(cdr(clause)) ? cons(test, makeNull()) : optimizeList(cdr(clause), scope);
+            kept = cons(cons(makeSymbol("else"), body), kept);
+            break;
+        }
+    }
+    kept = reverse(kept);
+    if (!isNull(kept) && isNull(cdr(kept))) {
+        Item *clause = car(kept);
+        if (car(clause)->type == SYMBOL_TYPE && strcmp(car(clause)->s, "else") == 0 &&
+            !isNull(cdr(clause)) && isNull(cdr(cdr(clause))) &&
+            !isSpecialForm(car(cdr(clause)), "define")) {
+            return car(cdr(clause));
+        }
+    }
+    return cons(car(expr), kept);
+}
+
+// optimize an and or an or expression. literal arguments that cannot
+// decide it are dropped, and one that does decides it. as the last
+// argument is not checked to be a boolean, an expression left with one
+// argument becomes that argument. takes in the expression, the scope
+// around it and whether it is an and
+Item *optimizeAndOr(Item *expr, Item *scope, int isAnd) {
+    Item *args = cdr(expr);
+    if (!isProperList(args)) {
+        return expr;
+    }
+    if (isNull(args)) {
+        return makeBoolean(isAnd);
+    }
+    args = optimizeList(args, scope);
+    while (car(args)->type == BOOL_TYPE && car(args)->i == isAnd && !isNull(cdr(args))) {
+        args = cdr(args);
+    }
+    if (car(args)->type == BOOL_TYPE && car(args)->i != isAnd) {
+        return car(args);
+    }
+    if (isNull(cdr(args)) && !isSpecialForm(car(args), "define")) {
+        return car(args);
+    }
+    return cons(car(expr), args);
+}
+
+// fold a call of an arithmetic or comparison primitive on literal numbers.
+// takes in the optimized call and the scope around it, and returns the
+// call's value, or the call if it cannot be folded
+Item *foldCall(Item *call, Item *scope) {
+    Item *function = car(call);
+    if (function->type != SYMBOL_TYPE || isBoundIn(function->s, scope) ||
+        tableLookup(assignedNames, function->s) != NULL) {
+        return call;
+    }
+    int foldable = 0;
+    for (size_t i = 0; i < sizeof(foldablePrimitives) / sizeof(foldablePrimitives[0]); i++) {
+        foldable |= strcmp(function->s, foldablePrimitives[i]) == 0;
+    }
+    Primitive *primitive = foldable ? findPrimitive(function->s) : NULL;
+    if (primitive == NULL) {
+        return call;
+    }
+    int argc = length(cdr(call));
+    if (argc < primitive->minArgs || (primitive->maxArgs >= 0 && argc > primitive->maxArgs)) {
+        return call;
+    }
+    Item **argv = talloc(sizeof(Item *) * (argc + 1));
+    int i = 0;
+    for (Item *args = cdr(call); !isNull(args); args = cdr(args)) {
+        if (!isNumber(car(args))) {
+            return call;
+        }
+        argv[i++] = car(args);
+    }
+    if (strcmp(function->s, "/") == 0 || strcmp(function->s, "modulo") == 0) {
+        Item *divisor = argv[1];
+        if ((divisor->type == INT_TYPE && divisor->i == 0) ||
+            (divisor->type == DOUBLE_TYPE && divisor->d == 0)) {
+            return call;
+        }
+        if (strcmp(function->s, "modulo") == 0 &&
+            (argv[0]->type == DOUBLE_TYPE || divisor->type == DOUBLE_TYPE)) {
+            return call;
+        }
+    }
+    return callPrimitive(primitive, argc, argv);
+}
+
+// checks whether an expression binds a name anywhere in it, as a
+// parameter, a let, let* or letrec variable, a named let's name or
+// variable, or by a define
+int bindsName(Item *expr, char *name) {
+    if (expr->type != CONS_TYPE || isSpecialForm(expr, "quote")) {
+        return 0;
+    }
+    Item *args = cdr(expr);
+    if (isSpecialForm(expr, "let") && args->type == CONS_TYPE && car(args)->type == SYMBOL_TYPE) {
+        if (car(args)->s == name) {
+            return 1;
+        }
+        args = cdr(args);
+    }
+    if (isSpecialForm(expr, "lambda") && args->type == CONS_TYPE &&
+        isBoundIn(name, bindParameters(car(args), makeNull()))) {
+        return 1;
+    }
+    if ((isSpecialForm(expr, "let") || isSpecialForm(expr, "let*") || isSpecialForm(expr, "letrec")) &&
+        args->type == CONS_TYPE) {
+        for (Item *b = car(args); b->type == CONS_TYPE; b = cdr(b)) {
+            if (car(b)->type == CONS_TYPE && car(car(b))->type == SYMBOL_TYPE && car(car(b))->s == name) {
+                return 1;
+            }
+        }
+    }
+    if (isSpecialForm(expr, "define") && args->type == CONS_TYPE && car(args)->type == SYMBOL_TYPE &&
+        car(args)->s == name) {
+        return 1;
+    }
+    for (; expr->type == CONS_TYPE; expr = cdr(expr)) {
+        if (bindsName(car(expr), name)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int isFreeInList(Item *exprs, char *name);
+
+// checks whether an expression refers to a variable it does not bind
+// itself. takes in the expression and the variable's name. a define in a
+// body is not taken into account, so this can report a reference that
+// is not free but never misses one that is
+int isFreeIn(Item *expr, char *name) {
+    if (expr->type == SYMBOL_TYPE) {
+        return expr->s == name;
+    }
+    if (expr->type != CONS_TYPE || isSpecialForm(expr, "quote")) {
+        return 0;
+    }
+    Item *args = cdr(expr);
+    if (isSpecialForm(expr, "lambda") && args->type == CONS_TYPE) {
+        return !isBoundIn(name, bindParameters(car(args), makeNull())) && isFreeInList(cdr(args), name);
+    }
+    if (isNamedLet(expr)) {
+        int bound = car(args)->s == name;
+        for (Item *b = car(cdr(args)); !isNull(b); b = cdr(b)) {
+            if (isFreeIn(car(cdr(car(b))), name)) {
+                return 1;
+            }
+            bound |= car(car(b))->s == name;
+        }
+        return !bound && isFreeInList(cdr(cdr(args)), name);
+    }
+    int isLet = isSpecialForm(expr, "let");
+    int isLetStar = isSpecialForm(expr, "let*");
+    int isLetrec = isSpecialForm(expr, "letrec");
+    if ((isLet || isLetStar || isLetrec) && args->type == CONS_TYPE &&
+        isWellFormedBindingList(car(args), 1)) {
+        int bound = 0;
+        for (Item *b = car(args); !isNull(b); b = cdr(b)) {
+            bound |= isLetrec && car(car(b))->s == name;
+        }
+        for (Item *b = car(args); !isNull(b); b = cdr(b)) {
+            if (!bound && isFreeIn(car(cdr(car(b))), name)) {
+                return 1;
+            }
+            bound |= isLetStar && car(car(b))->s == name;
+        }
+        for (Item *b = car(args); !isNull(b); b = cdr(b)) {
+            bound |= isLet && car(car(b))->s == name;
+        }
+        return !bound && isFreeInList(cdr(args), name);
+    }
+    return isFreeInList(expr, name);
+}
+
+// checks whether any expression of a list refers to a variable it does
+// not bind
+int isFreeInList(Item *exprs, char *name) {
+    for (; exprs->type == CONS_TYPE; exprs = cdr(exprs)) {
+        if (isFreeIn(car(exprs), name)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// counts the pairs in an expression, as a measure of its size
+int countPairs(Item *expr) {
+    if (expr->type != CONS_TYPE) {
+        return 0;
+    }
+    return 1 + countPairs(car(expr)) + countPairs(cdr(expr));
+}
+
+// copy the pairs and symbols of an expression, so that nothing the
+// evaluators cache on an inlined body is shared with another copy of it.
+// quoted data and other literals are shared instead, since a program can
+// tell a copy of one from the original with eq? or by mutating it
+Item *copyExpression(Item *expr) {
+    if (expr->type == SYMBOL_TYPE) {
+        return makeSymbol(expr->s);
+    }
+    if (expr->type != CONS_TYPE || isSpecialForm(expr, "quote")) {
+        return expr;
+    }
+    Item *first = copyExpression(car(expr));
+    return cons(first, copyExpression(cdr(expr)));
+}
+
+// remember a top-level definition whose calls can be inlined: it binds a
+// name nothing else assigns to a lambda expression with a fixed number of
+// parameters and a small body of one expression that does not refer to
+// the name. takes in the optimized top-level form
+void recordInlinable(Item *form) {
+    if (!isSpecialForm(form, "define") || !isProperList(form) || length(form) != 3) {
+        return;
+    }
+    Item *name = car(cdr(form));
+    Item *lambda = car(cdr(cdr(form)));
+    if (name->type != SYMBOL_TYPE || tableLookup(assignedNames, name->s)->c.cdr->i != 1 ||
+        !isSpecialForm(lambda, "lambda") || !isProperList(lambda) || length(lambda) != 3) {
+        return;
+    }
+    Item *params = car(cdr(lambda));
+    if (!isProperList(params)) {
+        return;
+    }
+    for (Item *p = params; !isNull(p); p = cdr(p)) {
+        if (car(p)->type != SYMBOL_TYPE || isKeyword(car(p)) || isBoundIn(car(p)->s, cdr(p))) {
+            return;
+        }
+    }
+    Item *body = car(cdr(cdr(lambda)));
+    if (isSpecialForm(body, "define") || countPairs(body) > INLINE_SIZE_LIMIT ||
+        isFreeIn(lambda, name->s)) {
+        return;
+    }
+    tableDefine(inlinableFunctions, name->s, lambda);
+}
+
+// make a new name for a parameter of an inlined function. the name has a
+// character symbols cannot be written with, so no variable of the
+// program can capture or be captured by it, and it counts as assigned if
+// the parameter's name does. takes in the parameter
+Item *renameParameter(Item *param) {
+    char *name = talloc(strlen(param->s) + 16);
+    sprintf(name, "%s#%d", param->s, ++renamedCount);
+    Item *renamed = makeSymbol(name);
+    Item *assigned = tableLookup(assignedNames, param->s);
+    if (assigned != NULL) {
+        tableDefine(assignedNames, renamed->s, assigned->c.cdr);
+    }
+    return renamed;
+}
+
+// inline a call of a small function defined at the top level. arguments
+// that are literals, or local variables nothing assigns or rebinds in the
+// body, are substituted for their parameters if nothing assigns those
+// either. the other parameters are
+// renamed and bound to their arguments by a let around the body, so the
+// arguments are still evaluated once and in order. takes in the
+// optimized call and the scope around it, and returns the optimized body,
+// or the call if it cannot be inlined
+Item *inlineCall(Item *call, Item *scope) {
+    Item *function = car(call);
+    if (function->type != SYMBOL_TYPE || isBoundIn(function->s, scope) ||
+        isBoundIn(function->s, inlining)) {
+        return call;
+    }
+    Item *cell = tableLookup(inlinableFunctions, function->s);
+    if (cell == NULL || length(car(cdr(cell->c.cdr))) != length(cdr(call))) {
+        return call;
+    }
+    Item *lambda = cell->c.cdr;
+    Item *body = car(cdr(cdr(lambda)));
+    // the function's free variables are globals, which must not be
+    // shadowed where it is inlined
+    for (Item *s = scope; !isNull(s); s = cdr(s)) {
+        if (isFreeIn(lambda, car(s)->s)) {
+            return call;
+        }
+    }
+    Item *substituted = makeNull();
+    Item *bindings = makeNull();
+    Item *args = cdr(call);
+    for (Item *p = car(cdr(lambda)); !isNull(p); p = cdr(p), args = cdr(args)) {
+        Item *arg = car(args);
+        if (tableLookup(assignedNames, car(p)->s) == NULL &&
+            (isLiteral(arg) ||
+             (arg->type == SYMBOL_TYPE && isBoundIn(arg->s, scope) && !isBoundIn(arg->s, loopVariables) &&
+              tableLookup(assignedNames, arg->s) == NULL && !bindsName(body, arg->s)))) {
+            substituted = cons(cons(car(p), arg), substituted);
+        } else {
+            Item *renamed = renameParameter(car(p));
+            substituted = cons(cons(car(p), renamed), substituted);
+            bindings = cons(cons(renamed, cons(arg, makeNull())), bindings);
+        }
+    }
+    Item *inlined = substitute(copyExpression(body), substituted);
+    if (inlined == NULL) {
+        return call;
+    }
+    if (!isNull(bindings)) {
+        inlined = cons(makeSymbol("let"), cons(reverse(bindings), cons(inlined, makeNull())));
+    }
+    inlining = cons(function, inlining);
+    inlined = optimizeExpression(inlined, scope);
+    inlining = cdr(inlining);
+    return inlined;
+}
+
+// optimize an expression. takes in the expression and the list of names
+// the forms around it bind, and returns the simplified expression, which
+// shares whatever was not simplified
+Item *optimizeExpression(Item *expr, Item *scope) {
+    if (expr->type != CONS_TYPE) {
+        return expr;
+    }
+    Item *args = cdr(expr);
+    if (isSpecialForm(expr, "quote")) {
+        return expr;
+    } else if (isSpecialForm(expr, "lambda") || isSpecialForm(expr, "define") ||
+               isSpecialForm(expr, "set!")) {
+        // the parameters or the variable stay as they are
+        if (args->type != CONS_TYPE || !isProperList(args)) {
+            return expr;
+        }
+        Item *inner = scope;
+        if (isSpecialForm(expr, "lambda")) {
+            inner = bindDefinitions(cdr(args), bindParameters(car(args), scope));
+        }
+        return cons(car(expr), cons(car(args), optimizeList(cdr(args), inner)));
+    } else if (isNamedLet(expr)) {
+        return optimizeNamedLet(expr, scope);
+    } else if (isSpecialForm(expr, "let")) {
+        return optimizeLet(expr, scope, 0);
+    } else if (isSpecialForm(expr, "let*")) {
+        return optimizeLet(expr, scope, 1);
+    } else if (isSpecialForm(expr, "letrec")) {
+        if (args->type != CONS_TYPE || !isWellFormedBindingList(car(args), 1)) {
+            return expr;
+        }
+        return optimizeBindings(expr, scope, 0);
+    } else if (isSpecialForm(expr, "if")) {
+        return optimizeIf(expr, scope);
+    } else if (isSpecialForm(expr, "cond")) {
+        return optimizeCond(expr, scope);
+    } else if (isSpecialForm(expr, "and")) {
+        return optimizeAndOr(expr, scope, 1);
+    } else if (isSpecialForm(expr, "or")) {
+        return optimizeAndOr(expr, scope, 0);
+    }
+    if (!isProperList(expr)) {
+        return expr;
+    }
+    Item *call = optimizeList(expr, scope);
+    Item *inlined = inlineCall(call, scope);
+    if (inlined != call) {
+        return inlined;
+    }
+    return foldCall(call, scope);
+}
+
+// simplify the forms of a program. takes in the list of forms and returns
+// the list of simplified forms
+Item *optimize(Item *tree) {
+    assignedNames = createSymbolTable();
+    inlinableFunctions = createSymbolTable();
+    inlining = makeNull();
+    loopVariables = makeNull();
+    for (Item *forms = tree; forms->type == CONS_TYPE; forms = cdr(forms)) {
+        scanAssignments(car(forms), assignedNames);
+    }
+    // a function is only inlined into the forms after its definition,
+    // which run once it is bound
+    Item *forms = makeNull();
+    for (; tree->type == CONS_TYPE; tree = cdr(tree)) {
+        Item *form = optimizeExpression(car(tree), makeNull());
+        recordInlinable(form);
+        forms = cons(form, forms);
+    }
+    return reverse(forms);
+}
@@ -0,0 +1,27 @@
+#include "item.h"
+#include "symtab.h"
+
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+// Simplifies a program's parse tree before it is evaluated. Calls of the
+// arithmetic and comparison primitives on literal numbers are folded where
+// the primitive's name is neither rebound nor assigned, if and cond
+// branches that a literal test rules out are dropped, and let and let*
+// forms are flattened once the literals they bind have been substituted
+// into their bodies. Calls of small non-recursive functions that a
+// top-level define binds, and nothing else assigns, are replaced by the
+// function's body in the forms after the definition. Only well-formed
+// forms are changed, and only in ways that evaluate to the same values and
+// report the same errors. Takes in the list of top-level forms and returns
+// the simplified list.
+Item *optimize(Item *tree);
+
+// Helpers shared with type inference, which also walks parse trees.
+int isSpecialForm(Item *expr, const char *name);
+int isProperList(Item *item);
+int isWellFormedBindingList(Item *bindings, int allowDuplicates);
+int isNamedLet(Item *expr);
+void scanAssignments(Item *expr, SymbolTable *counts);
+
+#endif
@@ -5,6 +5,8 @@
 #include "parser.h"
 #include "linkedlist.h"
 #include "item.h"
+#include "bignum.h"
+#include "vector.h"
 
 /* "pops" an item from a given stack, which means it returns
    the item at the very top of the stack (or more accurately
@@ -72,13 +74,18 @@ void printToBuffer(Item *tree, char *buf, int *pos) {
                 sprintf(buf + *pos, "%s", tree->s);
                 *pos += strlen(tree->s);
                 break;
+            case CALL_SITE_TYPE:
+                printToBuffer(tree->cs.symbol, buf, pos);
+                break;
             case STR_TYPE:
                 sprintf(buf + *pos, "\"%s\"", tree->s);
                 *pos += strlen(tree->s) + 2;
                 break;
             case INT_TYPE:
-                sprintf(buf + *pos, "%d", tree->i);
-                *pos += snprintf(NULL, 0, "%d", tree->i);
+                *pos += sprintf(buf + *pos, "%ld", tree->i);
+                break;
+            case BIGNUM_TYPE:
+                *pos += sprintf(buf + *pos, "%s", integerToString(tree));
                 break;
             case DOUBLE_TYPE:
                 sprintf(buf + *pos, "%f", tree->d);
@@ -97,15 +104,69 @@ void printToBuffer(Item *tree, char *buf, int *pos) {
                 sprintf(buf + *pos, "()");
                 *pos += 2;
                 break;
+            case VECTOR_TYPE:
+                buf[(*pos)++] = '#';
+                buf[(*pos)++] = '(';
+                for (long i = 0; i < tree->v.length; i++) {
+                    if (i > 0) {
+                        buf[(*pos)++] = ' ';
+                    }
+                    printToBuffer(tree->v.elements[i], buf, pos);
+                }
+                buf[(*pos)++] = ')';
+                break;
             default:
                 syntaxError("Item type unrecognized");
             }
     }
 }
 
+/* measures how many characters printToBuffer writes for a given
+   parse tree, so the buffer can be sized to fit whole programs */
+int printedLength(Item *tree) {
+    if (tree == NULL) {
+        return 0;
+    }
+    switch (tree->type) {
+        case CONS_TYPE:
+            {
+                int total = 2;
+                Item *current = tree;
+                while (current->type == CONS_TYPE) {
+                    total += printedLength(car(current)) + 1;
+                    current = cdr(current);
+                }
+                return total + 2 + printedLength(current);
+            }
+        case SYMBOL_TYPE:
+            return strlen(tree->s);
+        case CALL_SITE_TYPE:
+            return printedLength(tree->cs.symbol);
+        case STR_TYPE:
+            return strlen(tree->s) + 2;
+        case INT_TYPE:
+            return snprintf(NULL, 0, "%ld", tree->i);
+        case BIGNUM_TYPE:
+            return strlen(integerToString(tree));
+        case DOUBLE_TYPE:
+            return snprintf(NULL, 0, "%f", tree->d);
+        case VECTOR_TYPE: {
+            int total = 3;
+            for (long i = 0; i < tree->v.length; i++) {
+                total += printedLength(tree->v.elements[i]) + 1;
+            }
+            return total;
+        }
+        default:
+            return 2;
+    }
+}
+
 /* prints the items of a given parse tree in perfect Scheme code */
 void printTree(Item *tree) {
-    char buffer[1000] = {0};  
+    int size = printedLength(tree) + 1;
+    char *buffer = talloc(size);
+    memset(buffer, 0, size);
     int pos = 0;
     printToBuffer(tree, buffer, &pos);
     size_t len = strlen(buffer);
@@ -136,14 +197,14 @@ Item *parse(Item *tokens) {
         switch (token->type) {
             case OPEN_TYPE:
             case OPENBRACKET_TYPE:
+            case OPENVECTOR_TYPE:
                 push(&stack, token);
                 openParentheses++;
                 break;
             case SYMBOL_TYPE:
                 if (strcmp(token->s, "lambda") == 0) {
-                    previousToken = token;
                     push(&stack, token);
-                } else if (previousToken && (strcmp(previousToken->s, "lambda") == 0) && strcmp(token->s, "quote") == 0) {
+                } else if (previousToken && previousToken->type == SYMBOL_TYPE && (strcmp(previousToken->s, "lambda") == 0) && strcmp(token->s, "quote") == 0) {
                     syntaxError("lambda is not followed by arguments");
                 } else {
                     push(&stack, token);
@@ -156,12 +217,13 @@ Item *parse(Item *tokens) {
                 }
                 openParentheses--;
                 Item *sublist = makeNull();
-                while (!isNull(stack) && (car(stack)->type != OPEN_TYPE && car(stack)->type != OPENBRACKET_TYPE)) {
+                while (!isNull(stack) && (car(stack)->type != OPEN_TYPE && car(stack)->type != OPENBRACKET_TYPE &&
+                                          car(stack)->type != OPENVECTOR_TYPE)) {
                     sublist = cons(pop(&stack), sublist);
                 }
-                pop(&stack);
-                if (!isNull(sublist) && isNull(cdr(sublist)) && car(sublist)->type == CONS_TYPE && !isNull(car(sublist)->c.cdr)) {
-                    sublist = car(sublist);
+                // a vector literal's elements are data, so it is made here
+                if (pop(&stack)->type == OPENVECTOR_TYPE) {
+                    sublist = listToVector(sublist);
                 }
                 push(&stack, sublist);
                 break;
@@ -169,6 +231,7 @@ Item *parse(Item *tokens) {
                 push(&stack, token);
                 break;
         }
+        previousToken = token;
     }
 
     if (openParentheses > 0) {
@@ -180,9 +243,5 @@ Item *parse(Item *tokens) {
         parseTree = cons(pop(&stack), parseTree);
     }
 
-    if (isNull(cdr(parseTree))) {
-        return car(parseTree);
-    }
-
     return parseTree; 
 }
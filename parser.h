@@ -12,5 +12,8 @@ Item *parse(Item *tokens);
 // Scheme code; use parentheses to indicate subtrees.
 void printTree(Item *tree);
 
+// Prints a syntax error and exits. Takes in the message.
+void syntaxError(const char *message);
+
 
 #endif
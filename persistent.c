@@ -0,0 +1,981 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "persistent.h"
+#include "bignum.h"
+#include "hashtable.h"
+#include "interpreter.h"
+#include "linkedlist.h"
+#include "talloc.h"
+
+#define BITS 5
+#define BRANCHES (1 << BITS)
+#define MASK (BRANCHES - 1)
+
+// A node of a map. A bitmap node keeps an entry, a key and its value, for
+// each bit of dataMap and a child for each bit of nodeMap, in slots, all
+// the entries first; a collision node keeps pairs entries whose keys all
+// have the same hash. A node whose edit is a live transient's belongs to
+// that transient, and may have room in slots for more than it holds.
+struct MapNode {
+    unsigned long edit;
+    uint32_t dataMap;
+    uint32_t nodeMap;
+    int collision;
+    int pairs;
+    unsigned long hash;
+    int capacity;
+    void **slots;
+};
+
+typedef struct MapNode MapNode;
+
+// A node of a vector: elements at the bottom of the trie, and children
+// above it.
+struct VectorNode {
+    unsigned long edit;
+    void *slots[BRANCHES];
+};
+
+typedef struct VectorNode VectorNode;
+
+// A map: its root and how many entries it has. edit is 0 for a persistent
+// map, and for a transient the token its nodes are marked with, until
+// persistent! sets it to 0 and transient stays set.
+struct PersistentMap {
+    MapNode *root;
+    long count;
+    unsigned long edit;
+    int transient;
+};
+
+// A vector: how many elements it has, the shift of its root's level, its
+// root and its tail, which holds the elements after the last full leaf of
+// the trie. edit and transient are as for maps.
+struct PersistentVector {
+    long count;
+    int shift;
+    VectorNode *root;
+    VectorNode *tail;
+    unsigned long edit;
+    int transient;
+};
+
+typedef struct PersistentMap PersistentMap;
+typedef struct PersistentVector PersistentVector;
+
+// the token the next transient marks its nodes with
+unsigned long nextEdit = 1;
+
+// makes an item for a map or vector. takes in its type and contents
+Item *makePersistentItem(itemType type, void *contents) {
+    Item *item = talloc(sizeof(Item));
+    item->type = type;
+    item->p = contents;
+    return item;
+}
+
+// returns a map's contents, checking that it is a map, and for the
+// procedures ending in ! a live transient one, or for the others that
+// update a persistent one. takes in the value, the error to report, and
+// 1 for a transient, 0 for a persistent map and -1 for either
+PersistentMap *checkMap(Item *value, const char *message, int transient) {
+    if (value->type != PMAP_TYPE) {
+        evaluationError(message);
+    }
+    PersistentMap *map = value->p;
+    if (map->transient && map->edit == 0) {
+        evaluationError("transient used after persistent!");
+    }
+    if (transient >= 0 && map->transient != transient) {
+        evaluationError(transient ? "expects a transient map; use transient to make one"
+                                  : "expects a persistent map; use the procedure ending in ! on a transient");
+    }
+    return map;
+}
+
+// the same for vectors
+PersistentVector *checkPvector(Item *value, const char *message, int transient) {
+    if (value->type != PVECTOR_TYPE) {
+        evaluationError(message);
+    }
+    PersistentVector *vector = value->p;
+    if (vector->transient && vector->edit == 0) {
+        evaluationError("transient used after persistent!");
+    }
+    if (transient >= 0 && vector->transient != transient) {
+        evaluationError(transient ? "expects a transient vector; use transient to make one"
+                                  : "expects a persistent vector; use the procedure ending in ! on a transient");
+    }
+    return vector;
+}
+
+// maps
+
+// returns the hash of a map key
+unsigned long keyHash(Item *key) {
+    return equalHash(key);
+}
+
+// returns how many slots of a map node are in use
+int nodeSize(MapNode *node) {
+    if (node->collision) {
+        return 2 * node->pairs;
+    }
+    return 2 * __builtin_popcount(node->dataMap) + __builtin_popcount(node->nodeMap);
+}
+
+// makes an empty bitmap node. takes in the owner's edit and room for how
+// many slots
+MapNode *newMapNode(unsigned long edit, int capacity) {
+    MapNode *node = talloc(sizeof(MapNode));
+    node->edit = edit;
+    node->dataMap = 0;
+    node->nodeMap = 0;
+    node->collision = 0;
+    node->pairs = 0;
+    node->hash = 0;
+    node->capacity = capacity;
+    node->slots = talloc(sizeof(void *) * (capacity > 0 ? capacity : 1));
+    return node;
+}
+
+// returns a node that may be changed on behalf of an edit, with room for
+// more slots: the node itself if the edit's transient owns it, or a copy.
+// transients copy with room to spare, so that a run of insertions into the
+// same node does not copy it each time. takes in the node, the edit and
+// how many more slots it needs room for
+MapNode *editableNode(MapNode *node, unsigned long edit, int room) {
+    int size = nodeSize(node);
+    if (edit != 0 && node->edit == edit) {
+        if (node->capacity < size + room) {
+            void **slots = talloc(sizeof(void *) * 2 * (size + room));
+            memcpy(slots, node->slots, sizeof(void *) * size);
+            node->slots = slots;
+            node->capacity = 2 * (size + room);
+        }
+        return node;
+    }
+    int capacity = edit != 0 ? 2 * (size + room) : size + room;
+    MapNode *copy = newMapNode(edit, capacity);
+    copy->dataMap = node->dataMap;
+    copy->nodeMap = node->nodeMap;
+    copy->collision = node->collision;
+    copy->pairs = node->pairs;
+    copy->hash = node->hash;
+    memcpy(copy->slots, node->slots, sizeof(void *) * size);
+    return copy;
+}
+
+// opens a gap in a node's slots, which must have room for it. takes in the
+// node, where the gap goes and how wide it is
+void openSlots(MapNode *node, int at, int width) {
+    memmove(node->slots + at + width, node->slots + at, sizeof(void *) * (nodeSize(node) - at));
+}
+
+// closes a gap in a node's slots. takes in the node, where the gap is, how
+// wide it is, and the node's size before the gap closes
+void closeSlots(MapNode *node, int at, int width, int size) {
+    memmove(node->slots + at, node->slots + at + width, sizeof(void *) * (size - at - width));
+}
+
+// returns which branch of a node a hash takes at a level
+uint32_t branchBit(unsigned long hash, int shift) {
+    return (uint32_t)1 << ((hash >> shift) & MASK);
+}
+
+// returns a bitmap node's index for a bit among the bits set in a map
+int bitIndex(uint32_t map, uint32_t bit) {
+    return __builtin_popcount(map & (bit - 1));
+}
+
+// makes the node for two entries whose hashes agree below a level. takes
+// in the entries, their hashes, the level's shift and the edit
+MapNode *mergeEntries(Item *key1, Item *value1, unsigned long hash1, Item *key2, Item *value2,
+                      unsigned long hash2, int shift, unsigned long edit) {
+    if (shift >= 64) {
+        MapNode *node = newMapNode(edit, 4);
+        node->collision = 1;
+        node->pairs = 2;
+        node->hash = hash1;
+        node->slots[0] = key1;
+        node->slots[1] = value1;
+        node->slots[2] = key2;
+        node->slots[3] = value2;
+        return node;
+    }
+    uint32_t bit1 = branchBit(hash1, shift);
+    uint32_t bit2 = branchBit(hash2, shift);
+    if (bit1 == bit2) {
+        MapNode *node = newMapNode(edit, 1);
+        node->nodeMap = bit1;
+        node->slots[0] = mergeEntries(key1, value1, hash1, key2, value2, hash2, shift + BITS, edit);
+        return node;
+    }
+    MapNode *node = newMapNode(edit, 4);
+    node->dataMap = bit1 | bit2;
+    int first = bit1 < bit2 ? 0 : 2;
+    node->slots[first] = key1;
+    node->slots[first + 1] = value1;
+    node->slots[2 - first] = key2;
+    node->slots[3 - first] = value2;
+    return node;
+}
+
+// looks up a key. takes in the root, the key and its hash, and returns the
+// key's value or NULL
+Item *mapLookup(MapNode *node, Item *key, unsigned long hash) {
+    int shift = 0;
+    while (1) {
+        if (node->collision) {
+            for (int i = 0; i < node->pairs; i++) {
+                if (isEqual(node->slots[2 * i], key)) {
+                    return node->slots[2 * i + 1];
+                }
+            }
+            return NULL;
+        }
+        uint32_t bit = branchBit(hash, shift);
+        if (node->dataMap & bit) {
+            int i = bitIndex(node->dataMap, bit);
+            return isEqual(node->slots[2 * i], key) ? node->slots[2 * i + 1] : NULL;
+        } else if (node->nodeMap & bit) {
+            node = node->slots[2 * __builtin_popcount(node->dataMap) + bitIndex(node->nodeMap, bit)];
+            shift += BITS;
+        } else {
+            return NULL;
+        }
+    }
+}
+
+// stores a value under a key below a node. takes in the node, its level's
+// shift, the key, its hash and the value, the edit, and where to record
+// whether the key is new, and returns the node to replace this one with,
+// the node itself if nothing changed
+MapNode *mapAssoc(MapNode *node, int shift, Item *key, unsigned long hash, Item *value,
+                  unsigned long edit, int *added) {
+    if (node->collision) {
+        for (int i = 0; i < node->pairs; i++) {
+            if (isEqual(node->slots[2 * i], key)) {
+                if (node->slots[2 * i + 1] == value) {
+                    return node;
+                }
+                MapNode *copy = editableNode(node, edit, 0);
+                copy->slots[2 * i + 1] = value;
+                return copy;
+            }
+        }
+        MapNode *copy = editableNode(node, edit, 2);
+        copy->slots[2 * copy->pairs] = key;
+        copy->slots[2 * copy->pairs + 1] = value;
+        copy->pairs++;
+        *added = 1;
+        return copy;
+    }
+    uint32_t bit = branchBit(hash, shift);
+    int data = __builtin_popcount(node->dataMap);
+    if (node->dataMap & bit) {
+        int i = bitIndex(node->dataMap, bit);
+        Item *existing = node->slots[2 * i];
+        if (isEqual(existing, key)) {
+            if (node->slots[2 * i + 1] == value) {
+                return node;
+            }
+            MapNode *copy = editableNode(node, edit, 0);
+            copy->slots[2 * i + 1] = value;
+            return copy;
+        }
+        // the two keys share this branch, so both move down into a child
+        MapNode *child = mergeEntries(existing, node->slots[2 * i + 1], keyHash(existing), key, value, hash,
+                                      shift + BITS, edit);
+        MapNode *copy = editableNode(node, edit, 0);
+        int size = nodeSize(copy);
+        closeSlots(copy, 2 * i, 2, size);
+        copy->dataMap &= ~bit;
+        int at = 2 * (data - 1) + bitIndex(copy->nodeMap, bit);
+        memmove(copy->slots + at + 1, copy->slots + at, sizeof(void *) * (size - 2 - at));
+        copy->slots[at] = child;
+        copy->nodeMap |= bit;
+        *added = 1;
+        return copy;
+    } else if (node->nodeMap & bit) {
+        int at = 2 * data + bitIndex(node->nodeMap, bit);
+        MapNode *child = node->slots[at];
+        MapNode *newChild = mapAssoc(child, shift + BITS, key, hash, value, edit, added);
+        if (newChild == child) {
+            return node;
+        }
+        MapNode *copy = editableNode(node, edit, 0);
+        copy->slots[at] = newChild;
+        return copy;
+    }
+    MapNode *copy = editableNode(node, edit, 2);
+    int i = bitIndex(copy->dataMap, bit);
+    openSlots(copy, 2 * i, 2);
+    copy->slots[2 * i] = key;
+    copy->slots[2 * i + 1] = value;
+    copy->dataMap |= bit;
+    *added = 1;
+    return copy;
+}
+
+// returns whether a node holds a single entry and nothing else, so that
+// its parent may hold the entry instead
+int isSingleton(MapNode *node) {
+    return node->collision ? node->pairs == 1
+                           : node->nodeMap == 0 && __builtin_popcount(node->dataMap) == 1;
+}
+
+// removes a key below a node. takes in the node, its level's shift, the
+// key and its hash, the edit, and where to record whether the key was
+// there, and returns the node to replace this one with
+MapNode *mapDissoc(MapNode *node, int shift, Item *key, unsigned long hash, unsigned long edit, int *removed) {
+    if (node->collision) {
+        for (int i = 0; i < node->pairs; i++) {
+            if (isEqual(node->slots[2 * i], key)) {
+                MapNode *copy = editableNode(node, edit, 0);
+                closeSlots(copy, 2 * i, 2, 2 * copy->pairs);
+                copy->pairs--;
+                *removed = 1;
+                return copy;
+            }
+        }
+        return node;
+    }
+    uint32_t bit = branchBit(hash, shift);
+    int data = __builtin_popcount(node->dataMap);
+    if (node->dataMap & bit) {
+        int i = bitIndex(node->dataMap, bit);
+        if (!isEqual(node->slots[2 * i], key)) {
+            return node;
+        }
+        MapNode *copy = editableNode(node, edit, 0);
+        closeSlots(copy, 2 * i, 2, nodeSize(copy));
+        copy->dataMap &= ~bit;
+        *removed = 1;
+        return copy;
+    } else if (node->nodeMap & bit) {
+        int at = 2 * data + bitIndex(node->nodeMap, bit);
+        MapNode *child = node->slots[at];
+        MapNode *newChild = mapDissoc(child, shift + BITS, key, hash, edit, removed);
+        if (newChild == child) {
+            return node;
+        }
+        MapNode *copy = editableNode(node, edit, 1);
+        if (!isSingleton(newChild)) {
+            copy->slots[at] = newChild;
+            return copy;
+        }
+        // the child's one entry comes up into this node
+        int size = nodeSize(copy);
+        closeSlots(copy, at, 1, size);
+        copy->nodeMap &= ~bit;
+        int i = bitIndex(copy->dataMap, bit);
+        openSlots(copy, 2 * i, 2);
+        copy->slots[2 * i] = newChild->slots[0];
+        copy->slots[2 * i + 1] = newChild->slots[1];
+        copy->dataMap |= bit;
+        return copy;
+    }
+    return node;
+}
+
+// collects a map's entries, keys and values alternately. takes in a node,
+// the array and where in it to put them, and returns where the next goes
+long collectEntries(MapNode *node, Item **entries, long n) {
+    if (node->collision) {
+        memcpy(entries + n, node->slots, sizeof(void *) * 2 * node->pairs);
+        return n + 2 * node->pairs;
+    }
+    int data = __builtin_popcount(node->dataMap);
+    memcpy(entries + n, node->slots, sizeof(void *) * 2 * data);
+    n += 2 * data;
+    for (int i = 0; i < __builtin_popcount(node->nodeMap); i++) {
+        n = collectEntries(node->slots[2 * data + i], entries, n);
+    }
+    return n;
+}
+
+// returns an array of a map's entries, keys and values alternately
+Item **mapEntries(PersistentMap *map) {
+    Item **entries = talloc(sizeof(Item *) * 2 * (map->count > 0 ? map->count : 1));
+    collectEntries(map->root, entries, 0);
+    return entries;
+}
+
+// makes a map. takes in its root, its count and its edit
+Item *makeMap(MapNode *root, long count, unsigned long edit) {
+    PersistentMap *map = talloc(sizeof(PersistentMap));
+    map->root = root;
+    map->count = count;
+    map->edit = edit;
+    map->transient = edit != 0;
+    return makePersistentItem(PMAP_TYPE, map);
+}
+
+// stores a value under a key in a transient map. takes in the map, the key
+// and the value
+void transientAssoc(PersistentMap *map, Item *key, Item *value) {
+    int added = 0;
+    map->root = mapAssoc(map->root, 0, key, keyHash(key), value, map->edit, &added);
+    map->count += added;
+}
+
+// implements pmap. takes in keys and values alternately and returns a map
+// of them, later values replacing earlier ones of the same key
+Item *primitivePmap(int argc, Item **argv) {
+    if (argc % 2 != 0) {
+        evaluationError("pmap expects keys and values in pairs");
+    }
+    unsigned long edit = nextEdit++;
+    Item *result = makeMap(newMapNode(edit, 0), 0, edit);
+    PersistentMap *map = result->p;
+    for (int i = 0; i < argc; i += 2) {
+        transientAssoc(map, argv[i], argv[i + 1]);
+    }
+    map->edit = 0;
+    map->transient = 0;
+    return result;
+}
+
+// implements pmap?. takes in a value and returns whether it is a map,
+// persistent or transient
+Item *primitiveIsPmap(Item *value) {
+    Item *result = talloc(sizeof(Item));
+    result->type = BOOL_TYPE;
+    result->i = value->type == PMAP_TYPE;
+    return result;
+}
+
+// implements pmap-count. takes in a map and returns how many keys it has
+Item *primitivePmapCount(Item *map) {
+    return makeFixnum(checkMap(map, "pmap-count expects a map", -1)->count);
+}
+
+// implements pmap-ref. takes in a map, a key and optionally a default,
+// and returns the key's value, or the default if it has none
+Item *primitivePmapRef(int argc, Item **argv) {
+    PersistentMap *map = checkMap(argv[0], "pmap-ref expects a map", -1);
+    Item *value = mapLookup(map->root, argv[1], keyHash(argv[1]));
+    if (value != NULL) {
+        return value;
+    }
+    if (argc < 3) {
+        evaluationError("pmap-ref key not found");
+    }
+    return argv[2];
+}
+
+// implements pmap-set. takes in a map, a key and a value, and returns a
+// map with the value stored under the key
+Item *primitivePmapSet(int argc, Item **argv) {
+    PersistentMap *map = checkMap(argv[0], "pmap-set expects a map", 0);
+    int added = 0;
+    MapNode *root = mapAssoc(map->root, 0, argv[1], keyHash(argv[1]), argv[2], 0, &added);
+    return root == map->root ? argv[0] : makeMap(root, map->count + added, 0);
+}
+
+// implements pmap-delete. takes in a map and a key, and returns a map
+// without the key
+Item *primitivePmapDelete(Item *value, Item *key) {
+    PersistentMap *map = checkMap(value, "pmap-delete expects a map", 0);
+    int removed = 0;
+    MapNode *root = mapDissoc(map->root, 0, key, keyHash(key), 0, &removed);
+    return root == map->root ? value : makeMap(root, map->count - removed, 0);
+}
+
+// implements pmap-contains?. takes in a map and a key and returns whether
+// the key has a value
+Item *primitivePmapContains(Item *map, Item *key) {
+    PersistentMap *contents = checkMap(map, "pmap-contains? expects a map", -1);
+    Item *result = talloc(sizeof(Item));
+    result->type = BOOL_TYPE;
+    result->i = mapLookup(contents->root, key, keyHash(key)) != NULL;
+    return result;
+}
+
+// implements pmap-walk. takes in a map and a procedure, calls the
+// procedure on each key and its value, and returns void
+Item *primitivePmapWalk(Item *map, Item *procedure) {
+    PersistentMap *walked = checkMap(map, "pmap-walk expects a map", -1);
+    long count = walked->count;
+    Item **entries = mapEntries(walked);
+    for (long i = 0; i < count; i++) {
+        apply(procedure, 2, entries + 2 * i);
+    }
+    return makeVoid();
+}
+
+// implements pmap-keys. takes in a map and returns a list of its keys
+Item *primitivePmapKeys(Item *map) {
+    PersistentMap *listed = checkMap(map, "pmap-keys expects a map", -1);
+    Item **entries = mapEntries(listed);
+    Item *keys = makeNull();
+    for (long i = listed->count - 1; i >= 0; i--) {
+        keys = cons(entries[2 * i], keys);
+    }
+    return keys;
+}
+
+// implements pmap->alist. takes in a map and returns a list of pairs of
+// its keys and their values
+Item *primitivePmapToAlist(Item *map) {
+    PersistentMap *listed = checkMap(map, "pmap->alist expects a map", -1);
+    Item **entries = mapEntries(listed);
+    Item *alist = makeNull();
+    for (long i = listed->count - 1; i >= 0; i--) {
+        alist = cons(cons(entries[2 * i], entries[2 * i + 1]), alist);
+    }
+    return alist;
+}
+
+// vectors
+
+// makes an empty vector node. takes in the owner's edit
+VectorNode *newVectorNode(unsigned long edit) {
+    VectorNode *node = talloc(sizeof(VectorNode));
+    node->edit = edit;
+    memset(node->slots, 0, sizeof(node->slots));
+    return node;
+}
+
+// returns a vector node that may be changed on behalf of an edit: the node
+// itself if the edit's transient owns it, or a copy. takes in the node and
+// the edit
+VectorNode *editableVectorNode(VectorNode *node, unsigned long edit) {
+    if (edit != 0 && node->edit == edit) {
+        return node;
+    }
+    VectorNode *copy = talloc(sizeof(VectorNode));
+    memcpy(copy, node, sizeof(VectorNode));
+    copy->edit = edit;
+    return copy;
+}
+
+// returns the index of the first element in a vector's tail
+long tailOffset(PersistentVector *vector) {
+    return vector->count < BRANCHES ? 0 : ((vector->count - 1) >> BITS) << BITS;
+}
+
+// returns the leaf, or the tail, holding an element of a vector. takes in
+// the vector and the element's index
+VectorNode *leafFor(PersistentVector *vector, long index) {
+    if (index >= tailOffset(vector)) {
+        return vector->tail;
+    }
+    VectorNode *node = vector->root;
+    for (int level = vector->shift; level > 0; level -= BITS) {
+        node = node->slots[(index >> level) & MASK];
+    }
+    return node;
+}
+
+// makes the path of nodes from a level down to a leaf. takes in the edit,
+// the level's shift and the leaf
+VectorNode *newPath(unsigned long edit, int level, VectorNode *leaf) {
+    if (level == 0) {
+        return leaf;
+    }
+    VectorNode *node = newVectorNode(edit);
+    node->slots[0] = newPath(edit, level - BITS, leaf);
+    return node;
+}
+
+// adds a full tail to the trie as its last leaf. takes in the vector, whose
+// count does not yet include the new element, a level's shift, the node at
+// that level and the tail, and returns the node to replace it with
+VectorNode *pushTail(PersistentVector *vector, int level, VectorNode *parent, VectorNode *tail) {
+    int index = ((vector->count - 1) >> level) & MASK;
+    VectorNode *copy = editableVectorNode(parent, vector->edit);
+    if (level == BITS) {
+        copy->slots[index] = tail;
+    } else {
+        VectorNode *child = parent->slots[index];
+        copy->slots[index] = child != NULL ? pushTail(vector, level - BITS, child, tail)
+                                           : newPath(vector->edit, level - BITS, tail);
+    }
+    return copy;
+}
+
+// stores an element in the trie. takes in the edit, a level's shift, the
+// node at that level, the index and the value, and returns the node to
+// replace it with
+VectorNode *trieAssoc(unsigned long edit, int level, VectorNode *node, long index, Item *value) {
+    VectorNode *copy = editableVectorNode(node, edit);
+    if (level == 0) {
+        copy->slots[index & MASK] = value;
+    } else {
+        int i = (index >> level) & MASK;
+        copy->slots[i] = trieAssoc(edit, level - BITS, node->slots[i], index, value);
+    }
+    return copy;
+}
+
+// removes the trie's last leaf. takes in the vector, whose count still
+// includes the element being popped, a level's shift and the node at that
+// level, and returns the node to replace it with, or NULL if it is left
+// empty
+VectorNode *popTail(PersistentVector *vector, int level, VectorNode *node) {
+    int index = ((vector->count - 2) >> level) & MASK;
+    if (level > BITS) {
+        VectorNode *child = popTail(vector, level - BITS, node->slots[index]);
+        if (child == NULL && index == 0) {
+            return NULL;
+        }
+        VectorNode *copy = editableVectorNode(node, vector->edit);
+        copy->slots[index] = child;
+        return copy;
+    } else if (index == 0) {
+        return NULL;
+    }
+    VectorNode *copy = editableVectorNode(node, vector->edit);
+    copy->slots[index] = NULL;
+    return copy;
+}
+
+// sets an element of a vector in place, the vector being a transient or a
+// copy about to be returned. takes in the vector, the index and the value
+void vectorAssoc(PersistentVector *vector, long index, Item *value) {
+    if (index >= tailOffset(vector)) {
+        vector->tail = editableVectorNode(vector->tail, vector->edit);
+        vector->tail->slots[index & MASK] = value;
+    } else {
+        vector->root = trieAssoc(vector->edit, vector->shift, vector->root, index, value);
+    }
+}
+
+// pushes an element onto a vector in place. takes in the vector and the
+// value
+void vectorPush(PersistentVector *vector, Item *value) {
+    if (vector->count - tailOffset(vector) < BRANCHES) {
+        vector->tail = editableVectorNode(vector->tail, vector->edit);
+        vector->tail->slots[vector->count & MASK] = value;
+        vector->count++;
+        return;
+    }
+    VectorNode *full = vector->tail;
+    if ((vector->count >> BITS) > (1L << vector->shift)) {
+        VectorNode *root = newVectorNode(vector->edit);
+        root->slots[0] = vector->root;
+        root->slots[1] = newPath(vector->edit, vector->shift, full);
+        vector->root = root;
+        vector->shift += BITS;
+    } else {
+        vector->root = pushTail(vector, vector->shift, vector->root, full);
+    }
+    vector->tail = newVectorNode(vector->edit);
+    vector->tail->slots[0] = value;
+    vector->count++;
+}
+
+// pops the last element off a vector in place. takes in the vector
+void vectorPop(PersistentVector *vector) {
+    if (vector->count == 0) {
+        evaluationError("pvector-pop expects a non-empty vector");
+    }
+    if (vector->count == 1) {
+        vector->tail = newVectorNode(vector->edit);
+        vector->count = 0;
+        return;
+    }
+    if (vector->count - tailOffset(vector) > 1) {
+        vector->tail = editableVectorNode(vector->tail, vector->edit);
+        vector->tail->slots[(vector->count - 1) & MASK] = NULL;
+        vector->count--;
+        return;
+    }
+    VectorNode *tail = leafFor(vector, vector->count - 2);
+    VectorNode *root = popTail(vector, vector->shift, vector->root);
+    if (root == NULL) {
+        root = newVectorNode(vector->edit);
+    }
+    if (vector->shift > BITS && root->slots[1] == NULL) {
+        root = root->slots[0];
+        vector->shift -= BITS;
+    }
+    vector->root = root;
+    vector->tail = tail;
+    vector->count--;
+}
+
+// copies a vector's contents. takes in the vector and the edit the copy
+// works on behalf of
+PersistentVector *copyVector(PersistentVector *vector, unsigned long edit) {
+    PersistentVector *copy = talloc(sizeof(PersistentVector));
+    memcpy(copy, vector, sizeof(PersistentVector));
+    copy->edit = edit;
+    copy->transient = edit != 0;
+    return copy;
+}
+
+// makes an empty transient vector, to fill and then make persistent
+PersistentVector *emptyTransient() {
+    PersistentVector *vector = talloc(sizeof(PersistentVector));
+    vector->edit = nextEdit++;
+    vector->transient = 1;
+    vector->count = 0;
+    vector->shift = BITS;
+    vector->root = newVectorNode(vector->edit);
+    vector->tail = newVectorNode(vector->edit);
+    return vector;
+}
+
+// makes a filled transient vector persistent. takes in its contents and
+// returns the vector
+Item *finishVector(PersistentVector *vector) {
+    vector->edit = 0;
+    vector->transient = 0;
+    return makePersistentItem(PVECTOR_TYPE, vector);
+}
+
+// checks an index into a vector. takes in the index, the vector's length
+// and the error to report, and returns the index
+long checkPvectorIndex(Item *index, long count, const char *message) {
+    if (index->type != INT_TYPE || index->i < 0 || index->i >= count) {
+        evaluationError(message);
+    }
+    return index->i;
+}
+
+// implements pvector. takes in the elements and returns a vector of them
+Item *primitivePvector(int argc, Item **argv) {
+    PersistentVector *vector = emptyTransient();
+    for (int i = 0; i < argc; i++) {
+        vectorPush(vector, argv[i]);
+    }
+    return finishVector(vector);
+}
+
+// implements pvector?. takes in a value and returns whether it is a
+// vector, persistent or transient
+Item *primitiveIsPvector(Item *value) {
+    Item *result = talloc(sizeof(Item));
+    result->type = BOOL_TYPE;
+    result->i = value->type == PVECTOR_TYPE;
+    return result;
+}
+
+// implements pvector-length. takes in a vector and returns its length
+Item *primitivePvectorLength(Item *vector) {
+    return makeFixnum(checkPvector(vector, "pvector-length expects a vector", -1)->count);
+}
+
+// implements pvector-ref. takes in a vector and an index and returns the
+// element at the index
+Item *primitivePvectorRef(Item *vector, Item *index) {
+    PersistentVector *contents = checkPvector(vector, "pvector-ref expects a vector", -1);
+    long i = checkPvectorIndex(index, contents->count, "pvector-ref index out of range");
+    return leafFor(contents, i)->slots[i & MASK];
+}
+
+// implements pvector-set. takes in a vector, an index and a value, and
+// returns a vector with the value at the index
+Item *primitivePvectorSet(int argc, Item **argv) {
+    PersistentVector *vector = copyVector(checkPvector(argv[0], "pvector-set expects a vector", 0), 0);
+    vectorAssoc(vector, checkPvectorIndex(argv[1], vector->count, "pvector-set index out of range"), argv[2]);
+    return makePersistentItem(PVECTOR_TYPE, vector);
+}
+
+// implements pvector-push. takes in a vector and a value and returns a
+// vector with the value added at the end
+Item *primitivePvectorPush(Item *vector, Item *value) {
+    PersistentVector *copy = copyVector(checkPvector(vector, "pvector-push expects a vector", 0), 0);
+    vectorPush(copy, value);
+    return makePersistentItem(PVECTOR_TYPE, copy);
+}
+
+// implements pvector-pop. takes in a vector and returns a vector without
+// its last element
+Item *primitivePvectorPop(Item *vector) {
+    PersistentVector *copy = copyVector(checkPvector(vector, "pvector-pop expects a vector", 0), 0);
+    vectorPop(copy);
+    return makePersistentItem(PVECTOR_TYPE, copy);
+}
+
+// implements pvector-append. takes in two vectors and returns a vector of
+// the first's elements followed by the second's, pushing the second's
+// onto a transient copy of the first
+Item *primitivePvectorAppend(Item *a, Item *b) {
+    PersistentVector *first = checkPvector(a, "pvector-append expects vectors", 0);
+    PersistentVector *second = checkPvector(b, "pvector-append expects vectors", 0);
+    PersistentVector *vector = copyVector(first, nextEdit++);
+    for (long i = 0; i < second->count; i++) {
+        vectorPush(vector, leafFor(second, i)->slots[i & MASK]);
+    }
+    return finishVector(vector);
+}
+
+// implements pvector->list. takes in a vector and returns a list of its
+// elements
+Item *primitivePvectorToList(Item *vector) {
+    PersistentVector *contents = checkPvector(vector, "pvector->list expects a vector", -1);
+    Item *list = makeNull();
+    for (long i = contents->count - 1; i >= 0; i--) {
+        list = cons(leafFor(contents, i)->slots[i & MASK], list);
+    }
+    return list;
+}
+
+// implements list->pvector. takes in a list and returns a vector of its
+// elements
+Item *primitiveListToPvector(Item *list) {
+    PersistentVector *vector = emptyTransient();
+    for (; list->type == CONS_TYPE; list = cdr(list)) {
+        vectorPush(vector, car(list));
+    }
+    if (list->type != NULL_TYPE) {
+        evaluationError("list->pvector expects a list");
+    }
+    return finishVector(vector);
+}
+
+// transients
+
+// implements transient. takes in a persistent map or vector and returns a
+// transient one with the same contents
+Item *primitiveTransient(Item *value) {
+    if (value->type == PMAP_TYPE) {
+        PersistentMap *map = checkMap(value, "transient expects a map or vector", 0);
+        return makeMap(map->root, map->count, nextEdit++);
+    } else if (value->type == PVECTOR_TYPE) {
+        PersistentVector *vector = checkPvector(value, "transient expects a map or vector", 0);
+        return makePersistentItem(PVECTOR_TYPE, copyVector(vector, nextEdit++));
+    }
+    evaluationError("transient expects a map or vector");
+    return NULL;
+}
+
+// implements persistent!. takes in a transient map or vector, returns a
+// persistent one with the same contents and ends the transient
+Item *primitivePersistent(Item *value) {
+    if (value->type == PMAP_TYPE) {
+        PersistentMap *map = checkMap(value, "persistent! expects a transient map or vector", 1);
+        map->edit = 0;
+        return makeMap(map->root, map->count, 0);
+    } else if (value->type == PVECTOR_TYPE) {
+        PersistentVector *vector = checkPvector(value, "persistent! expects a transient map or vector", 1);
+        PersistentVector *result = copyVector(vector, 0);
+        vector->edit = 0;
+        return makePersistentItem(PVECTOR_TYPE, result);
+    }
+    evaluationError("persistent! expects a transient map or vector");
+    return NULL;
+}
+
+// implements pmap-set!. takes in a transient map, a key and a value,
+// stores the value under the key and returns the map
+Item *primitivePmapSetInPlace(int argc, Item **argv) {
+    transientAssoc(checkMap(argv[0], "pmap-set! expects a map", 1), argv[1], argv[2]);
+    return argv[0];
+}
+
+// implements pmap-delete!. takes in a transient map and a key, removes the
+// key and returns the map
+Item *primitivePmapDeleteInPlace(Item *value, Item *key) {
+    PersistentMap *map = checkMap(value, "pmap-delete! expects a map", 1);
+    int removed = 0;
+    map->root = mapDissoc(map->root, 0, key, keyHash(key), map->edit, &removed);
+    map->count -= removed;
+    return value;
+}
+
+// implements pvector-set!. takes in a transient vector, an index and a
+// value, stores the value at the index and returns the vector
+Item *primitivePvectorSetInPlace(int argc, Item **argv) {
+    PersistentVector *vector = checkPvector(argv[0], "pvector-set! expects a vector", 1);
+    vectorAssoc(vector, checkPvectorIndex(argv[1], vector->count, "pvector-set! index out of range"), argv[2]);
+    return argv[0];
+}
+
+// implements pvector-push!. takes in a transient vector and a value, adds
+// the value at the end and returns the vector
+Item *primitivePvectorPushInPlace(Item *vector, Item *value) {
+    vectorPush(checkPvector(vector, "pvector-push! expects a vector", 1), value);
+    return vector;
+}
+
+// implements pvector-pop!. takes in a transient vector, removes its last
+// element and returns the vector
+Item *primitivePvectorPopInPlace(Item *vector) {
+    vectorPop(checkPvector(vector, "pvector-pop! expects a vector", 1));
+    return vector;
+}
+
+// equality and printing
+
+// compares two maps, or two vectors, by contents. takes in the values,
+// which have the same type, and returns whether they are equal?
+int persistentEqual(Item *a, Item *b) {
+    if (a->type == PMAP_TYPE) {
+        PersistentMap *first = a->p;
+        PersistentMap *second = b->p;
+        if (first->count != second->count) {
+            return 0;
+        }
+        Item **entries = mapEntries(first);
+        for (long i = 0; i < first->count; i++) {
+            Item *value = mapLookup(second->root, entries[2 * i], keyHash(entries[2 * i]));
+            if (value == NULL || !isEqual(value, entries[2 * i + 1])) {
+                return 0;
+            }
+        }
+        return 1;
+    }
+    PersistentVector *first = a->p;
+    PersistentVector *second = b->p;
+    if (first->count != second->count) {
+        return 0;
+    }
+    for (long i = 0; i < first->count; i++) {
+        if (!isEqual(leafFor(first, i)->slots[i & MASK], leafFor(second, i)->slots[i & MASK])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// hashes a map or vector to match persistentEqual: a map by its count,
+// and a vector by its length and first few elements. takes in the value
+unsigned long persistentHash(Item *value) {
+    if (value->type == PMAP_TYPE) {
+        return ((PersistentMap *)value->p)->count;
+    }
+    PersistentVector *vector = value->p;
+    unsigned long hash = vector->count;
+    for (long i = 0; i < vector->count && i < 8; i++) {
+        hash = hash * 31 + equalHash(leafFor(vector, i)->slots[i & MASK]);
+    }
+    return hash;
+}
+
+// prints a map, vector or transient. takes in the value
+void printPersistent(Item *value) {
+    int transient = value->type == PMAP_TYPE ? ((PersistentMap *)value->p)->transient
+                                             : ((PersistentVector *)value->p)->transient;
+    if (transient) {
+        printf("#<transient>");
+        return;
+    }
+    if (value->type == PMAP_TYPE) {
+        PersistentMap *map = value->p;
+        Item **entries = mapEntries(map);
+        printf("#pmap(");
+        for (long i = 0; i < map->count; i++) {
+            if (i > 0) {
+                printf(" ");
+            }
+            printItem(cons(entries[2 * i], entries[2 * i + 1]));
+        }
+        printf(")");
+        return;
+    }
+    PersistentVector *vector = value->p;
+    printf("#pvector(");
+    for (long i = 0; i < vector->count; i++) {
+        if (i > 0) {
+            printf(" ");
+        }
+        printItem(leafFor(vector, i)->slots[i & MASK]);
+    }
+    printf(")");
+}
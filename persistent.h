@@ -0,0 +1,72 @@
+#include "item.h"
+
+#ifndef PERSISTENT_H
+#define PERSISTENT_H
+
+// Persistent maps and vectors. Updating one returns a new map or vector
+// and leaves the old one as it was, copying only the path from the root to
+// what changed, a node for every five bits of hash or index, and sharing
+// everything else with the old one, so an update takes O(log32 n) time and
+// space.
+//
+// A map is a hash array mapped trie keyed by equal?: each node has a
+// bitmap of which of its 32 branches hold an entry and which a child, and
+// keeps just those, entries first. Keys whose hashes agree in every bit
+// share a collision node at the bottom. Deleting an entry pulls a child
+// left with a single entry back up into its parent, so a map's shape, and
+// the order it is walked and printed in, depends only on its keys.
+//
+// A vector is a trie of 32-way nodes indexed five bits at a time, with its
+// last up to 32 elements kept in a tail outside the trie, so pushing and
+// popping usually copy only the tail. Vectors are radix-balanced: every
+// node but the rightmost is full, which is the RRB layout without the
+// relaxed nodes concatenation would need; pvector-append pushes the second
+// vector's elements onto the first.
+//
+// transient makes a transient copy of a map or vector in O(1), which the
+// procedures ending in ! update in place: nodes a transient has copied
+// belong to it and are changed without copying again, so building a large
+// map or vector through one allocates little more than the result.
+// persistent! returns a persistent map or vector of a transient's
+// contents in O(1), and the transient may not be used after it. Every
+// procedure that only reads takes transients as well.
+Item *primitivePmap(int argc, Item **argv);
+Item *primitiveIsPmap(Item *value);
+Item *primitivePmapCount(Item *map);
+Item *primitivePmapRef(int argc, Item **argv);
+Item *primitivePmapSet(int argc, Item **argv);
+Item *primitivePmapDelete(Item *map, Item *key);
+Item *primitivePmapContains(Item *map, Item *key);
+Item *primitivePmapWalk(Item *map, Item *procedure);
+Item *primitivePmapKeys(Item *map);
+Item *primitivePmapToAlist(Item *map);
+
+Item *primitivePvector(int argc, Item **argv);
+Item *primitiveIsPvector(Item *value);
+Item *primitivePvectorLength(Item *vector);
+Item *primitivePvectorRef(Item *vector, Item *index);
+Item *primitivePvectorSet(int argc, Item **argv);
+Item *primitivePvectorPush(Item *vector, Item *value);
+Item *primitivePvectorPop(Item *vector);
+Item *primitivePvectorAppend(Item *a, Item *b);
+Item *primitivePvectorToList(Item *vector);
+Item *primitiveListToPvector(Item *list);
+
+Item *primitiveTransient(Item *value);
+Item *primitivePersistent(Item *value);
+Item *primitivePmapSetInPlace(int argc, Item **argv);
+Item *primitivePmapDeleteInPlace(Item *map, Item *key);
+Item *primitivePvectorSetInPlace(int argc, Item **argv);
+Item *primitivePvectorPushInPlace(Item *vector, Item *value);
+Item *primitivePvectorPopInPlace(Item *vector);
+
+// Compares two maps, or two vectors, by contents with equal?, and hashes
+// one to match, for equal? and equal hash tables (see hashtable.h).
+int persistentEqual(Item *a, Item *b);
+unsigned long persistentHash(Item *value);
+
+// Prints a map as #pmap((key . value) ...), a vector as #pvector(...) and a
+// transient as #<transient>.
+void printPersistent(Item *value);
+
+#endif
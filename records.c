@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <string.h>
+#include "records.h"
+#include "interpreter.h"
+#include "linkedlist.h"
+#include "talloc.h"
+
+// reports an error naming a procedure or type. takes in the format, with
+// one %s for the name, and the name
+void recordError(const char *format, const char *name) {
+    int size = snprintf(NULL, 0, format, name) + 1;
+    char *message = talloc(size);
+    snprintf(message, size, format, name);
+    evaluationError(message);
+}
+
+// checks that a value is a record type. takes in the value and the name
+// of the procedure that expects it, and returns the type
+RecordType *checkRecordType(Item *value, const char *procedure) {
+    if (value->type != RECORD_TYPE_TYPE) {
+        recordError("%s expects a record type", procedure);
+    }
+    return value->rt;
+}
+
+// checks that a value is a symbol. takes in the value and the error to
+// report if it is not, with one %s for the name of the procedure that
+// expects it, and the name
+void checkRecordSymbol(Item *value, const char *format, const char *procedure) {
+    if (value->type != SYMBOL_TYPE) {
+        recordError(format, procedure);
+    }
+}
+
+// counts the names in a list of field names. takes in the list and
+// returns its length, or -1 if it is not a proper list
+int countNames(Item *names) {
+    int count = 0;
+    for (; names->type == CONS_TYPE; names = cdr(names)) {
+        count++;
+    }
+    return names->type == NULL_TYPE ? count : -1;
+}
+
+// finds a field of a record type. takes in the type, the field's name and
+// the name of the procedure that wants it, and returns its position
+int findField(RecordType *type, Item *field, const char *procedure) {
+    checkRecordSymbol(field, "%s expects a field name", procedure);
+    for (int i = 0; i < type->fieldCount; i++) {
+        if (type->fields[i] == field->s) {
+            return i;
+        }
+    }
+    int size = snprintf(NULL, 0, "%s has no field %s", type->name, field->s) + 1;
+    char *message = talloc(size);
+    snprintf(message, size, "%s has no field %s", type->name, field->s);
+    evaluationError(message);
+    return -1;
+}
+
+// makes a procedure of a record type. takes in the type, the name it is
+// defined as, its entry point, its arity and the error to report for
+// another number of arguments, with a %s for the name and optionally a %d
+// for the arity, and returns the procedure, whose fields are left for the
+// caller to fill in
+Item *makeRecordProcedure(RecordType *type, Item *name, Item *(*call)(Primitive *, Item **),
+                          int arity, const char *arityFormat) {
+    Primitive *primitive = talloc(sizeof(Primitive));
+    memset(primitive, 0, sizeof(Primitive));
+    primitive->name = name->s;
+    primitive->callRecord = call;
+    primitive->minArgs = arity;
+    primitive->maxArgs = arity;
+    int size = snprintf(NULL, 0, arityFormat, name->s, arity) + 1;
+    char *message = talloc(size);
+    snprintf(message, size, arityFormat, name->s, arity);
+    primitive->arityError = message;
+    primitive->record = type;
+    Item *procedure = talloc(sizeof(Item));
+    procedure->type = PRIMITIVE_TYPE;
+    procedure->pr = primitive;
+    return procedure;
+}
+
+// implements make-record-type. takes in the type's name and the list of
+// its fields' names and returns the type
+Item *primitiveMakeRecordType(Item *name, Item *fields) {
+    checkRecordSymbol(name, "%s expects a symbol as the type name", "make-record-type");
+    if (countNames(fields) < 0) {
+        evaluationError("make-record-type expects a list of field names");
+    }
+    RecordType *type = talloc(sizeof(RecordType));
+    type->name = name->s;
+    type->fieldCount = countNames(fields);
+    type->fields = talloc(sizeof(char *) * (type->fieldCount + 1));
+    int i = 0;
+    for (; fields->type == CONS_TYPE; fields = cdr(fields)) {
+        checkRecordSymbol(car(fields), "%s expects a list of field names", "make-record-type");
+        for (int j = 0; j < i; j++) {
+            if (type->fields[j] == car(fields)->s) {
+                recordError("%s has two fields of the same name", type->name);
+            }
+        }
+        type->fields[i++] = car(fields)->s;
+    }
+    Item *result = talloc(sizeof(Item));
+    result->type = RECORD_TYPE_TYPE;
+    result->rt = type;
+    return result;
+}
+
+// makes a record from a constructor's arguments. takes in the constructor
+// and its arguments and returns the record
+Item *constructRecord(Primitive *self, Item **argv) {
+    RecordType *type = self->record;
+    Item **slots = talloc(sizeof(Item *) * (type->fieldCount + 1));
+    if (self->minArgs < type->fieldCount) {
+        Item *unset = talloc(sizeof(Item));
+        unset->type = BOOL_TYPE;
+        unset->i = 0;
+        for (int i = 0; i < type->fieldCount; i++) {
+            slots[i] = unset;
+        }
+    }
+    for (int i = 0; i < self->minArgs; i++) {
+        slots[self->fields[i]] = argv[i];
+    }
+    Item *record = talloc(sizeof(Item));
+    record->type = RECORD_TYPE;
+    record->rc.type = type;
+    record->rc.slots = slots;
+    return record;
+}
+
+// implements record-constructor. takes in the type, the name the
+// constructor is defined as and the list of the fields it takes, and
+// returns the constructor
+Item *primitiveRecordConstructor(int argc, Item **argv) {
+    RecordType *type = checkRecordType(argv[0], "record-constructor");
+    checkRecordSymbol(argv[1], "%s expects a symbol as the procedure name", "record-constructor");
+    int arity = countNames(argv[2]);
+    if (arity < 0) {
+        evaluationError("record-constructor expects a list of field names");
+    }
+    Item *constructor = makeRecordProcedure(type, argv[1], constructRecord, arity,
+                                            arity == 1 ? "%s expects %d argument" : "%s expects %d arguments");
+    int *fields = talloc(sizeof(int) * (arity + 1));
+    int i = 0;
+    for (Item *names = argv[2]; names->type == CONS_TYPE; names = cdr(names)) {
+        fields[i] = findField(type, car(names), "record-constructor");
+        for (int j = 0; j < i; j++) {
+            if (fields[j] == fields[i]) {
+                recordError("%s takes a field twice", argv[1]->s);
+            }
+        }
+        i++;
+    }
+    constructor->pr->fields = fields;
+    return constructor;
+}
+
+// checks whether a value is a record of a predicate's type. takes in the
+// predicate and the value and returns true or false
+Item *testRecord(Primitive *self, Item **argv) {
+    Item *result = talloc(sizeof(Item));
+    result->type = BOOL_TYPE;
+    result->i = argv[0]->type == RECORD_TYPE && argv[0]->rc.type == self->record;
+    return result;
+}
+
+// implements record-predicate. takes in the type and the name the
+// predicate is defined as, and returns the predicate
+Item *primitiveRecordPredicate(Item *type, Item *name) {
+    RecordType *recordType = checkRecordType(type, "record-predicate");
+    checkRecordSymbol(name, "%s expects a symbol as the procedure name", "record-predicate");
+    return makeRecordProcedure(recordType, name, testRecord, 1, "%s expects one argument");
+}
+
+// checks that a value is a record of a procedure's type. takes in the
+// procedure and the value, and returns the record's fields
+Item **checkRecord(Primitive *self, Item *value) {
+    if (value->type != RECORD_TYPE || value->rc.type != self->record) {
+        int size = snprintf(NULL, 0, "%s expects a %s", self->name, self->record->name) + 1;
+        char *message = talloc(size);
+        snprintf(message, size, "%s expects a %s", self->name, self->record->name);
+        evaluationError(message);
+    }
+    return value->rc.slots;
+}
+
+// reads an accessor's field. takes in the accessor and the record, and
+// returns the field's value
+Item *readField(Primitive *self, Item **argv) {
+    return checkRecord(self, argv[0])[self->fields[0]];
+}
+
+// writes a modifier's field. takes in the modifier, the record and the
+// new value, and returns void
+Item *writeField(Primitive *self, Item **argv) {
+    checkRecord(self, argv[0])[self->fields[0]] = argv[1];
+    return makeVoid();
+}
+
+// makes an accessor or modifier. takes in the arguments, the type, the
+// procedure's name and its field, the name of the primitive making it, its
+// entry point and its arity, and returns the procedure
+Item *makeFieldProcedure(Item **argv, const char *maker, Item *(*call)(Primitive *, Item **), int arity) {
+    RecordType *type = checkRecordType(argv[0], maker);
+    checkRecordSymbol(argv[1], "%s expects a symbol as the procedure name", maker);
+    Item *procedure = makeRecordProcedure(type, argv[1], call, arity,
+                                          arity == 1 ? "%s expects one argument" : "%s expects two arguments");
+    procedure->pr->fields = talloc(sizeof(int));
+    procedure->pr->fields[0] = findField(type, argv[2], maker);
+    return procedure;
+}
+
+// implements record-accessor. takes in the type, the name the accessor is
+// defined as and the field it reads, and returns the accessor
+Item *primitiveRecordAccessor(int argc, Item **argv) {
+    return makeFieldProcedure(argv, "record-accessor", readField, 1);
+}
+
+// implements record-modifier. takes in the type, the name the modifier is
+// defined as and the field it writes, and returns the modifier
+Item *primitiveRecordModifier(int argc, Item **argv) {
+    return makeFieldProcedure(argv, "record-modifier", writeField, 2);
+}
+
+// implements record?. takes in a value and returns whether it is a record
+Item *primitiveIsRecord(Item *value) {
+    Item *result = talloc(sizeof(Item));
+    result->type = BOOL_TYPE;
+    result->i = value->type == RECORD_TYPE;
+    return result;
+}
+
+// prints a record or a record type. takes in the value and does not
+// return anything
+void printRecord(Item *value) {
+    if (value->type == RECORD_TYPE_TYPE) {
+        printf("#<record-type %s>", value->rt->name);
+        return;
+    }
+    printf("#<record %s", value->rc.type->name);
+    for (int i = 0; i < value->rc.type->fieldCount; i++) {
+        printf(" ");
+        printItem(value->rc.slots[i]);
+    }
+    printf(">");
+}
@@ -0,0 +1,37 @@
+#include "item.h"
+
+#ifndef RECORDS_H
+#define RECORDS_H
+
+// A record type: its name and the names of its fields, in the order a
+// record of the type stores them.
+struct RecordType {
+    const char *name;
+    int fieldCount;
+    char **fields;
+};
+
+typedef struct RecordType RecordType;
+
+// Records, after R7RS. define-record-type is rewritten by the expander into
+// calls of the procedures here: make-record-type makes a type from its name
+// and the list of its fields, and record-constructor, record-predicate,
+// record-accessor and record-modifier each make a procedure for a type,
+// taking the name the procedure is defined as to report errors with. A
+// record keeps its fields in an array, and the procedures are primitives
+// that know their type and the position of their field, so reading a field
+// is a check of the record's type and a load from the array. A
+// constructor takes the fields it names, in that order, and the fields it
+// does not take start out #f.
+Item *primitiveMakeRecordType(Item *name, Item *fields);
+Item *primitiveRecordConstructor(int argc, Item **argv);
+Item *primitiveRecordPredicate(Item *type, Item *name);
+Item *primitiveRecordAccessor(int argc, Item **argv);
+Item *primitiveRecordModifier(int argc, Item **argv);
+Item *primitiveIsRecord(Item *value);
+
+// Prints a record as #<record type field ...> and a record type as
+// #<record-type type>.
+void printRecord(Item *value);
+
+#endif
@@ -0,0 +1,296 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "str.h"
+#include "bignum.h"
+#include "interpreter.h"
+#include "linkedlist.h"
+#include "symtab.h"
+#include "talloc.h"
+
+// the strings of one character string-ref returns, made the first time
+// each is asked for
+Item *singleCharacters[256];
+
+// makes a string. takes in its characters and their number, copies them
+// and returns the string
+Item *makeString(const char *chars, long length) {
+    Item *string = talloc(sizeof(Item));
+    string->type = STR_TYPE;
+    string->str.chars = talloc(length + 1);
+    memcpy(string->str.chars, chars, length);
+    string->str.chars[length] = '\0';
+    string->str.length = length;
+    string->str.rope = NULL;
+    return string;
+}
+
+// makes a rope joining two strings. takes in the strings and returns the
+// rope
+Item *makeRope(Item *left, Item *right) {
+    Item *string = talloc(sizeof(Item));
+    string->type = STR_TYPE;
+    string->str.chars = NULL;
+    string->str.length = left->str.length + right->str.length;
+    string->str.rope = talloc(sizeof(Rope));
+    string->str.rope->left = left;
+    string->str.rope->right = right;
+    return string;
+}
+
+// flattens a rope into an ordinary string, in place. a rope built by
+// appending in a loop is as deep as it is long, so its leaves are copied
+// with a stack of the ropes still to visit rather than by recursion.
+// takes in the rope and does not return anything
+void flattenRope(Item *string) {
+    char *chars = talloc(string->str.length + 1);
+    long capacity = 16;
+    long depth = 0;
+    Item **pending = malloc(sizeof(Item *) * capacity);
+    long *offsets = malloc(sizeof(long) * capacity);
+    pending[depth] = string;
+    offsets[depth] = 0;
+    depth++;
+    while (depth > 0) {
+        depth--;
+        Item *piece = pending[depth];
+        long offset = offsets[depth];
+        if (piece->str.rope == NULL) {
+            memcpy(chars + offset, piece->str.chars, piece->str.length);
+            continue;
+        }
+        if (depth + 2 > capacity) {
+            capacity *= 2;
+            pending = realloc(pending, sizeof(Item *) * capacity);
+            offsets = realloc(offsets, sizeof(long) * capacity);
+        }
+        Item *left = piece->str.rope->left;
+        pending[depth] = piece->str.rope->right;
+        offsets[depth] = offset + left->str.length;
+        pending[depth + 1] = left;
+        offsets[depth + 1] = offset;
+        depth += 2;
+    }
+    free(pending);
+    free(offsets);
+    chars[string->str.length] = '\0';
+    string->str.chars = chars;
+    string->str.rope = NULL;
+}
+
+// returns a string's characters, flattening it first if it is a rope.
+// takes in the string
+char *stringChars(Item *string) {
+    if (string->str.rope != NULL) {
+        flattenRope(string);
+    }
+    return string->str.chars;
+}
+
+// checks that a value is a string. takes in the value and the error to
+// report if it is not
+void checkString(Item *value, const char *message) {
+    if (value->type != STR_TYPE) {
+        evaluationError(message);
+    }
+}
+
+// checks that a value is a position in a string. takes in the value, the
+// string's length, whether the position may be the length, as the end of a
+// range can, and the error to report if it is not, and returns the
+// position
+long checkPosition(Item *position, long length, int inclusive, const char *message) {
+    if (position->type != INT_TYPE || position->i < 0 || position->i > length ||
+        (position->i == length && !inclusive)) {
+        evaluationError(message);
+    }
+    return position->i;
+}
+
+// implements string?. takes in a value and returns whether it is a string
+Item *primitiveIsString(Item *value) {
+    Item *result = talloc(sizeof(Item));
+    result->type = BOOL_TYPE;
+    result->i = value->type == STR_TYPE;
+    return result;
+}
+
+// implements string-length. takes in a string and returns its length
+Item *primitiveStringLength(Item *string) {
+    checkString(string, "string-length expects a string");
+    return makeFixnum(string->str.length);
+}
+
+// implements string-ref. takes in a string and an index and returns the
+// string of the one character at the index
+Item *primitiveStringRef(Item *string, Item *index) {
+    checkString(string, "string-ref expects a string");
+    long i = checkPosition(index, string->str.length, 0, "string-ref index out of range");
+    unsigned char c = stringChars(string)[i];
+    if (singleCharacters[c] == NULL) {
+        singleCharacters[c] = makeString((char *)&c, 1);
+    }
+    return singleCharacters[c];
+}
+
+// implements substring. takes in a string, a start and optionally an end,
+// and returns the string of the characters from the start up to but not
+// including the end
+Item *primitiveSubstring(int argc, Item **argv) {
+    checkString(argv[0], "substring expects a string");
+    long length = argv[0]->str.length;
+    long start = checkPosition(argv[1], length, 1, "substring index out of range");
+    long end = argc > 2 ? checkPosition(argv[2], length, 1, "substring index out of range") : length;
+    if (start > end) {
+        evaluationError("substring starts after it ends");
+    }
+    if (start == 0 && end == length) {
+        return argv[0];
+    }
+    return makeString(stringChars(argv[0]) + start, end - start);
+}
+
+// joins two strings, copying them if the result is short and making a
+// rope otherwise. takes in the strings and returns the result
+Item *appendTwo(Item *left, Item *right) {
+    if (left->str.length == 0) {
+        return right;
+    } else if (right->str.length == 0) {
+        return left;
+    }
+    long length = left->str.length + right->str.length;
+    if (length >= ROPE_MINIMUM) {
+        return makeRope(left, right);
+    }
+    char chars[ROPE_MINIMUM];
+    memcpy(chars, stringChars(left), left->str.length);
+    memcpy(chars + left->str.length, stringChars(right), right->str.length);
+    return makeString(chars, length);
+}
+
+// implements string-append. takes in any number of strings and returns
+// the string of all of their characters in order
+Item *primitiveStringAppend(int argc, Item **argv) {
+    Item *result = makeString("", 0);
+    for (int i = 0; i < argc; i++) {
+        checkString(argv[i], "string-append expects strings");
+        result = appendTwo(result, argv[i]);
+    }
+    return result;
+}
+
+// compares two strings byte by byte, a prefix before any longer string.
+// takes in the strings and returns a negative number, 0 or a positive
+// number as the first is less than, equal to or greater than the second
+int compareStrings(Item *a, Item *b) {
+    long shorter = a->str.length < b->str.length ? a->str.length : b->str.length;
+    int order = memcmp(stringChars(a), stringChars(b), shorter);
+    if (order != 0) {
+        return order;
+    }
+    return (a->str.length > b->str.length) - (a->str.length < b->str.length);
+}
+
+// implements string=? and string<?: checks that each string compares to
+// the next as wanted. takes in the arguments, the error to report for one
+// that is not a string, and whether each must be less than the next
+// rather than equal to it
+Item *compareChain(int argc, Item **argv, const char *message, int less) {
+    Item *result = talloc(sizeof(Item));
+    result->type = BOOL_TYPE;
+    result->i = 1;
+    for (int i = 0; i < argc; i++) {
+        checkString(argv[i], message);
+    }
+    for (int i = 0; i + 1 < argc && result->i; i++) {
+        if (less) {
+            result->i = compareStrings(argv[i], argv[i + 1]) < 0;
+        } else {
+            result->i = argv[i]->str.length == argv[i + 1]->str.length &&
+                        compareStrings(argv[i], argv[i + 1]) == 0;
+        }
+    }
+    return result;
+}
+
+Item *primitiveStringEqual(int argc, Item **argv) {
+    return compareChain(argc, argv, "string=? expects strings", 0);
+}
+
+Item *primitiveStringLess(int argc, Item **argv) {
+    return compareChain(argc, argv, "string<? expects strings", 1);
+}
+
+// implements string->symbol. takes in a string and returns the symbol
+// with that name
+Item *primitiveStringToSymbol(Item *string) {
+    checkString(string, "string->symbol expects a string");
+    Item *symbol = talloc(sizeof(Item));
+    symbol->type = SYMBOL_TYPE;
+    symbol->s = intern(stringChars(string));
+    symbol->sc.cell = NULL;
+    symbol->sc.epoch = 0;
+    return symbol;
+}
+
+// implements symbol->string. takes in a symbol and returns its name
+Item *primitiveSymbolToString(Item *symbol) {
+    if (symbol->type != SYMBOL_TYPE) {
+        evaluationError("symbol->string expects a symbol");
+    }
+    return makeString(symbol->s, strlen(symbol->s));
+}
+
+// implements number->string. takes in a number and returns it written as
+// printItem prints it
+Item *primitiveNumberToString(Item *number) {
+    char buffer[64];
+    switch (number->type) {
+        case INT_TYPE:
+            snprintf(buffer, sizeof(buffer), "%ld", number->i);
+            break;
+        case BIGNUM_TYPE: {
+            char *digits = integerToString(number);
+            return makeString(digits, strlen(digits));
+        }
+        case DOUBLE_TYPE:
+            snprintf(buffer, sizeof(buffer), "%f", number->d);
+            break;
+        default:
+            evaluationError("number->string expects a number");
+    }
+    return makeString(buffer, strlen(buffer));
+}
+
+// implements string-split. takes in a string and a separator and returns
+// the list of the pieces of the string between separators
+Item *primitiveStringSplit(Item *string, Item *separator) {
+    checkString(string, "string-split expects a string");
+    checkString(separator, "string-split expects a string as the separator");
+    if (separator->str.length == 0) {
+        evaluationError("string-split expects a separator of at least one character");
+    }
+    const char *chars = stringChars(string);
+    const char *sep = stringChars(separator);
+    long length = string->str.length;
+    long sepLength = separator->str.length;
+    Item *pieces = makeNull();
+    long start = 0;
+    long i = 0;
+    while (i + sepLength <= length) {
+        const char *found = memchr(chars + i, sep[0], length - sepLength + 1 - i);
+        if (found == NULL) {
+            break;
+        }
+        i = found - chars;
+        if (memcmp(found, sep, sepLength) == 0) {
+            pieces = cons(makeString(chars + start, i - start), pieces);
+            i += sepLength;
+            start = i;
+        } else {
+            i++;
+        }
+    }
+    pieces = cons(makeString(chars + start, length - start), pieces);
+    return reverse(pieces);
+}
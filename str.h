@@ -0,0 +1,53 @@
+#include "item.h"
+
+#ifndef STR_H
+#define STR_H
+
+// Strings. A string carries its length, so asking for it costs nothing,
+// and may hold any bytes, NUL among them; its characters are followed by
+// a NUL all the same, so C code can read them as a C string. Strings are
+// never changed once made, so results may share them with arguments.
+//
+// string-append copies short results, but a result of at least
+// ROPE_MINIMUM characters is a rope: a node joining the two strings it was
+// made from, each perhaps a rope itself, which costs the same however long
+// they are. A rope is flattened into an ordinary string, in place, the
+// first time anything needs its characters, in one pass over all of them,
+// so a string built up by appending to it in a loop takes time linear in
+// its length rather than quadratic.
+#define ROPE_MINIMUM 128
+
+// The two halves of a rope.
+struct Rope {
+    struct Item *left;
+    struct Item *right;
+};
+
+typedef struct Rope Rope;
+
+// Makes a string. Takes in its characters and their number, and copies
+// them.
+Item *makeString(const char *chars, long length);
+
+// Returns a string's characters, flattening it first if it is a rope.
+char *stringChars(Item *string);
+
+// There is no character type, so string-ref returns a string of one
+// character. string=? and string<? compare bytes and take two or more
+// strings. substring takes a start and optionally an end, by default the
+// end of the string. string-split takes a string and a non-empty
+// separator and returns the list of the pieces between separators, empty
+// ones included. number->string writes numbers as they print.
+Item *primitiveIsString(Item *value);
+Item *primitiveStringLength(Item *string);
+Item *primitiveStringRef(Item *string, Item *index);
+Item *primitiveSubstring(int argc, Item **argv);
+Item *primitiveStringAppend(int argc, Item **argv);
+Item *primitiveStringEqual(int argc, Item **argv);
+Item *primitiveStringLess(int argc, Item **argv);
+Item *primitiveStringToSymbol(Item *string);
+Item *primitiveSymbolToString(Item *symbol);
+Item *primitiveNumberToString(Item *number);
+Item *primitiveStringSplit(Item *string, Item *separator);
+
+#endif
@@ -0,0 +1,132 @@
+#include <stdint.h>
+#include <string.h>
+#include "symtab.h"
+#include "linkedlist.h"
+#include "talloc.h"
+
+#define INITIAL_CAPACITY 64
+
+// all interned names, stored in an open-addressing table of strings
+static char **internedNames = NULL;
+static int internCapacity = 0;
+static int internCount = 0;
+
+// hashes a string using FNV-1a. takes in a string and returns its hash
+static unsigned int hashString(const char *s) {
+    unsigned int hash = 2166136261u;
+    while (*s) {
+        hash ^= (unsigned char)*s++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// hashes an interned name by its address. takes in a pointer and returns
+// its hash
+static unsigned int hashPointer(const void *p) {
+    uintptr_t bits = (uintptr_t)p;
+    bits ^= bits >> 17;
+    bits *= 0x9E3779B97F4A7C15ull;
+    return (unsigned int)(bits >> 32);
+}
+
+// doubles the size of the intern table and re-inserts every name into it.
+static void growInternTable() {
+    int newCapacity = internCapacity ? internCapacity * 2 : INITIAL_CAPACITY;
+    char **newNames = talloc(sizeof(char *) * newCapacity);
+    memset(newNames, 0, sizeof(char *) * newCapacity);
+    for (int i = 0; i < internCapacity; i++) {
+        char *name = internedNames[i];
+        if (name != NULL) {
+            unsigned int slot = hashString(name) & (newCapacity - 1);
+            while (newNames[slot] != NULL) {
+                slot = (slot + 1) & (newCapacity - 1);
+            }
+            newNames[slot] = name;
+        }
+    }
+    internedNames = newNames;
+    internCapacity = newCapacity;
+}
+
+// looks a name up in the intern table, adding a talloc'd copy the first time
+// it is seen. takes in a string and returns its canonical copy
+char *intern(const char *name) {
+    if (2 * (internCount + 1) > internCapacity) {
+        growInternTable();
+    }
+    unsigned int slot = hashString(name) & (internCapacity - 1);
+    while (internedNames[slot] != NULL) {
+        if (strcmp(internedNames[slot], name) == 0) {
+            return internedNames[slot];
+        }
+        slot = (slot + 1) & (internCapacity - 1);
+    }
+    char *copy = talloc(strlen(name) + 1);
+    strcpy(copy, name);
+    internedNames[slot] = copy;
+    internCount++;
+    return copy;
+}
+
+// creates an empty symbol table and returns it
+SymbolTable *createSymbolTable() {
+    SymbolTable *table = talloc(sizeof(SymbolTable));
+    table->capacity = INITIAL_CAPACITY;
+    table->count = 0;
+    table->cells = talloc(sizeof(Item *) * table->capacity);
+    memset(table->cells, 0, sizeof(Item *) * table->capacity);
+    return table;
+}
+
+// finds the slot for a name: either the slot holding its binding cell or
+// the empty slot where it would be inserted. takes in a table and an
+// interned name and returns the slot index
+static int findSlot(SymbolTable *table, char *name) {
+    unsigned int slot = hashPointer(name) & (table->capacity - 1);
+    while (table->cells[slot] != NULL && car(table->cells[slot])->s != name) {
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+    return slot;
+}
+
+// doubles the capacity of a symbol table. binding cells are moved, not
+// copied, so pointers to them stay valid.
+static void growTable(SymbolTable *table) {
+    Item **oldCells = table->cells;
+    int oldCapacity = table->capacity;
+    table->capacity = oldCapacity * 2;
+    table->cells = talloc(sizeof(Item *) * table->capacity);
+    memset(table->cells, 0, sizeof(Item *) * table->capacity);
+    for (int i = 0; i < oldCapacity; i++) {
+        if (oldCells[i] != NULL) {
+            table->cells[findSlot(table, car(oldCells[i])->s)] = oldCells[i];
+        }
+    }
+}
+
+// looks up the binding cell of a name. takes in a table and an interned name
+// and returns the cell, or NULL if the name is unbound
+Item *tableLookup(SymbolTable *table, char *name) {
+    return table->cells[findSlot(table, name)];
+}
+
+// binds a name to a value, overwriting any existing binding in place. takes
+// in a table, an interned name and a value and returns the binding cell
+Item *tableDefine(SymbolTable *table, char *name, Item *value) {
+    int slot = findSlot(table, name);
+    if (table->cells[slot] != NULL) {
+        table->cells[slot]->c.cdr = value;
+        return table->cells[slot];
+    }
+    if (2 * (table->count + 1) > table->capacity) {
+        growTable(table);
+        slot = findSlot(table, name);
+    }
+    Item *symbol = talloc(sizeof(Item));
+    symbol->type = SYMBOL_TYPE;
+    symbol->s = name;
+    table->cells[slot] = cons(symbol, value);
+    table->count++;
+    return table->cells[slot];
+}
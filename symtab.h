@@ -0,0 +1,33 @@
+#include "item.h"
+
+#ifndef SYMTAB_H
+#define SYMTAB_H
+
+// Returns the canonical copy of a symbol name. Every symbol with the same
+// spelling interns to the same pointer, so interned names can be compared
+// with == instead of strcmp.
+char *intern(const char *name);
+
+// An open-addressing hash table of bindings, keyed by interned symbol name.
+// Each slot holds a binding cell, the same (symbol . value) cons cell that
+// ordinary frames keep in their alist, so a binding can be updated in place
+// by overwriting the cdr of its cell.
+struct SymbolTable {
+    struct Item **cells;
+    int capacity;
+    int count;
+};
+
+typedef struct SymbolTable SymbolTable;
+
+// Create an empty symbol table.
+SymbolTable *createSymbolTable();
+
+// Return the binding cell for an interned name, or NULL if it is unbound.
+Item *tableLookup(SymbolTable *table, char *name);
+
+// Bind an interned name to a value. An existing binding is updated in place
+// rather than shadowed. Returns the binding cell.
+Item *tableDefine(SymbolTable *table, char *name, Item *value);
+
+#endif
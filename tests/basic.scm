@@ -0,0 +1,33 @@
+(define x 3)
+(+ x 2)
+(if #t 1 2)
+(if #f 1 2)
+(define f (lambda (n) (if (= n 0) 0 (f (- n 1)))))
+(f 100)
+(let ((x 1) (y 2)) (+ x y))
+(let ((x 1)) x)
+(cond ((< 1 2) 5) (else 6))
+(define l (cons 1 (cons 2 (quote ()))))
+l
+(car l)
+(cdr l)
+(define x 10)
+x
+(define fact (lambda (n) (if (= n 0) 1 (* n (fact (- n 1))))))
+(fact 10)
+(letrec ((even (lambda (n) (if (= n 0) #t (odd (- n 1))))) (odd (lambda (n) (if (= n 0) #f (even (- n 1)))))) (even 10))
+(let* ((a 1) (b (+ a 1))) (* a b))
+(define c 0)
+(set! c 5)
+c
+(append (quote (1 2)) (quote (3 4)))
+(and #t #f)
+(or #f #t)
+(/ 7 2)
+(modulo 7 3)
+(- 3.5 1)
+(null? (quote ()))
+(define p (cons 1 2))
+(set-car! p 5)
+p
+(> 3 2)
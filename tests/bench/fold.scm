@@ -0,0 +1,12 @@
+(define scale (lambda (n) (let ((k 3) (offset (* 10 3))) (+ (* n k) offset))))
+(define classify
+  (lambda (n)
+    (cond ((> 1 2) 0)
+          ((and #t (< n (* 10 10))) 1)
+          (else (if (or #f (= 1 1)) 2 3)))))
+(define loop
+  (lambda (i acc)
+    (if (= i 0)
+        acc
+        (loop (- i 1) (+ acc (scale i) (classify i) (- (* 2 3) 2))))))
+(loop 20000 0)
@@ -0,0 +1,57 @@
+(define fact (lambda (n) (if (= n 0) 1 (* n (fact (- n 1))))))
+(fact 20)
+(fact 21)
+(fact 30)
+(fact 100)
+(define expt2 (lambda (n) (if (= n 0) 1 (* 2 (expt2 (- n 1))))))
+(expt2 62)
+(expt2 63)
+(expt2 64)
+(expt2 100)
+(- 0 (expt2 63))
+(- (- 0 (expt2 63)) 1)
+(+ 9223372036854775807 1)
+(- -9223372036854775807 2)
+(* 3037000500 3037000500)
+123456789012345678901234567890
+-123456789012345678901234567890
+(+ 123456789012345678901234567890 -123456789012345678901234567890)
+(- (+ (expt2 100) 5) (expt2 100))
+(< (expt2 100) (expt2 101))
+(> (- 0 (expt2 100)) 5)
+(= (expt2 70) (* (expt2 35) (expt2 35)))
+(= (expt2 70) 5)
+(< 5 (expt2 70))
+(modulo (fact 30) 1000007)
+(modulo (fact 40) (expt2 70))
+(modulo (- 0 (fact 30)) 97)
+(modulo (fact 25) (fact 24))
+(/ (expt2 100) (expt2 98))
+(+ (expt2 80) 0.5)
+(* (fact 25) 1.0)
+(+ 1 2 3 (expt2 64) 4)
+(* 2 3 (expt2 62) 4)
+(define fib (lambda (n a b) (if (= n 0) a (fib (- n 1) b (+ a b)))))
+(fib 100 0 1)
+(fib 300 0 1)
+(define big (fact 400))
+(= (modulo (* big big) big) 0)
+(define square (lambda (x) (* x x)))
+(- (square (+ big 1)) (+ (square big) (* 2 big)))
+(modulo (square (fact 300)) 1000000007)
+(define sum (lambda (n acc) (if (= n 0) acc (sum (- n 1) (+ acc 4611686018427387904)))))
+(sum 10 0)
+(let loop ((i 0) (acc 1)) (if (= i 70) acc (loop (+ i 1) (* acc 2))))
+(modulo 7 -3)
+(modulo -7 3)
+(modulo (fact 30) (- 0 (expt2 70)))
+(modulo (- 0 (fact 30)) (- 0 (expt2 70)))
+(modulo (- 0 (fact 30)) (expt2 70))
+(modulo (- 0 (expt2 64)) 7)
+(modulo (expt2 64) -7)
+(* (fact 500) (fact 450))
+(* (- 0 (fact 300)) (+ (fact 310) 1))
+(- (* (+ (expt2 2000) 1) (- (expt2 2000) 1)) (* (expt2 2000) (expt2 2000)))
+123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890
+(- 123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890 1)
+-98765432109876543210987654321098765432109876543210987654321098765432109876543210
@@ -0,0 +1,3 @@
+(define saved #f)
+(+ 1 (call/cc (lambda (k) (set! saved k) 1)))
+(saved 5)
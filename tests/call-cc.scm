@@ -0,0 +1,6 @@
+(define f (lambda (n) (if (= n 0) 0 (+ 1 (call/ec (lambda (k) (f (- n 1))))))))
+(f 100000)
+(define g (lambda (n) (if (= n 0) 0 (+ 1 (call/cc (lambda (k) (k (g (- n 1)))))))))
+(g 1000)
+(+ 1 (call/cc (lambda (k) (+ 2 (k 40)))))
+(f 10000000)
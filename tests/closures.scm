@@ -0,0 +1,61 @@
+(define make-counter
+  (lambda ()
+    (let ((n 0))
+      (lambda () (set! n (+ n 1)) n))))
+(define c1 (make-counter))
+(define c2 (make-counter))
+(c1)
+(c1)
+(c2)
+(c1)
+(define adder (lambda (a) (lambda (b) (lambda (c) (+ a (+ b c))))))
+(((adder 1) 2) 3)
+(define f
+  (lambda (n)
+    (define even? (lambda (k) (if (= k 0) #t (odd? (- k 1)))))
+    (define odd? (lambda (k) (if (= k 0) #f (even? (- k 1)))))
+    (even? n)))
+(f 10)
+(f 7)
+(define g
+  (lambda (x)
+    (let ((get (lambda () x)))
+      (set! x (* x 2))
+      (get))))
+(g 21)
+(define h
+  (lambda (x)
+    (letrec ((loop (lambda (i acc) (if (= i 0) acc (loop (- i 1) (+ acc x))))))
+      (loop 10 0))))
+(h 3)
+(define pair
+  (lambda (v)
+    (let ((get (lambda () v)) (put (lambda (w) (set! v w))))
+      (cons get put))))
+(define p (pair 5))
+((car p))
+((cdr p) 9)
+((car p))
+(define rest (lambda args (lambda () args)))
+((rest 1 2 3))
+(define outer
+  (lambda (a)
+    (lambda (b)
+      (let* ((c (+ a b)) (k (lambda () (set! a (+ a 100)) (+ a c))))
+        (k)))))
+((outer 1) 2)
+(define shadow
+  (lambda (x)
+    (let ((f (lambda () x)))
+      (let ((x 50))
+        (+ x (f))))))
+(shadow 1)
+(define acc
+  (lambda (lst)
+    (let ((total 0))
+      (letrec ((walk (lambda (l) (cond ((null? l) total) (else (set! total (+ total (car l))) (walk (cdr l)))))))
+        (walk lst)))))
+(acc (quote (1 2 3 4)))
+(define deep (lambda (a) (lambda (b) (lambda (c) (lambda (d) (set! a (+ a d)) (list a b c d))))))
+(define list (lambda args args))
+((((deep 1) 2) 3) 4)
@@ -0,0 +1,53 @@
+(call/ec (lambda (k) (+ 1 (k 42))))
+(call/ec (lambda (k) 5))
+(define find-first
+  (lambda (pred lst)
+    (call/ec
+      (lambda (return)
+        (letrec ((walk (lambda (l) (if (null? l) #f (if (pred (car l)) (return (car l)) (walk (cdr l)))))))
+          (walk lst))))))
+(find-first (lambda (x) (> x 3)) (quote (1 2 5 7)))
+(find-first (lambda (x) (> x 30)) (quote (1 2 5 7)))
+(define deep
+  (lambda (n k) (if (= n 0) (k (quote bottom)) (+ 1 (deep (- n 1) k)))))
+(call/cc (lambda (k) (deep 100000 k)))
+(define saved #f)
+(call/cc (lambda (k) (set! saved k) 1))
+(call/ec (lambda (outer) (+ 1 (call/ec (lambda (inner) (outer 10))))))
+(call/ec (lambda (outer) (+ 1 (call/ec (lambda (inner) (inner 10))))))
+(define counter
+  (lambda (n)
+    (make-generator (lambda (yield) (let loop ((i 0)) (if (< i n) (let ((u (yield i))) (loop (+ i 1))) (quote done)))))))
+(define g (counter 3))
+(g)
+(g)
+(g)
+(g)
+(g)
+(eof-object? (g))
+(eof-object)
+(define sum-gen
+  (lambda (g acc) (let ((v (g))) (if (eof-object? v) acc (sum-gen g (+ acc v))))))
+(sum-gen (counter 50000) 0)
+(define zip
+  (lambda (a b) (let ((x (a)) (y (b))) (if (eof-object? x) (quote ()) (cons (cons x y) (zip a b))))))
+(zip (counter 4) (counter 5))
+(define nested
+  (make-generator
+    (lambda (yield)
+      (let ((inner (counter 3)))
+        (let loop ((v (inner)))
+          (if (eof-object? v) 0 (let ((u (yield (* v 10)))) (loop (inner)))))))))
+(nested)
+(nested)
+(nested)
+(nested)
+(define early
+  (make-generator
+    (lambda (yield)
+      (call/ec (lambda (stop) (yield 1) (stop 0) (yield 2)))
+      (yield 3))))
+(early)
+(early)
+(early)
+(saved 5)
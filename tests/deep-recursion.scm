@@ -0,0 +1,10 @@
+(define build (lambda (n) (if (= n 0) (quote ()) (cons n (build (- n 1))))))
+(define sum (lambda (l) (if (null? l) 0 (+ (car l) (sum (cdr l))))))
+(define big (build 1000000))
+(sum big)
+(define map1 (lambda (f l) (if (null? l) (quote ()) (cons (f (car l)) (map1 f (cdr l))))))
+(car (map1 (lambda (x) (* x 2)) big))
+(car (append big (quote (1))))
+(let ((a (+ 1 (+ 2 (+ 3 4))))) a)
+(define ack (lambda (m n) (cond ((= m 0) (+ n 1)) ((= n 0) (ack (- m 1) 1)) (else (ack (- m 1) (ack m (- n 1)))))))
+(ack 2 3)
@@ -0,0 +1,9 @@
+(define nest (lambda (n acc) (if (= n 0) acc (nest (- n 1) (cons acc (quote ()))))))
+(define a (nest 1000 0))
+(equal? a (nest 1000 0))
+(equal? a (nest 1000 1))
+(define t (make-hash-table))
+(hash-table-set! t a 1)
+(hash-table-ref/default t (nest 1000 0) #f)
+(define b (nest 1000000 0))
+(equal? b (nest 1000000 0))
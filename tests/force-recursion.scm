@@ -0,0 +1,3 @@
+(define f (lambda (n) (if (= n 0) 0 (+ 1 (force (delay (f (- n 1))))))))
+(f 100000)
+(f 10000000)
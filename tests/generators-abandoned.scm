@@ -0,0 +1,8 @@
+(define counter (lambda () (make-generator (lambda (yield) (let loop ((i 0)) (let ((u (yield i))) (loop (+ i 1))))))))
+(define first-two (lambda (g) (+ (g) (g))))
+(define run (lambda (n acc) (if (= n 0) acc (run (- n 1) (+ acc (first-two (counter)))))))
+(run 40000 0)
+(define finite (lambda () (make-generator (lambda (yield) (yield 1) 2))))
+(define drain (lambda (g) (let ((a (g)) (b (g)) (c (g))) (eof-object? c))))
+(define finish (lambda (n) (if (= n 0) #t (if (drain (finite)) (finish (- n 1)) #f))))
+(finish 40000)
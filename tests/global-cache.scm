@@ -0,0 +1,19 @@
+(define x 1)
+(define g (lambda () x))
+(g)
+(define f (lambda () (define x 2) (g)))
+(f)
+(define h (lambda () (define k (lambda () x)) (define a (k)) (define x 5) (cons a (k))))
+(h)
+(h)
+(set! x 7)
+(g)
+(define x 8)
+(g)
+(define a 1)
+(define b a)
+(set! a 2)
+b
+(define sq (lambda (n) (* n n)))
+(set! sq (lambda (n) (+ n n)))
+(sq 5)
@@ -0,0 +1,5 @@
+(define t (make-hash-table))
+(define f (lambda (n) (if (= n 0) 0 (+ 1 (hash-table-ref t n (lambda () (f (- n 1))))))))
+(f 100000)
+(define h (lambda (n) (if (= n 0) 0 (+ 1 (hash-table-ref t n (lambda () (h (- n 1))))))))
+(h 10000000)
@@ -0,0 +1,9 @@
+(define t (make-hash-table))
+(hash-table-set! t 1 1)
+(define depth 0)
+(define f (lambda (n) (if (= n 0) 0 ((lambda () (set! depth (+ depth 1)) (hash-table-walk t (lambda (k v) (f (- n 1)))))))))
+(f 100000)
+depth
+(define g (lambda (n) (if (= n 0) 0 ((lambda () (hash-table-update!/default t 2 (lambda (v) (+ 1 (g (- n 1)))) 0) (hash-table-ref t 2))))))
+(g 100000)
+(f 10000000)
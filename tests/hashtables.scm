@@ -0,0 +1,57 @@
+(eq? (quote a) (quote a))
+(eq? 1 1)
+(eq? "a" "a")
+(eqv? 2.5 2.5)
+(eqv? 100000000000000000000 100000000000000000000)
+(eq? 2.5 2.5)
+(equal? (quote (1 (2 "x") #(3 4))) (quote (1 (2 "x") #(3 4))))
+(equal? (quote (1 2)) (quote (1 3)))
+(equal? (string-append "ab" "c") "abc")
+(equal? (f64vector 1 2) (f64vector 1 2))
+(define h (make-hash-table))
+(hash-table? h)
+(hash-table-set! h "one" 1)
+(hash-table-set! h (quote (a b)) 2)
+(hash-table-set! h 3 "three")
+(hash-table-ref h "one")
+(hash-table-ref h (quote (a b)))
+(hash-table-ref h 3)
+(hash-table-ref h 4 (lambda () (quote missing)))
+(hash-table-ref/default h 5 0)
+(hash-table-count h)
+(hash-table-delete! h "one")
+(hash-table-contains? h "one")
+(hash-table-count h)
+(define counts (make-hash-table eq?))
+(define tally (lambda (l) (if (null? l) (hash-table->alist counts) (tally-one l))))
+(define tally-one (lambda (l) (hash-table-update!/default counts (car l) (lambda (n) (+ n 1)) 0) (tally (cdr l))))
+(tally (quote (a b a c b a)))
+(define model (make-vector 3000 #f))
+(define t (make-hash-table eqv?))
+(define fill (lambda (i)
+  (if (< i 20000)
+      (let ((k (modulo (* i 7919) 3000)))
+        (if (= (modulo i 3) 0)
+            (let () (hash-table-delete! t k) (vector-set! model k #f))
+            (let () (hash-table-set! t k i) (vector-set! model k i)))
+        (fill (+ i 1)))
+      #t)))
+(fill 0)
+(define check (lambda (k bad)
+  (if (= k 3000) bad
+      (check (+ k 1) (if (equal? (hash-table-ref/default t k #f) (vector-ref model k)) bad (+ bad 1))))))
+(check 0 0)
+(define live (lambda (k n) (if (= k 3000) n (live (+ k 1) (if (eq? (vector-ref model k) #f) n (+ n 1))))))
+(= (live 0 0) (hash-table-count t))
+(define sum 0)
+(hash-table-walk t (lambda (k v) (set! sum (+ sum k))))
+sum
+(define big (make-hash-table))
+(define put (lambda (i) (if (< i 100000) (let () (hash-table-set! big (number->string i) i) (put (+ i 1))) #t)))
+(put 0)
+(hash-table-count big)
+(hash-table-ref big "77777")
+(define s (make-hash-table string=?))
+(hash-table-set! s (string-append "ke" "y") 1)
+(hash-table-ref s "key")
+h
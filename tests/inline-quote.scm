@@ -0,0 +1,13 @@
+(define cell (lambda () (quote (0))))
+(set-car! (cell) 5)
+(car (cell))
+(define q (lambda () (quote (a b))))
+(eq? (q) (q))
+(define wrap (lambda (x) (cons x (quote (tail)))))
+(eq? (cdr (wrap 1)) (cdr (wrap 2)))
+(define name (lambda () (quote name)))
+(eq? (name) (quote name))
+(define text (lambda () "text"))
+(eq? (text) (text))
+(define v (lambda () (quote #(1 2))))
+(eq? (v) (v))
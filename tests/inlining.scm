@@ -0,0 +1,61 @@
+(define square (lambda (x) (* x x)))
+(define add3 (lambda (a b c) (+ a (+ b c))))
+(define twice (lambda (f v) (f (f v))))
+(define sumsq (lambda (p q) (+ (square p) (square q))))
+(square 7)
+(sumsq 3 4)
+(add3 1 2 3)
+(define y 10)
+(add3 y (square y) (car (cons 5 6)))
+(twice square 3)
+(define g (lambda (b) (let ((a 1)) (add3 a b b))))
+(g 4)
+(define h (lambda (x) (let ((y 2)) (square (+ x y)))))
+(h 3)
+(define shadow (lambda (*) (square *)))
+(shadow 5)
+(define swap (lambda (a b) (cons b a)))
+(define k (lambda (a b) (swap b a)))
+(k 1 2)
+(define m (lambda (b) (swap b (car (cons 9 0)))))
+(m 1)
+(define fact (lambda (n) (if (= n 0) 1 (* n (fact (- n 1))))))
+(fact 5)
+(define even (lambda (n) (if (= n 0) #t (odd (- n 1)))))
+(define odd (lambda (n) (if (= n 0) #f (even (- n 1)))))
+(even 10)
+(define later (lambda () (cube 2)))
+(define cube (lambda (x) (* x (square x))))
+(later)
+(cube 3)
+(define redef (lambda (x) (+ x 1)))
+(redef 1)
+(define redef (lambda (x) (+ x 2)))
+(redef 1)
+(define mut (lambda (x) (- x 1)))
+(mut 5)
+(set! mut (lambda (x) (- x 100)))
+(mut 5)
+(define konst (lambda (v) (lambda () v)))
+(define k1 (konst 1))
+(define k2 (konst (square 3)))
+(cons (k1) (k2))
+(define use (lambda (v w) (let ((v2 (konst v)) (w2 (konst w))) (+ (v2) (w2)))))
+(use 3 4)
+(use 5 6)
+(define cap (lambda (p) (let ((q 1)) (add3 p q q))))
+(cap 10)
+(define loc (lambda (n) (define z (square n)) (+ z 1)))
+(loc 4)
+(define bump (lambda (n) (set! n (+ n 1)) n))
+(define uses-bump (lambda (m) (bump m)))
+(uses-bump 41)
+(define inner (lambda (x) (let ((x (+ x 1))) (* x 2))))
+(define w 5)
+(inner w)
+(let ((x 3)) (inner x))
+(let ((x 3)) (square x))
+(define callx (lambda (fn) (fn 2)))
+(callx square)
+(let ((square (lambda (x) 0))) (square 5))
+(square 1 2)
@@ -0,0 +1,47 @@
+(define x 1)
+(define r1
+  (lambda (x)
+    (let ((f (lambda () x)))
+      (define y (f))
+      (define x 10)
+      (+ y (f)))))
+(r1 5)
+(define append (lambda (a b) 99))
+(define r2
+  (lambda ()
+    (define g (lambda () (append 1 2)))
+    (define append (lambda (a b) (+ a b)))
+    (g)))
+(r2)
+(define r3
+  (lambda (n)
+    (define a 1)
+    (define get (lambda () a))
+    (define a 2)
+    (get)))
+(r3 0)
+(define r4
+  (lambda (v)
+    (let* ((a v) (b (lambda () a)) (a 7))
+      (+ a (b)))))
+(r4 3)
+(define r5
+  (lambda (k)
+    (let ((getter (lambda () k)))
+      (set! k (+ k 1))
+      (getter))))
+(r5 1)
+(define r6
+  (lambda (z)
+    (cond ((= z 0) (define w 5) w)
+          (else (let ((h (lambda () z))) (h))))))
+(r6 0)
+(r6 4)
+(define r7 (lambda (q) (lambda () (quote q))))
+((r7 1))
+(define r8
+  (lambda (p)
+    (define helper (lambda () (later)))
+    (define later (lambda () (* p 3)))
+    (helper)))
+(r8 5)
@@ -0,0 +1,36 @@
+(define add (lambda (a b) (+ a b)))
+(add 1 2)
+(add 1.5 2)
+(add 2147483647 1)
+(define cmp (lambda (a b) (if (< a b) (quote lt) (if (= a b) (quote eq) (quote gt)))))
+(cmp 1 2)
+(cmp 2.5 2.5)
+(cmp 3 1)
+(define mul (lambda (a b) (* a b)))
+(mul 6 7)
+(mul 65536 65536)
+(define sub (lambda (a b) (- a b)))
+(sub 10 3)
+(define + -)
+(add 10 3)
+(define twice (lambda (f x) (f (f x))))
+(twice (lambda (n) (* n 2)) 5)
+(define lst (lambda (n) (if (= n 0) (quote ()) (cons n (lst (- n 1))))))
+(lst 5)
+(define andor (lambda (a b) (cons (and a b) (or a b))))
+(andor #t #f)
+(define cnd (lambda (x) (cond ((= x 1) (quote one)) ((= x 2)) (else (quote many)))))
+(cnd 1)
+(cnd 2)
+(cnd 3)
+(define sc (lambda (p) (set-car! p 9) (set-cdr! p 8) p))
+(sc (cons 1 2))
+(define counter (let ((n 0)) (lambda () (set! n (+ n 1)) n)))
+(counter)
+(counter)
+(define g 5)
+(define setg (lambda (v) (set! g v) g))
+(setg 6)
+(define defg (lambda () (let ((h 1)) (define k (+ h 1)) k)))
+(defg)
+(add (quote a) 1)
@@ -0,0 +1,58 @@
+(let loop ((i 0) (acc 0))
+  (if (= i 10) acc (loop (+ i 1) (+ acc i))))
+(do ((i 0 (+ i 1)) (acc (quote ()) (cons i acc))) ((= i 5) acc))
+(do ((vec 3) (i 0 (+ i 1))) ((= i 3) vec))
+(define count-up (lambda (n)
+  (let loop ((i 0) (acc (quote ())))
+    (if (= i n) acc (loop (+ i 1) (cons i acc))))))
+(count-up 4)
+(define sum-to (lambda (n)
+  (let loop ((i 0) (acc 0))
+    (cond ((> i n) acc)
+          (else (loop (+ i 1) (+ acc i)))))))
+(sum-to 100000)
+(let loop ((i 0) (s 0)) (if (= i 3000) s (loop (+ i 1) (+ s i))))
+(define fact (lambda (n)
+  (let f ((n n))
+    (if (= n 0) 1 (* n (f (- n 1)))))))
+(fact 10)
+(define procs
+  (let loop ((i 0) (acc (quote ())))
+    (if (= i 3) acc (loop (+ i 1) (cons (lambda () i) acc)))))
+((car procs))
+((car (cdr procs)))
+(define nested (lambda (n)
+  (let outer ((i 0) (total 0))
+    (if (= i n) total
+        (let inner ((j 0) (t total))
+          (if (= j i) (outer (+ i 1) t) (inner (+ j 1) (+ t 1))))))))
+(nested 50)
+(let loop ((loop 1)) loop)
+(let loop ((i 0))
+  (let ((loop 5)) (+ loop i)))
+(define evens (lambda (lst)
+  (let loop ((lst lst) (acc (quote ())))
+    (cond ((null? lst) acc)
+          ((= 0 (modulo (car lst) 2)) (loop (cdr lst) (cons (car lst) acc)))
+          (else (loop (cdr lst) acc))))))
+(evens (quote (1 2 3 4 5 6)))
+(define x 0)
+(do ((i 0 (+ i 1))) ((= i 4)) (set! x (+ x i)))
+x
+(let loop ((i 0) (acc 1))
+  (and (< i 100) (or (= i 5) (loop (+ i 1) acc))))
+(let ((do 5)) do)
+(define g (lambda (n) (let loop ((i 0)) (if (< i n) (loop (+ i 1)) i))))
+(g 5000)
+(define h (lambda (n) (let loop ((i 0) (j 0)) (if (< i n) (loop (+ i 1) (+ j i)) j))))
+(h 10)
+(h 20)
+(define set-loop (lambda (n)
+  (let loop ((i 0) (acc 0))
+    (if (< i n) ((lambda () (set! i (+ i 2)) (loop i (+ acc i)))) acc))))
+(set-loop 10)
+(do ((i 0 (+ i 1))) ((= i 5)))
+(cons (do ((i 0 (+ i 1))) ((= i 2))) 1)
+(do ((i 0 (+ i 1)) (acc 1 (* acc 2))) ((= i 10) acc))
+(let loop ((i 0) (acc 0)) (if (< i 3) (loop (+ i 1) (let ((u (set! i (+ i 10)))) (+ acc i))) acc))
+(let loop ((i 0)) (if (< i 3) (loop (+ i 1) 2) i))
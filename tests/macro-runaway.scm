@@ -0,0 +1,2 @@
+(define-syntax inf (syntax-rules () ((_ x) (inf (x)))))
+(inf 1)
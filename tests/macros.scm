@@ -0,0 +1,81 @@
+(define-syntax swap!
+  (syntax-rules ()
+    ((_ a b) (let ((tmp a)) (set! a b) (set! b tmp)))))
+(define tmp 1)
+(define other 2)
+(swap! tmp other)
+tmp
+other
+
+(define-syntax my-or
+  (syntax-rules ()
+    ((_) #f)
+    ((_ e) e)
+    ((_ e r ...) (let ((t e)) (if t t (my-or r ...))))))
+(define t 5)
+(my-or #f t)
+(let ((t 7)) (my-or #f t))
+
+(define-syntax my-let*
+  (syntax-rules ()
+    ((_ () body ...) (let () body ...))
+    ((_ ((x v) rest ...) body ...) (let ((x v)) (my-let* (rest ...) body ...)))))
+(my-let* ((a 1) (b (+ a 1)) (c (* b 3))) (+ a b c))
+
+(define-syntax while
+  (syntax-rules ()
+    ((_ cond body ...)
+     (letrec ((loop (lambda () (if cond (begin body ... (loop)) #f)))) (loop)))))
+(define-syntax begin
+  (syntax-rules ()
+    ((_ e) e)
+    ((_ e r ...) (let ((ignored e)) (begin r ...)))))
+(define i 0)
+(define total 0)
+(while (< i 5) (set! total (+ total i)) (set! i (+ i 1)))
+total
+
+(define-syntax my-if
+  (syntax-rules (then else)
+    ((_ c then a else b) (cond (c a) (else b)))))
+(my-if #t then 1 else 2)
+(my-if #f then 1 else 2)
+
+(define f
+  (lambda (x)
+    (define-syntax double
+      (syntax-rules () ((_ e) (* 2 e))))
+    (define y (double x))
+    (+ y 1)))
+(f 10)
+
+(define-syntax inc!
+  (syntax-rules ()
+    ((_ v) (set! v (+ v 1)))
+    ((_ v n) (set! v (+ v n)))))
+(define g
+  (lambda (+)
+    (define z 1)
+    (inc! z 2)
+    z))
+(g -)
+
+(define-syntax my-list-pairs
+  (syntax-rules ()
+    ((_ (a b) ...) (quote ((b a) ...)))))
+(my-list-pairs (1 2) (3 4) (x y))
+
+(define-syntax unless
+  (syntax-rules ()
+    ((_ c body ...) (if c #f (let () body ...)))))
+(define k
+  (lambda (if) (unless #f if)))
+(k 42)
+
+(define-syntax ten (syntax-rules () ((_) 10)))
+(define-syntax add-ten (syntax-rules () ((_ e) (+ e (ten)))))
+(let ((ten 3)) (add-ten ten))
+(define-syntax nest
+  (syntax-rules ()
+    ((_ (a ...) ...) (+ 0 a ... ...))))
+(nest (1 2) (3) (4 5 6))
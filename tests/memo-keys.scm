@@ -0,0 +1,13 @@
+(define calls 0)
+(define id (memoize (lambda (x) (set! calls (+ calls 1)) x)))
+(define fill
+  (lambda (i n)
+    (if (= i n)
+        calls
+        (if (= (id (* i 4294967296)) (* i 4294967296)) (fill (+ i 1) n) #f))))
+(fill 0 20000)
+(fill 0 20000)
+(memo-stats id)
+(id (make-vector 2 1))
+(id (make-vector 2 1))
+(memo-stats id)
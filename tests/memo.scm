@@ -0,0 +1,50 @@
+(define-memoized fib
+  (lambda (n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2))))))
+(fib 30)
+(memo-stats fib)
+(fib 30)
+(memo-stats fib)
+(define calls 0)
+(define slow-add (lambda (a b) (set! calls (+ calls 1)) (+ a b)))
+(define fast-add (memoize slow-add))
+(fast-add 1 2)
+(fast-add 1 2)
+(fast-add 2 1)
+calls
+(define len (memoize (lambda (l) (set! calls (+ calls 1)) (if (null? l) 0 (+ 1 (len (cdr l)))))))
+(len (quote (1 2 3)))
+(len (cons 1 (cons 2 (cons 3 (quote ())))))
+(len (quote (a b c)))
+(memo-stats len)
+calls
+(define sq (memoize (lambda (x) (set! calls (+ calls 1)) (* x x)) 2 (quote lru)))
+(sq 1)
+(sq 2)
+(sq 1)
+(sq 3)
+(sq 1)
+(sq 2)
+(memo-stats sq)
+(define sqf (memoize (lambda (x) (* x x)) 2 (quote fifo)))
+(sqf 1)
+(sqf 2)
+(sqf 1)
+(sqf 3)
+(sqf 1)
+(memo-stats sqf)
+(memo-clear! sqf)
+(memo-stats sqf)
+(sqf 2.5)
+(sqf 2.5)
+(memo-stats sqf)
+(define mcar (memoize car))
+(mcar (quote (9 8)))
+(mcar (quote (9 8)))
+(memo-stats mcar)
+(let ((paths (memoize (lambda (i j) 0))))
+  (define-memoized grid (lambda (i j) (if (= i 0) 1 (if (= j 0) 1 (+ (grid (- i 1) j) (grid i (- j 1)))))))
+  (grid 16 16))
+fib
+(define-memoized deep (lambda (n) (if (= n 0) 0 (+ 1 (deep (- n 1))))))
+(deep 20000)
+(memoize 5)
@@ -0,0 +1,5 @@
+(define car 0)
+(define walked (lambda (n) (define car (lambda (x) x)) (if (= n 0) 0 (+ 1 (compiled (- n 1))))))
+(define compiled (lambda (n) (if (= n 0) 0 (+ 1 (walked (- n 1))))))
+(compiled 100000)
+(compiled 10000000)
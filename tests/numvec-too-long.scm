@@ -0,0 +1,4 @@
+(define s (make-s64vector 3 7))
+s
+(s64vector-sum s)
+(make-s64vector 2305843009213693952)
@@ -0,0 +1,44 @@
+(define b (make-bytevector 4 7))
+b
+(bytevector-u8-set! b 1 255)
+(bytevector-u8-ref b 1)
+(bytevector-length b)
+(bytevector? b)
+(bytevector? (vector 1))
+(bytevector 1 2 3)
+(bytevector-copy b 1 3)
+(bytevector-fill! b 9 2)
+b
+(define s (s64vector 1 2 3 4 5))
+s
+(s64vector-sum s)
+(s64vector-dot s s)
+(s64vector-add s s)
+(s64vector-mul s s)
+(s64vector-scale s -3)
+(s64vector-min s)
+(s64vector-max s)
+(s64vector->list s)
+(list->s64vector (quote (9 8 7)))
+(define big (make-s64vector 10 4611686018427387904))
+(s64vector-sum big)
+(s64vector-dot big big)
+(s64vector-copy s 2)
+(define f (make-f64vector 37 0.5))
+(f64vector-set! f 3 -2)
+(f64vector-set! f 36 9.25)
+(f64vector-sum f)
+(f64vector-min f)
+(f64vector-max f)
+(f64vector-dot f f)
+(f64vector-ref (f64vector-add f f) 36)
+(f64vector-ref (f64vector-mul f f) 3)
+(f64vector-ref (f64vector-scale f 4) 36)
+(f64vector 1 2.5 3)
+(f64vector->list (f64vector 1 2))
+(list->f64vector (quote (1 2 3)))
+(define g (make-f64vector 100000 0.1))
+(f64vector-sum g)
+(f64vector-length g)
+(f64vector-fill! g 1.0 0 50000)
+(f64vector-sum g)
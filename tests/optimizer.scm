@@ -0,0 +1,38 @@
+(+ 1 2)
+(* 2 3 4)
+(- 10 4)
+(/ 7 2)
+(/ 1 0.5)
+(modulo 17 5)
+(< 1 2)
+(= 3 3.0)
+(if (< 1 2) (quote yes) (quote no))
+(if #f 1 (+ 2 3))
+(cond (#f 1) ((> 1 2) 2) (#t 3) (else 4))
+(cond (#f 1) (else (+ 1 1)))
+(cond ((= 1 1)))
+(let ((x 5) (y 6)) (+ x y))
+(let () (+ 1 2))
+(let ((z (car (cons 1 2)))) z)
+(and #t #t (< 1 2) (quote done))
+(or #f #f)
+(and)
+(define f (lambda (n) (if (< n 1) 0 (+ n (f (- n 1))))))
+(f (+ 5 5))
+(let ((if 3)) if)
+(let ((x 1)) (define y 2) (+ x y))
+(let ((q 1)) (set! q 2) q)
+(quote (+ 1 2))
+(let ((s "str")) s)
+(+ 1 (- 2 3))
+(let* ((x 1) (x (+ x 1)) (y (* x 10))) (cons x y))
+(let* ((x 1) (x (car (cons x 2))) (y x)) (cons x y))
+(let ((x 1)) (lambda (x) x))
+((let ((x 1)) (lambda (x) (+ x 1))) 41)
+(let ((n 3)) ((lambda (m) (let ((n 4)) (+ n m))) n))
+(let ((k 2)) (letrec ((k (lambda () 9))) (k)))
+(let ((a 1) (b 2)) (let* ((b 5) (c (+ a b))) c))
+(let ((h (lambda (+) (+ 1 2)))) (h (lambda (a b) (* a b))))
+(+ 1 2)
+(cond (#f) (5 6))
+(if 1 2 3)
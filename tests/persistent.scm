@@ -0,0 +1,67 @@
+(define m (pmap (quote a) 1 (quote b) 2))
+(pmap-ref m (quote a))
+(pmap-ref m (quote c) 0)
+(define m2 (pmap-set m (quote c) 3))
+(pmap-count m)
+(pmap-count m2)
+(pmap-contains? m (quote c))
+(pmap-contains? m2 (quote c))
+(pmap-count (pmap-delete m2 (quote a)))
+(pmap-ref m2 (quote a))
+(pmap? m)
+(equal? (pmap-delete m2 (quote c)) m)
+(equal? (pmap 1 2) (pmap 1 3))
+(pmap "x" (quote (1 2)))
+(define v (pvector 1 2 3))
+v
+(pvector-ref v 1)
+(pvector-set v 1 (quote two))
+v
+(pvector-push v 4)
+(pvector-pop v)
+(pvector-length (pvector))
+(pvector->list (pvector-append v (pvector 4 5)))
+(list->pvector (quote (a b c)))
+(equal? (pvector 1 2) (list->pvector (quote (1 2))))
+(define build (lambda (t i n) (if (= i n) (persistent! t) (build (pvector-push! t (* i i)) (+ i 1) n))))
+(define big (build (transient (pvector)) 0 100000))
+(pvector-length big)
+(pvector-ref big 99999)
+(pvector-ref big 1056)
+(define big2 (pvector-set big 70000 (quote x)))
+(pvector-ref big 70000)
+(pvector-ref big2 70000)
+(define shrink (lambda (v n) (if (= n 0) v (shrink (pvector-pop v) (- n 1)))))
+(define small (shrink big 99000))
+(pvector-length small)
+(pvector-ref small 999)
+(define check (lambda (v i bad) (if (= i (pvector-length v)) bad (check v (+ i 1) (if (= (pvector-ref v i) (* i i)) bad (+ bad 1))))))
+(check small 0 0)
+(check (shrink big 65000) 0 0)
+(define model (make-hash-table))
+(define mbuild (lambda (m i)
+  (if (= i 30000) m
+      (let ((k (modulo (* i 7919) 5000)))
+        (if (= (modulo i 3) 0)
+            (let () (hash-table-delete! model k) (mbuild (pmap-delete m k) (+ i 1)))
+            (let () (hash-table-set! model k i) (mbuild (pmap-set m k i) (+ i 1))))))))
+(define pm (mbuild (pmap) 0))
+(= (pmap-count pm) (hash-table-count model))
+(define mcheck (lambda (k bad) (if (= k 5000) bad (mcheck (+ k 1) (if (equal? (pmap-ref pm k #f) (hash-table-ref/default model k #f)) bad (+ bad 1))))))
+(mcheck 0 0)
+(define tb (lambda (t i) (if (= i 20000) (persistent! t) (tb (pmap-set! t (number->string i) i) (+ i 1)))))
+(define sm (tb (transient (pmap)) 0))
+(pmap-count sm)
+(pmap-ref sm "12345")
+(define td (lambda (t i) (if (= i 20000) (persistent! t) (td (pmap-delete! t (number->string i)) (+ i 2)))))
+(define sm2 (td (transient sm) 0))
+(pmap-count sm2)
+(pmap-count sm)
+(pmap-contains? sm2 "12344")
+(pmap-contains? sm2 "12345")
+(define h (make-hash-table))
+(hash-table-set! h (pvector 1 2) (quote found))
+(hash-table-ref h (pvector 1 2))
+(define t (transient v))
+(persistent! t)
+(pvector? t)
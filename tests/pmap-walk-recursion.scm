@@ -0,0 +1,6 @@
+(define m (pmap 1 1))
+(define depth 0)
+(define f (lambda (n) (if (= n 0) 0 ((lambda () (set! depth (+ depth 1)) (pmap-walk m (lambda (k v) (f (- n 1)))))))))
+(f 100000)
+depth
+(f 10000000)
@@ -0,0 +1 @@
+(define-record-type <dup> (make-dup x) dup? (x dup-x) (x dup-x2))
@@ -0,0 +1 @@
+(define-record-type <bad> (make-bad z) bad? (x bad-x))
@@ -0,0 +1,3 @@
+(define-record-type <point> (make-point x y) point? (x point-x set-point-x!) (y point-y))
+(define-record-type <node> (make-node value) node? (value node-value) (next node-next set-node-next!))
+(set-point-x! (make-node 1) 2)
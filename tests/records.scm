@@ -0,0 +1,41 @@
+(define-record-type <point> (make-point x y) point? (x point-x set-point-x!) (y point-y))
+(define p (make-point 1 2))
+p
+<point>
+(point? p)
+(point? 5)
+(record? p)
+(point-x p)
+(point-y p)
+(set-point-x! p 10)
+(point-x p)
+(define-record-type <node> (make-node value) node? (value node-value) (next node-next set-node-next!))
+(define n (make-node 3))
+(node-next n)
+(point? n)
+(define sum-nodes
+  (lambda (k acc)
+    (if (= k 0) acc
+        (sum-nodes (- k 1) (+ acc (node-value (make-node k)))))))
+(sum-nodes 100000 0)
+(define area (lambda (r)
+  (define-record-type rect (make-rect w h) rect? (w rect-w) (h rect-h))
+  (let ((x (make-rect r (+ r 1))))
+    (* (rect-w x) (rect-h x)))))
+(area 4)
+(define-syntax def-pair
+  (syntax-rules ()
+    ((_ type make pred a b)
+     (define-record-type type (make a b) pred (a a) (b b)))))
+(def-pair pr make-pr pr? first second)
+(first (make-pr 7 8))
+(second (make-pr 7 8))
+(equal? (make-point 1 2) (make-point 1 2))
+(let ((q (make-point 1 2))) (equal? q q))
+(point? "point")
+(point? (quote (1 2)))
+(point? <point>)
+(node? #f)
+(set-node-next! n (make-node 4))
+(node-value (node-next n))
+(point-x 5)
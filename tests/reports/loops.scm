@@ -0,0 +1,8 @@
+(let loop ((i 0) (acc 0)) (if (= i 10) acc (loop (+ i 1) (+ acc i))))
+(let loop ((i 0) (acc 0)) (if (< i 3) (loop (+ i 1) (let ((u (set! i (+ i 10)))) (+ acc i))) acc))
+(define procs (let loop ((i 0) (acc (quote ()))) (if (= i 3) acc (loop (+ i 1) (cons (lambda () i) acc)))))
+(define fact (lambda (n) (let f ((n n)) (if (= n 0) 1 (* n (f (- n 1)))))))
+(let loop ((i 0) (acc 0)) (if (= i 5) acc ((lambda () (set! i (+ i 1)) (loop i (+ acc i))))))
+(let loop ((i 0)) (if (< i 3) (loop (+ i 1) 2) i))
+(do ((i 0 (+ i 1))) ((= i 5)))
+(do ((i 0 (+ i 1)) (acc 1 (* acc 2))) ((= i 10) acc))
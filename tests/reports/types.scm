@@ -0,0 +1,11 @@
+(define square (lambda (x) (* x x)))
+(square 5)
+(define add (lambda (a b) (+ a b)))
+(add 1 2)
+(add 1.5 2.5)
+(define unknown (lambda (f x) (+ (f x) 1)))
+(unknown square 3)
+(let loop ((i 0) (acc 0)) (if (= i 10) acc (loop (+ i 1) (+ acc i))))
+(define mixed (lambda (v) (* v 2.0)))
+(mixed 3)
+(+ (car (cons 1 2)) 1)
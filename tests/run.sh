@@ -0,0 +1,90 @@
+#!/bin/sh
+# Runs every program in this directory with each way the interpreter can
+# evaluate it and checks that what it prints, errors included, matches the
+# .out file beside it. Takes in the interpreter to run, ./interpreter by
+# default, and optionally a C compiler, with which each program is also
+# translated with --compile-to-c and built against the interpreter's
+# sources. A program with a .flags file beside it is run with the options
+# in it as well, in every mode. Exits with 1 if any program's output
+# differs.
+
+dir=$(dirname "$0")
+interpreter=${1:-./interpreter}
+cc=$2
+failed=0
+
+# the runtime compiled programs link against is built once
+if [ -n "$cc" ]; then
+    build=$(mktemp -d)
+    trap 'rm -rf "$build"' EXIT
+    for source in "$dir"/../*.c; do
+        if [ "$(basename "$source")" != main.c ]; then
+            name=$(basename "$source" .c)
+            $cc -w -pthread -c "$source" -o "$build/$name.o" || exit 1
+        fi
+    done
+fi
+
+# the bytecode VM with the JIT, with every function compiled to native code
+# the first time it runs, and without the JIT, and the tree walker with and
+# without the optimizer
+modes="|--jit-threshold=1|--no-jit|--tree-walk|--tree-walk --no-optimize"
+
+for program in "$dir"/*.scm; do
+    expected="${program%.scm}.out"
+    flags=$(cat "${program%.scm}.flags" 2>/dev/null)
+    IFS='|'
+    for mode in $modes; do
+        IFS=' '
+        if ! $interpreter $mode $flags < "$program" 2>&1 | cmp -s - "$expected"; then
+            echo "FAIL $(basename "$program") ${mode:-(default)}"
+            failed=1
+        fi
+    done
+    IFS=' '
+    if [ -n "$cc" ]; then
+        name=$(basename "$program" .scm)
+        # a program that stops with a syntax error stops the translation,
+        # which then prints the error itself
+        if $interpreter --compile-to-c < "$program" > "$build/$name.c" 2>&1; then
+            $cc -w -pthread -I"$dir/.." "$build/$name.c" "$build"/*.o -o "$build/$name" -lm
+            run="$build/$name $flags"
+        else
+            run="cat $build/$name.c"
+        fi
+        if ! $run 2>&1 | cmp -s - "$expected"; then
+            echo "FAIL $(basename "$program") --compile-to-c"
+            failed=1
+        fi
+        rm -f "$build/$name" "$build/$name.c"
+    fi
+done
+
+# the reports on a program, which come before it is run and so are the
+# same in every mode, are checked once each, with the options in the
+# .flags file beside the program
+for program in "$dir"/reports/*.scm; do
+    if ! $interpreter $(cat "${program%.scm}.flags") < "$program" 2>&1 | cmp -s - "${program%.scm}.out"; then
+        echo "FAIL reports/$(basename "$program")"
+        failed=1
+    fi
+done
+
+# the optimizer has to save the tree walker steps on a loop made of the
+# forms it simplifies, without changing what the loop computes
+steps() {
+    $interpreter --tree-walk --count-steps $1 < "$dir/bench/fold.scm" 2>&1 >/dev/null | tr -cd 0-9
+}
+optimized=$(steps)
+unoptimized=$(steps --no-optimize)
+echo "bench/fold.scm: $optimized evaluation steps optimized, $unoptimized not"
+if [ "$($interpreter < "$dir/bench/fold.scm")" != "$($interpreter --no-optimize < "$dir/bench/fold.scm")" ] ||
+   [ "$optimized" -ge "$unoptimized" ]; then
+    echo "FAIL bench/fold.scm --count-steps"
+    failed=1
+fi
+
+if [ $failed = 0 ]; then
+    echo "all tests passed"
+fi
+exit $failed
@@ -0,0 +1 @@
+(define f (lambda (n) (+ 1 (f n)))) (f 1)
@@ -0,0 +1,40 @@
+(define integers-from
+  (lambda (n) (cons-stream n (integers-from (+ n 1)))))
+(define stream-take
+  (lambda (s n)
+    (if (= n 0) (quote ()) (cons (stream-car s) (stream-take (stream-cdr s) (- n 1))))))
+(stream-take (integers-from 1) 5)
+(define count 0)
+(define q (delay (let ((x (set! count (+ count 1)))) count)))
+(force q)
+(force q)
+count
+(promise? q)
+(promise? 5)
+(force 7)
+(force (make-promise 9))
+(force (make-promise q))
+(define chain
+  (lambda (n) (if (= n 0) (delay-force (delay (quote done))) (delay-force (chain (- n 1))))))
+(force (chain 100000))
+(define stream-filter
+  (lambda (pred s)
+    (if (pred (stream-car s))
+        (cons-stream (stream-car s) (stream-filter pred (stream-cdr s)))
+        (stream-filter pred (stream-cdr s)))))
+(define even (lambda (n) (= (modulo n 2) 0)))
+(stream-take (stream-filter even (integers-from 1)) 4)
+(define stream-ref
+  (lambda (s n) (if (= n 0) (stream-car s) (stream-ref (stream-cdr s) (- n 1)))))
+(stream-ref (integers-from 0) 50000)
+(let ((x 5)) (define r (delay (+ x 1))) (set! x 10) (force r))
+(delay 1)
+(define x 0)
+(define rp
+  (delay (if (> x 3) x (let ((y (set! x (+ x 1)))) (force rp)))))
+(force rp)
+(let loop ((i 0) (acc (quote ()))) (if (= i 3) acc (loop (+ i 1) (cons (force (delay i)) acc))))
+(let loop ((i 0) (acc (quote ()))) (if (= i 3) (stream-take acc 3) (loop (+ i 1) (cons-stream i acc))))
+(do ((i 0 (+ i 1)) (ps (quote ()) (cons (delay i) ps))) ((= i 3) (cons (force (car ps)) (force (car (cdr ps))))))
+(define lazy-loop (lambda (n) (delay-force (if (= n 0) (delay 0) (lazy-loop (- n 1))))))
+(force (lazy-loop 200000))
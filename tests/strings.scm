@@ -0,0 +1,50 @@
+(define s "hello, world")
+(string-length s)
+(string-ref s 4)
+(substring s 7)
+(substring s 0 5)
+(string-append "a" "b" "c")
+(string-append)
+(string=? "abc" "abc")
+(string=? "abc" "abd")
+(string=? "a" "a" "a")
+(string<? "abc" "abd")
+(string<? "ab" "abc")
+(string<? "b" "a")
+(string<? "a" "b" "c")
+(string->symbol "foo")
+(symbol->string (quote bar))
+(number->string 42)
+(number->string 123456789012345678901234567890)
+(number->string 2.5)
+(string-split "a,b,,c" ",")
+(string-split "one--two--" "--")
+(string-split "" ",")
+(string? s)
+(string? 3)
+(define build (lambda (n acc) (if (= n 0) acc (build (- n 1) (string-append acc "xy")))))
+(define big (build 5000 ""))
+(string-length big)
+(string-ref big 9999)
+(substring big 100 110)
+(string=? big (build 5000 ""))
+(string<? big (string-append big "x"))
+(string-length (string-append big big))
+(define long "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab")
+(string-length long)
+(string-ref long 323)
+(define m (memoize (lambda (x) (string-length x))))
+(m (string-append big "z"))
+(m (string-append big "z"))
+(memo-stats m)
+(string-append "ab" (substring big 0 200) "cd")
+(define rope (string-append (substring big 0 150) "MID" (substring big 0 150)))
+(string-length rope)
+(substring rope 148 155)
+(string-ref rope 150)
+(string-ref rope 152)
+(string=? rope (string-append (substring big 0 150) "MID" (substring big 0 150)))
+(string<? rope (string-append (substring big 0 150) "MIE"))
+(define csv (string-append (substring big 0 140) ",," (substring big 0 2) ","))
+(string-split csv ",")
+(string-ref s 12)
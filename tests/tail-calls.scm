@@ -0,0 +1,9 @@
+(define loop (lambda (i acc) (if (= i 0) acc (loop (- i 1) (+ acc 1)))))
+(loop 500000 0)
+(define loop2 (lambda (i) (cond ((= i 0) (quote done)) (else (let ((j (- i 1))) (loop2 j))))))
+(loop2 300000)
+(define ev (lambda (n) (or (= n 0) (od (- n 1)))))
+(define od (lambda (n) (and (> n 0) (ev (- n 1)))))
+(ev 300001)
+((lambda args args) 1 2 3)
+(define count 0)
@@ -0,0 +1,57 @@
+(define v (make-vector 5 0))
+v
+(vector-length v)
+(vector-set! v 0 10)
+(vector-set! v 4 (quote end))
+v
+(vector-ref v 0)
+(vector-ref v 4)
+(define w (vector 1 2.5 "three" (quote four) (quote (5 6)) #t))
+w
+(vector? w)
+(vector? (quote (1 2)))
+(vector->list w)
+(vector->list w 2)
+(vector->list w 2 4)
+(list->vector (quote (1 2 3)))
+(list->vector (quote ()))
+(vector)
+(make-vector 0)
+(make-vector 3)
+#(1 2 (3 4) #(5 6) "s" a)
+(vector-ref #(10 20 30) 2)
+(define c (vector-copy w 1 3))
+c
+(vector-set! c 0 99)
+c
+w
+(vector-copy w)
+(define f (make-vector 6 1))
+(vector-fill! f 7 2 4)
+f
+(vector-fill! f 0)
+f
+(define squares (lambda (n)
+  (let ((out (make-vector n 0)))
+    (let loop ((i 0))
+      (if (= i n) out
+          (let ((ignored (vector-set! out i (* i i))))
+            (loop (+ i 1))))))))
+(squares 10)
+(define vsum (lambda (vec)
+  (let loop ((i 0) (acc 0))
+    (if (= i (vector-length vec)) acc (loop (+ i 1) (+ acc (vector-ref vec i)))))))
+(vsum (squares 1000))
+(define bubble (lambda (vec)
+  (let outer ((i 0))
+    (if (= i (vector-length vec)) vec
+        (let inner ((j 0))
+          (if (= j (- (- (vector-length vec) i) 1)) (outer (+ i 1))
+              (let ((a (vector-ref vec j)) (b (vector-ref vec (+ j 1))))
+                (if (> a b)
+                    (let ((x (vector-set! vec j b)) (y (vector-set! vec (+ j 1) a))) (inner (+ j 1)))
+                    (inner (+ j 1))))))))))
+(bubble (vector 5 3 9 1 7 2 8))
+(quote #(a b))
+(let ((lit #(1 2))) (vector-ref lit 1))
+(make-vector 2305843009213693952)
@@ -0,0 +1,29 @@
+(define x 1)
+(define mk (lambda (n) (lambda (m) (set! n (+ n m)) n)))
+(define acc (mk 10))
+(acc 1)
+(acc 5)
+(define tw (lambda () (define x 2) (lambda (y) (+ x y))))
+((tw) 3)
+(define comp (lambda (f) (f 4)))
+(comp (tw))
+(letrec ((f (lambda (n) (if (= n 0) (quote ()) (cons n (f (- n 1))))))) (f 5))
+(let* ((a 1) (a (+ a 1))) a)
+(define g (lambda args (cons (quote got) args)))
+(g)
+(g 1 2)
+(cond (#f 1) ((= 1 2) 2))
+(cond ((+ 1 2)) (else 4))
+(cond (#t))
+(define p (cons 1 2))
+(set-cdr! p 9)
+p
+(and)
+(or)
+(and #t #t)
+(define h (lambda (a b) (define c (+ a b)) (define a 10) (* a c)))
+(h 1 2)
+(lambda (x) x)
+(define fib (lambda (n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2))))))
+(fib 20)
+(set-cdr! 5 1)
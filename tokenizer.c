@@ -1,6 +1,8 @@
 #include "tokenizer.h"
 #include "talloc.h"
 #include "linkedlist.h"
+#include "symtab.h"
+#include "bignum.h"
 #include <ctype.h>
 #include <string.h>
 #include <stdbool.h>
@@ -42,13 +44,14 @@ Item *addItem(Item *list, Item *newItem) {
     return cons(newItem, list);
 }
 
-// creates an item from a string and allocates memory to it, returns
+// creates a symbol item from a string, interning its name, and returns
 // the item
 Item *createStringItem(const char *str) {
     Item *item = talloc(sizeof(Item));
     item->type = SYMBOL_TYPE;
-    item->s = talloc(strlen(str) + 1);
-    strcpy(item->s, str);
+    item->s = intern(str);
+    item->sc.cell = NULL;
+    item->sc.epoch = 0;
     return item; }
 
 // looks (or "peeks") at the next character without actually
@@ -107,14 +110,26 @@ Item *tokenize() {
 
         if (charRead == '"' || charRead == '(' || charRead == ')' || charRead == '[' || charRead == ']' || charRead == '#') {
             if (charRead == '"') {
+                // a string can be any length, so one that outgrows the
+                // token buffer moves to a larger one, as numbers do
+                char *chars = storedTokens;
+                int capacity = sizeof(storedTokens);
                 int i = 0;
-                while ((charRead = fgetc(stdin)) != '"' && charRead != EOF && i < 300) {
-                    storedTokens[i] = charRead;
+                while ((charRead = fgetc(stdin)) != '"' && charRead != EOF) {
+                    if (i + 1 == capacity) {
+                        char *larger = talloc(2 * capacity);
+                        memcpy(larger, chars, i);
+                        chars = larger;
+                        capacity *= 2;
+                    }
+                    chars[i] = charRead;
                     i++;
                 }
-                storedTokens[i] = '\0';
+                chars[i] = '\0';
                 Item *item = createItem(STR_TYPE);
-                item->s = createStringItem(storedTokens)->s;
+                item->str.chars = intern(chars);
+                item->str.length = i;
+                item->str.rope = NULL;
                 list = addItem(list, item);
             } else if (charRead == '(') {
                 list = addItem(list, createItem(OPEN_TYPE));
@@ -126,10 +141,16 @@ Item *tokenize() {
                 list = addItem(list, createItem(CLOSEBRACKET_TYPE));
             } else if (charRead == '#') {
                 charRead = fgetc(stdin);
+                if (charRead == '(') {
+                    list = addItem(list, createItem(OPENVECTOR_TYPE));
+                    continue;
+                }
                 Item *item = createItem(BOOL_TYPE);
                 if (charRead == 't') {
+                    item->i = 1;
                     boolStates = addBoolState(boolStates, true);
                 } else if (charRead == 'f') {
+                    item->i = 0;
                     boolStates = addBoolState(boolStates, false);
                 } else {
                     printf("Syntax error\n");
@@ -145,29 +166,54 @@ Item *tokenize() {
         }
 
         if (isdigit(charRead) || charRead == '+' || charRead == '-') {
-            storedTokens[0] = charRead;
+            // an integer can have any number of digits, so a number that
+            // outgrows the token buffer moves to a larger one
+            char *number = storedTokens;
+            int capacity = sizeof(storedTokens);
+            number[0] = charRead;
             int i = 1;
             while ((isdigit(peekChar()) || peekChar() == '.')) {
-                storedTokens[i] = fgetc(stdin);
+                if (i + 1 == capacity) {
+                    char *larger = talloc(2 * capacity);
+                    memcpy(larger, number, i);
+                    number = larger;
+                    capacity *= 2;
+                }
+                number[i] = fgetc(stdin);
                 i++;
             }
-            storedTokens[i] = '\0';
-            if (isdigit(storedTokens[0]) || storedTokens[0] == '-' && i > 1) {
+            number[i] = '\0';
+            if (isdigit(number[0]) || (number[0] == '-' && i > 1)) {
                 Item *item;
-                if (strchr(storedTokens, '.') != NULL) {
+                if (strchr(number, '.') != NULL) {
                     item = createItem(DOUBLE_TYPE);
-                    item->d = strtod(storedTokens, NULL); 
+                    item->d = strtod(number, NULL); 
                 } else {
-                    item = createItem(INT_TYPE);
-                    item->i = atoi(storedTokens); 
+                    item = parseInteger(number);
                 }
                 list = addItem(list, item); 
             } else {
-                list = addItem(list, createStringItem(storedTokens));
+                list = addItem(list, createStringItem(number));
             }
             continue;
         }
 
+        // the ellipsis of syntax-rules patterns is the only symbol that
+        // starts with a dot
+        if (charRead == '.') {
+            int dots = 1;
+            while (dots < 3 && peekChar() == '.') {
+                fgetc(stdin);
+                dots++;
+            }
+            if (dots != 3 || isSubsequent(peekChar())) {
+                printf("Syntax error\n");
+                texit(1);
+            }
+            list = addItem(list, createStringItem("..."));
+            continue;
+        }
+
         if (isInitial(charRead)) {
             int i = 0;
             storedTokens[i] = charRead;
@@ -194,7 +240,7 @@ void displayTokens(Item *list) {
         Item *token = car(list);
         switch (token->type) {
             case INT_TYPE:
-                printf("%d:integer ", token->i);
+                printf("%s:integer ", integerToString(token));
                 break;
             case DOUBLE_TYPE:
                 printf("%.2f:double ", token->d);
@@ -217,6 +263,9 @@ void displayTokens(Item *list) {
             case CLOSEBRACKET_TYPE:
                 printf("]:closebracket ");
                 break;
+            case OPENVECTOR_TYPE:
+                printf("#(:openvector ");
+                break;
             case BOOL_TYPE:
                 if (boolStatePtr != NULL) {
                     if (boolStatePtr->value) {
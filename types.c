@@ -0,0 +1,668 @@
+#include <stdio.h>
+#include <string.h>
+#include "types.h"
+#include "interpreter.h"
+#include "linkedlist.h"
+#include "optimizer.h"
+#include "parser.h"
+#include "symtab.h"
+#include "talloc.h"
+
+// The types values are told apart by, from least to most general. An
+// expression of type NO_VALUE has not been seen to produce a value at all,
+// such as a call of a function no call site has reached yet, and one of
+// type ANY_VALUE may produce anything. An integer may be a fixnum or a
+// bignum, which the evaluators tell apart where they compute a proved call.
+// Types are kept in INT items, which the inference widens in place.
+typedef enum {
+    NO_VALUE, INT_VALUE, DOUBLE_VALUE, BOOL_VALUE, ANY_VALUE
+} ValueType;
+
+const char *valueTypeNames[] = {"unreached", "integer", "double", "boolean", "unknown"};
+
+// how many define and set! forms assign each name in the program, and how
+// many set! forms alone. a define in a body binds a new variable there,
+// which is accounted for where the body binds it, so only set! changes a
+// local variable's value
+SymbolTable *assignmentCounts = NULL;
+SymbolTable *setCounts = NULL;
+
+// the functions whose parameters and results are inferred, by name. each
+// is a list of type cells: the result's and then each parameter's. a name
+// that turns out to be used other than by calling it is left bound to the
+// empty list
+SymbolTable *signatures = NULL;
+
+// the signatures of the named let loops, in the same form: the type of the
+// loop's value and then each variable's. loop names are often reused, so
+// each is kept in a list of (arguments . signature) pairs under the
+// arguments of its form
+Item *loopSignatures = NULL;
+
+// the types of the top-level variables that are defined once and never
+// assigned, by name
+SymbolTable *globalTypes = NULL;
+
+// whether the pass being made widened any type cell, in which case another
+// pass is needed
+int typesWidened = 0;
+
+// whether the pass being made is the last, which marks the proved call
+// sites or reports the others
+int finalPass = 0;
+int reportSites = 0;
+
+// how many arithmetic and comparison calls the last pass saw and proved
+int siteCount = 0;
+int provedCount = 0;
+
+ValueType inferExpression(Item *expr, Item *env);
+
+// join two types into the least type that includes both
+ValueType joinTypes(ValueType a, ValueType b) {
+    if (a == NO_VALUE || a == b) {
+        return b;
+    }
+    if (b == NO_VALUE) {
+        return a;
+    }
+    return ANY_VALUE;
+}
+
+// make a type cell. takes in its type
+Item *makeTypeCell(ValueType type) {
+    Item *cell = talloc(sizeof(Item));
+    cell->type = INT_TYPE;
+    cell->i = type;
+    return cell;
+}
+
+// widen a type cell to include a type, noting whether it changed
+void widenType(Item *cell, ValueType type) {
+    ValueType joined = joinTypes(cell->i, type);
+    if (joined != (ValueType)cell->i) {
+        cell->i = joined;
+        typesWidened = 1;
+    }
+}
+
+// count the define and set! forms that assign a name
+int assignmentCount(char *name) {
+    Item *cell = tableLookup(assignmentCounts, name);
+    return cell == NULL ? 0 : cell->c.cdr->i;
+}
+
+// count the set! forms that assign each name in an expression, like
+// scanAssignments does for define and set!
+void findSets(Item *expr) {
+    if (expr->type != CONS_TYPE || isSpecialForm(expr, "quote")) {
+        return;
+    }
+    if (isSpecialForm(expr, "set!") && cdr(expr)->type == CONS_TYPE &&
+        car(cdr(expr))->type == SYMBOL_TYPE) {
+        Item *cell = tableLookup(setCounts, car(cdr(expr))->s);
+        if (cell == NULL) {
+            tableDefine(setCounts, car(cdr(expr))->s, makeTypeCell(1));
+        } else {
+            cell->c.cdr->i++;
+        }
+    }
+    for (; expr->type == CONS_TYPE; expr = cdr(expr)) {
+        findSets(car(expr));
+    }
+}
+
+// checks whether a set! form assigns a name anywhere in the program
+int isSet(char *name) {
+    return tableLookup(setCounts, name) != NULL;
+}
+
+// checks whether an expression is a lambda with a proper list of symbols
+// for parameters
+int isSimpleLambda(Item *expr) {
+    if (!isSpecialForm(expr, "lambda") || cdr(expr)->type != CONS_TYPE ||
+        !isProperList(car(cdr(expr)))) {
+        return 0;
+    }
+    for (Item *params = car(cdr(expr)); !isNull(params); params = cdr(params)) {
+        if (car(params)->type != SYMBOL_TYPE) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// checks whether an expression is a define of a name, as the evaluators
+// accept it
+int isSimpleDefine(Item *expr) {
+    return isSpecialForm(expr, "define") && isProperList(expr) && length(expr) == 3 &&
+           car(cdr(expr))->type == SYMBOL_TYPE;
+}
+
+void dropSignature(char *name);
+
+// give a function a signature. a name that two forms bind to functions
+// gets none. takes in the name and the lambda expression
+void addSignature(char *name, Item *lambda) {
+    if (tableLookup(signatures, name) != NULL) {
+        dropSignature(name);
+        return;
+    }
+    Item *signature = makeNull();
+    for (Item *params = car(cdr(lambda)); !isNull(params); params = cdr(params)) {
+        signature = cons(makeTypeCell(NO_VALUE), signature);
+    }
+    tableDefine(signatures, name, cons(makeTypeCell(NO_VALUE), signature));
+}
+
+// give a signature to every function that a define binds a name to that
+// nothing else assigns, or that a letrec binds a name to that nothing
+// assigns. takes in an expression and does not return anything
+void findFunctions(Item *expr) {
+    if (expr->type != CONS_TYPE || isSpecialForm(expr, "quote")) {
+        return;
+    }
+    if (isSimpleDefine(expr) && isSimpleLambda(car(cdr(cdr(expr)))) &&
+        assignmentCount(car(cdr(expr))->s) == 1) {
+        addSignature(car(cdr(expr))->s, car(cdr(cdr(expr))));
+    }
+    if (isSpecialForm(expr, "letrec") && cdr(expr)->type == CONS_TYPE &&
+        isWellFormedBindingList(car(cdr(expr)), 0)) {
+        for (Item *b = car(cdr(expr)); !isNull(b); b = cdr(b)) {
+            if (isSimpleLambda(car(cdr(car(b)))) && assignmentCount(car(car(b))->s) == 0) {
+                addSignature(car(car(b))->s, car(cdr(car(b))));
+            }
+        }
+    }
+    for (; expr->type == CONS_TYPE; expr = cdr(expr)) {
+        findFunctions(car(expr));
+    }
+}
+
+// find the signature of a function by name. returns it, or NULL if the
+// name has none
+Item *findSignature(char *name) {
+    Item *cell = tableLookup(signatures, name);
+    return cell == NULL || isNull(cell->c.cdr) ? NULL : cell->c.cdr;
+}
+
+// take away the signature of a function whose value escapes, or that is
+// called with the wrong number of arguments, since it can then be called
+// from anywhere with anything
+void dropSignature(char *name) {
+    Item *cell = tableLookup(signatures, name);
+    if (cell != NULL) {
+        cell->c.cdr = makeNull();
+    }
+}
+
+// find the signature a lambda bound to a name takes its types from. takes
+// in the name and the lambda expression, and returns the signature, or
+// NULL if the name has none or the lambda's parameters do not fit it
+Item *lambdaSignature(char *name, Item *lambda) {
+    Item *signature = findSignature(name);
+    if (signature == NULL || !isSimpleLambda(lambda) ||
+        length(car(cdr(lambda))) != length(signature) - 1) {
+        return NULL;
+    }
+    return signature;
+}
+
+void findEscapesInList(Item *exprs);
+
+// drop the signatures of the functions an expression uses other than by
+// calling them by name. a name is taken to refer to the function wherever
+// it appears, even where it is bound to something else, which only drops
+// more signatures than needed. takes in the expression
+void findEscapes(Item *expr) {
+    if (expr->type == SYMBOL_TYPE) {
+        dropSignature(expr->s);
+        return;
+    }
+    if (expr->type != CONS_TYPE || isSpecialForm(expr, "quote")) {
+        return;
+    }
+    Item *args = cdr(expr);
+    if ((isSimpleDefine(expr) || isSpecialForm(expr, "set!")) && args->type == CONS_TYPE) {
+        findEscapesInList(cdr(args));
+    } else if (isSpecialForm(expr, "lambda") && args->type == CONS_TYPE) {
+        findEscapesInList(cdr(args));
+    } else if (isNamedLet(expr)) {
+        for (Item *b = car(cdr(args)); !isNull(b); b = cdr(b)) {
+            findEscapes(car(cdr(car(b))));
+        }
+        findEscapesInList(cdr(cdr(args)));
+    } else if ((isSpecialForm(expr, "let") || isSpecialForm(expr, "let*") ||
+                isSpecialForm(expr, "letrec")) &&
+               args->type == CONS_TYPE && isWellFormedBindingList(car(args), 1)) {
+        for (Item *b = car(args); !isNull(b); b = cdr(b)) {
+            findEscapes(car(cdr(car(b))));
+        }
+        findEscapesInList(cdr(args));
+    } else if (isSpecialForm(expr, "cond")) {
+        for (; args->type == CONS_TYPE; args = cdr(args)) {
+            findEscapesInList(car(args));
+        }
+    } else if (car(expr)->type == SYMBOL_TYPE) {
+        Item *signature = findSignature(car(expr)->s);
+        if (signature != NULL && (!isProperList(args) || length(args) != length(signature) - 1)) {
+            dropSignature(car(expr)->s);
+        }
+        findEscapesInList(args);
+    } else {
+        findEscapesInList(expr);
+    }
+}
+
+void findEscapesInList(Item *exprs) {
+    for (; exprs->type == CONS_TYPE; exprs = cdr(exprs)) {
+        findEscapes(car(exprs));
+    }
+    findEscapes(exprs);
+}
+
+// find what a name is bound to. takes in the name and the environment, a
+// list of (symbol . binding) pairs, and returns the binding: a type cell,
+// a signature, or NULL for a global with neither
+Item *findBinding(char *name, Item *env) {
+    for (; !isNull(env); env = cdr(env)) {
+        if (car(car(env))->s == name) {
+            return cdr(car(env));
+        }
+    }
+    Item *signature = findSignature(name);
+    if (signature != NULL) {
+        return signature;
+    }
+    Item *cell = tableLookup(globalTypes, name);
+    return cell == NULL ? NULL : cell->c.cdr;
+}
+
+// bind the names a body defines, each to its signature if it has one and
+// otherwise to an unknown type. like the evaluators, this counts the
+// defines nested anywhere in the body. takes in the body and the
+// environment and returns the new environment
+Item *bindBodyDefinitions(Item *body, Item *env) {
+    for (; body->type == CONS_TYPE; body = cdr(body)) {
+        Item *expr = car(body);
+        if (expr->type != CONS_TYPE || isSpecialForm(expr, "quote")) {
+            continue;
+        }
+        if (isSpecialForm(expr, "define") && cdr(expr)->type == CONS_TYPE &&
+            car(cdr(expr))->type == SYMBOL_TYPE) {
+            Item *signature = findSignature(car(cdr(expr))->s);
+            Item *binding = signature != NULL ? signature : makeTypeCell(ANY_VALUE);
+            env = cons(cons(car(cdr(expr)), binding), env);
+        }
+        env = bindBodyDefinitions(expr, env);
+    }
+    return env;
+}
+
+// bind a variable to the type of the value it is first given, or to an
+// unknown type if a set! may assign it. takes in the symbol, the type and
+// the environment and returns the new environment
+Item *bindVariable(Item *symbol, ValueType type, Item *env) {
+    if (isSet(symbol->s)) {
+        type = ANY_VALUE;
+    }
+    return cons(cons(symbol, makeTypeCell(type)), env);
+}
+
+// infer the type of a sequence of expressions, which is the type of the
+// last. takes in the list and the environment
+ValueType inferSequence(Item *exprs, Item *env) {
+    ValueType type = ANY_VALUE;
+    for (; exprs->type == CONS_TYPE; exprs = cdr(exprs)) {
+        type = inferExpression(car(exprs), env);
+    }
+    return type;
+}
+
+// infer the types in a lambda's body. takes in the lambda expression, the
+// environment and the function's signature, or NULL if it has none, in
+// which case its parameters are of unknown type
+void inferLambda(Item *expr, Item *env, Item *signature) {
+    Item *args = cdr(expr);
+    if (args->type != CONS_TYPE) {
+        return;
+    }
+    Item *params = car(args);
+    Item *cells = signature != NULL ? cdr(signature) : makeNull();
+    for (; params->type == CONS_TYPE; params = cdr(params)) {
+        if (car(params)->type != SYMBOL_TYPE) {
+            return;
+        }
+        if (signature != NULL && !isSet(car(params)->s)) {
+            env = cons(cons(car(params), car(cells)), env);
+        } else {
+            env = bindVariable(car(params), ANY_VALUE, env);
+        }
+        cells = signature != NULL ? cdr(cells) : cells;
+    }
+    if (params->type == SYMBOL_TYPE) {
+        env = bindVariable(params, ANY_VALUE, env);
+    }
+    Item *body = cdr(args);
+    ValueType type = inferSequence(body, bindBodyDefinitions(body, env));
+    if (signature != NULL) {
+        widenType(car(signature), type);
+    }
+}
+
+// infer the type of a let, let* or letrec form. takes in the form, the
+// environment and which of the three it is
+ValueType inferLet(Item *expr, Item *env, const char *kind) {
+    Item *args = cdr(expr);
+    if (args->type != CONS_TYPE || !isWellFormedBindingList(car(args), 1)) {
+        return ANY_VALUE;
+    }
+    Item *bindings = car(args);
+    Item *inner = env;
+    if (strcmp(kind, "letrec") == 0) {
+        for (Item *b = bindings; !isNull(b); b = cdr(b)) {
+            Item *signature = lambdaSignature(car(car(b))->s, car(cdr(car(b))));
+            if (signature != NULL) {
+                inner = cons(cons(car(car(b)), signature), inner);
+            } else {
+                inner = bindVariable(car(car(b)), ANY_VALUE, inner);
+            }
+        }
+        for (Item *b = bindings; !isNull(b); b = cdr(b)) {
+            Item *signature = lambdaSignature(car(car(b))->s, car(cdr(car(b))));
+            if (signature != NULL) {
+                inferLambda(car(cdr(car(b))), inner, signature);
+            } else {
+                inferExpression(car(cdr(car(b))), inner);
+            }
+        }
+    } else {
+        for (Item *b = bindings; !isNull(b); b = cdr(b)) {
+            ValueType type = inferExpression(car(cdr(car(b))), strcmp(kind, "let*") == 0 ? inner : env);
+            inner = bindVariable(car(car(b)), type, inner);
+        }
+    }
+    Item *body = cdr(args);
+    return inferSequence(body, bindBodyDefinitions(body, inner));
+}
+
+// infer the type of a named let. the loop is typed like a function a
+// letrec binds: its name is bound to its signature, which calls of the
+// loop widen, and the initial values widen the variables' types too. takes
+// in the form and the environment
+ValueType inferNamedLet(Item *expr, Item *env) {
+    Item *args = cdr(expr);
+    Item *signature = NULL;
+    for (Item *l = loopSignatures; !isNull(l) && signature == NULL; l = cdr(l)) {
+        if (car(car(l)) == args) {
+            signature = cdr(car(l));
+        }
+    }
+    if (signature == NULL) {
+        signature = makeNull();
+        for (Item *b = car(cdr(args)); !isNull(b); b = cdr(b)) {
+            signature = cons(makeTypeCell(NO_VALUE), signature);
+        }
+        signature = cons(makeTypeCell(NO_VALUE), signature);
+        loopSignatures = cons(cons(args, signature), loopSignatures);
+    }
+    Item *inner = cons(cons(car(args), signature), env);
+    Item *cells = cdr(signature);
+    for (Item *b = car(cdr(args)); !isNull(b); b = cdr(b), cells = cdr(cells)) {
+        widenType(car(cells), inferExpression(car(cdr(car(b))), env));
+        if (isSet(car(car(b))->s)) {
+            inner = bindVariable(car(car(b)), ANY_VALUE, inner);
+        } else {
+            inner = cons(cons(car(car(b)), car(cells)), inner);
+        }
+    }
+    Item *body = cdr(cdr(args));
+    widenType(car(signature), inferSequence(body, bindBodyDefinitions(body, inner)));
+    return car(signature)->i;
+}
+
+// infer the type of a cond form. a clause of a test alone, or a cond with
+// no else clause, can produce a value of any type
+ValueType inferCond(Item *expr, Item *env) {
+    ValueType type = NO_VALUE;
+    int hasElse = 0;
+    for (Item *clauses = cdr(expr); clauses->type == CONS_TYPE; clauses = cdr(clauses)) {
+        Item *clause = car(clauses);
+        if (clause->type != CONS_TYPE || !isProperList(clause)) {
+            return ANY_VALUE;
+        }
+        Item *test = car(clause);
+        if (test->type == SYMBOL_TYPE && strcmp(test->s, "else") == 0) {
+            hasElse = 1;
+        } else {
+            inferExpression(test, env);
+        }
+        type = joinTypes(type, isNull(cdr(clause)) ? ANY_VALUE : inferSequence(cdr(clause), env));
+    }
+    return hasElse ? type : ANY_VALUE;
+}
+
+// find the type a primitive's call produces. takes in its name and the
+// types of its arguments
+ValueType primitiveResultType(const char *name, ValueType *types, int argc) {
+    int allIntegers = 1;
+    int allNumbers = 1;
+    for (int i = 0; i < argc; i++) {
+        if (types[i] == NO_VALUE) {
+            return NO_VALUE;
+        }
+        allIntegers &= types[i] == INT_VALUE;
+        allNumbers &= types[i] == INT_VALUE || types[i] == DOUBLE_VALUE;
+    }
+    if (strcmp(name, "+") == 0 || strcmp(name, "-") == 0 || strcmp(name, "*") == 0) {
+        return allIntegers ? INT_VALUE : allNumbers ? DOUBLE_VALUE : ANY_VALUE;
+    } else if (strcmp(name, "/") == 0) {
+        return DOUBLE_VALUE;
+    } else if (strcmp(name, "modulo") == 0) {
+        return INT_VALUE;
+    } else if (strcmp(name, "<") == 0 || strcmp(name, ">") == 0 || strcmp(name, "=") == 0 ||
+               strcmp(name, "null?") == 0) {
+        return BOOL_VALUE;
+    }
+    return ANY_VALUE;
+}
+
+// on the last pass, mark a call of an arithmetic or comparison primitive
+// with two operands as proved if their types allow, or report it. a call
+// already marked differently, because the tree shares it, is made generic
+// again. takes in the call, its operator symbol and the operand types
+void checkSite(Item *call, Item *symbol, ValueType *types) {
+    int operation = -1;
+    for (int i = SITE_ADD; i <= SITE_MODULO; i++) {
+        if (strcmp(symbol->s, siteOperationNames[i]) == 0) {
+            operation = i;
+        }
+    }
+    if (!finalPass || operation < 0) {
+        return;
+    }
+    int kind = GENERIC_SITE;
+    if (types[0] == INT_VALUE && types[1] == INT_VALUE) {
+        kind = PROVEN_FIXNUM_SITE;
+    } else if (types[0] == DOUBLE_VALUE && types[1] == DOUBLE_VALUE && operation != SITE_MODULO) {
+        kind = PROVEN_FLONUM_SITE;
+    }
+    siteCount++;
+    if (kind == GENERIC_SITE) {
+        if (reportSites) {
+            printTree(cons(call, makeNull()));
+            printf(": operands of type %s and %s\n", valueTypeNames[types[0]], valueTypeNames[types[1]]);
+        }
+        if (car(call)->type == CALL_SITE_TYPE) {
+            car(call)->cs.kind = GENERIC_SITE;
+        }
+        return;
+    }
+    provedCount++;
+    if (car(call)->type == CALL_SITE_TYPE) {
+        if (car(call)->cs.kind != kind) {
+            car(call)->cs.kind = GENERIC_SITE;
+        }
+        return;
+    }
+    Item *site = talloc(sizeof(Item));
+    site->type = CALL_SITE_TYPE;
+    site->cs.symbol = symbol;
+    site->cs.primitive = findPrimitive(symbol->s);
+    site->cs.operation = operation;
+    site->cs.kind = kind;
+    call->c.car = site;
+}
+
+// infer the type of a call. a call of a function with a signature widens
+// its parameters' types with the arguments' and has its result's type; a
+// call of a primitive whose name nothing binds or assigns has the type the
+// primitive produces. takes in the call and the environment
+ValueType inferCall(Item *expr, Item *env) {
+    Item *function = car(expr);
+    Item *symbol = function->type == CALL_SITE_TYPE ? function->cs.symbol : function;
+    Item *args = cdr(expr);
+    if (symbol->type != SYMBOL_TYPE) {
+        inferExpression(function, env);
+    }
+    if (!isProperList(args)) {
+        inferSequence(args, env);
+        return ANY_VALUE;
+    }
+    int argc = length(args);
+    ValueType *types = talloc(sizeof(ValueType) * (argc + 1));
+    for (int i = 0; i < argc; i++, args = cdr(args)) {
+        types[i] = inferExpression(car(args), env);
+    }
+    if (symbol->type != SYMBOL_TYPE) {
+        return ANY_VALUE;
+    }
+    Item *binding = findBinding(symbol->s, env);
+    if (binding != NULL && binding->type == CONS_TYPE) {
+        if (length(binding) != argc + 1) {
+            return ANY_VALUE;
+        }
+        Item *cells = cdr(binding);
+        for (int i = 0; i < argc; i++, cells = cdr(cells)) {
+            widenType(car(cells), types[i]);
+        }
+        return car(binding)->i;
+    }
+    if (binding != NULL || assignmentCount(symbol->s) > 0 || findPrimitive(symbol->s) == NULL) {
+        return ANY_VALUE;
+    }
+    if (argc == 2) {
+        checkSite(expr, symbol, types);
+    }
+    return primitiveResultType(symbol->s, types, argc);
+}
+
+// infer the type of an expression's value. takes in the expression and
+// the environment. along the way the types of the variables and functions
+// it binds are widened as needed, and on the last pass its primitive calls
+// are marked or reported
+ValueType inferExpression(Item *expr, Item *env) {
+    switch (expr->type) {
+        case INT_TYPE:
+        case BIGNUM_TYPE:
+            return INT_VALUE;
+        case DOUBLE_TYPE:
+            return DOUBLE_VALUE;
+        case BOOL_TYPE:
+            return BOOL_VALUE;
+        case SYMBOL_TYPE: {
+            Item *binding = findBinding(expr->s, env);
+            return binding != NULL && binding->type == INT_TYPE ? binding->i : ANY_VALUE;
+        }
+        case CONS_TYPE:
+            break;
+        default:
+            return ANY_VALUE;
+    }
+    Item *args = cdr(expr);
+    if (isSpecialForm(expr, "quote")) {
+        Item *datum = args->type == CONS_TYPE ? car(args) : args;
+        return datum->type == CONS_TYPE || datum->type == SYMBOL_TYPE ? ANY_VALUE : inferExpression(datum, env);
+    } else if (isSpecialForm(expr, "define")) {
+        if (!isSimpleDefine(expr)) {
+            return ANY_VALUE;
+        }
+        Item *name = car(args);
+        Item *value = car(cdr(args));
+        Item *binding = findBinding(name->s, env);
+        if (binding != NULL && binding->type == CONS_TYPE && lambdaSignature(name->s, value) == binding) {
+            inferLambda(value, env, binding);
+            return ANY_VALUE;
+        }
+        ValueType type = inferExpression(value, env);
+        int global = 1;
+        for (Item *e = env; !isNull(e); e = cdr(e)) {
+            global &= car(car(e))->s != name->s;
+        }
+        if (global && assignmentCount(name->s) == 1) {
+            Item *cell = tableLookup(globalTypes, name->s);
+            if (cell == NULL) {
+                cell = tableDefine(globalTypes, name->s, makeTypeCell(NO_VALUE));
+            }
+            widenType(cell->c.cdr, type);
+        }
+        return ANY_VALUE;
+    } else if (isSpecialForm(expr, "set!") || isSpecialForm(expr, "set-car!") ||
+               isSpecialForm(expr, "set-cdr!")) {
+        inferSequence(args, env);
+        return ANY_VALUE;
+    } else if (isSpecialForm(expr, "lambda")) {
+        inferLambda(expr, env, NULL);
+        return ANY_VALUE;
+    } else if (isNamedLet(expr)) {
+        return inferNamedLet(expr, env);
+    } else if (isSpecialForm(expr, "let") || isSpecialForm(expr, "let*") || isSpecialForm(expr, "letrec")) {
+        return inferLet(expr, env, car(expr)->s);
+    } else if (isSpecialForm(expr, "if")) {
+        if (!isProperList(args) || length(args) < 2) {
+            return ANY_VALUE;
+        }
+        inferExpression(car(args), env);
+        ValueType type = inferExpression(car(cdr(args)), env);
+        Item *alternative = cdr(cdr(args));
+        return joinTypes(type, isNull(alternative) ? ANY_VALUE : inferExpression(car(alternative), env));
+    } else if (isSpecialForm(expr, "cond")) {
+        return inferCond(expr, env);
+    } else if (isSpecialForm(expr, "and") || isSpecialForm(expr, "or")) {
+        ValueType type = inferSequence(args, env);
+        return isNull(args) ? BOOL_VALUE : joinTypes(BOOL_VALUE, type);
+    }
+    return inferCall(expr, env);
+}
+
+// infer the types of a program's values, repeating passes over it until
+// no type widens, and then make one more to mark or report its call sites
+Item *inferTypes(Item *tree, int report) {
+    assignmentCounts = createSymbolTable();
+    setCounts = createSymbolTable();
+    signatures = createSymbolTable();
+    globalTypes = createSymbolTable();
+    loopSignatures = makeNull();
+    for (Item *forms = tree; forms->type == CONS_TYPE; forms = cdr(forms)) {
+        scanAssignments(car(forms), assignmentCounts);
+        findSets(car(forms));
+    }
+    for (Item *forms = tree; forms->type == CONS_TYPE; forms = cdr(forms)) {
+        findFunctions(car(forms));
+    }
+    findEscapesInList(tree);
+    finalPass = 0;
+    do {
+        typesWidened = 0;
+        inferSequence(tree, makeNull());
+    } while (typesWidened);
+    finalPass = 1;
+    reportSites = report;
+    siteCount = 0;
+    provedCount = 0;
+    inferSequence(tree, makeNull());
+    if (report) {
+        printf("%d of %d arithmetic and comparison calls typed\n", provedCount, siteCount);
+    }
+    return tree;
+}
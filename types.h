@@ -0,0 +1,18 @@
+#include "item.h"
+
+#ifndef TYPES_H
+#define TYPES_H
+
+// Infers the types of a program's values and marks the calls of the
+// arithmetic and comparison primitives whose operands are proved to be
+// integers, or doubles, so that every evaluator computes them without
+// checking the operator or the operands. The types flow from literals
+// through let variables, top-level variables defined once, and the
+// parameters and results of functions that a define or letrec binds and
+// that are only ever called by name with the right number of arguments;
+// anything else is of unknown type. Takes in the list of top-level forms,
+// after they are optimized, and whether to print the calls that could not
+// be proved instead, and returns the list.
+Item *inferTypes(Item *tree, int report);
+
+#endif
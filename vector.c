@@ -0,0 +1,173 @@
+#include <limits.h>
+#include <string.h>
+#include "vector.h"
+#include "bignum.h"
+#include "interpreter.h"
+#include "linkedlist.h"
+#include "talloc.h"
+
+// makes a vector with room for its elements, which are left for the
+// caller to fill in. takes in the length. a length whose size in bytes
+// does not fit in a long, or that there is not the memory for, is an
+// error
+Item *makeVector(long length) {
+    if (length > LONG_MAX / (long)sizeof(Item *)) {
+        evaluationError("vector is too long");
+    }
+    Item *vector = talloc(sizeof(Item));
+    vector->type = VECTOR_TYPE;
+    vector->v.length = length;
+    vector->v.elements = talloc(sizeof(Item *) * (length > 0 ? length : 1));
+    if (vector->v.elements == NULL) {
+        evaluationError("not enough memory for the vector");
+    }
+    return vector;
+}
+
+// checks that a value is a vector. takes in the value and the name of the
+// procedure that expects one
+void checkVector(Item *value, const char *name) {
+    if (value->type != VECTOR_TYPE) {
+        evaluationError(name);
+    }
+}
+
+// checks that a value is an index of a vector. takes in the value, the
+// number of elements, and whether the index may be that number, as the
+// end of a range can, and returns the index
+long checkIndex(Item *index, long length, int inclusive) {
+    if (index->type != INT_TYPE) {
+        evaluationError(index->type == BIGNUM_TYPE ? "vector index out of range"
+                                                   : "vector index must be an integer");
+    }
+    if (index->i < 0 || index->i > length || (index->i == length && !inclusive)) {
+        evaluationError("vector index out of range");
+    }
+    return index->i;
+}
+
+// reads the optional start and end of a range of a vector's elements.
+// takes in the arguments of the call, where the range starts among them
+// and the vector's length, and sets the start and end, by default the
+// whole vector
+void checkRange(int argc, Item **argv, int first, long length, long *start, long *end) {
+    *start = argc > first ? checkIndex(argv[first], length, 1) : 0;
+    *end = argc > first + 1 ? checkIndex(argv[first + 1], length, 1) : length;
+    if (*start > *end) {
+        evaluationError("vector range starts after it ends");
+    }
+}
+
+// makes a vector of the elements of a list. takes in the list, which must
+// be proper, and returns the vector
+Item *listToVector(Item *list) {
+    long length = 0;
+    for (Item *rest = list; rest->type == CONS_TYPE; rest = cdr(rest)) {
+        length++;
+    }
+    Item *vector = makeVector(length);
+    for (long i = 0; i < length; i++) {
+        vector->v.elements[i] = car(list);
+        list = cdr(list);
+    }
+    return vector;
+}
+
+// implements make-vector. takes in the length and optionally the value of
+// every element, 0 if there is none, and returns the vector
+Item *primitiveMakeVector(int argc, Item **argv) {
+    if (argv[0]->type != INT_TYPE || argv[0]->i < 0) {
+        evaluationError("make-vector expects a length of at least 0");
+    }
+    Item *vector = makeVector(argv[0]->i);
+    Item *fill = argc > 1 ? argv[1] : makeFixnum(0);
+    for (long i = 0; i < vector->v.length; i++) {
+        vector->v.elements[i] = fill;
+    }
+    return vector;
+}
+
+// implements vector. takes in the elements and returns a vector of them
+Item *primitiveVector(int argc, Item **argv) {
+    Item *vector = makeVector(argc);
+    memcpy(vector->v.elements, argv, sizeof(Item *) * argc);
+    return vector;
+}
+
+// implements vector?. takes in a value and returns whether it is a vector
+Item *primitiveIsVector(Item *value) {
+    Item *result = talloc(sizeof(Item));
+    result->type = BOOL_TYPE;
+    result->i = value->type == VECTOR_TYPE;
+    return result;
+}
+
+// implements vector-length. takes in a vector and returns its length
+Item *primitiveVectorLength(Item *vector) {
+    checkVector(vector, "vector-length expects a vector");
+    return makeFixnum(vector->v.length);
+}
+
+// implements vector-ref. takes in a vector and an index and returns the
+// element at the index
+Item *primitiveVectorRef(Item *vector, Item *index) {
+    checkVector(vector, "vector-ref expects a vector");
+    return vector->v.elements[checkIndex(index, vector->v.length, 0)];
+}
+
+// implements vector-set!. takes in a vector, an index and a value, stores
+// the value at the index and returns void
+Item *primitiveVectorSet(int argc, Item **argv) {
+    checkVector(argv[0], "vector-set! expects a vector");
+    argv[0]->v.elements[checkIndex(argv[1], argv[0]->v.length, 0)] = argv[2];
+    return makeVoid();
+}
+
+// implements vector-fill!. takes in a vector, a value and optionally a
+// range, stores the value at every index in the range and returns void
+Item *primitiveVectorFill(int argc, Item **argv) {
+    checkVector(argv[0], "vector-fill! expects a vector");
+    long start, end;
+    checkRange(argc, argv, 2, argv[0]->v.length, &start, &end);
+    for (long i = start; i < end; i++) {
+        argv[0]->v.elements[i] = argv[1];
+    }
+    return makeVoid();
+}
+
+// implements vector-copy. takes in a vector and optionally a range, and
+// returns a new vector of the elements in the range
+Item *primitiveVectorCopy(int argc, Item **argv) {
+    checkVector(argv[0], "vector-copy expects a vector");
+    long start, end;
+    checkRange(argc, argv, 1, argv[0]->v.length, &start, &end);
+    Item *copy = makeVector(end - start);
+    memcpy(copy->v.elements, argv[0]->v.elements + start, sizeof(Item *) * (end - start));
+    return copy;
+}
+
+// implements vector->list. takes in a vector and optionally a range, and
+// returns a list of the elements in the range
+Item *primitiveVectorToList(int argc, Item **argv) {
+    checkVector(argv[0], "vector->list expects a vector");
+    long start, end;
+    checkRange(argc, argv, 1, argv[0]->v.length, &start, &end);
+    Item *list = makeNull();
+    for (long i = end - 1; i >= start; i--) {
+        list = cons(argv[0]->v.elements[i], list);
+    }
+    return list;
+}
+
+// implements list->vector. takes in a list and returns a vector of its
+// elements
+Item *primitiveListToVector(Item *list) {
+    Item *rest = list;
+    while (rest->type == CONS_TYPE) {
+        rest = cdr(rest);
+    }
+    if (rest->type != NULL_TYPE) {
+        evaluationError("list->vector expects a list");
+    }
+    return listToVector(list);
+}
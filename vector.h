@@ -0,0 +1,32 @@
+#include "item.h"
+
+#ifndef VECTOR_H
+#define VECTOR_H
+
+// Vectors: fixed-length sequences whose elements are kept side by side, so
+// any of them is reached in constant time. vector-ref and vector-set!
+// check the index against the length and allocate nothing. A vector
+// literal, #(...), evaluates to itself, and its elements are not
+// evaluated. Procedures taking an optional start and end work on the
+// elements from start up to but not including end, by default all of them.
+Item *primitiveMakeVector(int argc, Item **argv);
+Item *primitiveVector(int argc, Item **argv);
+Item *primitiveIsVector(Item *value);
+Item *primitiveVectorLength(Item *vector);
+Item *primitiveVectorRef(Item *vector, Item *index);
+Item *primitiveVectorSet(int argc, Item **argv);
+Item *primitiveVectorFill(int argc, Item **argv);
+Item *primitiveVectorCopy(int argc, Item **argv);
+Item *primitiveVectorToList(int argc, Item **argv);
+Item *primitiveListToVector(Item *list);
+
+// Makes a vector of the elements of a list, for the parser's vector
+// literals. Takes in the list, which must be proper.
+Item *listToVector(Item *list);
+
+// Check an index, or the optional start and end arguments of a call, for
+// a vector of some length; numeric vectors share them (see numvec.h).
+long checkIndex(Item *index, long length, int inclusive);
+void checkRange(int argc, Item **argv, int first, long length, long *start, long *end);
+
+#endif
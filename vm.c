@@ -0,0 +1,635 @@
+#include <stdio.h>
+#include <string.h>
+#include "vm.h"
+#include "jit.h"
+#include "aot.h"
+#include "interpreter.h"
+#include "linkedlist.h"
+#include "talloc.h"
+#include "memo.h"
+
+// With GCC and clang the VM dispatches with computed gotos: each opcode in
+// a function's prepared code is replaced by the address of the code that
+// runs it, and every instruction jumps straight to the next one. Other
+// compilers fall back to a switch.
+#if defined(__GNUC__)
+#define THREADED_DISPATCH 1
+#endif
+
+const int opcodeOperands[OPCODE_COUNT] = {
+    [CONST_OP] = 1, [LOCAL_REF_OP] = 2, [LOCAL_SET_OP] = 2,
+    [BOX_OP] = 1, [BOX_REF_OP] = 2, [BOX_SET_OP] = 2,
+    [GLOBAL_REF_OP] = 1, [GLOBAL_SET_OP] = 1, [GLOBAL_DEFINE_OP] = 1,
+    [VOID_OP] = 0, [POP_OP] = 0, [JUMP_OP] = 1, [JUMP_IF_FALSE_OP] = 1,
+    [JUMP_UNLESS_TRUE_OP] = 1, [AND_JUMP_OP] = 1, [OR_JUMP_OP] = 1,
+    [MAKE_CLOSURE_OP] = 1, [CALL_OP] = 1, [TAIL_CALL_OP] = 1,
+    [RETURN_OP] = 0, [SET_CAR_OP] = 0, [SET_CDR_OP] = 0,
+    [FIXNUM_OP] = 1, [FLONUM_OP] = 1, [LOOP_OP] = 0, [PROMISE_OP] = 1,
+    [MEMO_STORE_OP] = 0
+};
+
+// The state of a function waiting for a call to return: the function, where
+// to resume it, its environment, and where its part of the operand stack
+// starts. Kept as an index, since the operand stack can move when it grows.
+typedef struct {
+    Function *function;
+    intptr_t *pc;
+    Env *env;
+    int base;
+} CallFrame;
+
+#define INITIAL_STACK_CAPACITY 1024
+
+// the operand stack and the call stack, shared by every run of the VM. a
+// run that calls out to C, which may start a nested run, first publishes
+// its stack height in valueTop so the nested run starts above it
+Item **valueStack = NULL;
+int valueCapacity = 0;
+int valueTop = 0;
+CallFrame *callStack = NULL;
+int callTop = 0;
+int callCapacity = 0;
+
+// the value of forms evaluated only for their effect, shared by all of them
+Item *voidItem = NULL;
+
+// checks that the VM's stacks may grow to the given sizes without going
+// over the stack limit, and exits with an evaluation error if not. takes in
+// the capacities and does not return anything
+void checkStackLimit(size_t values, size_t calls) {
+    if (values * sizeof(Item *) + calls * sizeof(CallFrame) > getStackLimit()) {
+        evaluationError("recursion too deep (stack limit reached)");
+    }
+}
+
+// grows the operand stack so it holds at least the given number of values.
+// takes in the number of values needed and does not return anything
+void growValueStack(int needed) {
+    int newCapacity = valueCapacity ? valueCapacity : INITIAL_STACK_CAPACITY;
+    while (newCapacity < needed) {
+        newCapacity *= 2;
+    }
+    checkStackLimit(newCapacity, callCapacity);
+    Item **newStack = talloc(sizeof(Item *) * newCapacity);
+    if (valueCapacity > 0) {
+        memcpy(newStack, valueStack, sizeof(Item *) * valueCapacity);
+    }
+    valueStack = newStack;
+    valueCapacity = newCapacity;
+}
+
+// saves the state of a calling function on the call stack, growing it if
+// needed. takes in the state and does not return anything
+void pushCallFrame(Function *function, intptr_t *pc, Env *env, int base) {
+    if (callTop == callCapacity) {
+        int newCapacity = callCapacity ? 2 * callCapacity : INITIAL_STACK_CAPACITY;
+        checkStackLimit(valueCapacity, newCapacity);
+        CallFrame *newStack = talloc(sizeof(CallFrame) * newCapacity);
+        if (callCapacity > 0) {
+            memcpy(newStack, callStack, sizeof(CallFrame) * callCapacity);
+        }
+        callStack = newStack;
+        callCapacity = newCapacity;
+    }
+    CallFrame *frame = &callStack[callTop++];
+    frame->function = function;
+    frame->pc = pc;
+    frame->env = env;
+    frame->base = base;
+}
+
+// swaps the operand and call stacks with a saved set. takes in the set and
+// does not return anything
+void swapVmStacks(Stacks *other) {
+    Item **values = valueStack;
+    int top = valueTop, capacity = valueCapacity;
+    valueStack = other->values;
+    valueTop = other->valueTop;
+    valueCapacity = other->valueCapacity;
+    other->values = values;
+    other->valueTop = top;
+    other->valueCapacity = capacity;
+
+    CallFrame *calls = callStack;
+    top = callTop;
+    capacity = callCapacity;
+    callStack = other->calls;
+    callTop = other->callTop;
+    callCapacity = other->callCapacity;
+    other->calls = calls;
+    other->callTop = top;
+    other->callCapacity = capacity;
+}
+
+// records the heights of the operand and call stacks. takes in where to
+// record them
+void markVmStacks(Stacks *marks) {
+    marks->valueTop = valueTop;
+    marks->callTop = callTop;
+}
+
+// cuts the operand and call stacks back to recorded heights, dropping the
+// calls of any run of the VM that was abandoned. takes in the heights
+void resetVmStacks(Stacks *marks) {
+    valueTop = marks->valueTop;
+    callTop = marks->callTop;
+}
+
+// checks whether an opcode's operand is a jump target. takes in the opcode
+// and returns true if it is
+int isJump(Opcode op) {
+    return op == JUMP_OP || op == JUMP_IF_FALSE_OP || op == JUMP_UNLESS_TRUE_OP ||
+           op == AND_JUMP_OP || op == OR_JUMP_OP;
+}
+
+// builds the prepared code of a function. takes in the function and the
+// dispatch table of code addresses for each opcode, or NULL if the VM
+// dispatches with a switch. jump targets become code addresses either way
+void prepareFunction(Function *function, void **dispatch) {
+    intptr_t *prepared = talloc(sizeof(intptr_t) * function->codeLength);
+    int pc = 0;
+    while (pc < function->codeLength) {
+        Opcode op = function->code[pc];
+        prepared[pc] = dispatch ? (intptr_t)dispatch[op] : op;
+        for (int i = 1; i <= opcodeOperands[op]; i++) {
+            prepared[pc + i] = function->code[pc + i];
+        }
+        if (isJump(op)) {
+            prepared[pc + 1] = (intptr_t)(prepared + function->code[pc + 1]);
+        }
+        pc += 1 + opcodeOperands[op];
+    }
+    function->prepared = prepared;
+}
+
+// creates the environment for a call to a compiled function. takes in the
+// function, the environment its closure was created in, and the arguments
+// as an array. returns the environment, with the parameters bound and every
+// other slot empty. a rest parameter gets a list of the extra arguments
+Env *bindSlots(Function *function, Env *parent, Item **args, int argc) {
+    if (argc < function->paramCount) {
+        evaluationError("too few arguments");
+    }
+    if (argc > function->paramCount && !function->variadic) {
+        evaluationError("too many arguments");
+    }
+    Env *env = talloc(sizeof(Env) + sizeof(Item *) * function->slotCount);
+    env->parent = parent;
+    for (int i = 0; i < function->paramCount; i++) {
+        env->slots[i] = args[i];
+    }
+    for (int i = function->paramCount; i < function->slotCount; i++) {
+        env->slots[i] = NULL;
+    }
+    if (function->variadic) {
+        Item *rest = makeNull();
+        for (int i = argc - 1; i >= function->paramCount; i--) {
+            rest = cons(args[i], rest);
+        }
+        env->slots[function->paramCount] = rest;
+    }
+    return env;
+}
+
+// calls something other than a compiled closure: a primitive, or a closure
+// made by the tree walker. takes in the function and the arguments as an
+// array, and returns the result
+Item *callOut(Item *function, Item **args, int argc) {
+    if (function->type == PRIMITIVE_TYPE) {
+        return callPrimitive(function->pr, argc, args);
+    }
+    return apply(function, argc, args);
+}
+
+// makes a closure of a compiled function. takes in the function and the
+// environment of the function making it, and returns the closure. the
+// variables the function captures are copied into a new environment; a
+// boxed variable's box is copied, so the closure shares the variable
+Item *makeClosure(Function *function, Env *env) {
+    Item *closure = talloc(sizeof(Item));
+    closure->type = COMPILED_TYPE;
+    closure->cc.function = function;
+    closure->cc.env = NULL;
+    if (function->captureCount > 0) {
+        Env *captured = talloc(sizeof(Env) + sizeof(Item *) * function->captureCount);
+        captured->parent = NULL;
+        for (int i = 0; i < function->captureCount; i++) {
+            Env *from = function->captures[2 * i] ? env->parent : env;
+            captured->slots[i] = from->slots[function->captures[2 * i + 1]];
+        }
+        closure->cc.env = captured;
+    }
+    return closure;
+}
+
+// makes a box for a variable. a box is a cell like a global's binding cell,
+// with the value in its cdr. takes in the value and returns the box
+Item *makeBox(Item *value) {
+    Item *box = talloc(sizeof(Item));
+    box->type = CONS_TYPE;
+    box->c.car = NULL;
+    box->c.cdr = value;
+    return box;
+}
+
+// resolves a global variable reference site, caching its binding cell on
+// the site. takes in the site and returns the cell
+Item *resolveGlobal(Item *site) {
+    if (site->sc.cell == NULL) {
+        site->sc.cell = lookupGlobalCell(site->s);
+        if (site->sc.cell == NULL) {
+            evaluationError("Unbound symbol");
+        }
+    }
+    return site->sc.cell;
+}
+
+// the function a call of a memoized procedure that misses returns through,
+// which keeps the value in the memo table and returns it to the caller.
+// the call is made like any other, on the VM's call stack, so deep
+// recursion through a memoized procedure needs no C stack
+intptr_t memoStoreCode[] = {MEMO_STORE_OP, RETURN_OP};
+Function memoStoreFunction = {.code = memoStoreCode, .codeLength = 2};
+
+// checks whether a memoized procedure wraps a closure the VM runs itself.
+// takes in the memoized procedure
+int wrapsBytecode(Item *memoized) {
+    Item *function = memoized->mo.function;
+    return function->type == COMPILED_TYPE && function->cc.function->aotEntry == NULL;
+}
+
+// pushes the frame of memoStoreFunction for a call that missed. takes in
+// the entry memoLookup made for the call, where the value returned goes on
+// the operand stack, and the dispatch table
+void pushMemoFrame(Item *pending, int base, void **dispatch) {
+    if (memoStoreFunction.prepared == NULL) {
+        prepareFunction(&memoStoreFunction, dispatch);
+    }
+    Env *env = talloc(sizeof(Env) + sizeof(Item *));
+    env->parent = NULL;
+    env->slots[0] = pending;
+    pushCallFrame(&memoStoreFunction, memoStoreFunction.prepared, env, base);
+}
+
+#ifdef THREADED_DISPATCH
+#define CASE(op) L_##op
+#define DISPATCH() goto *(void *)*pc++
+#else
+#define CASE(op) case op
+#define DISPATCH() goto dispatch
+#endif
+
+// makes room for the current function's operand stack, updating the
+// registers that point into it if it moves
+#define ENSURE_STACK() \
+    if (sp + function->maxStack > valueStack + valueCapacity) { \
+        int spIndex = sp - valueStack, baseIndex = base - valueStack; \
+        growValueStack(spIndex + function->maxStack); \
+        sp = valueStack + spIndex; \
+        base = valueStack + baseIndex; \
+    }
+
+// publish the stack height before calling out to C, and find the stack
+// again afterwards, since a nested run may have moved it
+#define SAVE_STACK() \
+    int spIndex = sp - valueStack, baseIndex = base - valueStack; \
+    valueTop = spIndex
+#define RESTORE_STACK() \
+    sp = valueStack + spIndex; \
+    base = valueStack + baseIndex
+
+// run the current function's native code from a code position, then carry
+// on interpreting wherever it stops
+#define RUN_NATIVE(position) { \
+        int baseIndex = base - valueStack; \
+        pc = function->prepared + jitEnter(function, &sp, env, (position)); \
+        base = valueStack + baseIndex; \
+    }
+
+// runs compiled code until the function it starts with returns. takes in
+// the function and its environment, and returns the function's value. the
+// function's operand stack starts at valueTop
+Item *execute(Function *function, Env *env) {
+#ifdef THREADED_DISPATCH
+    static void *dispatch[OPCODE_COUNT] = {
+        [CONST_OP] = &&L_CONST_OP, [LOCAL_REF_OP] = &&L_LOCAL_REF_OP,
+        [LOCAL_SET_OP] = &&L_LOCAL_SET_OP, [BOX_OP] = &&L_BOX_OP,
+        [BOX_REF_OP] = &&L_BOX_REF_OP, [BOX_SET_OP] = &&L_BOX_SET_OP,
+        [GLOBAL_REF_OP] = &&L_GLOBAL_REF_OP,
+        [GLOBAL_SET_OP] = &&L_GLOBAL_SET_OP, [GLOBAL_DEFINE_OP] = &&L_GLOBAL_DEFINE_OP,
+        [VOID_OP] = &&L_VOID_OP, [POP_OP] = &&L_POP_OP, [JUMP_OP] = &&L_JUMP_OP,
+        [JUMP_IF_FALSE_OP] = &&L_JUMP_IF_FALSE_OP,
+        [JUMP_UNLESS_TRUE_OP] = &&L_JUMP_UNLESS_TRUE_OP,
+        [AND_JUMP_OP] = &&L_AND_JUMP_OP, [OR_JUMP_OP] = &&L_OR_JUMP_OP,
+        [MAKE_CLOSURE_OP] = &&L_MAKE_CLOSURE_OP, [CALL_OP] = &&L_CALL_OP,
+        [TAIL_CALL_OP] = &&L_TAIL_CALL_OP, [RETURN_OP] = &&L_RETURN_OP,
+        [SET_CAR_OP] = &&L_SET_CAR_OP, [SET_CDR_OP] = &&L_SET_CDR_OP,
+        [FIXNUM_OP] = &&L_FIXNUM_OP, [FLONUM_OP] = &&L_FLONUM_OP,
+        [LOOP_OP] = &&L_LOOP_OP, [PROMISE_OP] = &&L_PROMISE_OP,
+        [MEMO_STORE_OP] = &&L_MEMO_STORE_OP
+    };
+#else
+    void **dispatch = NULL;
+#endif
+    if (voidItem == NULL) {
+        voidItem = makeVoid();
+    }
+    int entryCall = callTop;
+    Item **base = valueStack + valueTop;
+    Item **sp = base;
+    intptr_t *pc;
+    Item **constants;
+    Item *callee;
+    int argc;
+
+    // every call of a compiled function, including the first, starts here
+enterFunction:
+    ENSURE_STACK();
+    if (function->prepared == NULL) {
+        prepareFunction(function, dispatch);
+    }
+    pc = function->prepared;
+    constants = function->constants;
+    if (function->native == NULL && ++function->callCount == jitThreshold) {
+        jitCompile(function);
+    }
+    if (function->native != NULL) {
+        RUN_NATIVE(0);
+    }
+
+#ifdef THREADED_DISPATCH
+    DISPATCH();
+#else
+dispatch:
+    switch (*pc++) {
+#endif
+    CASE(CONST_OP):
+        *sp++ = constants[*pc++];
+        DISPATCH();
+    CASE(LOCAL_REF_OP): {
+        Env *e = env;
+        for (intptr_t depth = *pc++; depth > 0; depth--) {
+            e = e->parent;
+        }
+        Item *value = e->slots[*pc++];
+        if (value == NULL) {
+            evaluationError("Unbound symbol");
+        }
+        *sp++ = value;
+        DISPATCH();
+    }
+    CASE(LOCAL_SET_OP): {
+        Env *e = env;
+        for (intptr_t depth = *pc++; depth > 0; depth--) {
+            e = e->parent;
+        }
+        e->slots[*pc++] = *--sp;
+        DISPATCH();
+    }
+    CASE(BOX_OP): {
+        Item **slot = &env->slots[*pc++];
+        *slot = makeBox(*slot);
+        DISPATCH();
+    }
+    CASE(BOX_REF_OP): {
+        Env *e = env;
+        for (intptr_t depth = *pc++; depth > 0; depth--) {
+            e = e->parent;
+        }
+        Item *value = e->slots[*pc++]->c.cdr;
+        if (value == NULL) {
+            evaluationError("Unbound symbol");
+        }
+        *sp++ = value;
+        DISPATCH();
+    }
+    CASE(BOX_SET_OP): {
+        Env *e = env;
+        for (intptr_t depth = *pc++; depth > 0; depth--) {
+            e = e->parent;
+        }
+        e->slots[*pc++]->c.cdr = *--sp;
+        DISPATCH();
+    }
+    CASE(GLOBAL_REF_OP):
+        *sp++ = resolveGlobal(constants[*pc++])->c.cdr;
+        DISPATCH();
+    CASE(GLOBAL_SET_OP):
+        resolveGlobal(constants[*pc++])->c.cdr = *--sp;
+        DISPATCH();
+    CASE(GLOBAL_DEFINE_OP):
+        defineGlobal(constants[*pc++]->s, *--sp);
+        DISPATCH();
+    CASE(VOID_OP):
+        *sp++ = voidItem;
+        DISPATCH();
+    CASE(POP_OP):
+        sp--;
+        DISPATCH();
+    CASE(JUMP_OP):
+        pc = (intptr_t *)*pc;
+        DISPATCH();
+    CASE(LOOP_OP):
+        // a loop that runs long enough gets the function compiled, and
+        // carries on in native code from the same iteration
+        if (function->native == NULL && ++function->callCount == jitThreshold) {
+            jitCompile(function);
+        }
+        if (function->native != NULL) {
+            RUN_NATIVE(pc - 1 - function->prepared);
+        }
+        DISPATCH();
+    CASE(JUMP_IF_FALSE_OP): {
+        Item *test = *--sp;
+        if (test->type != BOOL_TYPE) {
+            evaluationError("if expects a boolean as the first argument");
+        }
+        pc = test->i ? pc + 1 : (intptr_t *)*pc;
+        DISPATCH();
+    }
+    CASE(JUMP_UNLESS_TRUE_OP): {
+        Item *test = *--sp;
+        pc = (test->type == BOOL_TYPE && test->i) ? pc + 1 : (intptr_t *)*pc;
+        DISPATCH();
+    }
+    CASE(AND_JUMP_OP): {
+        Item *test = sp[-1];
+        if (test->type != BOOL_TYPE) {
+            evaluationError("boolean arguments expected");
+        }
+        if (!test->i) {
+            pc = (intptr_t *)*pc;
+        } else {
+            sp--;
+            pc++;
+        }
+        DISPATCH();
+    }
+    CASE(OR_JUMP_OP): {
+        Item *test = sp[-1];
+        if (test->type != BOOL_TYPE) {
+            evaluationError("boolean arguments expected");
+        }
+        if (test->i) {
+            pc = (intptr_t *)*pc;
+        } else {
+            sp--;
+            pc++;
+        }
+        DISPATCH();
+    }
+    CASE(MAKE_CLOSURE_OP):
+        *sp++ = makeClosure(function->functions[*pc++], env);
+        DISPATCH();
+    CASE(CALL_OP):
+        argc = *pc++;
+        callee = sp[-argc - 1];
+        if (callee->type == MEMOIZED_TYPE && wrapsBytecode(callee)) {
+            Item *pending;
+            Item *result = memoLookup(callee, argc, sp - argc, &pending);
+            sp -= argc + 1;
+            if (result != NULL) {
+                *sp++ = result;
+                DISPATCH();
+            }
+            pushCallFrame(function, pc, env, base - valueStack);
+            pushMemoFrame(pending, sp - valueStack, dispatch);
+            base = sp;
+            callee = callee->mo.function;
+            function = callee->cc.function;
+            env = bindSlots(function, callee->cc.env, sp + 1, argc);
+            goto enterFunction;
+        }
+        if (callee->type == COMPILED_TYPE) {
+            Function *target = callee->cc.function;
+            Env *newEnv = bindSlots(target, callee->cc.env, sp - argc, argc);
+            sp -= argc + 1;
+            pushCallFrame(function, pc, env, base - valueStack);
+            base = sp;
+            function = target;
+            env = newEnv;
+            goto enterFunction;
+        } else {
+            SAVE_STACK();
+            Item *result = callOut(callee, sp - argc, argc);
+            RESTORE_STACK();
+            sp -= argc + 1;
+            *sp++ = result;
+            DISPATCH();
+        }
+    CASE(TAIL_CALL_OP):
+        argc = *pc++;
+        callee = sp[-argc - 1];
+        if (callee->type == MEMOIZED_TYPE && wrapsBytecode(callee)) {
+            Item *pending;
+            Item *result = memoLookup(callee, argc, sp - argc, &pending);
+            if (result != NULL) {
+                sp -= argc + 1;
+                *sp++ = result;
+                goto returnValue;
+            }
+            pushMemoFrame(pending, base - valueStack, dispatch);
+            callee = callee->mo.function;
+            function = callee->cc.function;
+            env = bindSlots(function, callee->cc.env, sp - argc, argc);
+            sp = base;
+            goto enterFunction;
+        }
+        if (callee->type == COMPILED_TYPE) {
+            Function *target = callee->cc.function;
+            env = bindSlots(target, callee->cc.env, sp - argc, argc);
+            sp = base;
+            function = target;
+            goto enterFunction;
+        } else {
+            SAVE_STACK();
+            Item *result = callOut(callee, sp - argc, argc);
+            RESTORE_STACK();
+            sp -= argc + 1;
+            *sp++ = result;
+        }
+        // a call out in tail position returns its result right away
+        goto returnValue;
+    CASE(RETURN_OP):
+    returnValue: {
+        Item *value = *--sp;
+        if (callTop == entryCall) {
+            valueTop = base - valueStack;
+            return value;
+        }
+        CallFrame *frame = &callStack[--callTop];
+        sp = base;
+        *sp++ = value;
+        function = frame->function;
+        pc = frame->pc;
+        env = frame->env;
+        base = valueStack + frame->base;
+        constants = function->constants;
+        if (function->native != NULL) {
+            RUN_NATIVE(pc - function->prepared);
+        }
+        DISPATCH();
+    }
+    CASE(SET_CAR_OP): {
+        Item *value = *--sp;
+        Item *pair = *--sp;
+        if (pair->type != CONS_TYPE) {
+            evaluationError("not a pair");
+        }
+        pair->c.car = value;
+        *sp++ = voidItem;
+        DISPATCH();
+    }
+    CASE(MEMO_STORE_OP):
+        memoStore(env->slots[0], sp[-1]);
+        DISPATCH();
+    CASE(PROMISE_OP):
+        sp[-1] = makePromise(sp[-1], NULL, *pc++);
+        DISPATCH();
+    CASE(SET_CDR_OP): {
+        Item *value = *--sp;
+        Item *pair = *--sp;
+        if (pair->type != CONS_TYPE) {
+            evaluationError("set-cdr! expects a pair as the first argument");
+        }
+        pair->c.cdr = value;
+        *sp++ = voidItem;
+        DISPATCH();
+    }
+    // type inference proved the operands' types, so nothing is checked
+    CASE(FIXNUM_OP): {
+        sp--;
+        sp[-1] = computeFixnum(*pc++, sp - 1);
+        DISPATCH();
+    }
+    CASE(FLONUM_OP): {
+        sp--;
+        sp[-1] = computeFlonum(*pc++, sp - 1);
+        DISPATCH();
+    }
+#ifndef THREADED_DISPATCH
+    default:
+        evaluationError("bad instruction");
+    }
+#endif
+    return NULL;
+}
+
+// runs a compiled top-level form in a fresh environment. takes in the
+// function and returns its value
+Item *vmRun(Function *function) {
+    return execute(function, bindSlots(function, NULL, NULL, 0));
+}
+
+// calls a compiled closure from C, checking the C stack depth first like
+// apply. takes in the closure and the arguments as a count and a vector,
+// and returns the closure's value
+Item *vmApply(Item *closure, int argc, Item **argv) {
+    checkStackDepth();
+    Function *function = closure->cc.function;
+    Env *env = bindSlots(function, closure->cc.env, argv, argc);
+    if (function->aotEntry != NULL) {
+        return aotInvoke(function, env);
+    }
+    return execute(function, env);
+}
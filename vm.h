@@ -0,0 +1,131 @@
+#include <stdint.h>
+#include "item.h"
+#include "interpreter.h"
+
+#ifndef VM_H
+#define VM_H
+
+// The bytecode instruction set. Each instruction is an opcode word followed
+// by its operands, all stored as intptr_t. Values live on an operand stack;
+// variables live in environments of numbered slots, addressed by a depth and
+// a slot number. Depth 0 is the running function's own environment and
+// depth 1 the environment of the closure it was called through, which holds
+// the variables the closure captured. A variable that is captured and may
+// be assigned afterwards lives in a box in its slot, so the closure and the
+// function that binds it share it.
+typedef enum {
+    CONST_OP,           // k: push constant k
+    LOCAL_REF_OP,       // depth slot: push the variable
+    LOCAL_SET_OP,       // depth slot: pop a value into the variable
+    BOX_OP,             // slot: put the variable's value in a new box
+    BOX_REF_OP,         // depth slot: push the value in the variable's box
+    BOX_SET_OP,         // depth slot: pop a value into the variable's box
+    GLOBAL_REF_OP,      // k: push the global named by site constant k
+    GLOBAL_SET_OP,      // k: pop a value into an existing global
+    GLOBAL_DEFINE_OP,   // k: pop a value into a new or existing global
+    VOID_OP,            // push the void value
+    POP_OP,             // discard the top of the stack
+    JUMP_OP,            // target: continue at target
+    JUMP_IF_FALSE_OP,   // target: pop a boolean, jump if it is false
+    JUMP_UNLESS_TRUE_OP,// target: pop a value, jump unless it is #t
+    AND_JUMP_OP,        // target: if the boolean on top is false jump,
+                        //   keeping it; otherwise pop it
+    OR_JUMP_OP,         // target: if the boolean on top is true jump,
+                        //   keeping it; otherwise pop it
+    MAKE_CLOSURE_OP,    // k: push a closure of nested function k,
+                        //   capturing the variables it uses
+    CALL_OP,            // argc: call the function below the arguments
+    TAIL_CALL_OP,       // argc: call it in place of the current function
+    RETURN_OP,          // return the top of the stack
+    SET_CAR_OP,         // pop a pair and a value, set its car, push void
+    SET_CDR_OP,         // pop a pair and a value, set its cdr, push void
+    FIXNUM_OP,          // operation: pop two integers, push the result of
+                        //   a site operation on them
+    FLONUM_OP,          // operation: the same for two doubles
+    LOOP_OP,            // the start of a loop iteration: counts towards
+                        //   compiling the function to native code
+    PROMISE_OP,         // chained: replace the procedure on top with a
+                        //   promise to call it, made by delay-force if
+                        //   chained is set
+    MEMO_STORE_OP,      // keep the value on top in the memo table entry in
+                        //   slot 0 (see memo.h); only in the function that
+                        //   calls of memoized procedures return through
+    OPCODE_COUNT
+} Opcode;
+
+// A compiled lambda (or top-level form). A global variable reference site is
+// a symbol constant whose cached binding cell is filled in the first time
+// the instruction runs.
+struct Function {
+    intptr_t *code;
+    int codeLength;
+    // the code with opcodes replaced by dispatch addresses and jump targets
+    // by code addresses, built the first time the function runs
+    intptr_t *prepared;
+    struct Item **constants;
+    int constantCount;
+    // lambdas nested directly inside this one
+    struct Function **functions;
+    int functionCount;
+    // the variables a closure of this function captures from the function
+    // that makes it, as (depth, slot) pairs in the maker's environment. the
+    // closure's environment holds them in this order
+    intptr_t *captures;
+    int captureCount;
+    int paramCount;
+    int variadic;
+    // parameters first, then variables bound by let, letrec and define
+    int slotCount;
+    // the deepest the operand stack gets while this function runs
+    int maxStack;
+    // how many times the function has been entered, and once the JIT has
+    // compiled it (see jit.h), its native code and the native address of
+    // each code position the interpreter can enter it at, or NULL
+    int callCount;
+    void *native;
+    void **nativeEntries;
+    // for a function compiled ahead of time to C (see aot.h), the C
+    // function that runs its body, which replaces the bytecode
+    struct Item *(*aotEntry)(struct Env *env);
+};
+
+typedef struct Function Function;
+
+// An environment: the variable slots of one activation of a function, and
+// the environment of the closure it was called through. A closure's own
+// environment holds one slot per captured variable and has no parent, so a
+// closure keeps alive only the variables it uses.
+struct Env {
+    struct Env *parent;
+    struct Item *slots[];
+};
+
+typedef struct Env Env;
+
+// Number of operands that follow each opcode.
+extern const int opcodeOperands[OPCODE_COUNT];
+
+// Runs a compiled top-level form in a fresh environment and returns its
+// value.
+Item *vmRun(Function *function);
+
+// Calls a compiled closure with a vector of arguments and returns its value.
+Item *vmApply(Item *closure, int argc, Item **argv);
+
+// Shared with the JIT, whose native code works on the VM's operand stack.
+extern Item **valueStack;
+extern int valueTop;
+extern Item *voidItem;
+Item *resolveGlobal(Item *site);
+Item *makeClosure(Function *function, Env *env);
+Item *makeBox(Item *value);
+Item *callOut(Item *function, Item **args, int argc);
+Env *bindSlots(Function *function, Env *parent, Item **args, int argc);
+
+// The VM's part of swapStacks, markStacks and resetStacks (see
+// interpreter.h).
+void swapVmStacks(Stacks *other);
+void markVmStacks(Stacks *marks);
+void resetVmStacks(Stacks *marks);
+
+#endif